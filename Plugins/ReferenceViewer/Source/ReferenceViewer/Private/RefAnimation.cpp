@@ -0,0 +1,282 @@
+#include "RefAnimation.h"
+#include "RefImageLoader.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Engine/Texture2D.h"
+
+FString FRefImageSequenceSource::MakePattern(const FString& FramePath)
+{
+    const FString BaseName = FPaths::GetBaseFilename(FramePath);
+
+    int32 DigitStart = BaseName.Len();
+    while (DigitStart > 0 && FChar::IsDigit(BaseName[DigitStart - 1]))
+    {
+        DigitStart--;
+    }
+
+    const int32 NumDigits = BaseName.Len() - DigitStart;
+    if (NumDigits == 0)
+        return FString();
+
+    return FPaths::GetPath(FramePath) / BaseName.Left(DigitStart) + FString::ChrN(NumDigits, TEXT('#')) + TEXT(".") + FPaths::GetExtension(FramePath);
+}
+
+bool FRefImageSequenceSource::IsPattern(const FString& Path)
+{
+    return FPaths::GetBaseFilename(Path).EndsWith(TEXT("#")) && !FPaths::FileExists(Path);
+}
+
+TSharedPtr<FRefImageSequenceSource, ESPMode::ThreadSafe> FRefImageSequenceSource::Open(const FString& Pattern)
+{
+    const FString Directory = FPaths::GetPath(Pattern);
+    const FString FileName = FPaths::GetCleanFilename(Pattern);
+
+    // The frame number is the run of '#' ending the base name; any earlier '#' is part of the name
+    const int32 HashEnd = FPaths::GetBaseFilename(FileName).Len() - 1;
+    if (HashEnd < 0 || FileName[HashEnd] != TEXT('#'))
+        return nullptr;
+
+    int32 HashStart = HashEnd;
+    while (HashStart > 0 && FileName[HashStart - 1] == TEXT('#'))
+    {
+        HashStart--;
+    }
+
+    const FString Prefix = FileName.Left(HashStart);
+    const FString Suffix = FileName.Mid(HashEnd + 1);
+
+    TArray<FString> Found;
+    IFileManager::Get().FindFiles(Found, *(Directory / (Prefix + TEXT("*") + Suffix)), true, false);
+
+    // Keep names whose middle is purely a frame number, ordered by that number
+    TArray<TPair<int64, FString>> Numbered;
+    for (const FString& Name : Found)
+    {
+        const FString Middle = Name.Mid(Prefix.Len(), Name.Len() - Prefix.Len() - Suffix.Len());
+        if (Middle.IsEmpty() || !Middle.IsNumeric() || Middle.Contains(TEXT(".")) || Middle.Contains(TEXT("-")))
+            continue;
+
+        Numbered.Emplace(FCString::Atoi64(*Middle), Directory / Name);
+    }
+    if (Numbered.Num() == 0)
+        return nullptr;
+
+    Numbered.Sort([](const TPair<int64, FString>& A, const TPair<int64, FString>& B) { return A.Key < B.Key; });
+
+    TSharedPtr<FRefImageSequenceSource, ESPMode::ThreadSafe> Source = MakeShared<FRefImageSequenceSource, ESPMode::ThreadSafe>();
+    for (const auto& Frame : Numbered)
+    {
+        Source->Files.Add(Frame.Value);
+    }
+
+    // Every frame must match the first one's size
+    TArray64<uint8> FirstFrame;
+    if (!FRefImageLoader::DecodeFile(Source->Files[0], FirstFrame, Source->Width, Source->Height))
+        return nullptr;
+
+    return Source;
+}
+
+bool FRefImageSequenceSource::DecodeFrame(int32 Frame, TArray64<uint8>& OutBGRA)
+{
+    if (!Files.IsValidIndex(Frame))
+        return false;
+
+    int32 FrameWidth = 0;
+    int32 FrameHeight = 0;
+    return FRefImageLoader::DecodeFile(Files[Frame], OutBGRA, FrameWidth, FrameHeight)
+        && FrameWidth == Width && FrameHeight == Height;
+}
+
+FRefAnimPlayer::FRefAnimPlayer(FRefFrameSourcePtr InSource)
+    : Source(InSource)
+    , NumFrames(InSource->GetNumFrames())
+    , Width(InSource->GetWidth())
+    , Height(InSource->GetHeight())
+    , AheadFrames(MinAheadFrames)
+    , Texture(nullptr)
+    , bPlaying(true)
+    , Accumulated(0.0f)
+    , DisplayedFrame(0)
+    , TargetFrame(0)
+    , NextDecodeFrame(1)
+    , bDecodeInFlight(false)
+    , Generation(0)
+{
+    // Ring size from the memory budget, never more than the whole sequence
+    const int64 FrameBytes = FMath::Max<int64>(1, (int64)Width * Height * 4);
+    AheadFrames = FMath::Clamp<int32>(MemoryBudget / FrameBytes, MinAheadFrames, MaxAheadFrames);
+    AheadFrames = FMath::Max(1, FMath::Min(AheadFrames, NumFrames - 1));
+}
+
+bool FRefAnimPlayer::Initialize()
+{
+    check(IsInGameThread());
+
+    if (NumFrames <= 0 || Width <= 0 || Height <= 0)
+        return false;
+
+    TArray64<uint8> FirstFrame;
+    if (!Source->DecodeFrame(0, FirstFrame))
+        return false;
+
+    Texture = FRefImageLoader::CreateTexture(FirstFrame.GetData(), Width, Height);
+    Proxy = FRefImageLoader::MakeProxy(FirstFrame.GetData(), Width, Height);
+    NextDecodeFrame = NumFrames > 1 ? 1 : 0;
+    return Texture != nullptr;
+}
+
+bool FRefAnimPlayer::Tick(float DeltaTime)
+{
+    if (!Texture || NumFrames <= 1)
+        return false;
+
+    // Only advance once the previous target is on screen, so slow decodes hold a frame instead of skipping ahead
+    if (bPlaying && TargetFrame == DisplayedFrame)
+    {
+        const float Duration = Source->GetFrameDuration(DisplayedFrame);
+        Accumulated += DeltaTime;
+        if (Accumulated >= Duration)
+        {
+            Accumulated = FMath::Min(Accumulated - Duration, Duration);
+            TargetFrame = (DisplayedFrame + 1) % NumFrames;
+        }
+    }
+
+    bool bUpdated = false;
+    if (TargetFrame != DisplayedFrame)
+    {
+        const int32 ReadyIndex = Ready.IndexOfByPredicate([this](const FReadyFrame& Entry) { return Entry.Frame == TargetFrame; });
+        if (ReadyIndex != INDEX_NONE)
+        {
+            Upload(Ready[ReadyIndex].Pixels);
+            Ready.RemoveAt(ReadyIndex);
+            DisplayedFrame = TargetFrame;
+            bUpdated = true;
+        }
+    }
+
+    KickDecode();
+    return bUpdated;
+}
+
+void FRefAnimPlayer::Seek(int32 Frame)
+{
+    if (NumFrames <= 0)
+        return;
+
+    Frame = ((Frame % NumFrames) + NumFrames) % NumFrames;
+    if (Frame == TargetFrame)
+        return;
+
+    // Anything decoded or decoding belongs to the old position
+    Generation++;
+    Ready.Reset();
+    TargetFrame = Frame;
+    NextDecodeFrame = Frame;
+    Accumulated = 0.0f;
+    KickDecode();
+}
+
+void FRefAnimPlayer::Step(int32 Delta)
+{
+    Pause();
+    Seek(TargetFrame + Delta);
+}
+
+FRefAnimPlayer::FFrameBuffer FRefAnimPlayer::AcquireBuffer()
+{
+    // A buffer is free once the ring, the worker and the render thread have all let go of it
+    for (const FFrameBuffer& Buffer : Buffers)
+    {
+        if (Buffer.GetSharedReferenceCount() == 1)
+            return Buffer;
+    }
+
+    // Ring plus one decoding plus one uploading
+    if (Buffers.Num() < AheadFrames + 2)
+    {
+        return Buffers.Add_GetRef(MakeShared<TArray64<uint8>, ESPMode::ThreadSafe>());
+    }
+    return nullptr;
+}
+
+void FRefAnimPlayer::KickDecode()
+{
+    if (bDecodeInFlight || Ready.Num() >= AheadFrames)
+        return;
+
+    // Next frame that is neither on screen nor already decoded
+    int32 Frame = NextDecodeFrame;
+    bool bFound = false;
+    for (int32 Attempt = 0; Attempt < NumFrames && !bFound; Attempt++)
+    {
+        const bool bAlreadyReady = Ready.ContainsByPredicate([Frame](const FReadyFrame& Entry) { return Entry.Frame == Frame; });
+        bFound = !bAlreadyReady && Frame != DisplayedFrame;
+        if (!bFound)
+        {
+            Frame = (Frame + 1) % NumFrames;
+        }
+    }
+    if (!bFound)
+        return;
+
+    FFrameBuffer Buffer = AcquireBuffer();
+    if (!Buffer.IsValid())
+        return;
+
+    bDecodeInFlight = true;
+    NextDecodeFrame = (Frame + 1) % NumFrames;
+
+    TWeakPtr<FRefAnimPlayer> WeakPlayer = AsShared();
+    FRefFrameSourcePtr DecodeSource = Source;
+    const uint32 DecodeGeneration = Generation;
+
+    Async(EAsyncExecution::ThreadPool, [WeakPlayer, DecodeSource, Buffer, Frame, DecodeGeneration]()
+    {
+        const bool bSuccess = DecodeSource->DecodeFrame(Frame, *Buffer);
+
+        AsyncTask(ENamedThreads::GameThread, [WeakPlayer, Buffer, Frame, DecodeGeneration, bSuccess]()
+        {
+            if (TSharedPtr<FRefAnimPlayer> Player = WeakPlayer.Pin())
+            {
+                Player->OnFrameDecoded(Frame, Buffer, DecodeGeneration, bSuccess);
+            }
+        });
+    });
+}
+
+void FRefAnimPlayer::OnFrameDecoded(int32 Frame, FFrameBuffer Pixels, uint32 InGeneration, bool bSuccess)
+{
+    bDecodeInFlight = false;
+
+    // Stale after a seek; the buffer goes back to the pool
+    if (InGeneration != Generation)
+        return;
+
+    // Unreadable frame: hold the current image and move past it rather than retrying forever
+    if (!bSuccess || Pixels->Num() != (int64)Width * Height * 4)
+    {
+        if (Frame == TargetFrame)
+        {
+            DisplayedFrame = TargetFrame;
+        }
+        return;
+    }
+
+    Ready.Add({ Frame, Pixels });
+}
+
+void FRefAnimPlayer::Upload(const FFrameBuffer& Pixels)
+{
+    // Render thread reads the buffer later; the cleanup callback's reference keeps it out of the pool until then
+    FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(0, 0, 0, 0, Width, Height);
+    FFrameBuffer Keep = Pixels;
+    Texture->UpdateTextureRegions(0, 1, Region, Width * 4, 4, Pixels->GetData(),
+        [Keep](uint8* SrcData, const FUpdateTextureRegion2D* Regions) mutable
+        {
+            delete Regions;
+            Keep.Reset();
+        });
+}
\ No newline at end of file
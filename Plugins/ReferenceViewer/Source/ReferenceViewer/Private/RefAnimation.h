@@ -0,0 +1,129 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+class UTexture2D;
+
+// Frames of an animated reference, decoded one at a time to BGRA8
+class FRefFrameSource
+{
+public:
+    virtual ~FRefFrameSource() {}
+
+    virtual int32 GetNumFrames() const = 0;
+    virtual int32 GetWidth() const = 0;
+    virtual int32 GetHeight() const = 0;
+
+    // Seconds the frame stays on screen
+    virtual float GetFrameDuration(int32 Frame) const = 0;
+
+    // Decodes one frame at GetWidth() x GetHeight(). Never called from two threads at once.
+    virtual bool DecodeFrame(int32 Frame, TArray64<uint8>& OutBGRA) = 0;
+};
+
+typedef TSharedPtr<FRefFrameSource, ESPMode::ThreadSafe> FRefFrameSourcePtr;
+
+// Numbered still images (walk_0001.png, walk_0002.png, ...) played at a fixed rate
+class FRefImageSequenceSource : public FRefFrameSource
+{
+public:
+    static constexpr float FramesPerSecond = 24.0f;
+
+    // Pattern for the sequence a numbered frame belongs to, with the digits replaced
+    // by '#' (walk_0001.png -> walk_####.png). Empty if the name has no trailing number.
+    static FString MakePattern(const FString& FramePath);
+
+    // True if the name ends in a run of '#' right before the extension, as MakePattern gives,
+    // and no file of that literal name exists
+    static bool IsPattern(const FString& Path);
+
+    // Finds every frame matching the pattern, in numeric order, and reads the frame size
+    static TSharedPtr<FRefImageSequenceSource, ESPMode::ThreadSafe> Open(const FString& Pattern);
+
+    virtual int32 GetNumFrames() const override { return Files.Num(); }
+    virtual int32 GetWidth() const override { return Width; }
+    virtual int32 GetHeight() const override { return Height; }
+    virtual float GetFrameDuration(int32 Frame) const override { return 1.0f / FramesPerSecond; }
+    virtual bool DecodeFrame(int32 Frame, TArray64<uint8>& OutBGRA) override;
+
+private:
+    TArray<FString> Files;
+    int32 Width = 0;
+    int32 Height = 0;
+};
+
+// Plays a frame source into one reused texture. Frames are decoded ahead on a
+// worker into a small ring whose size is capped by MemoryBudget, so memory stays
+// bounded for any sequence length. If decoding falls behind, the current frame
+// is held rather than blocking the game thread.
+class FRefAnimPlayer : public TSharedFromThis<FRefAnimPlayer>
+{
+public:
+    // Bytes of decoded frames kept ahead of playback
+    static constexpr int64 MemoryBudget = 64 * 1024 * 1024;
+    static constexpr int32 MinAheadFrames = 2;
+    static constexpr int32 MaxAheadFrames = 16;
+
+    explicit FRefAnimPlayer(FRefFrameSourcePtr InSource);
+
+    // Decodes the first frame and creates the texture. Game thread.
+    bool Initialize();
+
+    // Advances playback; returns true when a new frame was uploaded. Game thread.
+    bool Tick(float DeltaTime);
+
+    void Play() { bPlaying = true; }
+    void Pause() { bPlaying = false; }
+    void TogglePlay() { bPlaying = !bPlaying; }
+    bool IsPlaying() const { return bPlaying; }
+
+    // Jumps to a frame; shown as soon as it has been decoded
+    void Seek(int32 Frame);
+    void Step(int32 Delta);
+
+    int32 GetNumFrames() const { return NumFrames; }
+    int32 GetCurrentFrame() const { return TargetFrame; }
+
+    UTexture2D* GetTexture() const { return Texture; }
+
+    // Proxy of the first frame, for edges, the navigator and comparisons
+    FRefImageProxyPtr GetProxy() const { return Proxy; }
+
+private:
+    typedef TSharedPtr<TArray64<uint8>, ESPMode::ThreadSafe> FFrameBuffer;
+
+    struct FReadyFrame
+    {
+        int32 Frame;
+        FFrameBuffer Pixels;
+    };
+
+    FFrameBuffer AcquireBuffer();
+    void KickDecode();
+    void OnFrameDecoded(int32 Frame, FFrameBuffer Pixels, uint32 InGeneration, bool bSuccess);
+    void Upload(const FFrameBuffer& Pixels);
+
+    FRefFrameSourcePtr Source;
+    int32 NumFrames;
+    int32 Width;
+    int32 Height;
+    int32 AheadFrames;
+
+    UTexture2D* Texture;
+    FRefImageProxyPtr Proxy;
+
+    bool bPlaying;
+    float Accumulated;
+    int32 DisplayedFrame;
+    int32 TargetFrame;
+
+    // Decode-ahead ring
+    TArray<FReadyFrame> Ready;
+    TArray<FFrameBuffer> Buffers;
+    int32 NextDecodeFrame;
+    bool bDecodeInFlight;
+
+    // Bumped on seek so frames decoded for the old position are dropped
+    uint32 Generation;
+};
\ No newline at end of file
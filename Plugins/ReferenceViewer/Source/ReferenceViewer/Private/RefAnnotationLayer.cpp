@@ -0,0 +1,478 @@
+#include "RefAnnotationLayer.h"
+#include "Layout/Geometry.h"
+#include "Rendering/DrawElements.h"
+
+namespace
+{
+    // Strokes removed before the list is compacted
+    constexpr int32 MinRemovedToCompact = 64;
+
+    // Arrowhead wings, degrees off the stroke direction
+    constexpr float ArrowWingAngle = 155.0f;
+
+    FIntPoint ToCell(const FVector2D& Point)
+    {
+        return FIntPoint(
+            FMath::FloorToInt(Point.X / FRefAnnotationLayer::CellSize),
+            FMath::FloorToInt(Point.Y / FRefAnnotationLayer::CellSize));
+    }
+}
+
+void FRefAnnotationLayer::Simplify(TArray<FVector2D>& Points, float Tolerance)
+{
+    const int32 NumPoints = Points.Num();
+    if (NumPoints < 3)
+        return;
+
+    TBitArray<> Keep(false, NumPoints);
+    Keep[0] = true;
+    Keep[NumPoints - 1] = true;
+
+    // Spans still to split, iteratively so long strokes can't exhaust the stack
+    const double ToleranceSquared = (double)Tolerance * Tolerance;
+    TArray<TPair<int32, int32>, TInlineAllocator<64>> Spans;
+    Spans.Emplace(0, NumPoints - 1);
+    while (Spans.Num() > 0)
+    {
+        const TPair<int32, int32> Span = Spans.Pop(EAllowShrinking::No);
+        const FVector2D& Start = Points[Span.Key];
+        const FVector2D& End = Points[Span.Value];
+
+        int32 Farthest = INDEX_NONE;
+        double FarthestDistanceSquared = ToleranceSquared;
+        for (int32 Index = Span.Key + 1; Index < Span.Value; Index++)
+        {
+            const double DistanceSquared = FVector2D::DistSquared(Points[Index], FMath::ClosestPointOnSegment2D(Points[Index], Start, End));
+            if (DistanceSquared > FarthestDistanceSquared)
+            {
+                FarthestDistanceSquared = DistanceSquared;
+                Farthest = Index;
+            }
+        }
+
+        if (Farthest != INDEX_NONE)
+        {
+            Keep[Farthest] = true;
+            Spans.Emplace(Span.Key, Farthest);
+            Spans.Emplace(Farthest, Span.Value);
+        }
+    }
+
+    int32 NumKept = 0;
+    for (int32 Index = 0; Index < NumPoints; Index++)
+    {
+        if (Keep[Index])
+        {
+            Points[NumKept++] = Points[Index];
+        }
+    }
+    Points.SetNum(NumKept, EAllowShrinking::No);
+}
+
+FRefAnnotationLayer::FRefAnnotationLayer()
+    : NumRemoved(0)
+    , ActiveTolerance(1.0f)
+    , bDrawing(false)
+    , bActiveStraight(false)
+    , BatchBounds(ForceInit)
+    , bBatchesDirty(true)
+{
+}
+
+void FRefAnnotationLayer::AddStroke(const FRefStroke& Stroke)
+{
+    if (Stroke.Points.Num() < 2)
+        return;
+
+    RemoveStroke(Stroke.Id);
+
+    const int32 Index = Strokes.Add(Stroke);
+    if (!Strokes[Index].Id.IsValid())
+    {
+        Strokes[Index].Id = FGuid::NewGuid();
+    }
+    StrokeBounds.Add(Strokes[Index].GetBounds());
+    IndexById.Add(Strokes[Index].Id, Index);
+    AddToGrid(Index);
+    bBatchesDirty = true;
+}
+
+bool FRefAnnotationLayer::RemoveStroke(const FGuid& Id)
+{
+    int32 Index = INDEX_NONE;
+    if (!IndexById.RemoveAndCopyValue(Id, Index))
+        return false;
+
+    RemoveFromGrid(Index);
+    Strokes[Index].Id.Invalidate();
+    Strokes[Index].Points.Empty();
+    StrokeBounds[Index] = FBox2D(ForceInit);
+    NumRemoved++;
+    bBatchesDirty = true;
+
+    // Tombstones keep grid indices stable; drop them once they are most of the list
+    if (NumRemoved >= MinRemovedToCompact && NumRemoved * 2 > Strokes.Num())
+    {
+        Strokes.RemoveAll([](const FRefStroke& Stroke) { return !Stroke.Id.IsValid(); });
+        RebuildIndex();
+    }
+    return true;
+}
+
+void FRefAnnotationLayer::Reset(const TArray<FRefStroke>& InStrokes)
+{
+    Strokes.Reset();
+    for (const FRefStroke& Stroke : InStrokes)
+    {
+        if (Stroke.Points.Num() >= 2)
+        {
+            FRefStroke& Added = Strokes.Add_GetRef(Stroke);
+            if (!Added.Id.IsValid())
+            {
+                Added.Id = FGuid::NewGuid();
+            }
+        }
+    }
+    RebuildIndex();
+    bDrawing = false;
+}
+
+TArray<FRefStroke> FRefAnnotationLayer::GetStrokes() const
+{
+    TArray<FRefStroke> Result;
+    Result.Reserve(IndexById.Num());
+    for (const FRefStroke& Stroke : Strokes)
+    {
+        if (Stroke.Id.IsValid())
+        {
+            Result.Add(Stroke);
+        }
+    }
+    return Result;
+}
+
+void FRefAnnotationLayer::RebuildIndex()
+{
+    IndexById.Reset();
+    StrokeBounds.Reset(Strokes.Num());
+    Cells.Reset();
+    NumRemoved = 0;
+    for (int32 Index = 0; Index < Strokes.Num(); Index++)
+    {
+        IndexById.Add(Strokes[Index].Id, Index);
+        StrokeBounds.Add(Strokes[Index].GetBounds());
+        AddToGrid(Index);
+    }
+    bBatchesDirty = true;
+}
+
+void FRefAnnotationLayer::ForEachCell(const FRefStroke& Stroke, TFunctionRef<void(const FIntPoint&)> Visit) const
+{
+    // Per segment rather than per stroke, so a long curve doesn't claim every cell of its bounds
+    const float Pad = Stroke.bArrow ? Stroke.GetArrowHeadLength() : Stroke.Thickness * 0.5f;
+    for (int32 Index = 1; Index < Stroke.Points.Num(); Index++)
+    {
+        const FVector2D& A = Stroke.Points[Index - 1];
+        const FVector2D& B = Stroke.Points[Index];
+        const FIntPoint MinCell = ToCell(A.ComponentMin(B) - FVector2D(Pad));
+        const FIntPoint MaxCell = ToCell(A.ComponentMax(B) + FVector2D(Pad));
+        for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+        {
+            for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+            {
+                Visit(FIntPoint(X, Y));
+            }
+        }
+    }
+}
+
+void FRefAnnotationLayer::AddToGrid(int32 Index)
+{
+    ForEachCell(Strokes[Index], [this, Index](const FIntPoint& Cell)
+    {
+        // A stroke's entries are appended together, so a repeat can only be the last one
+        TArray<int32>& Members = Cells.FindOrAdd(Cell);
+        if (Members.Num() == 0 || Members.Last() != Index)
+        {
+            Members.Add(Index);
+        }
+    });
+}
+
+void FRefAnnotationLayer::RemoveFromGrid(int32 Index)
+{
+    ForEachCell(Strokes[Index], [this, Index](const FIntPoint& Cell)
+    {
+        if (TArray<int32>* Members = Cells.Find(Cell))
+        {
+            Members->RemoveSingleSwap(Index, EAllowShrinking::No);
+            if (Members->Num() == 0)
+            {
+                Cells.Remove(Cell);
+            }
+        }
+    });
+}
+
+void FRefAnnotationLayer::QueryIndices(const FBox2D& Rect, TArray<int32>& OutIndices) const
+{
+    OutIndices.Reset();
+    if (!Rect.bIsValid || IndexById.Num() == 0)
+        return;
+
+    const FIntPoint MinCell = ToCell(Rect.Min);
+    const FIntPoint MaxCell = ToCell(Rect.Max);
+
+    // A query wider than the board is cheaper as a scan
+    if ((int64)(MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1) > Cells.Num())
+    {
+        for (int32 Index = 0; Index < Strokes.Num(); Index++)
+        {
+            if (StrokeBounds[Index].bIsValid && StrokeBounds[Index].Intersect(Rect))
+            {
+                OutIndices.Add(Index);
+            }
+        }
+        return;
+    }
+
+    for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+    {
+        for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+        {
+            if (const TArray<int32>* Members = Cells.Find(FIntPoint(X, Y)))
+            {
+                OutIndices.Append(*Members);
+            }
+        }
+    }
+
+    // Drawing order, each stroke once
+    OutIndices.Sort();
+    int32 NumUnique = 0;
+    for (int32 Index = 0; Index < OutIndices.Num(); Index++)
+    {
+        const int32 StrokeIndex = OutIndices[Index];
+        if ((NumUnique == 0 || OutIndices[NumUnique - 1] != StrokeIndex) && StrokeBounds[StrokeIndex].Intersect(Rect))
+        {
+            OutIndices[NumUnique++] = StrokeIndex;
+        }
+    }
+    OutIndices.SetNum(NumUnique, EAllowShrinking::No);
+}
+
+void FRefAnnotationLayer::QueryStrokes(const FBox2D& Rect, TArray<const FRefStroke*>& OutStrokes) const
+{
+    TArray<int32> Indices;
+    QueryIndices(Rect, Indices);
+
+    OutStrokes.Reset(Indices.Num());
+    for (int32 Index : Indices)
+    {
+        OutStrokes.Add(&Strokes[Index]);
+    }
+}
+
+float FRefAnnotationLayer::DistanceToStroke(const FRefStroke& Stroke, const FVector2D& Point)
+{
+    double ClosestSquared = TNumericLimits<double>::Max();
+    for (int32 Index = 1; Index < Stroke.Points.Num(); Index++)
+    {
+        const FVector2D Closest = FMath::ClosestPointOnSegment2D(Point, Stroke.Points[Index - 1], Stroke.Points[Index]);
+        ClosestSquared = FMath::Min(ClosestSquared, FVector2D::DistSquared(Point, Closest));
+    }
+    return FMath::Sqrt(ClosestSquared) - Stroke.Thickness * 0.5f;
+}
+
+const FRefStroke* FRefAnnotationLayer::FindStrokeAt(const FVector2D& Point, float Radius) const
+{
+    TArray<int32> Indices;
+    QueryIndices(FBox2D(Point - FVector2D(Radius), Point + FVector2D(Radius)), Indices);
+
+    // Last drawn is on top
+    for (int32 Index = Indices.Num() - 1; Index >= 0; Index--)
+    {
+        const FRefStroke& Stroke = Strokes[Indices[Index]];
+        if (DistanceToStroke(Stroke, Point) <= Radius)
+        {
+            return &Stroke;
+        }
+    }
+    return nullptr;
+}
+
+void FRefAnnotationLayer::BeginStroke(const FVector2D& Point, const FLinearColor& Color, float Thickness, float Tolerance, bool bStraight, bool bArrow)
+{
+    Active = FRefStroke();
+    Active.Color = Color;
+    Active.Thickness = Thickness;
+    Active.bArrow = bArrow;
+    ActiveTail.Reset();
+    ActiveTail.Add(Point);
+    ActiveTolerance = Tolerance;
+    bActiveStraight = bStraight;
+    bDrawing = true;
+}
+
+void FRefAnnotationLayer::ExtendStroke(const FVector2D& Point)
+{
+    if (!bDrawing)
+        return;
+
+    if (bActiveStraight)
+    {
+        ActiveTail.SetNum(1);
+        ActiveTail.Add(Point);
+        return;
+    }
+
+    // Mouse events arrive far denser than the tolerance; most never become points
+    if (FVector2D::DistSquared(ActiveTail.Last(), Point) < FMath::Square(ActiveTolerance * 0.5f))
+        return;
+
+    ActiveTail.Add(Point);
+
+    // Settle all but the last kept point; the next batch starts from it so the joins stay exact
+    if (ActiveTail.Num() >= SimplifyBatch)
+    {
+        Simplify(ActiveTail, ActiveTolerance);
+        Active.Points.Append(ActiveTail.GetData(), ActiveTail.Num() - 1);
+        const FVector2D Last = ActiveTail.Last();
+        ActiveTail.Reset();
+        ActiveTail.Add(Last);
+    }
+}
+
+const FRefStroke* FRefAnnotationLayer::EndStroke()
+{
+    if (!bDrawing)
+        return nullptr;
+
+    bDrawing = false;
+    Active.Points.Append(ActiveTail);
+    ActiveTail.Reset();
+    Simplify(Active.Points, ActiveTolerance);
+
+    const FBox2D Extent(Active.Points);
+    if (Active.Points.Num() < 2 || Extent.GetSize().GetMax() < ActiveTolerance)
+        return nullptr;
+
+    Active.Id = FGuid::NewGuid();
+    AddStroke(Active);
+    return &Strokes.Last();
+}
+
+void FRefAnnotationLayer::AppendPolyline(const FRefStroke& Stroke, TArray<FVector2D>& OutPoints)
+{
+    if (Stroke.Points.Num() < 2)
+        return;
+
+    OutPoints.Append(Stroke.Points);
+
+    if (Stroke.bArrow)
+    {
+        const FVector2D& Tip = Stroke.Points.Last();
+        const FVector2D Direction = (Tip - Stroke.Points.Last(1)).GetSafeNormal();
+        const float HeadLength = Stroke.GetArrowHeadLength();
+        OutPoints.Add(Tip + Direction.GetRotated(ArrowWingAngle) * HeadLength);
+        OutPoints.Add(Tip);
+        OutPoints.Add(Tip + Direction.GetRotated(-ArrowWingAngle) * HeadLength);
+    }
+}
+
+void FRefAnnotationLayer::AppendStroke(FBatch& Batch, const FRefStroke& Stroke)
+{
+    if (Stroke.Points.Num() < 2)
+        return;
+
+    // Invisible bridge from the previous stroke, so both share one polyline
+    if (Batch.Points.Num() > 0)
+    {
+        Batch.Points.Add(Batch.Points.Last());
+        Batch.Colors.Add(FLinearColor::Transparent);
+        Batch.Points.Add(Stroke.Points[0]);
+        Batch.Colors.Add(FLinearColor::Transparent);
+    }
+
+    const int32 First = Batch.Points.Num();
+    AppendPolyline(Stroke, Batch.Points);
+    for (int32 Index = First; Index < Batch.Points.Num(); Index++)
+    {
+        Batch.Colors.Add(Stroke.Color);
+    }
+}
+
+void FRefAnnotationLayer::RebuildBatches(const FBox2D& Rect) const
+{
+    Batches.Reset();
+    BatchBounds = Rect;
+    bBatchesDirty = false;
+
+    TArray<int32> Indices;
+    QueryIndices(Rect, Indices);
+    for (int32 Index : Indices)
+    {
+        const FRefStroke& Stroke = Strokes[Index];
+        FBatch* Batch = Batches.FindByPredicate([&Stroke](const FBatch& Existing) { return Existing.Thickness == Stroke.Thickness; });
+        if (!Batch)
+        {
+            Batch = &Batches.AddDefaulted_GetRef();
+            Batch->Thickness = Stroke.Thickness;
+        }
+        AppendStroke(*Batch, Stroke);
+    }
+}
+
+void FRefAnnotationLayer::Draw(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId,
+    const FBox2D& ViewBounds, float ViewZoom, const FVector2D& ViewOffset) const
+{
+    // Batches cover a margin around the view, so panning and zooming in reuse them; zooming in
+    // far enough that most of the batch is off screen rebuilds it tighter
+    const FVector2D ViewSize = ViewBounds.GetSize();
+    const FVector2D BatchSize = BatchBounds.bIsValid ? BatchBounds.GetSize() : FVector2D::ZeroVector;
+    if (bBatchesDirty || !BatchBounds.bIsValid || !BatchBounds.IsInside(ViewBounds) || BatchSize.X * BatchSize.Y > 16.0 * ViewSize.X * ViewSize.Y)
+    {
+        RebuildBatches(ViewBounds.ExpandBy(ViewSize * 0.5));
+    }
+
+    auto DrawBatch = [&](const FBatch& Batch)
+    {
+        TArray<FVector2f> LocalPoints;
+        LocalPoints.SetNumUninitialized(Batch.Points.Num());
+        for (int32 Index = 0; Index < Batch.Points.Num(); Index++)
+        {
+            LocalPoints[Index] = FVector2f((Batch.Points[Index] + ViewOffset) * ViewZoom);
+        }
+
+        FSlateDrawElement::MakeLines(
+            OutDrawElements,
+            LayerId,
+            AllottedGeometry.ToPaintGeometry(),
+            MoveTemp(LocalPoints),
+            Batch.Colors,
+            ESlateDrawEffect::None,
+            FLinearColor::White,
+            true,
+            FMath::Max(1.0f, Batch.Thickness * ViewZoom)
+        );
+    };
+
+    for (const FBatch& Batch : Batches)
+    {
+        DrawBatch(Batch);
+    }
+
+    if (bDrawing)
+    {
+        FRefStroke Preview = Active;
+        Preview.Points.Append(ActiveTail);
+
+        FBatch PreviewBatch;
+        PreviewBatch.Thickness = Preview.Thickness;
+        AppendStroke(PreviewBatch, Preview);
+        if (PreviewBatch.Points.Num() > 0)
+        {
+            DrawBatch(PreviewBatch);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+class FSlateWindowElementList;
+struct FGeometry;
+
+// Vector annotations drawn over the board. Strokes are kept in canvas space and bucketed
+// in a uniform grid, so erasing and picking only test the strokes near the cursor however
+// many the board holds. Drawing merges the visible strokes of each width into one MakeLines
+// call; the gaps between strokes are bridged with transparent segments.
+class FRefAnnotationLayer
+{
+public:
+    // Grid cell side, in canvas units
+    static constexpr float CellSize = 256.0f;
+
+    // Raw points gathered while drawing before they are simplified and settled
+    static constexpr int32 SimplifyBatch = 32;
+
+    // Ramer-Douglas-Peucker: keeps the end points and every point further than
+    // Tolerance from the line through its kept neighbours
+    static void Simplify(TArray<FVector2D>& Points, float Tolerance);
+
+    // Appends the path a stroke is drawn along, arrow head included
+    static void AppendPolyline(const FRefStroke& Stroke, TArray<FVector2D>& OutPoints);
+
+    FRefAnnotationLayer();
+
+    // Strokes, in drawing order
+    void AddStroke(const FRefStroke& Stroke);
+    bool RemoveStroke(const FGuid& Id);
+    void Reset(const TArray<FRefStroke>& InStrokes = TArray<FRefStroke>());
+    TArray<FRefStroke> GetStrokes() const;
+    int32 Num() const { return IndexById.Num(); }
+
+    // Topmost stroke passing within Radius of Point, or null
+    const FRefStroke* FindStrokeAt(const FVector2D& Point, float Radius) const;
+
+    // Strokes whose bounds overlap Rect, in drawing order
+    void QueryStrokes(const FBox2D& Rect, TArray<const FRefStroke*>& OutStrokes) const;
+
+    // Stroke in progress. Tolerance is the simplification error allowed, in canvas units.
+    // A straight stroke keeps only its first point and the latest one.
+    void BeginStroke(const FVector2D& Point, const FLinearColor& Color, float Thickness, float Tolerance, bool bStraight, bool bArrow);
+    void ExtendStroke(const FVector2D& Point);
+    bool IsDrawing() const { return bDrawing; }
+
+    // Simplifies the rest of the stroke and adds it. Returns it, or null if it was a click.
+    const FRefStroke* EndStroke();
+
+    // ViewBounds is the visible board area; canvas space maps to the widget as (P + ViewOffset) * ViewZoom
+    void Draw(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId,
+        const FBox2D& ViewBounds, float ViewZoom, const FVector2D& ViewOffset) const;
+
+private:
+    // Visible strokes of one width, joined into a single polyline
+    struct FBatch
+    {
+        float Thickness = 1.0f;
+        TArray<FVector2D> Points;
+        TArray<FLinearColor> Colors;
+    };
+
+    void QueryIndices(const FBox2D& Rect, TArray<int32>& OutIndices) const;
+    void AddToGrid(int32 Index);
+    void RemoveFromGrid(int32 Index);
+    void RebuildIndex();
+    void RebuildBatches(const FBox2D& Rect) const;
+
+    // Calls Visit with every grid cell a segment of the stroke passes through
+    void ForEachCell(const FRefStroke& Stroke, TFunctionRef<void(const FIntPoint&)> Visit) const;
+
+    static void AppendStroke(FBatch& Batch, const FRefStroke& Stroke);
+    static float DistanceToStroke(const FRefStroke& Stroke, const FVector2D& Point);
+
+    // Removed strokes leave an invalid Id until the list is compacted
+    TArray<FRefStroke> Strokes;
+    TArray<FBox2D> StrokeBounds;
+    TMap<FGuid, int32> IndexById;
+    int32 NumRemoved;
+
+    TMap<FIntPoint, TArray<int32>> Cells;
+
+    // Stroke in progress: simplified points, then the raw tail since the last simplification
+    FRefStroke Active;
+    TArray<FVector2D> ActiveTail;
+    float ActiveTolerance;
+    bool bDrawing;
+    bool bActiveStraight;
+
+    // Canvas-space batches of the strokes around the view; rebuilt when strokes change or the view leaves BatchBounds
+    mutable TArray<FBatch> Batches;
+    mutable FBox2D BatchBounds;
+    mutable bool bBatchesDirty;
+};
\ No newline at end of file
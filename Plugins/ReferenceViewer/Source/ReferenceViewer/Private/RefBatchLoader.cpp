@@ -0,0 +1,78 @@
+#include "RefBatchLoader.h"
+#include "SReferenceCanvas.h"
+#include "RefImageLoader.h"
+#include "Async/Async.h"
+
+FRefBatchLoader::FRefBatchLoader(TSharedPtr<SReferenceCanvas> InCanvas, TArray<FRequest> InRequests)
+    : Canvas(InCanvas)
+    , Requests(MoveTemp(InRequests))
+    , NextRequest(0)
+    , NumInFlight(0)
+    , NumDone(0)
+{
+}
+
+void FRefBatchLoader::Start()
+{
+    PumpQueue();
+}
+
+void FRefBatchLoader::PumpQueue()
+{
+    while (NumInFlight < MaxConcurrentDecodes && NextRequest < Requests.Num())
+    {
+        const int32 Index = NextRequest++;
+        const FString FilePath = Requests[Index].FilePath;
+
+        // Removed from the board before its turn
+        if (!Requests[Index].Image.IsValid())
+        {
+            NumDone++;
+            continue;
+        }
+
+        NumInFlight++;
+        TWeakPtr<FRefBatchLoader> WeakLoader = AsShared();
+        Async(EAsyncExecution::ThreadPool, [WeakLoader, Index, FilePath]()
+        {
+            TSharedPtr<FLoadResult, ESPMode::ThreadSafe> Result = MakeShared<FLoadResult, ESPMode::ThreadSafe>();
+            if (FRefImageLoader::DecodeFile(FilePath, Result->BGRA, Result->Width, Result->Height))
+            {
+                Result->Proxy = FRefImageLoader::MakeProxy(Result->BGRA.GetData(), Result->Width, Result->Height);
+            }
+
+            AsyncTask(ENamedThreads::GameThread, [WeakLoader, Index, Result]()
+            {
+                if (TSharedPtr<FRefBatchLoader> Loader = WeakLoader.Pin())
+                {
+                    Loader->OnLoaded(Index, Result);
+                }
+            });
+        });
+    }
+}
+
+void FRefBatchLoader::OnLoaded(int32 Index, TSharedPtr<FLoadResult, ESPMode::ThreadSafe> Result)
+{
+    NumInFlight--;
+    NumDone++;
+
+    TSharedPtr<SReferenceCanvas> CanvasPtr = Canvas.Pin();
+    TSharedPtr<FRefImage> Image = Requests[Index].Image.Pin();
+    if (CanvasPtr.IsValid() && Image.IsValid() && Result->Proxy.IsValid() && CanvasPtr->GetImages().Contains(Image))
+    {
+        if (Requests[Index].bNativeSize)
+        {
+            FRefImageRecord Transform = Image->ToRecord();
+            Transform.Position = Image->GetCanvasPosition();
+            Transform.Size = FVector2D(Result->Width, Result->Height);
+            CanvasPtr->SetImageTransforms({ Transform });
+        }
+
+        Image->Proxy = Result->Proxy;
+        CanvasPtr->QueueImageUpload(Image, MoveTemp(Result->BGRA), Result->Width, Result->Height);
+        CanvasPtr->BuildEdgeMap(Image);
+    }
+
+    PumpQueue();
+}
\ No newline at end of file
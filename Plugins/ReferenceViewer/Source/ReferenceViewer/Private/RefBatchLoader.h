@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+class SReferenceCanvas;
+
+// Loads the pixels of images that are already placed on a board. Decodes run on
+// workers with a bounded number in flight, so a thousand-image batch never holds
+// more than a handful of full-size buffers at once.
+class FRefBatchLoader : public TSharedFromThis<FRefBatchLoader>
+{
+public:
+    static constexpr int32 MaxConcurrentDecodes = 8;
+
+    struct FRequest
+    {
+        TWeakPtr<FRefImage> Image;
+        FString FilePath;
+
+        // Resize to the file's pixel size once decoded, keeping the position
+        bool bNativeSize = false;
+    };
+
+    FRefBatchLoader(TSharedPtr<SReferenceCanvas> InCanvas, TArray<FRequest> InRequests);
+
+    void Start();
+
+    bool IsComplete() const { return NumDone == Requests.Num(); }
+    int32 GetNumRemaining() const { return Requests.Num() - NumDone; }
+    TSharedPtr<SReferenceCanvas> GetCanvas() const { return Canvas.Pin(); }
+
+private:
+    struct FLoadResult
+    {
+        TArray64<uint8> BGRA;
+        int32 Width = 0;
+        int32 Height = 0;
+        FRefImageProxyPtr Proxy;
+    };
+
+    void PumpQueue();
+    void OnLoaded(int32 Index, TSharedPtr<FLoadResult, ESPMode::ThreadSafe> Result);
+
+    TWeakPtr<SReferenceCanvas> Canvas;
+    TArray<FRequest> Requests;
+    int32 NextRequest;
+    int32 NumInFlight;
+    int32 NumDone;
+};
\ No newline at end of file
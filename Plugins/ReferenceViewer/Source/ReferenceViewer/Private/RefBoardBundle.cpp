@@ -0,0 +1,433 @@
+#include "RefBoardBundle.h"
+#include "RefLayoutFile.h"
+#include "RefImageLoader.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Engine/Texture2D.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopedSlowTask.h"
+
+#define LOCTEXT_NAMESPACE "FReferenceViewerModule"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRefBoardBundle, Log, All);
+
+namespace
+{
+    void PadTo(FArchive& Ar, int64 Alignment)
+    {
+        static const uint8 Zeros[4096] = {};
+        int64 Padding = Align(Ar.Tell(), Alignment) - Ar.Tell();
+        while (Padding > 0)
+        {
+            const int64 Chunk = FMath::Min<int64>(Padding, sizeof(Zeros));
+            Ar.Serialize(const_cast<uint8*>(Zeros), Chunk);
+            Padding -= Chunk;
+        }
+    }
+
+    // 2x2 box filter for BGRA8, clamping at odd edges
+    void DownsampleBGRA(const uint8* Src, int32 SrcWidth, int32 SrcHeight, uint8* Dest, int32 DestWidth, int32 DestHeight)
+    {
+        for (int32 Y = 0; Y < DestHeight; Y++)
+        {
+            const int32 Y0 = FMath::Min(Y * 2, SrcHeight - 1);
+            const int32 Y1 = FMath::Min(Y * 2 + 1, SrcHeight - 1);
+            for (int32 X = 0; X < DestWidth; X++)
+            {
+                const int32 X0 = FMath::Min(X * 2, SrcWidth - 1);
+                const int32 X1 = FMath::Min(X * 2 + 1, SrcWidth - 1);
+                const uint8* P00 = Src + ((int64)Y0 * SrcWidth + X0) * 4;
+                const uint8* P01 = Src + ((int64)Y0 * SrcWidth + X1) * 4;
+                const uint8* P10 = Src + ((int64)Y1 * SrcWidth + X0) * 4;
+                const uint8* P11 = Src + ((int64)Y1 * SrcWidth + X1) * 4;
+                uint8* Out = Dest + ((int64)Y * DestWidth + X) * 4;
+                for (int32 C = 0; C < 4; C++)
+                {
+                    Out[C] = (uint8)((P00[C] + P01[C] + P10[C] + P11[C] + 2) >> 2);
+                }
+            }
+        }
+    }
+
+    // Full chain down to 1x1, each level page aligned
+    void WriteMipChain(FArchive& Ar, const uint8* Source, int32 Width, int32 Height, FRefBoardBundle::FImageEntry& Entry,
+        TArray<uint8>& MipA, TArray<uint8>& MipB)
+    {
+        Entry.PixelFormat = PF_B8G8R8A8;
+
+        const uint8* Level = Source;
+        for (int32 Mip = 0; Mip < FRefBoardBundle::MaxMips; Mip++)
+        {
+            PadTo(Ar, FRefBoardBundle::DataAlignment);
+
+            FRefBoardBundle::FMipEntry& MipEntry = Entry.Mips[Mip];
+            MipEntry.Offset = Ar.Tell();
+            MipEntry.Size = (uint64)Width * Height * 4;
+            MipEntry.Width = Width;
+            MipEntry.Height = Height;
+            Ar.Serialize(const_cast<uint8*>(Level), MipEntry.Size);
+            Entry.NumMips = Mip + 1;
+
+            if (Width == 1 && Height == 1)
+                break;
+
+            const int32 NextWidth = FMath::Max(1, Width / 2);
+            const int32 NextHeight = FMath::Max(1, Height / 2);
+            TArray<uint8>& Next = (Level == MipA.GetData()) ? MipB : MipA;
+            Next.SetNumUninitialized(NextWidth * NextHeight * 4, EAllowShrinking::No);
+            DownsampleBGRA(Level, Width, Height, Next.GetData(), NextWidth, NextHeight);
+
+            Level = Next.GetData();
+            Width = NextWidth;
+            Height = NextHeight;
+        }
+    }
+}
+
+FRefBoardBundle::~FRefBoardBundle()
+{
+    Unmap();
+}
+
+bool FRefBoardBundle::Write(const FString& Path, const FReferenceLayout& Layout, const TArray<TSharedPtr<FRefImage>>& Images)
+{
+    // Bundle images keep only their resident mip in the texture, so their chain is copied from the
+    // bundle. Images not yet loaded, or showing a stand-in made from the proxy, are decoded from
+    // their file; the rest need pixels still resident on the CPU.
+    TArray<TSharedPtr<FRefImage>> Bundled;
+    TArray<FRefBoardBundle*> OpenAtPath;
+    for (const TSharedPtr<FRefImage>& Image : Images)
+    {
+        if (!Image.IsValid())
+            continue;
+
+        if (Image->Bundle.IsValid() && Image->BundleIndex != INDEX_NONE)
+        {
+            Bundled.Add(Image);
+            if (FPaths::IsSamePath(Image->Bundle->GetPath(), Path))
+            {
+                OpenAtPath.AddUnique(Image->Bundle.Get());
+            }
+        }
+        else if (Image->HdrSource.IsValid() && Image->HdrSource->Mips.Num() > 0)
+        {
+            Bundled.Add(Image);
+        }
+        else if (!Image->Texture || Image->bPreviewTexture)
+        {
+            if (!Image->FilePath.IsEmpty())
+            {
+                Bundled.Add(Image);
+            }
+        }
+        else if (Image->Texture && Image->Texture->GetPixelFormat() == PF_B8G8R8A8
+            && Image->Texture->GetPlatformData() && Image->Texture->GetPlatformData()->Mips.Num() > 0)
+        {
+            Bundled.Add(Image);
+        }
+    }
+
+    const FString TempPath = Path + TEXT(".tmp");
+    TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*TempPath));
+    if (!Ar.IsValid())
+        return false;
+
+    FScopedSlowTask SlowTask(Bundled.Num(), LOCTEXT("WritingBundle", "Writing reference board..."));
+    SlowTask.MakeDialogDelayed(0.5f);
+
+    FHeader Header = {};
+    Header.Magic = Magic;
+    Header.Version = Version;
+    Header.NumImages = Bundled.Num();
+    Ar->Serialize(&Header, sizeof(Header));
+
+    FString LayoutJson;
+    FRefLayoutFile::ToJson(Layout, LayoutJson);
+    FTCHARToUTF8 LayoutUtf8(*LayoutJson);
+    Header.LayoutOffset = Ar->Tell();
+    Header.LayoutSize = LayoutUtf8.Length();
+    Ar->Serialize(const_cast<ANSICHAR*>(LayoutUtf8.Get()), LayoutUtf8.Length());
+
+    PadTo(*Ar, 16);
+    Header.TableOffset = Ar->Tell();
+    TArray<FImageEntry> Table;
+    Table.SetNumZeroed(Bundled.Num());
+    Ar->Serialize(Table.GetData(), Table.Num() * sizeof(FImageEntry));
+
+    TArray<uint8> MipA, MipB;
+    TArray64<uint8> Tonemapped;
+    TArray64<uint8> Decoded;
+
+    // Crops sharing a texture, a bundled chain, a high bit-depth source or a file share one chain in the file too
+    TMap<const void*, int32> Written;
+    TMap<FString, int32> WrittenFiles;
+    for (int32 ImageIndex = 0; ImageIndex < Bundled.Num(); ImageIndex++)
+    {
+        SlowTask.EnterProgressFrame();
+
+        const FRefImage& Image = *Bundled[ImageIndex];
+        FImageEntry& Entry = Table[ImageIndex];
+        Entry.Id = Image.Id;
+
+        const bool bFromBundle = Image.Bundle.IsValid() && Image.BundleIndex != INDEX_NONE;
+        const bool bFromFile = !bFromBundle && !Image.HdrSource.IsValid() && (!Image.Texture || Image.bPreviewTexture);
+        if (bFromFile)
+        {
+            if (const int32* Shared = WrittenFiles.Find(Image.FilePath))
+            {
+                Entry.PixelFormat = Table[*Shared].PixelFormat;
+                Entry.NumMips = Table[*Shared].NumMips;
+                FMemory::Memcpy(Entry.Mips, Table[*Shared].Mips, sizeof(Entry.Mips));
+                continue;
+            }
+            WrittenFiles.Add(Image.FilePath, ImageIndex);
+
+            int32 Width = 0;
+            int32 Height = 0;
+            if (FRefImageLoader::DecodeFile(Image.FilePath, Decoded, Width, Height))
+            {
+                WriteMipChain(*Ar, Decoded.GetData(), Width, Height, Entry, MipA, MipB);
+            }
+            else
+            {
+                UE_LOG(LogRefBoardBundle, Warning, TEXT("Could not decode %s; it is left out of the bundle"), *Image.FilePath);
+            }
+            continue;
+        }
+
+        const void* PixelsKey = bFromBundle
+            ? static_cast<const void*>(Image.Bundle->MappedData + Image.Bundle->GetImage(Image.BundleIndex).Mips[0].Offset)
+            : Image.HdrSource.IsValid() ? static_cast<const void*>(Image.HdrSource.Get())
+            : static_cast<const void*>(Image.Texture);
+
+        if (const int32* Shared = Written.Find(PixelsKey))
+        {
+            Entry.PixelFormat = Table[*Shared].PixelFormat;
+            Entry.NumMips = Table[*Shared].NumMips;
+            FMemory::Memcpy(Entry.Mips, Table[*Shared].Mips, sizeof(Entry.Mips));
+            continue;
+        }
+        Written.Add(PixelsKey, ImageIndex);
+
+        if (bFromBundle)
+        {
+            Image.Bundle->CopyMips(*Ar, Image.BundleIndex, Entry);
+        }
+        else if (Image.HdrSource.IsValid())
+        {
+            // The texture holds a reduced mip; the full-size source is tonemapped as it is displayed
+            const FRefHdrImage::FMip& Full = Image.HdrSource->Mips[0];
+            FRefImageLoader::Tonemap(*Image.HdrSource, 0, Image.HdrExposure, Tonemapped);
+            WriteMipChain(*Ar, Tonemapped.GetData(), Full.Width, Full.Height, Entry, MipA, MipB);
+        }
+        else
+        {
+            FTexture2DMipMap& SourceMip = Image.Texture->GetPlatformData()->Mips[0];
+            const uint8* Source = static_cast<const uint8*>(SourceMip.BulkData.LockReadOnly());
+            if (Source)
+            {
+                WriteMipChain(*Ar, Source, SourceMip.SizeX, SourceMip.SizeY, Entry, MipA, MipB);
+            }
+            SourceMip.BulkData.Unlock();
+        }
+    }
+
+    // Patch header and table now that offsets are known
+    Ar->Seek(0);
+    Ar->Serialize(&Header, sizeof(Header));
+    Ar->Seek(Header.TableOffset);
+    Ar->Serialize(Table.GetData(), Table.Num() * sizeof(FImageEntry));
+
+    bool bSuccess = Ar->Close();
+    Ar.Reset();
+
+    // A mapped file can't be replaced on every platform, so an open bundle being overwritten lets go
+    // of it for the move and maps whichever file ends up at the path
+    for (FRefBoardBundle* Open : OpenAtPath)
+    {
+        Open->Unmap();
+    }
+
+    bSuccess = bSuccess && IFileManager::Get().Move(*Path, *TempPath, true, true);
+
+    for (FRefBoardBundle* Open : OpenAtPath)
+    {
+        Open->Map();
+    }
+    for (const TSharedPtr<FRefImage>& Image : Images)
+    {
+        if (Image.IsValid() && OpenAtPath.Contains(Image->Bundle.Get()))
+        {
+            Image->BundleIndex = Image->Bundle->FindImage(Image->Id);
+        }
+    }
+
+    return bSuccess;
+}
+
+TSharedPtr<FRefBoardBundle> FRefBoardBundle::Open(const FString& Path)
+{
+    TSharedPtr<FRefBoardBundle> Bundle = MakeShareable(new FRefBoardBundle());
+    Bundle->Path = Path;
+    if (!Bundle->Map())
+        return nullptr;
+
+    return Bundle;
+}
+
+bool FRefBoardBundle::Map()
+{
+    Unmap();
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    FOpenMappedResult MappedResult = PlatformFile.OpenMappedEx(*Path);
+    if (MappedResult.HasError())
+        return false;
+
+    MappedFile = MappedResult.StealValue();
+    MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+    if (!MappedRegion.IsValid())
+    {
+        Unmap();
+        return false;
+    }
+
+    MappedData = MappedRegion->GetMappedPtr();
+    MappedSize = MappedRegion->GetMappedSize();
+
+    const FHeader* Header = MappedSize >= (int64)sizeof(FHeader) ? reinterpret_cast<const FHeader*>(MappedData) : nullptr;
+    const uint64 TableEnd = Header ? Header->TableOffset + (uint64)Header->NumImages * sizeof(FImageEntry) : 0;
+    if (!Header || Header->Magic != Magic || Header->Version != Version
+        || Header->LayoutOffset + Header->LayoutSize > (uint64)MappedSize
+        || TableEnd > (uint64)MappedSize)
+    {
+        Unmap();
+        return false;
+    }
+
+    FUTF8ToTCHAR LayoutJson(reinterpret_cast<const ANSICHAR*>(MappedData + Header->LayoutOffset), Header->LayoutSize);
+    Layout = FReferenceLayout();
+    if (!FRefLayoutFile::FromJson(FString(LayoutJson.Length(), LayoutJson.Get()), Layout))
+    {
+        Unmap();
+        return false;
+    }
+
+    // Entries are read in place from the mapping
+    const FImageEntry* Table = reinterpret_cast<const FImageEntry*>(MappedData + Header->TableOffset);
+    for (uint32 i = 0; i < Header->NumImages; i++)
+    {
+        const FImageEntry& Entry = Table[i];
+        bool bValid = Entry.NumMips > 0 && Entry.NumMips <= (uint32)MaxMips;
+        for (uint32 Mip = 0; bValid && Mip < Entry.NumMips; Mip++)
+        {
+            bValid = Entry.Mips[Mip].Offset + Entry.Mips[Mip].Size <= (uint64)MappedSize;
+        }
+
+        if (bValid)
+        {
+            IndexById.Add(Entry.Id, Entries.Add(&Entry));
+        }
+    }
+
+    return true;
+}
+
+void FRefBoardBundle::Unmap()
+{
+    Entries.Reset();
+    IndexById.Reset();
+    MappedData = nullptr;
+    MappedSize = 0;
+
+    // Region must go before the file handle it was mapped from
+    MappedRegion.Reset();
+    MappedFile.Reset();
+}
+
+void FRefBoardBundle::CopyMips(FArchive& Ar, int32 Index, FImageEntry& OutEntry) const
+{
+    const FImageEntry& Source = *Entries[Index];
+    OutEntry.PixelFormat = Source.PixelFormat;
+    OutEntry.NumMips = Source.NumMips;
+    for (uint32 Mip = 0; Mip < Source.NumMips; Mip++)
+    {
+        PadTo(Ar, DataAlignment);
+
+        FMipEntry& MipEntry = OutEntry.Mips[Mip];
+        MipEntry = Source.Mips[Mip];
+        MipEntry.Offset = Ar.Tell();
+        Ar.Serialize(const_cast<uint8*>(MappedData + Source.Mips[Mip].Offset), Source.Mips[Mip].Size);
+    }
+}
+
+int32 FRefBoardBundle::FindImage(const FGuid& Id) const
+{
+    const int32* Index = IndexById.Find(Id);
+    return Index ? *Index : INDEX_NONE;
+}
+
+int32 FRefBoardBundle::SelectMip(int32 Index, const FVector2D& DisplaySize) const
+{
+    const FImageEntry& Entry = *Entries[Index];
+    for (int32 Mip = Entry.NumMips - 1; Mip > 0; Mip--)
+    {
+        if (Entry.Mips[Mip].Width >= DisplaySize.X && Entry.Mips[Mip].Height >= DisplaySize.Y)
+        {
+            return Mip;
+        }
+    }
+    return 0;
+}
+
+const uint8* FRefBoardBundle::GetMipData(int32 Index, int32 Mip) const
+{
+    const FImageEntry& Entry = *Entries[Index];
+    if (Mip < 0 || Mip >= (int32)Entry.NumMips || Entry.PixelFormat != PF_B8G8R8A8)
+        return nullptr;
+
+    const FMipEntry& MipEntry = Entry.Mips[Mip];
+    if (MipEntry.Size < (uint64)MipEntry.Width * MipEntry.Height * 4)
+        return nullptr;
+
+    return MappedData + MipEntry.Offset;
+}
+
+FRefImageProxyPtr FRefBoardBundle::MakeProxy(int32 Index) const
+{
+    const FImageEntry& Entry = *Entries[Index];
+    int32 Mip = 0;
+    while (Mip + 1 < (int32)Entry.NumMips
+        && FMath::Max(Entry.Mips[Mip + 1].Width, Entry.Mips[Mip + 1].Height) >= (uint32)FRefImageLoader::ProxyMaxDimension)
+    {
+        Mip++;
+    }
+
+    return FRefImageLoader::MakeProxy(GetMipData(Index, Mip), Entry.Mips[Mip].Width, Entry.Mips[Mip].Height);
+}
+
+UTexture2D* FRefBoardBundle::CreateTexture(int32 Index, int32 Mip) const
+{
+    check(IsInGameThread());
+
+    const FImageEntry& Entry = *Entries[Index];
+    if (Mip < 0 || Mip >= (int32)Entry.NumMips)
+        return nullptr;
+
+    const FMipEntry& MipEntry = Entry.Mips[Mip];
+    UTexture2D* Texture = UTexture2D::CreateTransient(MipEntry.Width, MipEntry.Height, (EPixelFormat)Entry.PixelFormat);
+    if (!Texture)
+        return nullptr;
+
+    // No decode: the mapped bytes are already in GPU layout
+    FByteBulkData& BulkData = Texture->GetPlatformData()->Mips[0].BulkData;
+    void* Dest = BulkData.Lock(LOCK_READ_WRITE);
+    FMemory::Memcpy(Dest, MappedData + MipEntry.Offset, FMath::Min<int64>(MipEntry.Size, BulkData.GetBulkDataSize()));
+    BulkData.Unlock();
+    Texture->UpdateResource();
+
+    return Texture;
+}
+
+#undef LOCTEXT_NAMESPACE
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+class UTexture2D;
+
+// Self-contained board file (.refboard): layout JSON plus every image as a
+// ready-to-upload mip chain. Pixel data is page aligned so an opened bundle is
+// simply memory mapped and mips are uploaded straight from the mapping.
+//
+// File layout (little endian):
+//   FHeader | layout JSON (UTF-8) | FImageEntry[NumImages] | mip data, each mip DataAlignment aligned
+class FRefBoardBundle
+{
+public:
+    static constexpr uint32 Magic = 0x31425652; // "RVB1"
+    static constexpr uint32 Version = 1;
+    static constexpr int32 MaxMips = 16;
+    static constexpr int64 DataAlignment = 4096;
+
+    // Display size of the mip an image starts from when a bundle is opened
+    static constexpr int32 ThumbnailSize = 64;
+
+    struct FHeader
+    {
+        uint32 Magic;
+        uint32 Version;
+        uint32 NumImages;
+        uint32 Reserved;
+        uint64 LayoutOffset;
+        uint64 LayoutSize;
+        uint64 TableOffset;
+    };
+
+    struct FMipEntry
+    {
+        uint64 Offset;
+        uint64 Size;
+        uint32 Width;
+        uint32 Height;
+    };
+
+    struct FImageEntry
+    {
+        FGuid Id;
+        // EPixelFormat; B8G8R8A8 or a block-compressed format
+        uint32 PixelFormat;
+        uint32 NumMips;
+        FMipEntry Mips[MaxMips];
+    };
+
+    ~FRefBoardBundle();
+
+    // Writes the layout and the mip chains of all loaded images. Images opened from a bundle have their
+    // chains copied from it as they are. If Path is a bundle these images have open, it is unmapped for
+    // the replace and mapped again after, and their BundleIndex updated to the new file.
+    static bool Write(const FString& Path, const FReferenceLayout& Layout, const TArray<TSharedPtr<FRefImage>>& Images);
+
+    // Maps the bundle; no pixel data is touched until a mip is requested
+    static TSharedPtr<FRefBoardBundle> Open(const FString& Path);
+
+    const FString& GetPath() const { return Path; }
+    const FReferenceLayout& GetLayout() const { return Layout; }
+    int32 FindImage(const FGuid& Id) const;
+    const FImageEntry& GetImage(int32 Index) const { return *Entries[Index]; }
+
+    // Smallest mip that still covers DisplaySize pixels
+    int32 SelectMip(int32 Index, const FVector2D& DisplaySize) const;
+
+    // Crops of one sheet are written once and point at the same mip chain
+    bool SharesPixels(int32 IndexA, int32 IndexB) const { return Entries[IndexA]->Mips[0].Offset == Entries[IndexB]->Mips[0].Offset; }
+
+    // Mapped BGRA pixels of a mip, or null if it is out of range or block compressed. Any thread.
+    const uint8* GetMipData(int32 Index, int32 Mip) const;
+
+    // Proxy of the whole image from the smallest mip at or above the proxy size, or null if block compressed
+    FRefImageProxyPtr MakeProxy(int32 Index) const;
+
+    // Transient texture filled directly from the mapped mip. Game thread only.
+    UTexture2D* CreateTexture(int32 Index, int32 Mip) const;
+
+private:
+    FRefBoardBundle() = default;
+
+    // Maps Path and reads the layout and image table; false leaves the bundle unmapped
+    bool Map();
+    void Unmap();
+
+    // Appends the image's chain from this bundle to Ar, pointing Entry at the copy
+    void CopyMips(FArchive& Ar, int32 Index, FImageEntry& OutEntry) const;
+
+    FString Path;
+    FReferenceLayout Layout;
+    TUniquePtr<IMappedFileHandle> MappedFile;
+    TUniquePtr<IMappedFileRegion> MappedRegion;
+    const uint8* MappedData = nullptr;
+    int64 MappedSize = 0;
+    TArray<const FImageEntry*> Entries;
+    TMap<FGuid, int32> IndexById;
+};
\ No newline at end of file
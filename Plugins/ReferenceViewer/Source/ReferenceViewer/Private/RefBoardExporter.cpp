@@ -0,0 +1,850 @@
+#include "RefBoardExporter.h"
+#include "RefBoardBundle.h"
+#include "RefImageLoader.h"
+#include "RefAnnotationLayer.h"
+#include "HAL/FileManager.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Texture2D.h"
+#include "ImageCore.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopedSlowTask.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+#define LOCTEXT_NAMESPACE "FReferenceViewerModule"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRefBoardExport, Log, All);
+
+namespace
+{
+    // Longest side an image is resampled to before compositing; larger draws are magnified from it.
+    // An image keeps its pixels for every band it crosses, so this bounds it to 256 MB.
+    constexpr int32 MaxSourceDimension = 8192;
+
+    // Raw PNG scanline bytes deflated per worker
+    constexpr int32 PngChunkBytes = 256 * 1024;
+
+    // Group state resolved through the parent chain
+    struct FExportGroup
+    {
+        FVector2D CanvasOffset = FVector2D::ZeroVector;
+        float Opacity = 1.0f;
+        bool bVisible = true;
+    };
+
+    // An image as it lands in the output
+    struct FExportImage
+    {
+        const FRefImageRecord* Record = nullptr;
+
+        // Output pixel space
+        FBox2D PixelRect;
+        float Opacity = 1.0f;
+
+        // Bands the image touches; its pixels live from the first to the last
+        int32 FirstBand = 0;
+        int32 LastBand = 0;
+
+        // Resampled to about the drawn size, within MaxSourceDimension, and cropped to the record's UV region
+        FRefImageProxyPtr Pixels;
+    };
+
+    // Full-size pixels of an image on their way to becoming a proxy
+    struct FExportSource
+    {
+        const uint8* BGRA = nullptr;
+        int32 Width = 0;
+        int32 Height = 0;
+        TArray64<uint8> Decoded;
+    };
+
+    // Premultiplied, sRGB-encoded rows in; the file out, band by band
+    class FExportWriter
+    {
+    public:
+        virtual ~FExportWriter() = default;
+        virtual bool Begin(FArchive& Ar, int32 Width, int32 Height) = 0;
+        virtual bool WriteRows(FArchive& Ar, const FLinearColor* Pixels, int32 NumRows) = 0;
+        virtual bool End(FArchive& Ar) = 0;
+    };
+
+    void WriteBigEndian(TArray<uint8>& Bytes, uint32 Value)
+    {
+        Bytes.Add((uint8)(Value >> 24));
+        Bytes.Add((uint8)(Value >> 16));
+        Bytes.Add((uint8)(Value >> 8));
+        Bytes.Add((uint8)Value);
+    }
+
+    // 8-bit RGBA PNG. Every chunk of rows is filtered and deflated on its own worker into a raw
+    // deflate stream ending on a byte boundary (Z_SYNC_FLUSH), so the pieces concatenate into one
+    // zlib stream; their Adler-32s are combined instead of re-read.
+    class FPngWriter : public FExportWriter
+    {
+    public:
+        virtual bool Begin(FArchive& Ar, int32 InWidth, int32 InHeight) override
+        {
+            Width = InWidth;
+            Adler = adler32(0, Z_NULL, 0);
+
+            static const uint8 Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+            Ar.Serialize(const_cast<uint8*>(Signature), sizeof(Signature));
+
+            TArray<uint8> Header;
+            WriteBigEndian(Header, InWidth);
+            WriteBigEndian(Header, InHeight);
+            Header.Add(8);  // Bit depth
+            Header.Add(6);  // RGBA
+            Header.Add(0);  // Deflate
+            Header.Add(0);  // Adaptive filtering
+            Header.Add(0);  // No interlace
+            WriteChunk(Ar, "IHDR", Header.GetData(), Header.Num());
+
+            // zlib header: deflate, 32K window, no dictionary
+            Pending.Add(0x78);
+            Pending.Add(0x01);
+            return !Ar.IsError();
+        }
+
+        virtual bool WriteRows(FArchive& Ar, const FLinearColor* Pixels, int32 NumRows) override
+        {
+            const int64 RowBytes = 1 + (int64)Width * 4;
+            const int32 RowsPerChunk = FMath::Clamp((int32)(PngChunkBytes / RowBytes), 1, NumRows);
+            const int32 NumChunks = FMath::DivideAndRoundUp(NumRows, RowsPerChunk);
+
+            TArray<TArray<uint8>> Compressed;
+            TArray<uLong> ChunkAdlers;
+            TArray<int64> ChunkSizes;
+            Compressed.SetNum(NumChunks);
+            ChunkAdlers.SetNumZeroed(NumChunks);
+            ChunkSizes.SetNumZeroed(NumChunks);
+            TAtomic<bool> bFailed(false);
+
+            ParallelFor(NumChunks, [&](int32 Chunk)
+            {
+                const int32 FirstRow = Chunk * RowsPerChunk;
+                const int32 ChunkRows = FMath::Min(RowsPerChunk, NumRows - FirstRow);
+
+                // Straight alpha, Sub filter: each byte minus the same channel one pixel left
+                TArray<uint8> Raw;
+                Raw.SetNumUninitialized((int32)(ChunkRows * RowBytes));
+                for (int32 Row = 0; Row < ChunkRows; Row++)
+                {
+                    uint8* Dest = Raw.GetData() + Row * RowBytes;
+                    const FLinearColor* Src = Pixels + (int64)(FirstRow + Row) * Width;
+                    *Dest++ = 1;
+
+                    uint8 Previous[4] = { 0, 0, 0, 0 };
+                    for (int32 X = 0; X < Width; X++, Dest += 4)
+                    {
+                        const FLinearColor& Pixel = Src[X];
+                        const float Unpremultiply = Pixel.A > 0.0f ? 1.0f / Pixel.A : 0.0f;
+                        const uint8 Current[4] = {
+                            (uint8)FMath::Clamp(FMath::RoundToInt(Pixel.R * Unpremultiply * 255.0f), 0, 255),
+                            (uint8)FMath::Clamp(FMath::RoundToInt(Pixel.G * Unpremultiply * 255.0f), 0, 255),
+                            (uint8)FMath::Clamp(FMath::RoundToInt(Pixel.B * Unpremultiply * 255.0f), 0, 255),
+                            (uint8)FMath::Clamp(FMath::RoundToInt(Pixel.A * 255.0f), 0, 255)
+                        };
+                        for (int32 C = 0; C < 4; C++)
+                        {
+                            Dest[C] = Current[C] - Previous[C];
+                            Previous[C] = Current[C];
+                        }
+                    }
+                }
+
+                ChunkAdlers[Chunk] = adler32(adler32(0, Z_NULL, 0), Raw.GetData(), Raw.Num());
+                ChunkSizes[Chunk] = Raw.Num();
+
+                z_stream Stream;
+                FMemory::Memzero(Stream);
+                if (deflateInit2(&Stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                {
+                    bFailed = true;
+                    return;
+                }
+
+                // The bound covers a finished stream; the sync marker needs a few bytes more
+                TArray<uint8>& Out = Compressed[Chunk];
+                Out.SetNumUninitialized((int32)deflateBound(&Stream, Raw.Num()) + 16);
+                Stream.next_in = Raw.GetData();
+                Stream.avail_in = Raw.Num();
+                Stream.next_out = Out.GetData();
+                Stream.avail_out = Out.Num();
+
+                const int32 Result = deflate(&Stream, Z_SYNC_FLUSH);
+                if (Result != Z_OK || Stream.avail_in != 0 || Stream.avail_out == 0)
+                {
+                    bFailed = true;
+                }
+                Out.SetNum(Out.Num() - Stream.avail_out, EAllowShrinking::No);
+                deflateEnd(&Stream);
+            });
+
+            if (bFailed)
+                return false;
+
+            for (int32 Chunk = 0; Chunk < NumChunks; Chunk++)
+            {
+                Adler = adler32_combine(Adler, ChunkAdlers[Chunk], ChunkSizes[Chunk]);
+                Pending.Append(Compressed[Chunk]);
+            }
+
+            WriteChunk(Ar, "IDAT", Pending.GetData(), Pending.Num());
+            Pending.Reset();
+            return !Ar.IsError();
+        }
+
+        virtual bool End(FArchive& Ar) override
+        {
+            // Empty final block closes the deflate stream, then the checksum of all the rows
+            Pending.Add(0x03);
+            Pending.Add(0x00);
+            WriteBigEndian(Pending, Adler);
+            WriteChunk(Ar, "IDAT", Pending.GetData(), Pending.Num());
+            WriteChunk(Ar, "IEND", nullptr, 0);
+            return !Ar.IsError();
+        }
+
+    private:
+        static void WriteChunk(FArchive& Ar, const char* Type, const uint8* Data, int32 Size)
+        {
+            TArray<uint8> Header;
+            WriteBigEndian(Header, Size);
+            Header.Append(reinterpret_cast<const uint8*>(Type), 4);
+            Ar.Serialize(Header.GetData(), Header.Num());
+
+            uLong Crc = crc32(0, Z_NULL, 0);
+            Crc = crc32(Crc, reinterpret_cast<const Bytef*>(Type), 4);
+            if (Size > 0)
+            {
+                Ar.Serialize(const_cast<uint8*>(Data), Size);
+                Crc = crc32(Crc, Data, Size);
+            }
+
+            TArray<uint8> Footer;
+            WriteBigEndian(Footer, Crc);
+            Ar.Serialize(Footer.GetData(), Footer.Num());
+        }
+
+        int32 Width = 0;
+        uLong Adler = 0;
+        TArray<uint8> Pending;
+    };
+
+    float SRGBToLinear(float Value)
+    {
+        Value = FMath::Clamp(Value, 0.0f, 1.0f);
+        return Value <= 0.04045f ? Value / 12.92f : FMath::Pow((Value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    // Uncompressed scanline OpenEXR, half-float linear RGBA with premultiplied alpha. Every
+    // scanline block has the same size, so the offset table is written up front and the
+    // blocks follow as the bands come in.
+    class FExrWriter : public FExportWriter
+    {
+    public:
+        virtual bool Begin(FArchive& Ar, int32 InWidth, int32 InHeight) override
+        {
+            Width = InWidth;
+            NextRow = 0;
+
+            TArray<uint8> Header;
+            auto AddInt = [&Header](int32 Value) { Header.Append(reinterpret_cast<const uint8*>(&Value), sizeof(Value)); };
+            auto AddFloat = [&Header](float Value) { Header.Append(reinterpret_cast<const uint8*>(&Value), sizeof(Value)); };
+            auto AddString = [&Header](const char* Value) { Header.Append(reinterpret_cast<const uint8*>(Value), FCStringAnsi::Strlen(Value) + 1); };
+            auto AddAttribute = [&](const char* Name, const char* Type, int32 Size)
+            {
+                AddString(Name);
+                AddString(Type);
+                AddInt(Size);
+            };
+
+            AddInt(20000630);  // Magic
+            AddInt(2);         // Version 2, single-part scanline
+
+            // Channels are stored in alphabetical order
+            AddAttribute("channels", "chlist", 4 * 18 + 1);
+            for (const char* Channel : { "A", "B", "G", "R" })
+            {
+                AddString(Channel);
+                AddInt(1);  // HALF
+                AddInt(0);  // pLinear and reserved
+                AddInt(1);  // X sampling
+                AddInt(1);  // Y sampling
+            }
+            Header.Add(0);
+
+            AddAttribute("compression", "compression", 1);
+            Header.Add(0);  // None
+
+            for (const char* Window : { "dataWindow", "displayWindow" })
+            {
+                AddAttribute(Window, "box2i", 16);
+                AddInt(0);
+                AddInt(0);
+                AddInt(InWidth - 1);
+                AddInt(InHeight - 1);
+            }
+
+            AddAttribute("lineOrder", "lineOrder", 1);
+            Header.Add(0);  // Increasing Y
+
+            AddAttribute("pixelAspectRatio", "float", 4);
+            AddFloat(1.0f);
+
+            AddAttribute("screenWindowCenter", "v2f", 8);
+            AddFloat(0.0f);
+            AddFloat(0.0f);
+
+            AddAttribute("screenWindowWidth", "float", 4);
+            AddFloat(1.0f);
+
+            Header.Add(0);
+
+            const int64 BlockSize = 8 + (int64)InWidth * 4 * sizeof(uint16);
+            const int64 FirstBlock = Header.Num() + (int64)InHeight * sizeof(uint64);
+            for (int32 Y = 0; Y < InHeight; Y++)
+            {
+                const uint64 Offset = FirstBlock + Y * BlockSize;
+                Header.Append(reinterpret_cast<const uint8*>(&Offset), sizeof(Offset));
+            }
+
+            Ar.Serialize(Header.GetData(), Header.Num());
+            return !Ar.IsError();
+        }
+
+        virtual bool WriteRows(FArchive& Ar, const FLinearColor* Pixels, int32 NumRows) override
+        {
+            const int64 BlockSize = 8 + (int64)Width * 4 * sizeof(uint16);
+            TArray64<uint8> Blocks;
+            Blocks.SetNumUninitialized(BlockSize * NumRows);
+
+            ParallelFor(NumRows, [&](int32 Row)
+            {
+                uint8* Block = Blocks.GetData() + Row * BlockSize;
+                const int32 Y = NextRow + Row;
+                const int32 DataSize = Width * 4 * sizeof(uint16);
+                FMemory::Memcpy(Block, &Y, sizeof(Y));
+                FMemory::Memcpy(Block + 4, &DataSize, sizeof(DataSize));
+
+                // Planar: all of A, then B, G and R
+                uint16* Planes = reinterpret_cast<uint16*>(Block + 8);
+                const FLinearColor* Src = Pixels + (int64)Row * Width;
+                for (int32 X = 0; X < Width; X++)
+                {
+                    const FLinearColor& Pixel = Src[X];
+
+                    // Linearise the straight colour, then premultiply again
+                    const float Unpremultiply = Pixel.A > 0.0f ? 1.0f / Pixel.A : 0.0f;
+                    Planes[X] = FFloat16(Pixel.A).Encoded;
+                    Planes[Width + X] = FFloat16(SRGBToLinear(Pixel.B * Unpremultiply) * Pixel.A).Encoded;
+                    Planes[2 * Width + X] = FFloat16(SRGBToLinear(Pixel.G * Unpremultiply) * Pixel.A).Encoded;
+                    Planes[3 * Width + X] = FFloat16(SRGBToLinear(Pixel.R * Unpremultiply) * Pixel.A).Encoded;
+                }
+            });
+
+            NextRow += NumRows;
+            Ar.Serialize(Blocks.GetData(), Blocks.Num());
+            return !Ar.IsError();
+        }
+
+        virtual bool End(FArchive& Ar) override
+        {
+            return !Ar.IsError();
+        }
+
+    private:
+        int32 Width = 0;
+        int32 NextRow = 0;
+    };
+
+    FLinearColor SampleBilinear(const FRefImageProxy& Proxy, float X, float Y)
+    {
+        X = FMath::Clamp(X, 0.0f, (float)(Proxy.Width - 1));
+        Y = FMath::Clamp(Y, 0.0f, (float)(Proxy.Height - 1));
+        const int32 X0 = (int32)X;
+        const int32 Y0 = (int32)Y;
+        const int32 X1 = FMath::Min(X0 + 1, Proxy.Width - 1);
+        const int32 Y1 = FMath::Min(Y0 + 1, Proxy.Height - 1);
+        const float FracX = X - X0;
+        const float FracY = Y - Y0;
+
+        const uint8* Pixels = Proxy.BGRA.GetData();
+        auto Fetch = [&](int32 PX, int32 PY)
+        {
+            const uint8* P = Pixels + ((int64)PY * Proxy.Width + PX) * 4;
+            return FLinearColor(P[2], P[1], P[0], P[3]);
+        };
+
+        const FLinearColor Top = FMath::Lerp(Fetch(X0, Y0), Fetch(X1, Y0), FracX);
+        const FLinearColor Bottom = FMath::Lerp(Fetch(X0, Y1), Fetch(X1, Y1), FracX);
+        return FMath::Lerp(Top, Bottom, FracY) * (1.0f / 255.0f);
+    }
+
+    // Over, into premultiplied Dest, of a straight colour at the given coverage
+    FORCEINLINE void BlendOver(FLinearColor& Dest, const FLinearColor& Source, float Alpha)
+    {
+        const float Remain = 1.0f - Alpha;
+        Dest.R = Source.R * Alpha + Dest.R * Remain;
+        Dest.G = Source.G * Alpha + Dest.G * Remain;
+        Dest.B = Source.B * Alpha + Dest.B * Remain;
+        Dest.A = Alpha + Dest.A * Remain;
+    }
+
+    void CompositeImage(const FExportImage& Image, const FIntRect& Tile, FLinearColor* Pixels, int32 Stride)
+    {
+        // Pixels whose centres fall inside the image
+        const FIntRect Footprint(
+            FMath::Max(Tile.Min.X, FMath::CeilToInt(Image.PixelRect.Min.X - 0.5)),
+            FMath::Max(Tile.Min.Y, FMath::CeilToInt(Image.PixelRect.Min.Y - 0.5)),
+            FMath::Min(Tile.Max.X, FMath::CeilToInt(Image.PixelRect.Max.X - 0.5)),
+            FMath::Min(Tile.Max.Y, FMath::CeilToInt(Image.PixelRect.Max.Y - 0.5)));
+        if (Footprint.Width() <= 0 || Footprint.Height() <= 0)
+            return;
+
+        const FRefImageProxy& Proxy = *Image.Pixels;
+        const FVector2D ImageSize = Image.PixelRect.GetSize();
+        const float ScaleX = (float)(Proxy.Width / ImageSize.X);
+        const float ScaleY = (float)(Proxy.Height / ImageSize.Y);
+
+        for (int32 Y = Footprint.Min.Y; Y < Footprint.Max.Y; Y++)
+        {
+            const float SourceY = (float)(Y + 0.5 - Image.PixelRect.Min.Y) * ScaleY - 0.5f;
+            FLinearColor* Row = Pixels + (int64)(Y - Tile.Min.Y) * Stride - Tile.Min.X;
+            for (int32 X = Footprint.Min.X; X < Footprint.Max.X; X++)
+            {
+                const float SourceX = (float)(X + 0.5 - Image.PixelRect.Min.X) * ScaleX - 0.5f;
+                const FLinearColor Source = SampleBilinear(Proxy, SourceX, SourceY);
+                const float Alpha = Source.A * Image.Opacity;
+                if (Alpha > 0.0f)
+                {
+                    BlendOver(Row[X], Source, Alpha);
+                }
+            }
+        }
+    }
+
+    // Antialiased strokes: each pixel takes the coverage of the nearest segment of the stroke,
+    // so joints between segments are not blended twice
+    void CompositeStrokes(const FRefAnnotationLayer& Annotations, const FBox2D& Bounds, double Scale,
+        const FIntRect& Tile, FLinearColor* Pixels, int32 Stride)
+    {
+        const FBox2D CanvasTile(
+            Bounds.Min + FVector2D(Tile.Min) / Scale,
+            Bounds.Min + FVector2D(Tile.Max) / Scale);
+
+        TArray<const FRefStroke*> Strokes;
+        Annotations.QueryStrokes(CanvasTile, Strokes);
+        if (Strokes.Num() == 0)
+            return;
+
+        TArray<float> Coverage;
+        Coverage.SetNumZeroed(Tile.Area());
+        TArray<FVector2D> Polyline;
+
+        for (const FRefStroke* Stroke : Strokes)
+        {
+            Polyline.Reset();
+            FRefAnnotationLayer::AppendPolyline(*Stroke, Polyline);
+            if (Polyline.Num() < 2)
+                continue;
+
+            const float HalfWidth = FMath::Max(0.5f, Stroke->Thickness * (float)Scale * 0.5f);
+            FIntRect Touched(Tile.Max, Tile.Min);
+
+            for (int32 Index = 1; Index < Polyline.Num(); Index++)
+            {
+                const FVector2D A = (Polyline[Index - 1] - Bounds.Min) * Scale;
+                const FVector2D B = (Polyline[Index] - Bounds.Min) * Scale;
+                const FIntRect Span(
+                    FMath::Max(Tile.Min.X, FMath::FloorToInt(FMath::Min(A.X, B.X) - HalfWidth - 1.0)),
+                    FMath::Max(Tile.Min.Y, FMath::FloorToInt(FMath::Min(A.Y, B.Y) - HalfWidth - 1.0)),
+                    FMath::Min(Tile.Max.X, FMath::CeilToInt(FMath::Max(A.X, B.X) + HalfWidth + 1.0)),
+                    FMath::Min(Tile.Max.Y, FMath::CeilToInt(FMath::Max(A.Y, B.Y) + HalfWidth + 1.0)));
+                if (Span.Width() <= 0 || Span.Height() <= 0)
+                    continue;
+
+                Touched.Include(Span.Min);
+                Touched.Include(Span.Max);
+
+                for (int32 Y = Span.Min.Y; Y < Span.Max.Y; Y++)
+                {
+                    float* Row = Coverage.GetData() + (int64)(Y - Tile.Min.Y) * Tile.Width() - Tile.Min.X;
+                    for (int32 X = Span.Min.X; X < Span.Max.X; X++)
+                    {
+                        const FVector2D Center(X + 0.5, Y + 0.5);
+                        const float Distance = (float)FVector2D::Distance(Center, FMath::ClosestPointOnSegment2D(Center, A, B));
+                        Row[X] = FMath::Max(Row[X], FMath::Clamp(HalfWidth + 0.5f - Distance, 0.0f, 1.0f));
+                    }
+                }
+            }
+
+            // Stroke colours are authored like palette swatches, in sRGB
+            const FColor Encoded = Stroke->Color.ToFColor(true);
+            const FLinearColor Color(Encoded.R / 255.0f, Encoded.G / 255.0f, Encoded.B / 255.0f);
+
+            for (int32 Y = Touched.Min.Y; Y < Touched.Max.Y; Y++)
+            {
+                float* CoverageRow = Coverage.GetData() + (int64)(Y - Tile.Min.Y) * Tile.Width() - Tile.Min.X;
+                FLinearColor* Row = Pixels + (int64)(Y - Tile.Min.Y) * Stride - Tile.Min.X;
+                for (int32 X = Touched.Min.X; X < Touched.Max.X; X++)
+                {
+                    if (CoverageRow[X] > 0.0f)
+                    {
+                        BlendOver(Row[X], Color, CoverageRow[X] * Stroke->Color.A);
+                        CoverageRow[X] = 0.0f;
+                    }
+                }
+            }
+        }
+    }
+
+    void ResolveGroups(const FReferenceLayout& Layout, TMap<FGuid, FExportGroup>& OutGroups)
+    {
+        TMap<FGuid, const FRefGroupRecord*> RecordsById;
+        for (const FRefGroupRecord& Record : Layout.Groups)
+        {
+            RecordsById.Add(Record.Id, &Record);
+        }
+
+        // Walks up the parent chain; a cycle in a damaged layout stops at the repeat
+        for (const FRefGroupRecord& Record : Layout.Groups)
+        {
+            FExportGroup Group;
+            TSet<FGuid> Visited;
+            for (const FRefGroupRecord* Current = &Record; Current && !Visited.Contains(Current->Id); )
+            {
+                Visited.Add(Current->Id);
+                Group.CanvasOffset += Current->Offset;
+                Group.Opacity *= Current->Opacity;
+                Group.bVisible &= Current->bVisible;
+
+                const FRefGroupRecord* const* Parent = Current->ParentId.IsValid() ? RecordsById.Find(Current->ParentId) : nullptr;
+                Current = Parent ? *Parent : nullptr;
+            }
+            OutGroups.Add(Record.Id, Group);
+        }
+    }
+
+    // Copies the CPU side of a transient board texture, which the board keeps for saving
+    bool CopyLiveTexture(UTexture2D* Texture, FExportSource& OutSource)
+    {
+        FTexturePlatformData* PlatformData = Texture ? Texture->GetPlatformData() : nullptr;
+        if (!PlatformData || PlatformData->PixelFormat != PF_B8G8R8A8 || PlatformData->Mips.Num() == 0)
+            return false;
+
+        FTexture2DMipMap& Mip = PlatformData->Mips[0];
+        const int64 Bytes = (int64)Mip.SizeX * Mip.SizeY * 4;
+        if (Bytes <= 0 || Mip.BulkData.GetBulkDataSize() < Bytes)
+            return false;
+
+        const uint8* Data = static_cast<const uint8*>(Mip.BulkData.LockReadOnly());
+        OutSource.Decoded = TArray64<uint8>(Data, Bytes);
+        Mip.BulkData.Unlock();
+
+        OutSource.BGRA = OutSource.Decoded.GetData();
+        OutSource.Width = Mip.SizeX;
+        OutSource.Height = Mip.SizeY;
+        return true;
+    }
+
+    // Game thread: texture assets and live textures have to be read here, the rest only point at their source
+    void GatherSource(const FExportImage& Image, const TSharedPtr<FRefBoardBundle>& Bundle, const TMap<FGuid, UTexture2D*>* LiveTextures,
+        const FVector2D& SheetSize, FExportSource& OutSource)
+    {
+        const FRefImageRecord& Record = *Image.Record;
+
+        if (Bundle.IsValid())
+        {
+            const int32 BundleIndex = Bundle->FindImage(Record.Id);
+            if (BundleIndex != INDEX_NONE)
+            {
+                const int32 Mip = Bundle->SelectMip(BundleIndex, SheetSize);
+                if (const uint8* MipData = Bundle->GetMipData(BundleIndex, Mip))
+                {
+                    OutSource.BGRA = MipData;
+                    OutSource.Width = Bundle->GetImage(BundleIndex).Mips[Mip].Width;
+                    OutSource.Height = Bundle->GetImage(BundleIndex).Mips[Mip].Height;
+                    return;
+                }
+            }
+        }
+
+        if (!Record.FilePath.IsEmpty() && FPaths::FileExists(Record.FilePath))
+            return;
+
+        UTexture2D* Texture = Record.TextureAsset.IsValid() ? Cast<UTexture2D>(Record.TextureAsset.TryLoad()) : nullptr;
+        if (!Texture || !Texture->Source.IsValid())
+        {
+            UTexture2D* const* LiveTexture = LiveTextures ? LiveTextures->Find(Record.Id) : nullptr;
+            if (LiveTexture)
+            {
+                CopyLiveTexture(*LiveTexture, OutSource);
+            }
+            return;
+        }
+
+        // Smallest source mip that still covers the sheet
+        int32 Mip = 0;
+        while (Mip + 1 < Texture->Source.GetNumMips()
+            && (Texture->Source.GetSizeX() >> (Mip + 1)) >= SheetSize.X
+            && (Texture->Source.GetSizeY() >> (Mip + 1)) >= SheetSize.Y)
+        {
+            Mip++;
+        }
+
+        FImage SourceImage;
+        if (!Texture->Source.GetMipImage(SourceImage, 0, 0, Mip))
+            return;
+
+        FImage Converted;
+        SourceImage.CopyTo(Converted, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+        OutSource.Decoded = MoveTemp(Converted.RawData);
+        OutSource.BGRA = OutSource.Decoded.GetData();
+        OutSource.Width = Converted.SizeX;
+        OutSource.Height = Converted.SizeY;
+    }
+
+    // Any thread: decodes files, then resamples to the sheet size and crops
+    void BuildPixels(FExportImage& Image, const FVector2D& SheetSize, FExportSource& Source)
+    {
+        if (!Source.BGRA && !Image.Record->FilePath.IsEmpty())
+        {
+            if (FRefImageLoader::DecodeFile(Image.Record->FilePath, Source.Decoded, Source.Width, Source.Height))
+            {
+                Source.BGRA = Source.Decoded.GetData();
+            }
+        }
+
+        if (!Source.BGRA)
+        {
+            UE_LOG(LogRefBoardExport, Warning, TEXT("No pixels for %s; it is left out of the export"), *Image.Record->Name);
+            return;
+        }
+
+        // Box filter by the largest whole factor that keeps the sheet size; bilinear sampling does the rest
+        const int32 SourceMax = FMath::Max(Source.Width, Source.Height);
+        const double NeededMax = FMath::Max(1.0, FMath::Max(SheetSize.X, SheetSize.Y));
+        const int32 Factor = FMath::Max(1, FMath::Max(FMath::FloorToInt(SourceMax / NeededMax), FMath::DivideAndRoundUp(SourceMax, MaxSourceDimension)));
+
+        FRefImageProxyPtr Resampled = FRefImageLoader::MakeProxy(Source.BGRA, Source.Width, Source.Height, FMath::DivideAndRoundUp(SourceMax, Factor));
+        Source = FExportSource();
+        Image.Pixels = FRefImageLoader::CropProxy(Resampled, Image.Record->UVRegion);
+    }
+
+    TUniquePtr<FExportWriter> MakeWriter(const FString& OutputPath)
+    {
+        const FString Extension = FPaths::GetExtension(OutputPath);
+        if (Extension.Equals(TEXT("png"), ESearchCase::IgnoreCase))
+            return MakeUnique<FPngWriter>();
+        if (Extension.Equals(TEXT("exr"), ESearchCase::IgnoreCase))
+            return MakeUnique<FExrWriter>();
+        return nullptr;
+    }
+}
+
+bool FRefBoardExporter::Export(const FReferenceLayout& Layout, const TSharedPtr<FRefBoardBundle>& Bundle,
+    const FString& OutputPath, const FRefBoardExportSettings& Settings,
+    const TMap<FGuid, UTexture2D*>* LiveTextures)
+{
+    check(IsInGameThread());
+
+    TUniquePtr<FExportWriter> Writer = MakeWriter(OutputPath);
+    if (!Writer.IsValid())
+    {
+        UE_LOG(LogRefBoardExport, Error, TEXT("Unsupported export format: %s (use .png or .exr)"), *OutputPath);
+        return false;
+    }
+
+    TMap<FGuid, FExportGroup> Groups;
+    ResolveGroups(Layout, Groups);
+
+    TMap<FGuid, const FExportGroup*> GroupByImage;
+    for (const FRefGroupRecord& Record : Layout.Groups)
+    {
+        for (const FGuid& ImageId : Record.Images)
+        {
+            GroupByImage.Add(ImageId, &Groups[Record.Id]);
+        }
+    }
+
+    // Canvas placement of every image that shows
+    TArray<FExportImage> Images;
+    FBox2D Bounds(ForceInit);
+    for (const FRefImageRecord& Record : Layout.Images)
+    {
+        const FExportGroup* const* Group = GroupByImage.Find(Record.Id);
+        const float Opacity = Record.Opacity * (Group ? (*Group)->Opacity : 1.0f);
+        if (!Record.bVisible || (Group && !(*Group)->bVisible) || Opacity <= 0.0f || Record.Size.X <= 0.0 || Record.Size.Y <= 0.0)
+            continue;
+
+        const FVector2D CanvasPosition = Record.Position + (Group ? (*Group)->CanvasOffset : FVector2D::ZeroVector);
+        FExportImage& Image = Images.AddDefaulted_GetRef();
+        Image.Record = &Record;
+        Image.Opacity = FMath::Min(Opacity, 1.0f);
+        Image.PixelRect = FBox2D(CanvasPosition, CanvasPosition + Record.Size);
+        Bounds += Image.PixelRect;
+    }
+
+    FRefAnnotationLayer Annotations;
+    if (Settings.bAnnotations && Layout.Strokes.Num() > 0)
+    {
+        Annotations.Reset(Layout.Strokes);
+        for (const FRefStroke& Stroke : Layout.Strokes)
+        {
+            Bounds += Stroke.GetBounds();
+        }
+    }
+
+    if (!Bounds.bIsValid)
+    {
+        UE_LOG(LogRefBoardExport, Error, TEXT("Board %s has nothing visible to export"), *Layout.Name);
+        return false;
+    }
+    Bounds = Bounds.ExpandBy(Settings.Margin);
+
+    // Oversized requests are scaled down to fit rather than refused
+    double Scale = Settings.Width > 0 ? Settings.Width / Bounds.GetSize().X : Settings.Scale;
+    Scale = FMath::Max(Scale, UE_DOUBLE_KINDA_SMALL_NUMBER);
+    const double LongestSide = Bounds.GetSize().GetMax() * Scale;
+    if (LongestSide > MaxDimension)
+    {
+        Scale *= MaxDimension / LongestSide;
+        UE_LOG(LogRefBoardExport, Warning, TEXT("Export scale reduced to %.3f to stay within %d pixels"), Scale, MaxDimension);
+    }
+
+    const int32 Width = FMath::Clamp(FMath::CeilToInt(Bounds.GetSize().X * Scale), 1, MaxDimension);
+    const int32 Height = FMath::Clamp(FMath::CeilToInt(Bounds.GetSize().Y * Scale), 1, MaxDimension);
+    const int32 NumBands = FMath::DivideAndRoundUp(Height, TileSize);
+    const int32 NumTileColumns = FMath::DivideAndRoundUp(Width, TileSize);
+
+    for (FExportImage& Image : Images)
+    {
+        Image.PixelRect = FBox2D((Image.PixelRect.Min - Bounds.Min) * Scale, (Image.PixelRect.Max - Bounds.Min) * Scale);
+        Image.FirstBand = FMath::Clamp(FMath::FloorToInt(Image.PixelRect.Min.Y / TileSize), 0, NumBands - 1);
+        Image.LastBand = FMath::Clamp(FMath::FloorToInt(Image.PixelRect.Max.Y / TileSize), 0, NumBands - 1);
+    }
+
+    const FString TempPath = OutputPath + TEXT(".tmp");
+    TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*TempPath));
+    if (!Ar.IsValid())
+    {
+        UE_LOG(LogRefBoardExport, Error, TEXT("Could not write %s"), *TempPath);
+        return false;
+    }
+
+    FScopedSlowTask SlowTask(NumBands, LOCTEXT("ExportingBoard", "Exporting reference board..."));
+    SlowTask.MakeDialogDelayed(0.5f);
+
+    const FLinearColor Background(
+        Settings.Background.R * Settings.Background.A,
+        Settings.Background.G * Settings.Background.A,
+        Settings.Background.B * Settings.Background.A,
+        Settings.Background.A);
+
+    bool bSuccess = Writer->Begin(*Ar, Width, Height);
+    TArray<FLinearColor> BandPixels;
+    TArray<int32> Starting;
+    TArray<const FExportImage*> Active;
+
+    for (int32 Band = 0; bSuccess && Band < NumBands; Band++)
+    {
+        SlowTask.EnterProgressFrame();
+
+        // Pixels of the images first crossing this band
+        Starting.Reset();
+        for (int32 Index = 0; Index < Images.Num(); Index++)
+        {
+            if (Images[Index].FirstBand == Band)
+            {
+                Starting.Add(Index);
+            }
+        }
+
+        TArray<FExportSource> Sources;
+        TArray<FVector2D> SheetSizes;
+        Sources.SetNum(Starting.Num());
+        SheetSizes.SetNum(Starting.Num());
+        for (int32 Slot = 0; Slot < Starting.Num(); Slot++)
+        {
+            const FExportImage& Image = Images[Starting[Slot]];
+            const FVector2f UVSize = Image.Record->UVRegion.GetSize();
+            SheetSizes[Slot] = Image.PixelRect.GetSize() / FVector2D(FMath::Max(UVSize.X, UE_KINDA_SMALL_NUMBER), FMath::Max(UVSize.Y, UE_KINDA_SMALL_NUMBER));
+            GatherSource(Image, Bundle, LiveTextures, SheetSizes[Slot], Sources[Slot]);
+        }
+
+        ParallelFor(Starting.Num(), [&](int32 Slot)
+        {
+            BuildPixels(Images[Starting[Slot]], SheetSizes[Slot], Sources[Slot]);
+        });
+        Sources.Empty();
+
+        Active.Reset();
+        for (const FExportImage& Image : Images)
+        {
+            if (Image.FirstBand <= Band && Image.LastBand >= Band && Image.Pixels.IsValid())
+            {
+                Active.Add(&Image);
+            }
+        }
+
+        const int32 BandTop = Band * TileSize;
+        const int32 BandRows = FMath::Min(TileSize, Height - BandTop);
+        BandPixels.SetNumUninitialized(Width * BandRows, EAllowShrinking::No);
+
+        ParallelFor(NumTileColumns, [&](int32 Column)
+        {
+            const FIntRect Tile(Column * TileSize, BandTop, FMath::Min((Column + 1) * TileSize, Width), BandTop + BandRows);
+            FLinearColor* TilePixels = BandPixels.GetData() + Tile.Min.X;
+
+            for (int32 Row = 0; Row < BandRows; Row++)
+            {
+                FLinearColor* RowPixels = TilePixels + (int64)Row * Width;
+                for (int32 X = 0; X < Tile.Width(); X++)
+                {
+                    RowPixels[X] = Background;
+                }
+            }
+
+            for (const FExportImage* Image : Active)
+            {
+                CompositeImage(*Image, Tile, TilePixels, Width);
+            }
+
+            if (Annotations.Num() > 0)
+            {
+                CompositeStrokes(Annotations, Bounds, Scale, Tile, TilePixels, Width);
+            }
+        });
+
+        bSuccess = Writer->WriteRows(*Ar, BandPixels.GetData(), BandRows);
+
+        // Images done with are released before the next band loads more
+        for (FExportImage& Image : Images)
+        {
+            if (Image.LastBand == Band)
+            {
+                Image.Pixels.Reset();
+            }
+        }
+    }
+
+    bSuccess = bSuccess && Writer->End(*Ar);
+    bSuccess = Ar->Close() && bSuccess;
+    Ar.Reset();
+
+    if (!bSuccess)
+    {
+        UE_LOG(LogRefBoardExport, Error, TEXT("Export of %s failed"), *OutputPath);
+        IFileManager::Get().Delete(*TempPath);
+        return false;
+    }
+
+    UE_LOG(LogRefBoardExport, Log, TEXT("Exported %s (%d x %d)"), *OutputPath, Width, Height);
+    return IFileManager::Get().Move(*OutputPath, *TempPath, true, true);
+}
+
+#undef LOCTEXT_NAMESPACE
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+class FRefBoardBundle;
+class UTexture2D;
+
+struct FRefBoardExportSettings
+{
+    // Output pixels per board unit
+    double Scale = 1.0;
+
+    // Output width in pixels; overrides Scale when set
+    int32 Width = 0;
+
+    // Board units kept around the content
+    float Margin = 20.0f;
+
+    // Composited before the images; alpha below one gives a transparent PNG
+    FLinearColor Background = FLinearColor(0.02f, 0.02f, 0.02f, 1.0f);
+
+    bool bAnnotations = true;
+};
+
+// Renders a board to one large PNG or EXR entirely on the CPU, without the editor UI, so it
+// also runs from a commandlet. The frame is produced one band of tiles at a time, top to
+// bottom: the tiles of a band are composited in parallel and the band is appended to the
+// file, so memory holds one band and the images crossing it, never the whole frame. Images
+// are read from the bundle, decoded from their files or taken from their texture assets,
+// and downsampled to the size they are drawn at as soon as they are loaded.
+class FRefBoardExporter
+{
+public:
+    // Output rows per band, and the side of the tiles composited in parallel
+    static constexpr int32 TileSize = 256;
+
+    // Longest side of an export
+    static constexpr int32 MaxDimension = 32768;
+
+    // The extension of OutputPath picks the format: .png (8-bit sRGB) or .exr (half-float linear).
+    // Bundle, if set, supplies the pixels of the images it holds. LiveTextures, if set, maps image
+    // ids to the textures of an open board; their CPU copies stand in for images with no bundle
+    // entry, file or asset, such as mesh silhouettes. Call from the game thread.
+    static bool Export(const FReferenceLayout& Layout, const TSharedPtr<FRefBoardBundle>& Bundle,
+        const FString& OutputPath, const FRefBoardExportSettings& Settings,
+        const TMap<FGuid, UTexture2D*>* LiveTextures = nullptr);
+};
\ No newline at end of file
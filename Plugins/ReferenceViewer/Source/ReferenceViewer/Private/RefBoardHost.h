@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class SReferenceCanvas;
+struct FRefBoardExportSettings;
+
+// A panel showing a board, as seen by the scripting subsystem
+class IRefBoardHost
+{
+public:
+    virtual ~IRefBoardHost() = default;
+
+    virtual TSharedPtr<SReferenceCanvas> GetBoardCanvas() const = 0;
+
+    // .refboard bundles, as the panel's Save Board / Open Board buttons
+    virtual bool SaveBoard(const FString& Path) = 0;
+    virtual bool OpenBoard(const FString& Path) = 0;
+
+    // Renders the board to a .png or .exr, as the panel's Export Image button
+    virtual bool ExportImage(const FString& Path, const FRefBoardExportSettings& Settings) = 0;
+
+    // Bundle last opened or saved by the panel; empty if none
+    virtual FString GetBundlePath() const = 0;
+
+    // Whether the panel holds the autosave journal
+    virtual bool OwnsAutosave() const = 0;
+};
\ No newline at end of file
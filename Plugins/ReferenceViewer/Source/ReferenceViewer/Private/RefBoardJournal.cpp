@@ -0,0 +1,505 @@
+#include "RefBoardJournal.h"
+#include "RefLayoutFile.h"
+#include "ReferenceViewer.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/FileManager.h"
+#include "HAL/Event.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Crc.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+    // "RVJ2"
+    const uint32 JournalMagic = 0x324A5652;
+
+    // Entry framing: payload size and CRC, so a torn tail write is detected and dropped
+    struct FEntryHeader
+    {
+        uint32 PayloadSize;
+        uint32 PayloadCrc;
+    };
+
+    void SerializeGroup(FArchive& Ar, FRefGroupRecord& Group)
+    {
+        Ar << Group.Id << Group.Name << Group.ParentId << Group.Offset << Group.Opacity
+           << Group.bLocked << Group.bVisible << Group.bCollapsed << Group.Images;
+    }
+}
+
+FRefBoardJournal::FRefBoardJournal(const FString& InBoardName, const FReferenceLayout& InRestoredLayout)
+    : BoardName(InBoardName)
+    , JournalPath(GetJournalPath(InBoardName))
+    , SnapshotPath(FRefLayoutFile::GetLayoutPath(InBoardName))
+    , NextSequence(InRestoredLayout.JournalSequence + 1)
+    , EntriesSinceCompaction(0)
+    , WakeEvent(FPlatformProcess::GetSynchEventFromPool(false))
+    , Thread(nullptr)
+    , bStopRequested(false)
+{
+    Mirror.Reset(InRestoredLayout);
+    Mirror.Layout.Name = BoardName;
+
+    Thread = FRunnableThread::Create(this, TEXT("ReferenceViewerJournal"), 0, TPri_BelowNormal);
+}
+
+FRefBoardJournal::~FRefBoardJournal()
+{
+    if (Thread)
+    {
+        Stop();
+        Thread->WaitForCompletion();
+        delete Thread;
+        Thread = nullptr;
+    }
+
+    FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+    WakeEvent = nullptr;
+}
+
+FString FRefBoardJournal::GetJournalPath(const FString& BoardName)
+{
+    return FReferenceViewerModule::GetSavedLayoutsPath() / (BoardName + TEXT(".journal"));
+}
+
+bool FRefBoardJournal::Replay(const FString& BoardName, FReferenceLayout& OutLayout)
+{
+    FReferenceLayout Snapshot;
+    const bool bHasSnapshot = FRefLayoutFile::Load(FRefLayoutFile::GetLayoutPath(BoardName), Snapshot);
+
+    FMirror State;
+    State.Reset(Snapshot);
+
+    TArray<uint8> JournalData;
+    bool bHasJournal = false;
+    if (FFileHelper::LoadFileToArray(JournalData, *GetJournalPath(BoardName), FILEREAD_Silent))
+    {
+        FMemoryReader Reader(JournalData);
+        uint32 Magic = 0;
+        Reader << Magic;
+        bHasJournal = (Magic == JournalMagic);
+
+        while (bHasJournal && Reader.TotalSize() - Reader.Tell() >= (int64)sizeof(FEntryHeader))
+        {
+            FEntryHeader Header;
+            Reader << Header.PayloadSize << Header.PayloadCrc;
+
+            const int64 PayloadStart = Reader.Tell();
+            if (PayloadStart + Header.PayloadSize > Reader.TotalSize()
+                || FCrc::MemCrc32(JournalData.GetData() + PayloadStart, Header.PayloadSize) != Header.PayloadCrc)
+            {
+                // Torn write at the moment of the crash; everything before it is intact
+                break;
+            }
+
+            FEntry Entry;
+            SerializeEntry(Reader, Entry);
+            Reader.Seek(PayloadStart + Header.PayloadSize);
+
+            // Entries already folded into the snapshot by an interrupted compaction
+            if (Entry.Sequence > State.Layout.JournalSequence)
+            {
+                State.Apply(Entry);
+            }
+        }
+    }
+
+    OutLayout = State.ToLayout();
+    OutLayout.Name = BoardName;
+    return bHasSnapshot || bHasJournal;
+}
+
+void FRefBoardJournal::SerializeEntry(FArchive& Ar, FEntry& Entry)
+{
+    uint8 Op = (uint8)Entry.Op;
+    Ar << Entry.Sequence << Op;
+    Entry.Op = (ERefJournalOp)Op;
+
+    FRefImageRecord& Record = Entry.Record;
+    switch (Entry.Op)
+    {
+        case ERefJournalOp::Add:
+            Ar << Record.Id << Record.Name << Record.FilePath << Record.TextureAsset << Record.Position << Record.Size
+               << Record.Rotation << Record.Opacity << Record.bLocked << Record.bVisible;
+            break;
+        case ERefJournalOp::Remove:
+            Ar << Record.Id;
+            break;
+        case ERefJournalOp::Move:
+            Ar << Record.Id << Record.Position;
+            break;
+        case ERefJournalOp::Opacity:
+            Ar << Record.Id << Record.Opacity;
+            break;
+        case ERefJournalOp::Lock:
+            Ar << Record.Id << Record.bLocked;
+            break;
+        case ERefJournalOp::Clear:
+            break;
+        case ERefJournalOp::Transform:
+            Ar << Record.Id << Record.Position << Record.Size << Record.Rotation << Record.Opacity;
+            break;
+        case ERefJournalOp::Visibility:
+            Ar << Record.Id << Record.bVisible;
+            break;
+        case ERefJournalOp::Crop:
+            Ar << Record.Id << Record.Position << Record.Size << Record.UVRegion;
+            break;
+        case ERefJournalOp::Groups:
+        {
+            int32 NumGroups = Entry.Groups.Num();
+            Ar << NumGroups;
+            if (Ar.IsLoading())
+            {
+                Entry.Groups.SetNum(FMath::Max(0, NumGroups));
+            }
+            for (FRefGroupRecord& Group : Entry.Groups)
+            {
+                SerializeGroup(Ar, Group);
+            }
+            break;
+        }
+        case ERefJournalOp::AddStroke:
+            Ar << Entry.Stroke.Id << Entry.Stroke.Points << Entry.Stroke.Color << Entry.Stroke.Thickness << Entry.Stroke.bArrow;
+            break;
+        case ERefJournalOp::RemoveStroke:
+            Ar << Entry.Stroke.Id;
+            break;
+    }
+}
+
+void FRefBoardJournal::RecordAdd(const FRefImage& Image)
+{
+    Enqueue(ERefJournalOp::Add, Image.ToRecord());
+}
+
+void FRefBoardJournal::RecordRemove(const FRefImage& Image)
+{
+    FRefImageRecord Record;
+    Record.Id = Image.Id;
+    Enqueue(ERefJournalOp::Remove, Record);
+}
+
+void FRefBoardJournal::RecordMove(const FRefImage& Image)
+{
+    FRefImageRecord Record;
+    Record.Id = Image.Id;
+    Record.Position = Image.Position;
+    Enqueue(ERefJournalOp::Move, Record);
+}
+
+void FRefBoardJournal::RecordOpacity(const FRefImage& Image)
+{
+    FRefImageRecord Record;
+    Record.Id = Image.Id;
+    Record.Opacity = Image.Opacity;
+    Enqueue(ERefJournalOp::Opacity, Record);
+}
+
+void FRefBoardJournal::RecordLock(const FRefImage& Image)
+{
+    FRefImageRecord Record;
+    Record.Id = Image.Id;
+    Record.bLocked = Image.bLocked;
+    Enqueue(ERefJournalOp::Lock, Record);
+}
+
+void FRefBoardJournal::RecordTransform(const FRefImage& Image)
+{
+    FRefImageRecord Record;
+    Record.Id = Image.Id;
+    Record.Position = Image.Position;
+    Record.Size = Image.Size;
+    Record.Rotation = Image.Rotation;
+    Record.Opacity = Image.Opacity;
+    Enqueue(ERefJournalOp::Transform, Record);
+}
+
+void FRefBoardJournal::RecordVisibility(const FRefImage& Image)
+{
+    FRefImageRecord Record;
+    Record.Id = Image.Id;
+    Record.bVisible = Image.bVisible;
+    Enqueue(ERefJournalOp::Visibility, Record);
+}
+
+void FRefBoardJournal::RecordCrop(const FRefImage& Image)
+{
+    FRefImageRecord Record;
+    Record.Id = Image.Id;
+    Record.Position = Image.Position;
+    Record.Size = Image.Size;
+    Record.UVRegion = Image.UVRegion;
+    Enqueue(ERefJournalOp::Crop, Record);
+}
+
+void FRefBoardJournal::RecordClear()
+{
+    Enqueue(ERefJournalOp::Clear, FRefImageRecord());
+}
+
+void FRefBoardJournal::RecordGroups(TArray<FRefGroupRecord> Groups)
+{
+    Enqueue(ERefJournalOp::Groups, FRefImageRecord(), MoveTemp(Groups));
+}
+
+void FRefBoardJournal::RecordAddStroke(const FRefStroke& Stroke)
+{
+    FEntry Entry;
+    Entry.Op = ERefJournalOp::AddStroke;
+    Entry.Stroke = Stroke;
+    Enqueue(MoveTemp(Entry));
+}
+
+void FRefBoardJournal::RecordRemoveStroke(const FGuid& StrokeId)
+{
+    FEntry Entry;
+    Entry.Op = ERefJournalOp::RemoveStroke;
+    Entry.Stroke.Id = StrokeId;
+    Enqueue(MoveTemp(Entry));
+}
+
+void FRefBoardJournal::Enqueue(ERefJournalOp Op, const FRefImageRecord& Record, TArray<FRefGroupRecord> Groups)
+{
+    FEntry Entry;
+    Entry.Op = Op;
+    Entry.Record = Record;
+    Entry.Groups = MoveTemp(Groups);
+    Enqueue(MoveTemp(Entry));
+}
+
+void FRefBoardJournal::Enqueue(FEntry&& Entry)
+{
+    check(IsInGameThread());
+
+    Entry.Sequence = NextSequence++;
+
+    // Lock-free; the writer thread picks it up on its next wake
+    Pending.Enqueue(MoveTemp(Entry));
+    WakeEvent->Trigger();
+}
+
+uint32 FRefBoardJournal::Run()
+{
+    // Start every session from a fresh snapshot so the journal stays short
+    Compact();
+
+    while (!bStopRequested)
+    {
+        // Short wait batches bursts (e.g. a multi-selection drop) into one write
+        WakeEvent->Wait(FTimespan::FromMilliseconds(250));
+        WritePending();
+
+        if (EntriesSinceCompaction >= CompactionEntryCount)
+        {
+            Compact();
+        }
+    }
+
+    // Clean shutdown: fold everything into the snapshot
+    WritePending();
+    Compact();
+    return 0;
+}
+
+void FRefBoardJournal::Stop()
+{
+    bStopRequested = true;
+    WakeEvent->Trigger();
+}
+
+bool FRefBoardJournal::OpenJournal(bool bTruncate)
+{
+    JournalFile.Reset();
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    PlatformFile.CreateDirectoryTree(*FPaths::GetPath(JournalPath));
+    JournalFile.Reset(PlatformFile.OpenWrite(*JournalPath, !bTruncate));
+    if (!JournalFile.IsValid())
+        return false;
+
+    if (bTruncate || JournalFile->Size() == 0)
+    {
+        uint32 Magic = JournalMagic;
+        JournalFile->Write(reinterpret_cast<const uint8*>(&Magic), sizeof(Magic));
+    }
+    return true;
+}
+
+void FRefBoardJournal::WritePending()
+{
+    if (Pending.IsEmpty())
+        return;
+
+    TArray<uint8> Buffer;
+    FMemoryWriter Writer(Buffer);
+    TArray<uint8> Payload;
+
+    FEntry Entry;
+    while (Pending.Dequeue(Entry))
+    {
+        Payload.Reset();
+        FMemoryWriter PayloadWriter(Payload);
+        SerializeEntry(PayloadWriter, Entry);
+
+        FEntryHeader Header;
+        Header.PayloadSize = Payload.Num();
+        Header.PayloadCrc = FCrc::MemCrc32(Payload.GetData(), Payload.Num());
+        Writer << Header.PayloadSize << Header.PayloadCrc;
+        Writer.Serialize(Payload.GetData(), Payload.Num());
+
+        Mirror.Apply(Entry);
+        EntriesSinceCompaction++;
+    }
+
+    if (!JournalFile.IsValid() && !OpenJournal(false))
+        return;
+
+    JournalFile->Write(Buffer.GetData(), Buffer.Num());
+    JournalFile->Flush();
+}
+
+void FRefBoardJournal::Compact()
+{
+    // Snapshot first; the journal is only truncated once the snapshot is safely in place
+    if (!FRefLayoutFile::Save(SnapshotPath, Mirror.ToLayout()))
+        return;
+
+    OpenJournal(true);
+    EntriesSinceCompaction = 0;
+}
+
+void FRefBoardJournal::FMirror::Reset(const FReferenceLayout& InLayout)
+{
+    Layout = InLayout;
+    IndexById.Reset();
+    NumRemoved = 0;
+    for (int32 i = 0; i < Layout.Images.Num(); i++)
+    {
+        IndexById.Add(Layout.Images[i].Id, i);
+    }
+    StrokeIndexById.Reset();
+    NumStrokesRemoved = 0;
+    for (int32 i = 0; i < Layout.Strokes.Num(); i++)
+    {
+        StrokeIndexById.Add(Layout.Strokes[i].Id, i);
+    }
+}
+
+void FRefBoardJournal::FMirror::Apply(const FEntry& Entry)
+{
+    Layout.JournalSequence = Entry.Sequence;
+
+    if (Entry.Op == ERefJournalOp::Clear)
+    {
+        Layout.Images.Reset();
+        Layout.Groups.Reset();
+        Layout.Strokes.Reset();
+        IndexById.Reset();
+        NumRemoved = 0;
+        StrokeIndexById.Reset();
+        NumStrokesRemoved = 0;
+        return;
+    }
+
+    if (Entry.Op == ERefJournalOp::AddStroke)
+    {
+        if (const int32* Existing = StrokeIndexById.Find(Entry.Stroke.Id))
+        {
+            Layout.Strokes[*Existing] = Entry.Stroke;
+        }
+        else
+        {
+            StrokeIndexById.Add(Entry.Stroke.Id, Layout.Strokes.Add(Entry.Stroke));
+        }
+        return;
+    }
+
+    if (Entry.Op == ERefJournalOp::RemoveStroke)
+    {
+        int32 StrokeIndex = INDEX_NONE;
+        if (StrokeIndexById.RemoveAndCopyValue(Entry.Stroke.Id, StrokeIndex))
+        {
+            // Tombstone, as for images
+            Layout.Strokes[StrokeIndex].Id.Invalidate();
+            Layout.Strokes[StrokeIndex].Points.Empty();
+            NumStrokesRemoved++;
+        }
+        return;
+    }
+
+    if (Entry.Op == ERefJournalOp::Add)
+    {
+        if (const int32* Existing = IndexById.Find(Entry.Record.Id))
+        {
+            Layout.Images[*Existing] = Entry.Record;
+        }
+        else
+        {
+            IndexById.Add(Entry.Record.Id, Layout.Images.Add(Entry.Record));
+        }
+        return;
+    }
+
+    if (Entry.Op == ERefJournalOp::Groups)
+    {
+        Layout.Groups = Entry.Groups;
+        return;
+    }
+
+    const int32* Index = IndexById.Find(Entry.Record.Id);
+    if (!Index)
+        return;
+
+    FRefImageRecord& Record = Layout.Images[*Index];
+    switch (Entry.Op)
+    {
+        case ERefJournalOp::Remove:
+            // Tombstone keeps indices stable; dropped in ToLayout()
+            Record.Id.Invalidate();
+            IndexById.Remove(Entry.Record.Id);
+            NumRemoved++;
+            break;
+        case ERefJournalOp::Move:
+            Record.Position = Entry.Record.Position;
+            break;
+        case ERefJournalOp::Opacity:
+            Record.Opacity = Entry.Record.Opacity;
+            break;
+        case ERefJournalOp::Lock:
+            Record.bLocked = Entry.Record.bLocked;
+            break;
+        case ERefJournalOp::Transform:
+            Record.Position = Entry.Record.Position;
+            Record.Size = Entry.Record.Size;
+            Record.Rotation = Entry.Record.Rotation;
+            Record.Opacity = Entry.Record.Opacity;
+            break;
+        case ERefJournalOp::Visibility:
+            Record.bVisible = Entry.Record.bVisible;
+            break;
+        case ERefJournalOp::Crop:
+            Record.Position = Entry.Record.Position;
+            Record.Size = Entry.Record.Size;
+            Record.UVRegion = Entry.Record.UVRegion;
+            break;
+        default:
+            break;
+    }
+}
+
+FReferenceLayout FRefBoardJournal::FMirror::ToLayout() const
+{
+    FReferenceLayout Result = Layout;
+    if (NumRemoved > 0)
+    {
+        Result.Images.RemoveAll([](const FRefImageRecord& Record) { return !Record.Id.IsValid(); });
+    }
+    if (NumStrokesRemoved > 0)
+    {
+        Result.Strokes.RemoveAll([](const FRefStroke& Stroke) { return !Stroke.Id.IsValid(); });
+    }
+    return Result;
+}
\ No newline at end of file
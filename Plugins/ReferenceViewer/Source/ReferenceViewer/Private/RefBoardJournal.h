@@ -0,0 +1,115 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include "RefViewerData.h"
+
+class FRunnableThread;
+class FEvent;
+class IFileHandle;
+
+enum class ERefJournalOp : uint8
+{
+    Add,
+    Remove,
+    Move,
+    Opacity,
+    Lock,
+    Clear,
+    Transform,
+    Visibility,
+    Groups,
+    Crop,
+    AddStroke,
+    RemoveStroke
+};
+
+// Append-only crash journal for one board, stored next to the saved layouts.
+// The game thread only enqueues entries; a background thread appends them to
+// <Board>.journal, mirrors the board state and periodically compacts it into
+// the <Board>.json snapshot.
+class FRefBoardJournal : public FRunnable
+{
+public:
+    // Appended entries between snapshots
+    static constexpr int32 CompactionEntryCount = 4096;
+
+    FRefBoardJournal(const FString& InBoardName, const FReferenceLayout& InRestoredLayout);
+    virtual ~FRefBoardJournal();
+
+    // Rebuilds the pre-crash board: snapshot plus any newer journal entries
+    static bool Replay(const FString& BoardName, FReferenceLayout& OutLayout);
+
+    // Mutation recording, game thread
+    void RecordAdd(const FRefImage& Image);
+    void RecordRemove(const FRefImage& Image);
+    void RecordMove(const FRefImage& Image);
+    void RecordOpacity(const FRefImage& Image);
+    void RecordLock(const FRefImage& Image);
+    void RecordTransform(const FRefImage& Image);
+    void RecordVisibility(const FRefImage& Image);
+    void RecordCrop(const FRefImage& Image);
+    void RecordClear();
+    
+    // Whole group table; groups change rarely and are few, so each change is a snapshot
+    void RecordGroups(TArray<FRefGroupRecord> Groups);
+
+    // Annotations; strokes are never edited, only drawn and erased
+    void RecordAddStroke(const FRefStroke& Stroke);
+    void RecordRemoveStroke(const FGuid& StrokeId);
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    struct FEntry
+    {
+        uint64 Sequence = 0;
+        ERefJournalOp Op = ERefJournalOp::Add;
+        FRefImageRecord Record;
+        TArray<FRefGroupRecord> Groups;
+        FRefStroke Stroke;
+    };
+
+    // Board state mirrored on the writer thread, used for compaction
+    struct FMirror
+    {
+        FReferenceLayout Layout;
+        TMap<FGuid, int32> IndexById;
+        int32 NumRemoved = 0;
+        TMap<FGuid, int32> StrokeIndexById;
+        int32 NumStrokesRemoved = 0;
+
+        void Reset(const FReferenceLayout& InLayout);
+        void Apply(const FEntry& Entry);
+        FReferenceLayout ToLayout() const;
+    };
+
+    static FString GetJournalPath(const FString& BoardName);
+    static void SerializeEntry(FArchive& Ar, FEntry& Entry);
+
+    void Enqueue(ERefJournalOp Op, const FRefImageRecord& Record, TArray<FRefGroupRecord> Groups = TArray<FRefGroupRecord>());
+    void Enqueue(FEntry&& Entry);
+    bool OpenJournal(bool bTruncate);
+    void WritePending();
+    void Compact();
+
+    FString BoardName;
+    FString JournalPath;
+    FString SnapshotPath;
+
+    // Game thread side
+    uint64 NextSequence;
+    TQueue<FEntry, EQueueMode::Mpsc> Pending;
+
+    // Writer thread side
+    FMirror Mirror;
+    TUniquePtr<IFileHandle> JournalFile;
+    int32 EntriesSinceCompaction;
+
+    FEvent* WakeEvent;
+    FRunnableThread* Thread;
+    TAtomic<bool> bStopRequested;
+};
\ No newline at end of file
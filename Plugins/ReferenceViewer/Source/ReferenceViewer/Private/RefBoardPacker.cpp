@@ -0,0 +1,197 @@
+#include "RefBoardPacker.h"
+
+namespace
+{
+    // One horizontal segment of the skyline, in cells
+    struct FSkylineNode
+    {
+        int32 X;
+        int32 Y;
+        int32 Width;
+    };
+
+    struct FCellRect
+    {
+        int32 MinX;
+        int32 MinY;
+        int32 MaxX;
+        int32 MaxY;
+    };
+
+    class FSkyline
+    {
+    public:
+        FSkyline(int32 InBinWidth, const TArray<FCellRect>& InObstacles)
+            : BinWidth(InBinWidth)
+            , Obstacles(InObstacles)
+        {
+            Nodes.Add({ 0, 0, BinWidth });
+        }
+
+        void Insert(int32 Width, int32 Height, int32& OutX, int32& OutY)
+        {
+            int32 BestNode = INDEX_NONE;
+            int32 BestTop = MAX_int32;
+            int32 BestX = 0;
+            int32 BestY = 0;
+
+            for (int32 i = 0; i < Nodes.Num(); i++)
+            {
+                int32 Y;
+                if (!Fit(i, Width, Height, Y))
+                    continue;
+
+                // Bottom-left: lowest top edge, then leftmost
+                const int32 Top = Y + Height;
+                if (Top < BestTop)
+                {
+                    BestNode = i;
+                    BestTop = Top;
+                    BestX = Nodes[i].X;
+                    BestY = Y;
+                }
+            }
+
+            // Bin is at least as wide as the widest item, so node 0 always fits
+            check(BestNode != INDEX_NONE);
+            AddLevel(BestNode, BestX, BestY, Width, Height);
+            OutX = BestX;
+            OutY = BestY;
+        }
+
+    private:
+        bool Fit(int32 NodeIndex, int32 Width, int32 Height, int32& OutY) const
+        {
+            const int32 X = Nodes[NodeIndex].X;
+            if (X + Width > BinWidth)
+                return false;
+
+            // Rest on the highest skyline segment under the span
+            int32 Y = 0;
+            int32 Remaining = Width;
+            for (int32 i = NodeIndex; Remaining > 0; i++)
+            {
+                Y = FMath::Max(Y, Nodes[i].Y);
+                Remaining -= Nodes[i].Width;
+            }
+
+            // Then step over any fixed image in the way
+            bool bMoved = true;
+            while (bMoved)
+            {
+                bMoved = false;
+                for (const FCellRect& Obstacle : Obstacles)
+                {
+                    if (X < Obstacle.MaxX && X + Width > Obstacle.MinX && Y < Obstacle.MaxY && Y + Height > Obstacle.MinY)
+                    {
+                        Y = Obstacle.MaxY;
+                        bMoved = true;
+                    }
+                }
+            }
+
+            OutY = Y;
+            return true;
+        }
+
+        void AddLevel(int32 NodeIndex, int32 X, int32 Y, int32 Width, int32 Height)
+        {
+            Nodes.Insert({ X, Y + Height, Width }, NodeIndex);
+
+            // Trim the segments now covered by the new one
+            for (int32 i = NodeIndex + 1; i < Nodes.Num(); )
+            {
+                const FSkylineNode& Previous = Nodes[i - 1];
+                const int32 Overlap = Previous.X + Previous.Width - Nodes[i].X;
+                if (Overlap <= 0)
+                    break;
+
+                Nodes[i].X += Overlap;
+                Nodes[i].Width -= Overlap;
+                if (Nodes[i].Width > 0)
+                    break;
+
+                Nodes.RemoveAt(i);
+            }
+
+            // Merge neighbours at the same height
+            for (int32 i = 0; i + 1 < Nodes.Num(); )
+            {
+                if (Nodes[i].Y == Nodes[i + 1].Y)
+                {
+                    Nodes[i].Width += Nodes[i + 1].Width;
+                    Nodes.RemoveAt(i + 1);
+                }
+                else
+                {
+                    i++;
+                }
+            }
+        }
+
+        int32 BinWidth;
+        const TArray<FCellRect>& Obstacles;
+        TArray<FSkylineNode> Nodes;
+    };
+}
+
+void FRefBoardPacker::Pack(const TArray<FVector2D>& Sizes, const FVector2D& Origin, float CellSize,
+    const TArray<FBox2D>& Obstacles, TArray<FVector2D>& OutPositions)
+{
+    OutPositions.SetNumUninitialized(Sizes.Num());
+    if (Sizes.Num() == 0)
+        return;
+
+    CellSize = FMath::Max(CellSize, 1.0f);
+
+    // Item footprints in cells, spacing on the right and bottom
+    TArray<FIntPoint> Cells;
+    Cells.SetNumUninitialized(Sizes.Num());
+    int64 TotalArea = 0;
+    int32 MaxWidth = 1;
+    for (int32 i = 0; i < Sizes.Num(); i++)
+    {
+        Cells[i].X = FMath::Max(1, FMath::CeilToInt((Sizes[i].X + Spacing) / CellSize));
+        Cells[i].Y = FMath::Max(1, FMath::CeilToInt((Sizes[i].Y + Spacing) / CellSize));
+        TotalArea += (int64)Cells[i].X * Cells[i].Y;
+        MaxWidth = FMath::Max(MaxWidth, Cells[i].X);
+    }
+
+    // Roughly square result, allowing for some waste
+    const int32 BinWidth = FMath::Max(MaxWidth, FMath::CeilToInt(FMath::Sqrt(TotalArea * 1.1)));
+
+    // Fixed images in cell space, grown by the spacing on the left and top
+    TArray<FCellRect> ObstacleCells;
+    for (const FBox2D& Box : Obstacles)
+    {
+        FCellRect Rect;
+        Rect.MinX = FMath::FloorToInt((Box.Min.X - Spacing - Origin.X) / CellSize);
+        Rect.MinY = FMath::FloorToInt((Box.Min.Y - Spacing - Origin.Y) / CellSize);
+        Rect.MaxX = FMath::CeilToInt((Box.Max.X - Origin.X) / CellSize);
+        Rect.MaxY = FMath::CeilToInt((Box.Max.Y - Origin.Y) / CellSize);
+        if (Rect.MaxX <= 0 || Rect.MaxY <= 0 || Rect.MinX >= BinWidth)
+            continue;
+
+        ObstacleCells.Add(Rect);
+    }
+
+    // Tallest first keeps the skyline flat
+    TArray<int32> Order;
+    Order.SetNumUninitialized(Sizes.Num());
+    for (int32 i = 0; i < Order.Num(); i++)
+    {
+        Order[i] = i;
+    }
+    Order.Sort([&Cells](int32 A, int32 B)
+    {
+        return Cells[A].Y != Cells[B].Y ? Cells[A].Y > Cells[B].Y : Cells[A].X > Cells[B].X;
+    });
+
+    FSkyline Skyline(BinWidth, ObstacleCells);
+    for (int32 Index : Order)
+    {
+        int32 X, Y;
+        Skyline.Insert(Cells[Index].X, Cells[Index].Y, X, Y);
+        OutPositions[Index] = Origin + FVector2D(X, Y) * CellSize;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Skyline bottom-left rectangle packer used to lay out images on the board.
+// Works in whole cells so packed images land on the grid, and treats fixed
+// images as obstacles to pack around.
+class FRefBoardPacker
+{
+public:
+    // Gap kept between packed images, canvas units
+    static constexpr float Spacing = 10.0f;
+
+    // Packs Sizes into a roughly square region whose top-left is Origin.
+    // Positions are Origin plus whole multiples of CellSize, in input order.
+    static void Pack(const TArray<FVector2D>& Sizes, const FVector2D& Origin, float CellSize,
+        const TArray<FBox2D>& Obstacles, TArray<FVector2D>& OutPositions);
+};
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "RefBoardSession.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+FString FRefBoardSession::GetSessionPath()
+{
+    return FPaths::ProjectSavedDir() / TEXT("ReferenceViewer") / TEXT("Session.json");
+}
+
+bool FRefBoardSession::Save(const TArray<FRefSessionBoard>& Boards)
+{
+    TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+    Root->SetNumberField(TEXT("Version"), 1);
+
+    TArray<TSharedPtr<FJsonValue>> BoardValues;
+    BoardValues.Reserve(Boards.Num());
+    for (const FRefSessionBoard& Board : Boards)
+    {
+        TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+        Object->SetStringField(TEXT("Name"), Board.Name);
+        if (!Board.BundlePath.IsEmpty())
+        {
+            Object->SetStringField(TEXT("BundlePath"), Board.BundlePath);
+        }
+        Object->SetBoolField(TEXT("Autosave"), Board.bAutosave);
+        BoardValues.Add(MakeShared<FJsonValueObject>(Object));
+    }
+    Root->SetArrayField(TEXT("Boards"), BoardValues);
+
+    FString Json;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+    if (!FJsonSerializer::Serialize(Root, Writer))
+        return false;
+
+    const FString Path = GetSessionPath();
+    const FString TempPath = Path + TEXT(".tmp");
+    if (!FFileHelper::SaveStringToFile(Json, *TempPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+        return false;
+
+    return IFileManager::Get().Move(*Path, *TempPath, true, true);
+}
+
+bool FRefBoardSession::Load(TArray<FRefSessionBoard>& OutBoards)
+{
+    OutBoards.Reset();
+
+    FString Json;
+    if (!FFileHelper::LoadFileToString(Json, *GetSessionPath()))
+        return false;
+
+    TSharedPtr<FJsonObject> Root;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Json);
+    if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+        return false;
+
+    const TArray<TSharedPtr<FJsonValue>>* BoardValues = nullptr;
+    if (Root->TryGetArrayField(TEXT("Boards"), BoardValues))
+    {
+        OutBoards.Reserve(BoardValues->Num());
+        for (const TSharedPtr<FJsonValue>& Value : *BoardValues)
+        {
+            const TSharedPtr<FJsonObject>* Object = nullptr;
+            if (!Value->TryGetObject(Object))
+                continue;
+
+            FRefSessionBoard& Board = OutBoards.AddDefaulted_GetRef();
+            Board.Name = (*Object)->GetStringField(TEXT("Name"));
+            (*Object)->TryGetStringField(TEXT("BundlePath"), Board.BundlePath);
+            (*Object)->TryGetBoolField(TEXT("Autosave"), Board.bAutosave);
+        }
+    }
+    return true;
+}
\ No newline at end of file
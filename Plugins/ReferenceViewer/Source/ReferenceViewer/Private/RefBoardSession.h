@@ -0,0 +1,26 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// A board that was open when the editor last shut down
+struct FRefSessionBoard
+{
+    FString Name;
+
+    // Bundle the board was last opened from or saved to; empty if it never had one
+    FString BundlePath;
+
+    // The panel held the autosave journal, so its contents come back from there
+    bool bAutosave = false;
+};
+
+// Which boards were open, so the next editor session can reopen them. Only names and
+// paths are kept here; the images themselves live in bundles and the autosave journal.
+class FRefBoardSession
+{
+public:
+    static FString GetSessionPath();
+
+    static bool Save(const TArray<FRefSessionBoard>& Boards);
+    static bool Load(TArray<FRefSessionBoard>& OutBoards);
+};
\ No newline at end of file
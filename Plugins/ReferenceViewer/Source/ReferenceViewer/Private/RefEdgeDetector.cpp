@@ -0,0 +1,236 @@
+#include "RefEdgeDetector.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+#include "Engine/Texture2D.h"
+
+bool FRefEdgeMap::FindNearestEdge(const FVector2D& Point, float Radius, FVector2D& OutPoint) const
+{
+    if (Points.Num() == 0 || Radius <= 0.0f)
+        return false;
+
+    const int32 MinCellX = FMath::Clamp(FMath::FloorToInt((Point.X - Radius) / CellSize), 0, CellsX - 1);
+    const int32 MaxCellX = FMath::Clamp(FMath::FloorToInt((Point.X + Radius) / CellSize), 0, CellsX - 1);
+    const int32 MinCellY = FMath::Clamp(FMath::FloorToInt((Point.Y - Radius) / CellSize), 0, CellsY - 1);
+    const int32 MaxCellY = FMath::Clamp(FMath::FloorToInt((Point.Y + Radius) / CellSize), 0, CellsY - 1);
+
+    float BestDistSq = Radius * Radius;
+    bool bFound = false;
+
+    for (int32 CellY = MinCellY; CellY <= MaxCellY; CellY++)
+    {
+        for (int32 CellX = MinCellX; CellX <= MaxCellX; CellX++)
+        {
+            const int32 Cell = CellY * CellsX + CellX;
+            for (int32 i = CellStart[Cell]; i < CellStart[Cell + 1]; i++)
+            {
+                const FVector2D Candidate(Points[i].X + 0.5f, Points[i].Y + 0.5f);
+                const float DistSq = FVector2D::DistSquared(Candidate, Point);
+                if (DistSq <= BestDistSq)
+                {
+                    BestDistSq = DistSq;
+                    OutPoint = Candidate;
+                    bFound = true;
+                }
+            }
+        }
+    }
+
+    return bFound;
+}
+
+FRefEdgeMapPtr FRefEdgeDetector::Build(const uint8* BGRA, int32 Width, int32 Height)
+{
+    if (!BGRA || Width < 3 || Height < 3)
+        return nullptr;
+
+    // Box-filter down to the working resolution and convert to luminance
+    const int32 Factor = FMath::Max(1, FMath::DivideAndRoundUp(FMath::Max(Width, Height), MaxDimension));
+    const int32 W = Width / Factor;
+    const int32 H = Height / Factor;
+    if (W < 3 || H < 3)
+        return nullptr;
+
+    TArray<float> Luma;
+    Luma.SetNumUninitialized(W * H);
+
+    ParallelFor(H, [&](int32 Y)
+    {
+        const float Norm = 1.0f / (Factor * Factor * 255.0f);
+        for (int32 X = 0; X < W; X++)
+        {
+            uint32 Sum = 0;
+            for (int32 SY = 0; SY < Factor; SY++)
+            {
+                const uint8* Src = BGRA + ((int64)(Y * Factor + SY) * Width + X * Factor) * 4;
+                for (int32 SX = 0; SX < Factor; SX++, Src += 4)
+                {
+                    // Rec. 601 weights in 8.8 fixed point
+                    Sum += (Src[2] * 77 + Src[1] * 150 + Src[0] * 29) >> 8;
+                }
+            }
+            Luma[Y * W + X] = Sum * Norm;
+        }
+    });
+
+    // Sobel gradients, four pixels per iteration
+    TArray<float> GradX, GradY, MagSq;
+    GradX.SetNumZeroed(W * H);
+    GradY.SetNumZeroed(W * H);
+    MagSq.SetNumZeroed(W * H);
+
+    ParallelFor(H - 2, [&](int32 Row)
+    {
+        const int32 Y = Row + 1;
+        const float* R0 = Luma.GetData() + (Y - 1) * W;
+        const float* R1 = Luma.GetData() + Y * W;
+        const float* R2 = Luma.GetData() + (Y + 1) * W;
+        float* OutX = GradX.GetData() + Y * W;
+        float* OutY = GradY.GetData() + Y * W;
+        float* OutMag = MagSq.GetData() + Y * W;
+
+        const VectorRegister4Float Two = VectorSetFloat1(2.0f);
+
+        int32 X = 1;
+        for (; X + 4 <= W - 1; X += 4)
+        {
+            const VectorRegister4Float L0 = VectorLoad(R0 + X - 1), C0 = VectorLoad(R0 + X), H0 = VectorLoad(R0 + X + 1);
+            const VectorRegister4Float L1 = VectorLoad(R1 + X - 1), H1 = VectorLoad(R1 + X + 1);
+            const VectorRegister4Float L2 = VectorLoad(R2 + X - 1), C2 = VectorLoad(R2 + X), H2 = VectorLoad(R2 + X + 1);
+
+            // Gx = (H0 - L0) + 2 (H1 - L1) + (H2 - L2)
+            const VectorRegister4Float Gx = VectorMultiplyAdd(Two, VectorSubtract(H1, L1),
+                VectorAdd(VectorSubtract(H0, L0), VectorSubtract(H2, L2)));
+            // Gy = (L2 + 2 C2 + H2) - (L0 + 2 C0 + H0)
+            const VectorRegister4Float Gy = VectorMultiplyAdd(Two, VectorSubtract(C2, C0),
+                VectorSubtract(VectorAdd(L2, H2), VectorAdd(L0, H0)));
+
+            VectorStore(Gx, OutX + X);
+            VectorStore(Gy, OutY + X);
+            VectorStore(VectorMultiplyAdd(Gx, Gx, VectorMultiply(Gy, Gy)), OutMag + X);
+        }
+
+        for (; X < W - 1; X++)
+        {
+            const float Gx = (R0[X + 1] - R0[X - 1]) + 2.0f * (R1[X + 1] - R1[X - 1]) + (R2[X + 1] - R2[X - 1]);
+            const float Gy = (R2[X - 1] + 2.0f * R2[X] + R2[X + 1]) - (R0[X - 1] + 2.0f * R0[X] + R0[X + 1]);
+            OutX[X] = Gx;
+            OutY[X] = Gy;
+            OutMag[X] = Gx * Gx + Gy * Gy;
+        }
+    });
+
+    float MaxMagSq = 0.0f;
+    for (float Value : MagSq)
+    {
+        MaxMagSq = FMath::Max(MaxMagSq, Value);
+    }
+
+    TSharedPtr<FRefEdgeMap, ESPMode::ThreadSafe> EdgeMap = MakeShared<FRefEdgeMap, ESPMode::ThreadSafe>();
+    EdgeMap->Width = W;
+    EdgeMap->Height = H;
+    EdgeMap->Strength.SetNumZeroed(W * H);
+    EdgeMap->CellsX = FMath::DivideAndRoundUp(W, EdgeMap->CellSize);
+    EdgeMap->CellsY = FMath::DivideAndRoundUp(H, EdgeMap->CellSize);
+
+    if (MaxMagSq <= KINDA_SMALL_NUMBER)
+    {
+        EdgeMap->CellStart.SetNumZeroed(EdgeMap->CellsX * EdgeMap->CellsY + 1);
+        return EdgeMap;
+    }
+
+    // Threshold and thin along the dominant gradient axis
+    const float ThresholdSq = MaxMagSq * EdgeThreshold * EdgeThreshold;
+    const float InvMaxMag = 1.0f / FMath::Sqrt(MaxMagSq);
+
+    ParallelFor(H - 2, [&](int32 Row)
+    {
+        const int32 Y = Row + 1;
+        for (int32 X = 1; X < W - 1; X++)
+        {
+            const int32 Index = Y * W + X;
+            const float Mag = MagSq[Index];
+            if (Mag < ThresholdSq)
+                continue;
+
+            const bool bHorizontal = FMath::Abs(GradX[Index]) >= FMath::Abs(GradY[Index]);
+            const int32 Step = bHorizontal ? 1 : W;
+            if (Mag < MagSq[Index - Step] || Mag < MagSq[Index + Step])
+                continue;
+
+            EdgeMap->Strength[Index] = (uint8)FMath::Clamp(FMath::Sqrt(Mag) * InvMaxMag * 255.0f, 1.0f, 255.0f);
+        }
+    });
+
+    // Bucket edge pixels into the grid
+    const int32 NumCells = EdgeMap->CellsX * EdgeMap->CellsY;
+    EdgeMap->CellStart.SetNumZeroed(NumCells + 1);
+    for (int32 Y = 0; Y < H; Y++)
+    {
+        for (int32 X = 0; X < W; X++)
+        {
+            if (EdgeMap->Strength[Y * W + X])
+            {
+                EdgeMap->CellStart[(Y / EdgeMap->CellSize) * EdgeMap->CellsX + X / EdgeMap->CellSize + 1]++;
+            }
+        }
+    }
+    for (int32 Cell = 0; Cell < NumCells; Cell++)
+    {
+        EdgeMap->CellStart[Cell + 1] += EdgeMap->CellStart[Cell];
+    }
+
+    EdgeMap->Points.SetNumUninitialized(EdgeMap->CellStart[NumCells]);
+    TArray<int32> Cursor(EdgeMap->CellStart.GetData(), NumCells);
+    for (int32 Y = 0; Y < H; Y++)
+    {
+        for (int32 X = 0; X < W; X++)
+        {
+            if (EdgeMap->Strength[Y * W + X])
+            {
+                const int32 Cell = (Y / EdgeMap->CellSize) * EdgeMap->CellsX + X / EdgeMap->CellSize;
+                EdgeMap->Points[Cursor[Cell]++] = { (uint16)X, (uint16)Y };
+            }
+        }
+    }
+
+    return EdgeMap;
+}
+
+void FRefEdgeDetector::BuildAsync(FRefImageProxyPtr Proxy, TFunction<void(FRefEdgeMapPtr)> OnComplete)
+{
+    if (!Proxy.IsValid())
+        return;
+
+    Async(EAsyncExecution::ThreadPool, [Proxy, OnComplete = MoveTemp(OnComplete)]() mutable
+    {
+        FRefEdgeMapPtr EdgeMap = Build(Proxy->BGRA.GetData(), Proxy->Width, Proxy->Height);
+
+        AsyncTask(ENamedThreads::GameThread, [EdgeMap, OnComplete = MoveTemp(OnComplete)]()
+        {
+            OnComplete(EdgeMap);
+        });
+    });
+}
+
+UTexture2D* FRefEdgeDetector::CreateOverlayTexture(const FRefEdgeMap& EdgeMap, const FColor& Color)
+{
+    check(IsInGameThread());
+
+    if (EdgeMap.Width <= 0 || EdgeMap.Height <= 0)
+        return nullptr;
+
+    UTexture2D* Texture = UTexture2D::CreateTransient(EdgeMap.Width, EdgeMap.Height, PF_B8G8R8A8);
+    if (!Texture)
+        return nullptr;
+
+    FColor* Dest = static_cast<FColor*>(Texture->GetPlatformData()->Mips[0].BulkData.Lock(LOCK_READ_WRITE));
+    for (int32 i = 0; i < EdgeMap.Strength.Num(); i++)
+    {
+        Dest[i] = FColor(Color.R, Color.G, Color.B, EdgeMap.Strength[i] ? 255 : 0);
+    }
+    Texture->GetPlatformData()->Mips[0].BulkData.Unlock();
+    Texture->UpdateResource();
+
+    return Texture;
+}
\ No newline at end of file
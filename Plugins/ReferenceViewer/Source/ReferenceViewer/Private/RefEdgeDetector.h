@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+class UTexture2D;
+
+// Edge map extracted from a downsampled copy of a reference image.
+// Built once on a worker thread and immutable afterwards, so it can be shared freely.
+struct FRefEdgeMap
+{
+    struct FEdgePoint
+    {
+        uint16 X;
+        uint16 Y;
+    };
+
+    // Edge map resolution (source image is downsampled to fit MaxDimension)
+    int32 Width = 0;
+    int32 Height = 0;
+
+    // Thinned edge strength per pixel, 0 = no edge
+    TArray<uint8> Strength;
+
+    // Uniform grid over edge pixels in CSR layout:
+    // points of cell i are Points[CellStart[i]] .. Points[CellStart[i + 1] - 1]
+    int32 CellSize = 8;
+    int32 CellsX = 0;
+    int32 CellsY = 0;
+    TArray<int32> CellStart;
+    TArray<FEdgePoint> Points;
+
+    // Nearest edge pixel centre to Point within Radius, both in edge map pixels
+    bool FindNearestEdge(const FVector2D& Point, float Radius, FVector2D& OutPoint) const;
+};
+
+typedef TSharedPtr<const FRefEdgeMap, ESPMode::ThreadSafe> FRefEdgeMapPtr;
+
+// Sobel edge extraction with non-maximum thinning
+class FRefEdgeDetector
+{
+public:
+    // Largest edge map side; bigger images are box-filtered down first
+    static constexpr int32 MaxDimension = 1024;
+
+    // Fraction of the strongest gradient below which pixels are discarded
+    static constexpr float EdgeThreshold = 0.2f;
+
+    static FRefEdgeMapPtr Build(const uint8* BGRA, int32 Width, int32 Height);
+
+    // Builds from the image proxy on the thread pool. OnComplete runs on the game thread.
+    static void BuildAsync(FRefImageProxyPtr Proxy, TFunction<void(FRefEdgeMapPtr)> OnComplete);
+
+    // Transparent texture with the edges drawn in Color, for the outline overlay. Game thread only.
+    static UTexture2D* CreateOverlayTexture(const FRefEdgeMap& EdgeMap, const FColor& Color);
+};
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "RefFolderWatch.h"
+#include "SReferenceCanvas.h"
+#include "RefImageLoader.h"
+#include "DirectoryWatcherModule.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Hash/CityHash.h"
+
+namespace
+{
+    FString NormalizePath(const FString& Path)
+    {
+        FString Result = FPaths::ConvertRelativePathToFull(Path);
+        FPaths::NormalizeFilename(Result);
+        return Result;
+    }
+}
+
+FRefFolderWatch::FRefFolderWatch(const FString& InFolder, TSharedPtr<SReferenceCanvas> InCanvas)
+    : Folder(NormalizePath(InFolder))
+    , Canvas(InCanvas)
+    , NumInFlight(0)
+{
+}
+
+FRefFolderWatch::~FRefFolderWatch()
+{
+    if (WatcherHandle.IsValid())
+    {
+        if (FDirectoryWatcherModule* Module = FModuleManager::GetModulePtr<FDirectoryWatcherModule>(TEXT("DirectoryWatcher")))
+        {
+            if (IDirectoryWatcher* Watcher = Module->Get())
+            {
+                Watcher->UnregisterDirectoryChangedCallback_Handle(Folder, WatcherHandle);
+            }
+        }
+    }
+}
+
+bool FRefFolderWatch::IsSupportedFile(const FString& FilePath)
+{
+    const FString Extension = FPaths::GetExtension(FilePath);
+    return Extension.Equals(TEXT("png"), ESearchCase::IgnoreCase)
+        || Extension.Equals(TEXT("jpg"), ESearchCase::IgnoreCase)
+        || Extension.Equals(TEXT("jpeg"), ESearchCase::IgnoreCase)
+        || Extension.Equals(TEXT("bmp"), ESearchCase::IgnoreCase)
+        || Extension.Equals(TEXT("tga"), ESearchCase::IgnoreCase)
+        || Extension.Equals(TEXT("exr"), ESearchCase::IgnoreCase)
+        || Extension.Equals(TEXT("hdr"), ESearchCase::IgnoreCase);
+}
+
+void FRefFolderWatch::Start()
+{
+    TSharedPtr<SReferenceCanvas> CanvasPtr = Canvas.Pin();
+    if (!CanvasPtr.IsValid())
+        return;
+
+    // Images from this folder already on the board are kept as they are
+    for (const TSharedPtr<FRefImage>& Image : CanvasPtr->GetImages())
+    {
+        if (Image->FilePath.IsEmpty())
+            continue;
+
+        const FString FilePath = NormalizePath(Image->FilePath);
+        if (FPaths::GetPath(FilePath) != Folder)
+            continue;
+
+        const FFileStatData Stat = IFileManager::Get().GetStatData(*FilePath);
+        if (!Stat.bIsValid)
+            continue;
+
+        FFileEntry& Entry = Files.FindOrAdd(FilePath);
+        Entry.Image = Image;
+        Entry.Timestamp = Stat.ModificationTime;
+        Entry.Size = Stat.FileSize;
+    }
+
+    Rescan();
+
+    IDirectoryWatcher* Watcher = FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>(TEXT("DirectoryWatcher")).Get();
+    if (Watcher)
+    {
+        Watcher->RegisterDirectoryChangedCallback_Handle(
+            Folder,
+            IDirectoryWatcher::FDirectoryChanged::CreateSP(this, &FRefFolderWatch::HandleDirectoryChanged),
+            WatcherHandle,
+            IDirectoryWatcher::WatchOptions::IgnoreChangesInSubtree);
+    }
+}
+
+void FRefFolderWatch::HandleDirectoryChanged(const TArray<FFileChangeData>& Changes)
+{
+    // Only the files named in the events are looked at
+    for (const FFileChangeData& Change : Changes)
+    {
+        if (Change.Action == FFileChangeData::FCA_RescanRequired)
+        {
+            Rescan();
+            continue;
+        }
+
+        const FString FilePath = NormalizePath(Change.Filename);
+        if (!IsSupportedFile(FilePath) || FPaths::GetPath(FilePath) != Folder)
+            continue;
+
+        const FFileStatData Stat = IFileManager::Get().GetStatData(*FilePath);
+        if (Change.Action == FFileChangeData::FCA_Removed || !Stat.bIsValid)
+        {
+            RemoveFile(FilePath);
+        }
+        else if (!Stat.bIsDirectory)
+        {
+            CheckFile(FilePath, Stat.ModificationTime, Stat.FileSize);
+        }
+    }
+
+    PumpQueue();
+}
+
+void FRefFolderWatch::Rescan()
+{
+    // Stat-only pass; nothing is read unless its timestamp or size moved
+    TSet<FString> Seen;
+    IFileManager::Get().IterateDirectoryStat(*Folder, [this, &Seen](const TCHAR* Name, const FFileStatData& Stat)
+    {
+        if (!Stat.bIsDirectory && IsSupportedFile(Name))
+        {
+            const FString FilePath = NormalizePath(Name);
+            Seen.Add(FilePath);
+            CheckFile(FilePath, Stat.ModificationTime, Stat.FileSize);
+        }
+        return true;
+    });
+
+    TArray<FString> Missing;
+    for (const auto& Pair : Files)
+    {
+        if (!Seen.Contains(Pair.Key))
+        {
+            Missing.Add(Pair.Key);
+        }
+    }
+    for (const FString& FilePath : Missing)
+    {
+        RemoveFile(FilePath);
+    }
+
+    PumpQueue();
+}
+
+void FRefFolderWatch::CheckFile(const FString& FilePath, const FDateTime& Timestamp, int64 Size)
+{
+    FFileEntry& Entry = Files.FindOrAdd(FilePath);
+    if (Entry.Size == Size && Entry.Timestamp == Timestamp)
+        return;
+
+    Entry.Timestamp = Timestamp;
+    Entry.Size = Size;
+    if (!Entry.bQueued)
+    {
+        Entry.bQueued = true;
+        Queue.Add(FilePath);
+    }
+}
+
+void FRefFolderWatch::RemoveFile(const FString& FilePath)
+{
+    FFileEntry Entry;
+    if (!Files.RemoveAndCopyValue(FilePath, Entry))
+        return;
+
+    TSharedPtr<SReferenceCanvas> CanvasPtr = Canvas.Pin();
+    TSharedPtr<FRefImage> Image = Entry.Image.Pin();
+    if (CanvasPtr.IsValid() && Image.IsValid())
+    {
+        CanvasPtr->RemoveImage(Image);
+    }
+    PendingPlacement.Remove(Image);
+}
+
+void FRefFolderWatch::PumpQueue()
+{
+    while (NumInFlight < MaxConcurrentDecodes && Queue.Num() > 0)
+    {
+        const FString FilePath = Queue[0];
+        Queue.RemoveAt(0, 1, EAllowShrinking::No);
+
+        FFileEntry* Entry = Files.Find(FilePath);
+        if (!Entry)
+            continue;
+
+        Entry->bQueued = false;
+        const uint64 PreviousHash = Entry->Hash;
+        NumInFlight++;
+
+        TWeakPtr<FRefFolderWatch> WeakWatch = AsShared();
+        Async(EAsyncExecution::ThreadPool, [WeakWatch, FilePath, PreviousHash]()
+        {
+            TSharedPtr<FLoadResult, ESPMode::ThreadSafe> Result = MakeShared<FLoadResult, ESPMode::ThreadSafe>();
+
+            TArray64<uint8> FileData;
+            if (FFileHelper::LoadFileToArray(FileData, *FilePath))
+            {
+                // Touched but identical files (re-saves, syncs) stop here
+                Result->Hash = CityHash64(reinterpret_cast<const char*>(FileData.GetData()), (uint32)FileData.Num());
+                if (Result->Hash != PreviousHash
+                    && FRefImageLoader::DecodeMemory(FileData.GetData(), FileData.Num(), Result->BGRA, Result->Width, Result->Height))
+                {
+                    Result->Proxy = FRefImageLoader::MakeProxy(Result->BGRA.GetData(), Result->Width, Result->Height);
+                    Result->bChanged = true;
+                }
+            }
+
+            AsyncTask(ENamedThreads::GameThread, [WeakWatch, FilePath, Result]()
+            {
+                if (TSharedPtr<FRefFolderWatch> Watch = WeakWatch.Pin())
+                {
+                    Watch->OnFileLoaded(FilePath, Result);
+                }
+            });
+        });
+    }
+}
+
+void FRefFolderWatch::OnFileLoaded(const FString& FilePath, TSharedPtr<FLoadResult, ESPMode::ThreadSafe> Result)
+{
+    NumInFlight--;
+
+    TSharedPtr<SReferenceCanvas> CanvasPtr = Canvas.Pin();
+    FFileEntry* Entry = Files.Find(FilePath);
+    if (CanvasPtr.IsValid() && Entry && Result->bChanged)
+    {
+        Entry->Hash = Result->Hash;
+
+        TSharedPtr<FRefImage> Image = Entry->Image.Pin();
+
+        if (Image.IsValid() && CanvasPtr->GetImages().Contains(Image))
+        {
+            // Same position and width; height follows the new aspect ratio of the cropped region
+            CanvasPtr->InvalidateMinimap(Image->GetBounds());
+            const FVector2f UVSize = Image->UVRegion.GetSize();
+            Image->Size.Y = Image->Size.X * (Result->Height * UVSize.Y) / FMath::Max(1.0f, Result->Width * UVSize.X);
+            Image->Proxy = FRefImageLoader::CropProxy(Result->Proxy, Image->UVRegion);
+            Image->MarkGroupDirty();
+
+            // Pixels now come from the file, not from a bundle it was saved into
+            Image->Bundle.Reset();
+            Image->BundleIndex = INDEX_NONE;
+            CanvasPtr->BuildEdgeMap(Image);
+        }
+        else if (!PendingPlacement.Contains(Image))
+        {
+            Image = MakeShareable(new FRefImage());
+            Image->FilePath = FilePath;
+            Image->Name = FPaths::GetBaseFilename(FilePath);
+            Image->Proxy = Result->Proxy;
+            Image->Size = FVector2D(Result->Width, Result->Height);
+            Entry->Image = Image;
+            PendingPlacement.Add(Image);
+        }
+        else
+        {
+            // Changed again before it was placed
+            Image->Proxy = Result->Proxy;
+            Image->Size = FVector2D(Result->Width, Result->Height);
+        }
+
+        // Old pixels stay up until the new ones are uploaded; a later change replaces this upload
+        CanvasPtr->QueueImageUpload(Image, MoveTemp(Result->BGRA), Result->Width, Result->Height);
+    }
+
+    PumpQueue();
+
+    if (CanvasPtr.IsValid() && Queue.Num() == 0 && NumInFlight == 0 && PendingPlacement.Num() > 0)
+    {
+        for (const TSharedPtr<FRefImage>& Image : PendingPlacement)
+        {
+            CanvasPtr->AddImage(Image);
+            CanvasPtr->BuildEdgeMap(Image);
+        }
+        CanvasPtr->PackNewImages(PendingPlacement);
+        PendingPlacement.Reset();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IDirectoryWatcher.h"
+#include "RefViewerData.h"
+
+class SReferenceCanvas;
+
+// Keeps a board in sync with the images in one folder. File events from the
+// directory watcher are filtered by modification time and size, then by a
+// content hash on a worker. Only files whose bytes really changed are decoded,
+// and the new pixels are swapped into the existing image in place.
+class FRefFolderWatch : public TSharedFromThis<FRefFolderWatch>
+{
+public:
+    // Files read and decoded at once; bounds memory when a large folder is bound
+    static constexpr int32 MaxConcurrentDecodes = 4;
+
+    FRefFolderWatch(const FString& InFolder, TSharedPtr<SReferenceCanvas> InCanvas);
+    ~FRefFolderWatch();
+
+    // Adopts images already on the board from this folder, loads the rest and starts watching
+    void Start();
+
+    const FString& GetFolder() const { return Folder; }
+
+    static bool IsSupportedFile(const FString& FilePath);
+
+private:
+    struct FFileEntry
+    {
+        FDateTime Timestamp;
+        int64 Size = -1;
+        uint64 Hash = 0;
+        TWeakPtr<FRefImage> Image;
+        bool bQueued = false;
+    };
+
+    struct FLoadResult
+    {
+        bool bChanged = false;
+        uint64 Hash = 0;
+        TArray64<uint8> BGRA;
+        int32 Width = 0;
+        int32 Height = 0;
+        FRefImageProxyPtr Proxy;
+    };
+
+    void HandleDirectoryChanged(const TArray<FFileChangeData>& Changes);
+    void Rescan();
+    void CheckFile(const FString& FilePath, const FDateTime& Timestamp, int64 Size);
+    void RemoveFile(const FString& FilePath);
+    void PumpQueue();
+    void OnFileLoaded(const FString& FilePath, TSharedPtr<FLoadResult, ESPMode::ThreadSafe> Result);
+
+    FString Folder;
+    TWeakPtr<SReferenceCanvas> Canvas;
+    FDelegateHandle WatcherHandle;
+
+    TMap<FString, FFileEntry> Files;
+    TArray<FString> Queue;
+    int32 NumInFlight;
+
+    // New files are placed together once the queue drains
+    TArray<TSharedPtr<FRefImage>> PendingPlacement;
+};
\ No newline at end of file
@@ -0,0 +1,366 @@
+#include "RefGifDecoder.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+    constexpr int32 MaxCodes = 4096;
+
+    // Header sizes go up to 65535 a side; past this a frame is taken as corrupt rather than allocated
+    constexpr int64 MaxFramePixels = 16384 * 16384;
+
+    // Bounds-checked little-endian reader over the file
+    struct FGifReader
+    {
+        const TArray64<uint8>& Data;
+        int64 Pos = 0;
+        bool bError = false;
+
+        explicit FGifReader(const TArray64<uint8>& InData) : Data(InData) {}
+
+        uint8 Byte()
+        {
+            if (Pos >= Data.Num())
+            {
+                bError = true;
+                return 0;
+            }
+            return Data[Pos++];
+        }
+
+        uint16 Word()
+        {
+            const uint8 Low = Byte();
+            return Low | (Byte() << 8);
+        }
+
+        void Skip(int64 Count)
+        {
+            Pos += Count;
+            bError |= Pos > Data.Num();
+        }
+
+        void SkipSubBlocks()
+        {
+            for (uint8 Length = Byte(); Length != 0 && !bError; Length = Byte())
+            {
+                Skip(Length);
+            }
+        }
+    };
+}
+
+bool FRefGifDecoder::Open(const FString& FilePath)
+{
+    if (!FFileHelper::LoadFileToArray(Data, *FilePath))
+        return false;
+
+    return Parse();
+}
+
+bool FRefGifDecoder::Parse()
+{
+    FGifReader Reader(Data);
+    if (Data.Num() < 13 || FMemory::Memcmp(Data.GetData(), "GIF8", 4) != 0)
+        return false;
+
+    Reader.Skip(6);
+    Width = Reader.Word();
+    Height = Reader.Word();
+    const uint8 ScreenFlags = Reader.Byte();
+    Reader.Skip(2);
+
+    if (ScreenFlags & 0x80)
+    {
+        GlobalPaletteOffset = Reader.Pos;
+        GlobalPaletteSize = 1 << ((ScreenFlags & 0x07) + 1);
+        Reader.Skip(GlobalPaletteSize * 3);
+    }
+
+    // Graphic control extension applies to the next image only
+    FFrame Pending;
+
+    while (!Reader.bError)
+    {
+        const uint8 Introducer = Reader.Byte();
+        if (Introducer == 0x3B)
+            break;
+
+        if (Introducer == 0x21)
+        {
+            const uint8 Label = Reader.Byte();
+            if (Label == 0xF9)
+            {
+                const uint8 BlockSize = Reader.Byte();
+                const uint8 Flags = Reader.Byte();
+                const uint16 Delay = Reader.Word();
+                const uint8 Transparent = Reader.Byte();
+                Reader.Skip(BlockSize - 4);
+
+                Pending.Disposal = (Flags >> 2) & 0x07;
+                Pending.TransparentIndex = (Flags & 0x01) ? Transparent : INDEX_NONE;
+                Pending.Duration = Delay >= 2 ? Delay / 100.0f : DefaultFrameDuration;
+            }
+            Reader.SkipSubBlocks();
+        }
+        else if (Introducer == 0x2C)
+        {
+            FFrame Frame = Pending;
+            Pending = FFrame();
+
+            Frame.Left = Reader.Word();
+            Frame.Top = Reader.Word();
+            Frame.Width = Reader.Word();
+            Frame.Height = Reader.Word();
+            const uint8 Flags = Reader.Byte();
+            Frame.bInterlaced = (Flags & 0x40) != 0;
+
+            if (Flags & 0x80)
+            {
+                Frame.PaletteOffset = Reader.Pos;
+                Frame.PaletteSize = 1 << ((Flags & 0x07) + 1);
+                Reader.Skip(Frame.PaletteSize * 3);
+            }
+            else
+            {
+                Frame.PaletteOffset = GlobalPaletteOffset;
+                Frame.PaletteSize = GlobalPaletteSize;
+            }
+
+            Frame.MinCodeSize = Reader.Byte();
+            Frame.DataOffset = Reader.Pos;
+            Reader.SkipSubBlocks();
+
+            // A truncated last frame is kept; it decodes as far as the data goes
+            if (Frame.DataOffset < Data.Num() && Frame.PaletteSize > 0 && Frame.MinCodeSize >= 2 && Frame.MinCodeSize <= 11)
+            {
+                Frames.Add(Frame);
+            }
+        }
+        else
+        {
+            // Unknown block; keep the frames read so far
+            break;
+        }
+    }
+
+    return Width > 0 && Height > 0 && (int64)Width * Height <= MaxFramePixels && Frames.Num() > 0;
+}
+
+float FRefGifDecoder::GetFrameDuration(int32 Frame) const
+{
+    return Frames.IsValidIndex(Frame) ? Frames[Frame].Duration : DefaultFrameDuration;
+}
+
+bool FRefGifDecoder::Decompress(const FFrame& Frame, TArray<uint8>& OutIndices) const
+{
+    const int64 NumPixels = (int64)Frame.Width * Frame.Height;
+    if (NumPixels <= 0 || NumPixels > MaxFramePixels)
+        return false;
+
+    OutIndices.SetNumZeroed(NumPixels);
+
+    uint16 Prefix[MaxCodes];
+    uint8 Suffix[MaxCodes];
+    uint8 Stack[MaxCodes + 1];
+
+    const int32 ClearCode = 1 << Frame.MinCodeSize;
+    const int32 EndCode = ClearCode + 1;
+    for (int32 Code = 0; Code < ClearCode; Code++)
+    {
+        Prefix[Code] = 0;
+        Suffix[Code] = (uint8)Code;
+    }
+
+    int32 CodeSize = Frame.MinCodeSize + 1;
+    int32 NextCode = ClearCode + 2;
+    int32 OldCode = INDEX_NONE;
+    uint8 FirstByte = 0;
+
+    // Bit reader across the data sub-blocks
+    int64 Pos = Frame.DataOffset;
+    int32 BlockRemaining = 0;
+    uint32 Bits = 0;
+    int32 NumBits = 0;
+    int64 Written = 0;
+
+    while (Written < NumPixels)
+    {
+        while (NumBits < CodeSize)
+        {
+            if (BlockRemaining == 0)
+            {
+                if (Pos >= Data.Num() || Data[Pos] == 0)
+                    return Written > 0;
+                BlockRemaining = Data[Pos++];
+            }
+            if (Pos >= Data.Num())
+                return Written > 0;
+
+            Bits |= (uint32)Data[Pos++] << NumBits;
+            NumBits += 8;
+            BlockRemaining--;
+        }
+
+        int32 Code = Bits & ((1 << CodeSize) - 1);
+        Bits >>= CodeSize;
+        NumBits -= CodeSize;
+
+        if (Code == ClearCode)
+        {
+            CodeSize = Frame.MinCodeSize + 1;
+            NextCode = ClearCode + 2;
+            OldCode = INDEX_NONE;
+            continue;
+        }
+        if (Code == EndCode)
+            break;
+
+        if (OldCode == INDEX_NONE)
+        {
+            if (Code >= ClearCode)
+                return false;
+
+            OutIndices[Written++] = (uint8)Code;
+            FirstByte = (uint8)Code;
+            OldCode = Code;
+            continue;
+        }
+
+        const int32 InCode = Code;
+        int32 StackSize = 0;
+
+        // Code not in the table yet: previous string plus its own first byte
+        if (Code >= NextCode)
+        {
+            if (Code > NextCode)
+                return false;
+
+            Stack[StackSize++] = FirstByte;
+            Code = OldCode;
+        }
+
+        while (Code >= ClearCode)
+        {
+            Stack[StackSize++] = Suffix[Code];
+            Code = Prefix[Code];
+        }
+        FirstByte = (uint8)Code;
+        Stack[StackSize++] = FirstByte;
+
+        if (NextCode < MaxCodes)
+        {
+            Prefix[NextCode] = (uint16)OldCode;
+            Suffix[NextCode] = FirstByte;
+            NextCode++;
+            if (NextCode == (1 << CodeSize) && CodeSize < 12)
+            {
+                CodeSize++;
+            }
+        }
+        OldCode = InCode;
+
+        while (StackSize > 0 && Written < NumPixels)
+        {
+            OutIndices[Written++] = Stack[--StackSize];
+        }
+    }
+
+    return true;
+}
+
+bool FRefGifDecoder::ApplyFrame(int32 Index)
+{
+    // Dispose of the previous frame first
+    if (Index > 0)
+    {
+        const FFrame& Previous = Frames[Index - 1];
+        if (Previous.Disposal == 2)
+        {
+            for (int32 Y = FMath::Max(0, Previous.Top); Y < FMath::Min(Height, Previous.Top + Previous.Height); Y++)
+            {
+                for (int32 X = FMath::Max(0, Previous.Left); X < FMath::Min(Width, Previous.Left + Previous.Width); X++)
+                {
+                    Canvas[Y * Width + X] = FColor(0, 0, 0, 0);
+                }
+            }
+        }
+        else if (Previous.Disposal == 3 && SavedCanvas.Num() == Canvas.Num())
+        {
+            Canvas = SavedCanvas;
+        }
+    }
+
+    const FFrame& Frame = Frames[Index];
+    if (Frame.Disposal == 3)
+    {
+        SavedCanvas = Canvas;
+    }
+
+    TArray<uint8> Indices;
+    if (!Decompress(Frame, Indices))
+        return false;
+
+    const uint8* Palette = Data.GetData() + Frame.PaletteOffset;
+
+    for (int32 Row = 0; Row < Frame.Height; Row++)
+    {
+        // Interlaced rows arrive as every 8th from 0, every 8th from 4, every 4th from 2, then odd rows
+        int32 SourceRow = Row;
+        if (Frame.bInterlaced)
+        {
+            const int32 Pass1 = (Frame.Height + 7) / 8;
+            const int32 Pass2 = (Frame.Height + 3) / 8;
+            const int32 Pass3 = (Frame.Height + 1) / 4;
+            if (Row % 8 == 0) SourceRow = Row / 8;
+            else if (Row % 8 == 4) SourceRow = Pass1 + Row / 8;
+            else if (Row % 4 == 2) SourceRow = Pass1 + Pass2 + Row / 4;
+            else SourceRow = Pass1 + Pass2 + Pass3 + Row / 2;
+        }
+
+        const int32 Y = Frame.Top + Row;
+        if (Y < 0 || Y >= Height)
+            continue;
+
+        const uint8* RowIndices = Indices.GetData() + SourceRow * Frame.Width;
+        for (int32 Column = 0; Column < Frame.Width; Column++)
+        {
+            const int32 X = Frame.Left + Column;
+            const int32 ColorIndex = RowIndices[Column];
+            if (X < 0 || X >= Width || ColorIndex == Frame.TransparentIndex || ColorIndex >= Frame.PaletteSize)
+                continue;
+
+            const uint8* Rgb = Palette + ColorIndex * 3;
+            Canvas[Y * Width + X] = FColor(Rgb[0], Rgb[1], Rgb[2], 255);
+        }
+    }
+
+    return true;
+}
+
+bool FRefGifDecoder::DecodeFrame(int32 Frame, TArray64<uint8>& OutBGRA)
+{
+    if (!Frames.IsValidIndex(Frame))
+        return false;
+
+    // Frames build on each other: going back means replaying from the start
+    if (LastFrame == INDEX_NONE || Frame <= LastFrame)
+    {
+        Canvas.Init(FColor(0, 0, 0, 0), Width * Height);
+        SavedCanvas.Reset();
+        LastFrame = INDEX_NONE;
+    }
+
+    for (int32 Index = LastFrame + 1; Index <= Frame; Index++)
+    {
+        if (!ApplyFrame(Index))
+        {
+            LastFrame = INDEX_NONE;
+            return false;
+        }
+        LastFrame = Index;
+    }
+
+    OutBGRA.SetNumUninitialized((int64)Width * Height * 4);
+    FMemory::Memcpy(OutBGRA.GetData(), Canvas.GetData(), OutBGRA.Num());
+    return true;
+}
\ No newline at end of file
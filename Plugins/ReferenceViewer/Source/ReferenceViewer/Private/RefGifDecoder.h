@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefAnimation.h"
+
+// GIF87a/89a frame source. The file is scanned once for the frame table; frames
+// are then LZW-decoded and composited on demand, honouring transparency and
+// disposal. GIF frames build on each other, so decoding is sequential: stepping
+// forward is incremental and stepping back restarts from the first frame.
+class FRefGifDecoder : public FRefFrameSource
+{
+public:
+    // Browsers' convention for a zero or tiny frame delay
+    static constexpr float DefaultFrameDuration = 0.1f;
+
+    bool Open(const FString& FilePath);
+
+    virtual int32 GetNumFrames() const override { return Frames.Num(); }
+    virtual int32 GetWidth() const override { return Width; }
+    virtual int32 GetHeight() const override { return Height; }
+    virtual float GetFrameDuration(int32 Frame) const override;
+    virtual bool DecodeFrame(int32 Frame, TArray64<uint8>& OutBGRA) override;
+
+private:
+    struct FFrame
+    {
+        int32 Left = 0;
+        int32 Top = 0;
+        int32 Width = 0;
+        int32 Height = 0;
+        bool bInterlaced = false;
+        int64 PaletteOffset = 0;
+        int32 PaletteSize = 0;
+        int32 TransparentIndex = INDEX_NONE;
+        uint8 Disposal = 0;
+        float Duration = DefaultFrameDuration;
+        int32 MinCodeSize = 0;
+        int64 DataOffset = 0;
+    };
+
+    bool Parse();
+    bool Decompress(const FFrame& Frame, TArray<uint8>& OutIndices) const;
+    bool ApplyFrame(int32 Index);
+
+    TArray64<uint8> Data;
+    int32 Width = 0;
+    int32 Height = 0;
+    int64 GlobalPaletteOffset = 0;
+    int32 GlobalPaletteSize = 0;
+    TArray<FFrame> Frames;
+
+    // Composited state after LastFrame
+    TArray<FColor> Canvas;
+    TArray<FColor> SavedCanvas;
+    int32 LastFrame = INDEX_NONE;
+};
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "RefGroupProxy.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+
+FRefImageProxyPtr FRefGroupProxyBuilder::Composite(const TArray<FRefGroupProxyLayer>& Layers, const FBox2D& Bounds)
+{
+    const FVector2D Extent = Bounds.GetSize();
+    if (!Bounds.bIsValid || Extent.X <= 0.0 || Extent.Y <= 0.0)
+        return nullptr;
+
+    const double Scale = Resolution / FMath::Max(Extent.X, Extent.Y);
+    TSharedPtr<FRefImageProxy, ESPMode::ThreadSafe> Result = MakeShared<FRefImageProxy, ESPMode::ThreadSafe>();
+    Result->Width = FMath::Max(1, FMath::RoundToInt(Extent.X * Scale));
+    Result->Height = FMath::Max(1, FMath::RoundToInt(Extent.Y * Scale));
+    Result->BGRA.SetNumUninitialized(Result->Width * Result->Height * 4);
+
+    const FVector2D CanvasPerPixel(Extent.X / Result->Width, Extent.Y / Result->Height);
+    const FColor PlaceholderColor(90, 90, 90, 255);
+
+    ParallelFor(Result->Height, [&](int32 Y)
+    {
+        const int32 Width = Result->Width;
+        const double CanvasY = Bounds.Min.Y + (Y + 0.5) * CanvasPerPixel.Y;
+
+        // Premultiplied BGRA accumulated in float, so stacked translucent layers don't band
+        TArray<float, TInlineAllocator<Resolution * 4>> Row;
+        Row.SetNumZeroed(Width * 4);
+
+        for (const FRefGroupProxyLayer& Layer : Layers)
+        {
+            const FVector2D LayerSize = Layer.Rect.GetSize();
+            if (LayerSize.X <= 0.0 || LayerSize.Y <= 0.0 || CanvasY < Layer.Rect.Min.Y || CanvasY >= Layer.Rect.Max.Y)
+                continue;
+
+            const double V = (CanvasY - Layer.Rect.Min.Y) / LayerSize.Y;
+            const FRefImageProxy* Proxy = Layer.Proxy.Get();
+            const uint8* SrcRow = Proxy
+                ? Proxy->BGRA.GetData() + (int64)FMath::Min((int32)(V * Proxy->Height), Proxy->Height - 1) * Proxy->Width * 4
+                : nullptr;
+
+            const int32 MinX = FMath::Max(0, FMath::FloorToInt((Layer.Rect.Min.X - Bounds.Min.X) / CanvasPerPixel.X));
+            const int32 MaxX = FMath::Min(Width, FMath::CeilToInt((Layer.Rect.Max.X - Bounds.Min.X) / CanvasPerPixel.X));
+            for (int32 X = MinX; X < MaxX; X++)
+            {
+                const double U = (Bounds.Min.X + (X + 0.5) * CanvasPerPixel.X - Layer.Rect.Min.X) / LayerSize.X;
+                if (U < 0.0 || U >= 1.0)
+                    continue;
+
+                const uint8* Src = SrcRow
+                    ? SrcRow + FMath::Min((int32)(U * Proxy->Width), Proxy->Width - 1) * 4
+                    : &PlaceholderColor.B;
+                const float Alpha = Layer.Opacity * Src[3] / 255.0f;
+                float* Dest = Row.GetData() + X * 4;
+                Dest[0] = Src[0] * Alpha + Dest[0] * (1.0f - Alpha);
+                Dest[1] = Src[1] * Alpha + Dest[1] * (1.0f - Alpha);
+                Dest[2] = Src[2] * Alpha + Dest[2] * (1.0f - Alpha);
+                Dest[3] = 255.0f * Alpha + Dest[3] * (1.0f - Alpha);
+            }
+        }
+
+        uint8* Out = Result->BGRA.GetData() + (int64)Y * Width * 4;
+        for (int32 X = 0; X < Width; X++)
+        {
+            const float* Src = Row.GetData() + X * 4;
+            const float Unpremultiply = Src[3] > 0.0f ? 255.0f / Src[3] : 0.0f;
+            Out[X * 4 + 0] = (uint8)FMath::Clamp(FMath::RoundToInt(Src[0] * Unpremultiply), 0, 255);
+            Out[X * 4 + 1] = (uint8)FMath::Clamp(FMath::RoundToInt(Src[1] * Unpremultiply), 0, 255);
+            Out[X * 4 + 2] = (uint8)FMath::Clamp(FMath::RoundToInt(Src[2] * Unpremultiply), 0, 255);
+            Out[X * 4 + 3] = (uint8)FMath::Clamp(FMath::RoundToInt(Src[3]), 0, 255);
+        }
+    });
+
+    return Result;
+}
+
+void FRefGroupProxyBuilder::CompositeAsync(TArray<FRefGroupProxyLayer> Layers, const FBox2D& Bounds, TFunction<void(FRefImageProxyPtr)> OnComplete)
+{
+    Async(EAsyncExecution::ThreadPool, [Layers = MoveTemp(Layers), Bounds, OnComplete = MoveTemp(OnComplete)]() mutable
+    {
+        FRefImageProxyPtr Result = Composite(Layers, Bounds);
+
+        AsyncTask(ENamedThreads::GameThread, [Result, OnComplete = MoveTemp(OnComplete)]()
+        {
+            OnComplete(Result);
+        });
+    });
+}
\ No newline at end of file
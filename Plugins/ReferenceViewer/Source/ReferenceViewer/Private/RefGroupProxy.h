@@ -0,0 +1,30 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+// One member of a collapsed group, as composited into the group's proxy
+struct FRefGroupProxyLayer
+{
+    // Null draws as a flat placeholder, like the navigator does
+    FRefImageProxyPtr Proxy;
+
+    // Canvas space
+    FBox2D Rect = FBox2D(ForceInit);
+
+    float Opacity = 1.0f;
+};
+
+// Flattens a group into one small image, so a collapsed group of any size draws as a single box
+class FRefGroupProxyBuilder
+{
+public:
+    // Longest side of the composite
+    static constexpr int32 Resolution = 512;
+
+    // Layers back to front over transparency, nearest sampled from their proxies. Any thread.
+    static FRefImageProxyPtr Composite(const TArray<FRefGroupProxyLayer>& Layers, const FBox2D& Bounds);
+
+    // Composites on the thread pool. OnComplete runs on the game thread.
+    static void CompositeAsync(TArray<FRefGroupProxyLayer> Layers, const FBox2D& Bounds, TFunction<void(FRefImageProxyPtr)> OnComplete);
+};
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "RefImageCompare.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+
+namespace
+{
+    // Nearest-neighbour resample of one output row into BGRA floats
+    void ResampleRow(const FRefImageProxy& Proxy, const FBox2D& Rect, const FBox2D& Overlap,
+        int32 OutWidth, float CanvasY, float* OutRow)
+    {
+        const FVector2D RectSize = Rect.GetSize();
+        const int32 SrcY = FMath::Clamp(FMath::FloorToInt((CanvasY - Rect.Min.Y) / RectSize.Y * Proxy.Height), 0, Proxy.Height - 1);
+        const uint8* SrcRow = Proxy.BGRA.GetData() + (int64)SrcY * Proxy.Width * 4;
+
+        const float StepX = Overlap.GetSize().X / OutWidth;
+        for (int32 X = 0; X < OutWidth; X++)
+        {
+            const float CanvasX = Overlap.Min.X + (X + 0.5f) * StepX;
+            const int32 SrcX = FMath::Clamp(FMath::FloorToInt((CanvasX - Rect.Min.X) / RectSize.X * Proxy.Width), 0, Proxy.Width - 1);
+            const uint8* Src = SrcRow + SrcX * 4;
+            OutRow[X * 4 + 0] = Src[0];
+            OutRow[X * 4 + 1] = Src[1];
+            OutRow[X * 4 + 2] = Src[2];
+            OutRow[X * 4 + 3] = Src[3];
+        }
+    }
+
+    // Blue -> green -> yellow -> red ramp
+    FColor HeatColor(float T)
+    {
+        T = FMath::Clamp(T, 0.0f, 1.0f);
+        const FLinearColor Ramp[4] = {
+            FLinearColor(0.0f, 0.0f, 0.4f),
+            FLinearColor(0.0f, 0.8f, 0.2f),
+            FLinearColor(1.0f, 0.9f, 0.0f),
+            FLinearColor(1.0f, 0.0f, 0.0f)
+        };
+        const float Scaled = T * 3.0f;
+        const int32 Index = FMath::Min(FMath::FloorToInt(Scaled), 2);
+        return FMath::Lerp(Ramp[Index], Ramp[Index + 1], Scaled - Index).ToFColor(false);
+    }
+}
+
+FRefDiffResultPtr FRefImageCompare::ComputeDifference(
+    const FRefImageProxy& ProxyA, const FBox2D& RectA,
+    const FRefImageProxy& ProxyB, const FBox2D& RectB,
+    bool bHeatmap)
+{
+    if (ProxyA.Width <= 0 || ProxyB.Width <= 0 || !RectA.Intersect(RectB))
+        return nullptr;
+
+    const FBox2D Overlap = RectA.Overlap(RectB);
+    const FVector2D OverlapSize = Overlap.GetSize();
+    if (OverlapSize.X < 1.0 || OverlapSize.Y < 1.0)
+        return nullptr;
+
+    const float Scale = FMath::Min(1.0, MaxDimension / FMath::Max(OverlapSize.X, OverlapSize.Y));
+
+    TSharedPtr<FRefDiffResult, ESPMode::ThreadSafe> Result = MakeShared<FRefDiffResult, ESPMode::ThreadSafe>();
+    Result->Width = FMath::Max(1, FMath::RoundToInt(OverlapSize.X * Scale));
+    Result->Height = FMath::Max(1, FMath::RoundToInt(OverlapSize.Y * Scale));
+    Result->CanvasRect = Overlap;
+    Result->Pixels.SetNumUninitialized(Result->Width * Result->Height);
+
+    TArray<float> RowErrors;
+    RowErrors.SetNumZeroed(Result->Height);
+
+    ParallelFor(Result->Height, [&](int32 Y)
+    {
+        const int32 Width = Result->Width;
+        const float CanvasY = Overlap.Min.Y + (Y + 0.5f) * OverlapSize.Y / Result->Height;
+
+        TArray<float, TInlineAllocator<4096>> RowA, RowB;
+        RowA.SetNumUninitialized(Width * 4);
+        RowB.SetNumUninitialized(Width * 4);
+        ResampleRow(ProxyA, RectA, Overlap, Width, CanvasY, RowA.GetData());
+        ResampleRow(ProxyB, RectB, Overlap, Width, CanvasY, RowB.GetData());
+
+        // One BGRA pixel per register: |A - B|, then Rec. 601 luminance of the difference
+        const VectorRegister4Float LumaWeights = MakeVectorRegisterFloat(0.114f / 255.0f, 0.587f / 255.0f, 0.299f / 255.0f, 0.0f);
+        const VectorRegister4Float AlphaMask = MakeVectorRegisterFloat(1.0f, 1.0f, 1.0f, 0.0f);
+        float ErrorSum = 0.0f;
+
+        FColor* Out = Result->Pixels.GetData() + (int64)Y * Width;
+        for (int32 X = 0; X < Width; X++)
+        {
+            const VectorRegister4Float Diff = VectorMultiply(
+                VectorAbs(VectorSubtract(VectorLoad(RowA.GetData() + X * 4), VectorLoad(RowB.GetData() + X * 4))),
+                AlphaMask);
+            const float Luma = VectorGetComponent(VectorDot4(Diff, LumaWeights), 0);
+            ErrorSum += Luma;
+
+            if (bHeatmap)
+            {
+                Out[X] = HeatColor(Luma);
+            }
+            else
+            {
+                alignas(16) float Channels[4];
+                VectorStoreAligned(Diff, Channels);
+                Out[X] = FColor((uint8)Channels[2], (uint8)Channels[1], (uint8)Channels[0], 255);
+            }
+        }
+        RowErrors[Y] = ErrorSum;
+    });
+
+    double TotalError = 0.0;
+    for (float RowError : RowErrors)
+    {
+        TotalError += RowError;
+    }
+    Result->MeanError = TotalError / ((double)Result->Width * Result->Height);
+
+    return Result;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+// Difference image between two references over the region where they overlap on the board
+struct FRefDiffResult
+{
+    int32 Width = 0;
+    int32 Height = 0;
+    TArray<FColor> Pixels;
+
+    // Overlap in canvas space that the pixels cover
+    FBox2D CanvasRect = FBox2D(ForceInit);
+
+    // Mean absolute difference over the overlap, 0..1
+    float MeanError = 0.0f;
+};
+
+typedef TSharedPtr<const FRefDiffResult, ESPMode::ThreadSafe> FRefDiffResultPtr;
+
+class FRefImageCompare
+{
+public:
+    // Longest side of the difference image
+    static constexpr int32 MaxDimension = 1024;
+
+    // Resamples both proxies over the overlap of their canvas rects and takes the
+    // per-channel absolute difference, or a luminance heatmap of it. Any thread.
+    static FRefDiffResultPtr ComputeDifference(
+        const FRefImageProxy& ProxyA, const FBox2D& RectA,
+        const FRefImageProxy& ProxyB, const FBox2D& RectB,
+        bool bHeatmap);
+};
\ No newline at end of file
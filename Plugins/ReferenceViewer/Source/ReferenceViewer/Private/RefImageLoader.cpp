@@ -0,0 +1,383 @@
+#include "RefImageLoader.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Engine/Texture2D.h"
+#include "ImageCore.h"
+
+namespace
+{
+    // Tonemapped values in [0, 1] to sRGB bytes; fine enough that neighbouring entries never skip a byte value
+    constexpr int32 EncodeTableSize = 4096;
+
+    const uint8* GetEncodeTable()
+    {
+        static const TArray<uint8> Table = []()
+        {
+            TArray<uint8> Values;
+            Values.SetNumUninitialized(EncodeTableSize);
+            for (int32 Index = 0; Index < EncodeTableSize; Index++)
+            {
+                const float Linear = Index / (float)(EncodeTableSize - 1);
+                const float Encoded = Linear <= 0.0031308f ? Linear * 12.92f : 1.055f * FMath::Pow(Linear, 1.0f / 2.4f) - 0.055f;
+                Values[Index] = (uint8)FMath::Clamp(FMath::RoundToInt(Encoded * 255.0f), 0, 255);
+            }
+            return Values;
+        }();
+        return Table.GetData();
+    }
+
+    void TonemapSpan(const FFloat16Color* Src, uint8* Dest, int64 Count, float Scale, bool bFilmic)
+    {
+        const uint8* Table = GetEncodeTable();
+        const VectorRegister4Float ScaleVec = MakeVectorRegister(Scale, Scale, Scale, 1.0f);
+        const VectorRegister4Float TableScale = VectorSetFloat1((float)(EncodeTableSize - 1));
+        const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+
+        // Narkowicz's fit of the ACES filmic curve: x(ax + b) / (x(cx + d) + e)
+        const VectorRegister4Float A = VectorSetFloat1(2.51f);
+        const VectorRegister4Float B = VectorSetFloat1(0.03f);
+        const VectorRegister4Float C = VectorSetFloat1(2.43f);
+        const VectorRegister4Float D = VectorSetFloat1(0.59f);
+        const VectorRegister4Float E = VectorSetFloat1(0.14f);
+
+        alignas(16) float Linear[4];
+        alignas(16) int32 Indices[4];
+        for (int64 Index = 0; Index < Count; Index++, Dest += 4)
+        {
+            FPlatformMath::VectorLoadHalf(Linear, reinterpret_cast<const uint16*>(Src + Index));
+            const float Alpha = FMath::Clamp(Linear[3], 0.0f, 1.0f);
+
+            // NaNs take the second operand of max and min, so they end up black
+            VectorRegister4Float Color = VectorMax(VectorMultiply(VectorLoadAligned(Linear), ScaleVec), VectorZeroFloat());
+            if (bFilmic)
+            {
+                Color = VectorDivide(VectorMultiply(Color, VectorMultiplyAdd(Color, A, B)), VectorMultiplyAdd(Color, VectorMultiplyAdd(Color, C, D), E));
+            }
+            Color = VectorMin(Color, VectorOneFloat());
+            VectorIntStoreAligned(VectorFloatToInt(VectorMultiplyAdd(Color, TableScale, Half)), Indices);
+
+            Dest[0] = Table[Indices[2]];
+            Dest[1] = Table[Indices[1]];
+            Dest[2] = Table[Indices[0]];
+            Dest[3] = (uint8)FMath::RoundToInt(Alpha * 255.0f);
+        }
+    }
+
+    // Linear half floats of the decoded image, halved down to HdrMinMipSize when bWithMips
+    FRefHdrImagePtr MakeHdrImage(const FImage& Decoded, bool bHighDynamicRange, bool bWithMips)
+    {
+        TSharedPtr<FRefHdrImage, ESPMode::ThreadSafe> Hdr = MakeShared<FRefHdrImage, ESPMode::ThreadSafe>();
+        Hdr->bHighDynamicRange = bHighDynamicRange;
+
+        {
+            FImage Linear;
+            Decoded.CopyTo(Linear, ERawImageFormat::RGBA16F, EGammaSpace::Linear);
+            const TArrayView64<FFloat16Color> Pixels = Linear.AsRGBA16F();
+
+            FRefHdrImage::FMip& Top = Hdr->Mips.AddDefaulted_GetRef();
+            Top.Width = Linear.SizeX;
+            Top.Height = Linear.SizeY;
+            Top.Pixels = TArray64<FFloat16Color>(Pixels.GetData(), Pixels.Num());
+        }
+
+        while (bWithMips && FMath::Max(Hdr->Mips.Last().Width, Hdr->Mips.Last().Height) > FRefImageLoader::HdrMinMipSize)
+        {
+            FRefHdrImage::FMip Next;
+            const FRefHdrImage::FMip& Previous = Hdr->Mips.Last();
+            Next.Width = FMath::Max(1, Previous.Width / 2);
+            Next.Height = FMath::Max(1, Previous.Height / 2);
+            Next.Pixels.SetNumUninitialized((int64)Next.Width * Next.Height);
+
+            // 2x2 box filter, clamping at odd edges
+            ParallelFor(Next.Height, [&](int32 Y)
+            {
+                const FFloat16Color* Row0 = Previous.Pixels.GetData() + (int64)FMath::Min(Y * 2, Previous.Height - 1) * Previous.Width;
+                const FFloat16Color* Row1 = Previous.Pixels.GetData() + (int64)FMath::Min(Y * 2 + 1, Previous.Height - 1) * Previous.Width;
+                FFloat16Color* Dest = Next.Pixels.GetData() + (int64)Y * Next.Width;
+                for (int32 X = 0; X < Next.Width; X++)
+                {
+                    const int32 X0 = FMath::Min(X * 2, Previous.Width - 1);
+                    const int32 X1 = FMath::Min(X * 2 + 1, Previous.Width - 1);
+                    const FLinearColor Sum = Row0[X0].GetFloats() + Row0[X1].GetFloats() + Row1[X0].GetFloats() + Row1[X1].GetFloats();
+                    Dest[X] = FFloat16Color(Sum * 0.25f);
+                }
+            });
+
+            Hdr->Mips.Add(MoveTemp(Next));
+        }
+
+        return Hdr;
+    }
+}
+
+bool FRefImageLoader::DecodeFile(const FString& FilePath, TArray64<uint8>& OutBGRA, int32& OutWidth, int32& OutHeight, FRefHdrImagePtr* OutHdr)
+{
+    // Map the source instead of reading it into a heap buffer
+    const uint8* CompressedData = nullptr;
+    int64 CompressedSize = 0;
+    TUniquePtr<IMappedFileHandle> MappedFile;
+    TUniquePtr<IMappedFileRegion> MappedRegion;
+    TArray64<uint8> FallbackData;
+
+    FOpenMappedResult MappedResult = FPlatformFileManager::Get().GetPlatformFile().OpenMappedEx(*FilePath);
+    if (MappedResult.HasValue())
+    {
+        MappedFile = MappedResult.StealValue();
+        MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+    }
+
+    if (MappedRegion.IsValid())
+    {
+        CompressedData = MappedRegion->GetMappedPtr();
+        CompressedSize = MappedRegion->GetMappedSize();
+    }
+    else if (FFileHelper::LoadFileToArray(FallbackData, *FilePath))
+    {
+        // Platform without mapping support
+        CompressedData = FallbackData.GetData();
+        CompressedSize = FallbackData.Num();
+    }
+    else
+    {
+        return false;
+    }
+
+    const bool bDecoded = DecodeMemory(CompressedData, CompressedSize, OutBGRA, OutWidth, OutHeight, OutHdr);
+
+    // Region must be released before the file handle it was mapped from
+    MappedRegion.Reset();
+    MappedFile.Reset();
+    return bDecoded;
+}
+
+bool FRefImageLoader::DecodeMemory(const uint8* CompressedData, int64 CompressedSize, TArray64<uint8>& OutBGRA, int32& OutWidth, int32& OutHeight, FRefHdrImagePtr* OutHdr)
+{
+    IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+    EImageFormat Format = ImageWrapperModule.DetectImageFormat(CompressedData, CompressedSize);
+    if (Format == EImageFormat::Invalid)
+        return false;
+
+    TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(Format);
+    if (!ImageWrapper.IsValid() || !ImageWrapper->SetCompressed(CompressedData, CompressedSize))
+        return false;
+
+    // More than 8 bits per channel: decoded in the native format, kept linear, handed out tonemapped
+    const bool bHighDynamicRange = Format == EImageFormat::EXR || Format == EImageFormat::HDR;
+    if (bHighDynamicRange || ImageWrapper->GetBitDepth() > 8)
+    {
+        FImage Decoded;
+        if (!ImageWrapper->GetRawImage(Decoded))
+            return false;
+
+        FRefHdrImagePtr Hdr = MakeHdrImage(Decoded, bHighDynamicRange, OutHdr != nullptr);
+        Tonemap(*Hdr, 0, 0.0f, OutBGRA);
+        OutWidth = Hdr->Mips[0].Width;
+        OutHeight = Hdr->Mips[0].Height;
+        if (OutHdr)
+        {
+            *OutHdr = Hdr;
+        }
+        return true;
+    }
+
+    // The 64-bit overload hands over the wrapper's own decode buffer instead of copying it
+    if (!ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, OutBGRA))
+        return false;
+
+    OutWidth = ImageWrapper->GetWidth();
+    OutHeight = ImageWrapper->GetHeight();
+    return true;
+}
+
+UTexture2D* FRefImageLoader::CreateTexture(const uint8* BGRA, int32 Width, int32 Height)
+{
+    check(IsInGameThread());
+
+    UTexture2D* Texture = UTexture2D::CreateTransient(Width, Height, PF_B8G8R8A8);
+    if (!Texture)
+        return nullptr;
+
+    FByteBulkData& BulkData = Texture->GetPlatformData()->Mips[0].BulkData;
+    void* TextureData = BulkData.Lock(LOCK_READ_WRITE);
+    FMemory::Memcpy(TextureData, BGRA, (int64)Width * Height * 4);
+    BulkData.Unlock();
+    Texture->UpdateResource();
+
+    return Texture;
+}
+
+void FRefImageLoader::Tonemap(const FRefHdrImage& Hdr, int32 Mip, float Exposure, TArray64<uint8>& OutBGRA)
+{
+    const FRefHdrImage::FMip& Source = Hdr.Mips[Mip];
+    OutBGRA.SetNumUninitialized((int64)Source.Width * Source.Height * 4);
+
+    // About 64K pixels per task
+    const int32 RowsPerTask = FMath::Max(1, 65536 / FMath::Max(1, Source.Width));
+    const int32 NumTasks = FMath::DivideAndRoundUp(Source.Height, RowsPerTask);
+    const float Scale = FMath::Pow(2.0f, Exposure);
+
+    ParallelFor(NumTasks, [&](int32 Task)
+    {
+        const int32 FirstRow = Task * RowsPerTask;
+        const int32 NumRows = FMath::Min(RowsPerTask, Source.Height - FirstRow);
+        const int64 First = (int64)FirstRow * Source.Width;
+        TonemapSpan(Source.Pixels.GetData() + First, OutBGRA.GetData() + First * 4, (int64)NumRows * Source.Width, Scale, Hdr.bHighDynamicRange);
+    });
+}
+
+UTexture2D* FRefImageLoader::CreateFloatTexture(const FRefHdrImage& Hdr, int32 Mip)
+{
+    check(IsInGameThread());
+
+    const FRefHdrImage::FMip& Source = Hdr.Mips[Mip];
+    UTexture2D* Texture = UTexture2D::CreateTransient(Source.Width, Source.Height, PF_FloatRGBA);
+    if (!Texture)
+        return nullptr;
+
+    // The values are linear already
+    Texture->SRGB = false;
+
+    FByteBulkData& BulkData = Texture->GetPlatformData()->Mips[0].BulkData;
+    void* TextureData = BulkData.Lock(LOCK_READ_WRITE);
+    FMemory::Memcpy(TextureData, Source.Pixels.GetData(), Source.Pixels.Num() * sizeof(FFloat16Color));
+    BulkData.Unlock();
+    Texture->UpdateResource();
+
+    return Texture;
+}
+
+FRefImageProxyPtr FRefImageLoader::MakeProxy(const uint8* BGRA, int32 Width, int32 Height, int32 MaxDimension)
+{
+    if (!BGRA || Width <= 0 || Height <= 0)
+        return nullptr;
+
+    const int32 Factor = FMath::Max(1, FMath::DivideAndRoundUp(FMath::Max(Width, Height), MaxDimension));
+
+    // A side shorter than the factor is box-filtered over its whole length only, so thin
+    // strips never read past the source
+    const int32 FactorX = FMath::Min(Factor, Width);
+    const int32 FactorY = FMath::Min(Factor, Height);
+
+    TSharedPtr<FRefImageProxy, ESPMode::ThreadSafe> Proxy = MakeShared<FRefImageProxy, ESPMode::ThreadSafe>();
+    Proxy->Width = Width / FactorX;
+    Proxy->Height = Height / FactorY;
+    Proxy->BGRA.SetNumUninitialized(Proxy->Width * Proxy->Height * 4);
+
+    ParallelFor(Proxy->Height, [&](int32 Y)
+    {
+        const uint32 Count = FactorX * FactorY;
+        uint8* Dest = Proxy->BGRA.GetData() + (int64)Y * Proxy->Width * 4;
+        for (int32 X = 0; X < Proxy->Width; X++, Dest += 4)
+        {
+            uint32 Sum[4] = { 0, 0, 0, 0 };
+            for (int32 SY = 0; SY < FactorY; SY++)
+            {
+                const uint8* Src = BGRA + ((int64)(Y * FactorY + SY) * Width + X * FactorX) * 4;
+                for (int32 SX = 0; SX < FactorX; SX++, Src += 4)
+                {
+                    Sum[0] += Src[0];
+                    Sum[1] += Src[1];
+                    Sum[2] += Src[2];
+                    Sum[3] += Src[3];
+                }
+            }
+            for (int32 C = 0; C < 4; C++)
+            {
+                Dest[C] = (uint8)((Sum[C] + Count / 2) / Count);
+            }
+        }
+    });
+
+    BuildCoverage(*Proxy);
+    return Proxy;
+}
+
+FRefImageProxyPtr FRefImageLoader::MakeTextureProxy(UTexture2D* Texture)
+{
+    if (!Texture || !Texture->Source.IsValid())
+        return nullptr;
+
+    const int32 SourceMax = FMath::Max(Texture->Source.GetSizeX(), Texture->Source.GetSizeY());
+    int32 Mip = 0;
+    while (Mip + 1 < Texture->Source.GetNumMips() && (SourceMax >> (Mip + 1)) >= ProxyMaxDimension)
+    {
+        Mip++;
+    }
+
+    FImage SourceImage;
+    if (!Texture->Source.GetMipImage(SourceImage, 0, 0, Mip))
+        return nullptr;
+
+    FImage Converted;
+    SourceImage.CopyTo(Converted, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+    return MakeProxy(Converted.RawData.GetData(), Converted.SizeX, Converted.SizeY);
+}
+
+FRefImageProxyPtr FRefImageLoader::CropProxy(const FRefImageProxyPtr& Proxy, const FBox2f& UVRegion)
+{
+    if (!Proxy.IsValid() || (UVRegion.Min == FVector2f::ZeroVector && UVRegion.Max == FVector2f::UnitVector))
+        return Proxy;
+
+    const int32 MinX = FMath::Clamp(FMath::FloorToInt(UVRegion.Min.X * Proxy->Width), 0, Proxy->Width - 1);
+    const int32 MinY = FMath::Clamp(FMath::FloorToInt(UVRegion.Min.Y * Proxy->Height), 0, Proxy->Height - 1);
+    const int32 MaxX = FMath::Clamp(FMath::CeilToInt(UVRegion.Max.X * Proxy->Width), MinX + 1, Proxy->Width);
+    const int32 MaxY = FMath::Clamp(FMath::CeilToInt(UVRegion.Max.Y * Proxy->Height), MinY + 1, Proxy->Height);
+
+    TSharedPtr<FRefImageProxy, ESPMode::ThreadSafe> Cropped = MakeShared<FRefImageProxy, ESPMode::ThreadSafe>();
+    Cropped->Width = MaxX - MinX;
+    Cropped->Height = MaxY - MinY;
+    Cropped->BGRA.SetNumUninitialized(Cropped->Width * Cropped->Height * 4);
+
+    for (int32 Y = 0; Y < Cropped->Height; Y++)
+    {
+        FMemory::Memcpy(
+            Cropped->BGRA.GetData() + (int64)Y * Cropped->Width * 4,
+            Proxy->BGRA.GetData() + ((int64)(MinY + Y) * Proxy->Width + MinX) * 4,
+            Cropped->Width * 4);
+    }
+
+    BuildCoverage(*Cropped);
+    return Cropped;
+}
+
+void FRefImageLoader::BuildCoverage(FRefImageProxy& Proxy)
+{
+    Proxy.Coverage.Reset();
+    Proxy.CoverageStride = 0;
+
+    const int32 NumPixels = Proxy.Width * Proxy.Height;
+    if (NumPixels <= 0 || Proxy.BGRA.Num() < NumPixels * 4)
+        return;
+
+    // Opaque images, the usual case, are found without allocating anything
+    const uint8* Alpha = Proxy.BGRA.GetData() + 3;
+    int32 FirstClear = 0;
+    while (FirstClear < NumPixels && Alpha[FirstClear * 4] > FRefImageProxy::CoverageThreshold)
+    {
+        FirstClear++;
+    }
+    if (FirstClear == NumPixels)
+        return;
+
+    const int32 Stride = FMath::DivideAndRoundUp(Proxy.Width, 64);
+    Proxy.Coverage.SetNumZeroed(Stride * Proxy.Height);
+    Proxy.CoverageStride = Stride;
+
+    for (int32 Y = 0; Y < Proxy.Height; Y++)
+    {
+        const uint8* Row = Alpha + (int64)Y * Proxy.Width * 4;
+        uint64* Bits = Proxy.Coverage.GetData() + Y * Stride;
+        for (int32 X = 0; X < Proxy.Width; X++)
+        {
+            if (Row[X * 4] > FRefImageProxy::CoverageThreshold)
+            {
+                Bits[X >> 6] |= 1ull << (X & 63);
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+class UTexture2D;
+
+// Image file decoding for the board
+class FRefImageLoader
+{
+public:
+    // Longest side of the CPU proxy kept per image
+    static constexpr int32 ProxyMaxDimension = 1024;
+
+    // Smallest mip kept of a high bit-depth image
+    static constexpr int32 HdrMinMipSize = 64;
+
+    // Memory-maps the file and decodes it to BGRA8. The compressed bytes are read
+    // straight from the mapping and the decoded buffer is the only full-size allocation.
+    // Sources with more than 8 bits per channel come out tonemapped at zero exposure;
+    // with OutHdr their linear pixels are kept there too.
+    static bool DecodeFile(const FString& FilePath, TArray64<uint8>& OutBGRA, int32& OutWidth, int32& OutHeight, FRefHdrImagePtr* OutHdr = nullptr);
+
+    // Decodes compressed image bytes already in memory to BGRA8. Any thread.
+    static bool DecodeMemory(const uint8* CompressedData, int64 CompressedSize, TArray64<uint8>& OutBGRA, int32& OutWidth, int32& OutHeight, FRefHdrImagePtr* OutHdr = nullptr);
+
+    // One mip of a high bit-depth image to sRGB BGRA8, scaled by 2^Exposure. High dynamic range
+    // sources go through a filmic curve, the rest are clamped. Bands of rows run on workers,
+    // each pixel in one SIMD register. Any thread.
+    static void Tonemap(const FRefHdrImage& Hdr, int32 Mip, float Exposure, TArray64<uint8>& OutBGRA);
+
+    // Half-float texture of one mip, drawn as it is without tonemapping. Game thread only.
+    static UTexture2D* CreateFloatTexture(const FRefHdrImage& Hdr, int32 Mip);
+
+    // Transient texture holding the pixels. Game thread only.
+    static UTexture2D* CreateTexture(const uint8* BGRA, int32 Width, int32 Height);
+
+    // Box-filtered copy no larger than MaxDimension on either side
+    static FRefImageProxyPtr MakeProxy(const uint8* BGRA, int32 Width, int32 Height, int32 MaxDimension = ProxyMaxDimension);
+
+    // Proxy of a texture asset from the smallest source mip at or above the proxy size, or null
+    // if it has no source. Game thread only.
+    static FRefImageProxyPtr MakeTextureProxy(UTexture2D* Texture);
+
+    // Copy of the UV sub-rectangle of a proxy; the proxy itself when the region is the whole image
+    static FRefImageProxyPtr CropProxy(const FRefImageProxyPtr& Proxy, const FBox2f& UVRegion);
+
+    // Fills the proxy's coverage mask from its alpha, or leaves it empty if nothing is transparent.
+    // Proxies made above already have one; call on others before sharing them.
+    static void BuildCoverage(FRefImageProxy& Proxy);
+};
\ No newline at end of file
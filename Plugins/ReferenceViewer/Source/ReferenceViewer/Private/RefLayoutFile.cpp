@@ -0,0 +1,305 @@
+#include "RefLayoutFile.h"
+#include "ReferenceViewer.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+namespace
+{
+    TArray<TSharedPtr<FJsonValue>> VectorToJson(const FVector2D& Vector)
+    {
+        return { MakeShared<FJsonValueNumber>(Vector.X), MakeShared<FJsonValueNumber>(Vector.Y) };
+    }
+
+    FVector2D VectorFromJson(const TSharedPtr<FJsonObject>& Object, const FString& Field, const FVector2D& Default)
+    {
+        const TArray<TSharedPtr<FJsonValue>>* Values = nullptr;
+        if (Object->TryGetArrayField(Field, Values) && Values->Num() == 2)
+        {
+            return FVector2D((*Values)[0]->AsNumber(), (*Values)[1]->AsNumber());
+        }
+        return Default;
+    }
+}
+
+FString FRefLayoutFile::GetLayoutPath(const FString& LayoutName)
+{
+    return FReferenceViewerModule::GetSavedLayoutsPath() / (LayoutName + TEXT(".json"));
+}
+
+bool FRefLayoutFile::Save(const FString& Path, const FReferenceLayout& Layout)
+{
+    FString Json;
+    if (!ToJson(Layout, Json))
+        return false;
+
+    const FString TempPath = Path + TEXT(".tmp");
+    if (!FFileHelper::SaveStringToFile(Json, *TempPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+        return false;
+
+    return IFileManager::Get().Move(*Path, *TempPath, true, true);
+}
+
+bool FRefLayoutFile::Load(const FString& Path, FReferenceLayout& OutLayout)
+{
+    FString Json;
+    if (!FFileHelper::LoadFileToString(Json, *Path))
+        return false;
+
+    return FromJson(Json, OutLayout);
+}
+
+bool FRefLayoutFile::ToJson(const FReferenceLayout& Layout, FString& OutJson)
+{
+    TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+    Root->SetNumberField(TEXT("Version"), 1);
+    Root->SetStringField(TEXT("Name"), Layout.Name);
+    Root->SetArrayField(TEXT("CanvasSize"), VectorToJson(Layout.CanvasSize));
+    Root->SetNumberField(TEXT("GridSize"), Layout.GridSize);
+    Root->SetBoolField(TEXT("GridEnabled"), Layout.bGridEnabled);
+    if (!Layout.WatchedFolder.IsEmpty())
+    {
+        Root->SetStringField(TEXT("WatchedFolder"), Layout.WatchedFolder);
+    }
+    Root->SetNumberField(TEXT("JournalSequence"), (double)Layout.JournalSequence);
+
+    TArray<TSharedPtr<FJsonValue>> ImageValues;
+    ImageValues.Reserve(Layout.Images.Num());
+    for (const FRefImageRecord& Record : Layout.Images)
+    {
+        TSharedRef<FJsonObject> Image = MakeShared<FJsonObject>();
+        Image->SetStringField(TEXT("Id"), Record.Id.ToString(EGuidFormats::Digits));
+        Image->SetStringField(TEXT("Name"), Record.Name);
+        Image->SetStringField(TEXT("FilePath"), Record.FilePath);
+        if (Record.TextureAsset.IsValid())
+        {
+            Image->SetStringField(TEXT("TextureAsset"), Record.TextureAsset.ToString());
+        }
+        Image->SetArrayField(TEXT("Position"), VectorToJson(Record.Position));
+        Image->SetArrayField(TEXT("Size"), VectorToJson(Record.Size));
+        Image->SetNumberField(TEXT("Rotation"), Record.Rotation);
+        Image->SetNumberField(TEXT("Opacity"), Record.Opacity);
+        Image->SetBoolField(TEXT("Locked"), Record.bLocked);
+        Image->SetBoolField(TEXT("Visible"), Record.bVisible);
+        if (Record.UVRegion.Min != FVector2f::ZeroVector || Record.UVRegion.Max != FVector2f::UnitVector)
+        {
+            Image->SetArrayField(TEXT("UVRegion"), {
+                MakeShared<FJsonValueNumber>(Record.UVRegion.Min.X), MakeShared<FJsonValueNumber>(Record.UVRegion.Min.Y),
+                MakeShared<FJsonValueNumber>(Record.UVRegion.Max.X), MakeShared<FJsonValueNumber>(Record.UVRegion.Max.Y) });
+        }
+        ImageValues.Add(MakeShared<FJsonValueObject>(Image));
+    }
+    Root->SetArrayField(TEXT("Images"), ImageValues);
+
+    if (Layout.Groups.Num() > 0)
+    {
+        TArray<TSharedPtr<FJsonValue>> GroupValues;
+        GroupValues.Reserve(Layout.Groups.Num());
+        for (const FRefGroupRecord& Record : Layout.Groups)
+        {
+            TSharedRef<FJsonObject> Group = MakeShared<FJsonObject>();
+            Group->SetStringField(TEXT("Id"), Record.Id.ToString(EGuidFormats::Digits));
+            Group->SetStringField(TEXT("Name"), Record.Name);
+            if (Record.ParentId.IsValid())
+            {
+                Group->SetStringField(TEXT("Parent"), Record.ParentId.ToString(EGuidFormats::Digits));
+            }
+            Group->SetArrayField(TEXT("Offset"), VectorToJson(Record.Offset));
+            Group->SetNumberField(TEXT("Opacity"), Record.Opacity);
+            Group->SetBoolField(TEXT("Locked"), Record.bLocked);
+            Group->SetBoolField(TEXT("Visible"), Record.bVisible);
+            Group->SetBoolField(TEXT("Collapsed"), Record.bCollapsed);
+
+            TArray<TSharedPtr<FJsonValue>> MemberValues;
+            MemberValues.Reserve(Record.Images.Num());
+            for (const FGuid& Member : Record.Images)
+            {
+                MemberValues.Add(MakeShared<FJsonValueString>(Member.ToString(EGuidFormats::Digits)));
+            }
+            Group->SetArrayField(TEXT("Images"), MemberValues);
+            GroupValues.Add(MakeShared<FJsonValueObject>(Group));
+        }
+        Root->SetArrayField(TEXT("Groups"), GroupValues);
+    }
+
+    if (Layout.Strokes.Num() > 0)
+    {
+        TArray<TSharedPtr<FJsonValue>> StrokeValues;
+        StrokeValues.Reserve(Layout.Strokes.Num());
+        for (const FRefStroke& Record : Layout.Strokes)
+        {
+            TSharedRef<FJsonObject> Stroke = MakeShared<FJsonObject>();
+            Stroke->SetStringField(TEXT("Id"), Record.Id.ToString(EGuidFormats::Digits));
+            Stroke->SetStringField(TEXT("Color"), Record.Color.ToFColor(true).ToHex());
+            Stroke->SetNumberField(TEXT("Thickness"), Record.Thickness);
+            if (Record.bArrow)
+            {
+                Stroke->SetBoolField(TEXT("Arrow"), true);
+            }
+
+            // Flat x, y pairs; simplified strokes are short, but boards can hold thousands
+            TArray<TSharedPtr<FJsonValue>> PointValues;
+            PointValues.Reserve(Record.Points.Num() * 2);
+            for (const FVector2D& Point : Record.Points)
+            {
+                PointValues.Add(MakeShared<FJsonValueNumber>(FMath::RoundToDouble(Point.X * 100.0) / 100.0));
+                PointValues.Add(MakeShared<FJsonValueNumber>(FMath::RoundToDouble(Point.Y * 100.0) / 100.0));
+            }
+            Stroke->SetArrayField(TEXT("Points"), PointValues);
+            StrokeValues.Add(MakeShared<FJsonValueObject>(Stroke));
+        }
+        Root->SetArrayField(TEXT("Strokes"), StrokeValues);
+    }
+
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutJson);
+    return FJsonSerializer::Serialize(Root, Writer);
+}
+
+bool FRefLayoutFile::FromJson(const FString& Json, FReferenceLayout& OutLayout)
+{
+    TSharedPtr<FJsonObject> Root;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Json);
+    if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+        return false;
+
+    OutLayout = FReferenceLayout();
+    OutLayout.Name = Root->GetStringField(TEXT("Name"));
+    OutLayout.CanvasSize = VectorFromJson(Root, TEXT("CanvasSize"), OutLayout.CanvasSize);
+    Root->TryGetNumberField(TEXT("GridSize"), OutLayout.GridSize);
+    Root->TryGetBoolField(TEXT("GridEnabled"), OutLayout.bGridEnabled);
+    Root->TryGetStringField(TEXT("WatchedFolder"), OutLayout.WatchedFolder);
+
+    double Sequence = 0.0;
+    if (Root->TryGetNumberField(TEXT("JournalSequence"), Sequence))
+    {
+        OutLayout.JournalSequence = (uint64)Sequence;
+    }
+
+    const TArray<TSharedPtr<FJsonValue>>* ImageValues = nullptr;
+    if (Root->TryGetArrayField(TEXT("Images"), ImageValues))
+    {
+        OutLayout.Images.Reserve(ImageValues->Num());
+        for (const TSharedPtr<FJsonValue>& Value : *ImageValues)
+        {
+            const TSharedPtr<FJsonObject>* Image = nullptr;
+            if (!Value->TryGetObject(Image))
+                continue;
+
+            FRefImageRecord& Record = OutLayout.Images.AddDefaulted_GetRef();
+            FGuid::Parse((*Image)->GetStringField(TEXT("Id")), Record.Id);
+            Record.Name = (*Image)->GetStringField(TEXT("Name"));
+            Record.FilePath = (*Image)->GetStringField(TEXT("FilePath"));
+            FString TextureAsset;
+            if ((*Image)->TryGetStringField(TEXT("TextureAsset"), TextureAsset))
+            {
+                Record.TextureAsset.SetPath(TextureAsset);
+            }
+            Record.Position = VectorFromJson(*Image, TEXT("Position"), Record.Position);
+            Record.Size = VectorFromJson(*Image, TEXT("Size"), Record.Size);
+            (*Image)->TryGetNumberField(TEXT("Rotation"), Record.Rotation);
+            (*Image)->TryGetNumberField(TEXT("Opacity"), Record.Opacity);
+            (*Image)->TryGetBoolField(TEXT("Locked"), Record.bLocked);
+            (*Image)->TryGetBoolField(TEXT("Visible"), Record.bVisible);
+
+            const TArray<TSharedPtr<FJsonValue>>* UVValues = nullptr;
+            if ((*Image)->TryGetArrayField(TEXT("UVRegion"), UVValues) && UVValues->Num() == 4)
+            {
+                Record.UVRegion = FBox2f(
+                    FVector2f((*UVValues)[0]->AsNumber(), (*UVValues)[1]->AsNumber()),
+                    FVector2f((*UVValues)[2]->AsNumber(), (*UVValues)[3]->AsNumber()));
+            }
+
+            if (!Record.Id.IsValid())
+            {
+                Record.Id = FGuid::NewGuid();
+            }
+        }
+    }
+
+    const TArray<TSharedPtr<FJsonValue>>* GroupValues = nullptr;
+    if (Root->TryGetArrayField(TEXT("Groups"), GroupValues))
+    {
+        OutLayout.Groups.Reserve(GroupValues->Num());
+        for (const TSharedPtr<FJsonValue>& Value : *GroupValues)
+        {
+            const TSharedPtr<FJsonObject>* Group = nullptr;
+            if (!Value->TryGetObject(Group))
+                continue;
+
+            FRefGroupRecord Record;
+            if (!FGuid::Parse((*Group)->GetStringField(TEXT("Id")), Record.Id))
+                continue;
+
+            Record.Name = (*Group)->GetStringField(TEXT("Name"));
+            FString ParentId;
+            if ((*Group)->TryGetStringField(TEXT("Parent"), ParentId))
+            {
+                FGuid::Parse(ParentId, Record.ParentId);
+            }
+            Record.Offset = VectorFromJson(*Group, TEXT("Offset"), Record.Offset);
+            (*Group)->TryGetNumberField(TEXT("Opacity"), Record.Opacity);
+            (*Group)->TryGetBoolField(TEXT("Locked"), Record.bLocked);
+            (*Group)->TryGetBoolField(TEXT("Visible"), Record.bVisible);
+            (*Group)->TryGetBoolField(TEXT("Collapsed"), Record.bCollapsed);
+
+            const TArray<TSharedPtr<FJsonValue>>* MemberValues = nullptr;
+            if ((*Group)->TryGetArrayField(TEXT("Images"), MemberValues))
+            {
+                for (const TSharedPtr<FJsonValue>& Member : *MemberValues)
+                {
+                    FGuid MemberId;
+                    if (FGuid::Parse(Member->AsString(), MemberId))
+                    {
+                        Record.Images.Add(MemberId);
+                    }
+                }
+            }
+            OutLayout.Groups.Add(MoveTemp(Record));
+        }
+    }
+
+    const TArray<TSharedPtr<FJsonValue>>* StrokeValues = nullptr;
+    if (Root->TryGetArrayField(TEXT("Strokes"), StrokeValues))
+    {
+        OutLayout.Strokes.Reserve(StrokeValues->Num());
+        for (const TSharedPtr<FJsonValue>& Value : *StrokeValues)
+        {
+            const TSharedPtr<FJsonObject>* Stroke = nullptr;
+            if (!Value->TryGetObject(Stroke))
+                continue;
+
+            FRefStroke Record;
+            if (!FGuid::Parse((*Stroke)->GetStringField(TEXT("Id")), Record.Id))
+            {
+                Record.Id = FGuid::NewGuid();
+            }
+            FString Color;
+            if ((*Stroke)->TryGetStringField(TEXT("Color"), Color))
+            {
+                Record.Color = FLinearColor::FromSRGBColor(FColor::FromHex(Color));
+            }
+            (*Stroke)->TryGetNumberField(TEXT("Thickness"), Record.Thickness);
+            (*Stroke)->TryGetBoolField(TEXT("Arrow"), Record.bArrow);
+
+            const TArray<TSharedPtr<FJsonValue>>* PointValues = nullptr;
+            if ((*Stroke)->TryGetArrayField(TEXT("Points"), PointValues))
+            {
+                Record.Points.Reserve(PointValues->Num() / 2);
+                for (int32 Index = 0; Index + 1 < PointValues->Num(); Index += 2)
+                {
+                    Record.Points.Add(FVector2D((*PointValues)[Index]->AsNumber(), (*PointValues)[Index + 1]->AsNumber()));
+                }
+            }
+            if (Record.Points.Num() >= 2)
+            {
+                OutLayout.Strokes.Add(MoveTemp(Record));
+            }
+        }
+    }
+
+    return true;
+}
\ No newline at end of file
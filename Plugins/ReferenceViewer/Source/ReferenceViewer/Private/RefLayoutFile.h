@@ -0,0 +1,20 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+// JSON layout files under FReferenceViewerModule::GetSavedLayoutsPath().
+// Thread safe: touches no UObjects, so the autosave journal can write from its own thread.
+class FRefLayoutFile
+{
+public:
+    static FString GetLayoutPath(const FString& LayoutName);
+
+    // Writes to a temporary file first and swaps it in, so a crash never leaves a torn layout
+    static bool Save(const FString& Path, const FReferenceLayout& Layout);
+    static bool Load(const FString& Path, FReferenceLayout& OutLayout);
+    
+    // In-memory form, also embedded in board bundles
+    static bool ToJson(const FReferenceLayout& Layout, FString& OutJson);
+    static bool FromJson(const FString& Json, FReferenceLayout& OutLayout);
+};
\ No newline at end of file
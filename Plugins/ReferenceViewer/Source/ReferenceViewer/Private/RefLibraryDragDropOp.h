@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DragAndDrop/DecoratedDragDropOp.h"
+#include "RefViewerData.h"
+
+// Files dragged from the library panel. Each carries its cached thumbnail so
+// the canvas can place it immediately and load the full pixels afterwards.
+class FRefLibraryDragDropOp : public FDecoratedDragDropOp
+{
+public:
+    DRAG_DROP_OPERATOR_TYPE(FRefLibraryDragDropOp, FDecoratedDragDropOp)
+
+    struct FEntry
+    {
+        FString FilePath;
+        FRefImageProxyPtr Thumbnail;
+        FIntPoint SourceSize = FIntPoint::ZeroValue;
+    };
+
+    TArray<FEntry> Entries;
+
+    static TSharedRef<FRefLibraryDragDropOp> New(TArray<FEntry> InEntries)
+    {
+        TSharedRef<FRefLibraryDragDropOp> Operation = MakeShareable(new FRefLibraryDragDropOp());
+        Operation->Entries = MoveTemp(InEntries);
+        Operation->CurrentHoverText = Operation->Entries.Num() == 1
+            ? FText::FromString(FPaths::GetCleanFilename(Operation->Entries[0].FilePath))
+            : FText::FromString(FString::Printf(TEXT("%d images"), Operation->Entries.Num()));
+        Operation->SetupDefaults();
+        Operation->Construct();
+        return Operation;
+    }
+};
\ No newline at end of file
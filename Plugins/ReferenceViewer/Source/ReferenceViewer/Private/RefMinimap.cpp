@@ -0,0 +1,179 @@
+#include "RefMinimap.h"
+#include "RefImageLoader.h"
+#include "Engine/Texture2D.h"
+
+namespace
+{
+    const FColor OutsideColor(12, 12, 12, 255);
+    const FColor BoardColor(32, 32, 32, 255);
+    const FColor PlaceholderColor(90, 90, 90, 255);
+}
+
+FRefMinimap::FRefMinimap()
+    : Bounds(ForceInit)
+    , BoardSize(FVector2D::ZeroVector)
+    , Width(0)
+    , Height(0)
+    , Texture(nullptr)
+    , DirtyRect(ForceInit)
+    , bFullRebuild(true)
+{
+}
+
+void FRefMinimap::MarkDirty(const FBox2D& CanvasRect)
+{
+    if (CanvasRect.bIsValid)
+    {
+        DirtyRect += CanvasRect;
+    }
+}
+
+void FRefMinimap::AddReferencedObjects(FReferenceCollector& Collector)
+{
+    Collector.AddReferencedObject(Texture);
+}
+
+bool FRefMinimap::Update(const TArray<TSharedPtr<FRefImage>>& Images, const FVector2D& CanvasSize)
+{
+    if (!bFullRebuild && !DirtyRect.bIsValid)
+        return false;
+
+    // Any change to the board extent rescales the whole composite
+    FBox2D NewBounds(FVector2D::ZeroVector, CanvasSize);
+    for (const auto& Image : Images)
+    {
+        if (Image->IsEffectivelyVisible())
+        {
+            NewBounds += Image->GetBounds();
+        }
+    }
+    NewBounds = NewBounds.ExpandBy(Margin);
+
+    if (bFullRebuild || !Texture || !NewBounds.Min.Equals(Bounds.Min) || !NewBounds.Max.Equals(Bounds.Max) || CanvasSize != BoardSize)
+    {
+        Bounds = NewBounds;
+        BoardSize = CanvasSize;
+
+        const FVector2D Extent = Bounds.GetSize();
+        const double Scale = Resolution / FMath::Max(Extent.X, Extent.Y);
+        Width = FMath::Max(1, FMath::RoundToInt(Extent.X * Scale));
+        Height = FMath::Max(1, FMath::RoundToInt(Extent.Y * Scale));
+        Pixels.SetNumUninitialized(Width * Height);
+
+        Composite(Images, FIntRect(0, 0, Width, Height));
+        Texture = FRefImageLoader::CreateTexture(reinterpret_cast<const uint8*>(Pixels.GetData()), Width, Height);
+
+        bFullRebuild = false;
+        DirtyRect = FBox2D(ForceInit);
+        return true;
+    }
+
+    // Dirty canvas rect to whole pixels, padded for sampling
+    const FVector2D PixelScale(Width / Bounds.GetSize().X, Height / Bounds.GetSize().Y);
+    const FVector2D DirtyMin = (DirtyRect.Min - Bounds.Min) * PixelScale;
+    const FVector2D DirtyMax = (DirtyRect.Max - Bounds.Min) * PixelScale;
+    const FIntRect PixelRect(
+        FMath::Clamp(FMath::FloorToInt(DirtyMin.X) - 1, 0, Width),
+        FMath::Clamp(FMath::FloorToInt(DirtyMin.Y) - 1, 0, Height),
+        FMath::Clamp(FMath::CeilToInt(DirtyMax.X) + 1, 0, Width),
+        FMath::Clamp(FMath::CeilToInt(DirtyMax.Y) + 1, 0, Height));
+    DirtyRect = FBox2D(ForceInit);
+
+    if (PixelRect.Width() > 0 && PixelRect.Height() > 0)
+    {
+        Composite(Images, PixelRect);
+        UploadRegion(PixelRect);
+    }
+    return false;
+}
+
+void FRefMinimap::Composite(const TArray<TSharedPtr<FRefImage>>& Images, const FIntRect& PixelRect)
+{
+    const FVector2D CanvasPerPixel(Bounds.GetSize().X / Width, Bounds.GetSize().Y / Height);
+
+    // Background, with the nominal board area slightly lighter
+    for (int32 Y = PixelRect.Min.Y; Y < PixelRect.Max.Y; Y++)
+    {
+        const double CanvasY = Bounds.Min.Y + (Y + 0.5) * CanvasPerPixel.Y;
+        for (int32 X = PixelRect.Min.X; X < PixelRect.Max.X; X++)
+        {
+            const double CanvasX = Bounds.Min.X + (X + 0.5) * CanvasPerPixel.X;
+            const bool bOnBoard = CanvasX >= 0.0 && CanvasY >= 0.0 && CanvasX < BoardSize.X && CanvasY < BoardSize.Y;
+            Pixels[Y * Width + X] = bOnBoard ? BoardColor : OutsideColor;
+        }
+    }
+
+    // Images back to front, each only over its own footprint
+    for (const auto& Image : Images)
+    {
+        if (!Image->IsEffectivelyVisible())
+            continue;
+
+        const FBox2D ImageBounds = Image->GetBounds();
+        const FIntRect Footprint(
+            FMath::Max(PixelRect.Min.X, FMath::FloorToInt((ImageBounds.Min.X - Bounds.Min.X) / CanvasPerPixel.X)),
+            FMath::Max(PixelRect.Min.Y, FMath::FloorToInt((ImageBounds.Min.Y - Bounds.Min.Y) / CanvasPerPixel.Y)),
+            FMath::Min(PixelRect.Max.X, FMath::CeilToInt((ImageBounds.Max.X - Bounds.Min.X) / CanvasPerPixel.X)),
+            FMath::Min(PixelRect.Max.Y, FMath::CeilToInt((ImageBounds.Max.Y - Bounds.Min.Y) / CanvasPerPixel.Y)));
+        if (Footprint.Width() <= 0 || Footprint.Height() <= 0)
+            continue;
+
+        // Images without CPU pixels (assets, bundles, silhouettes) show as a flat placeholder
+        const FRefImageProxy* Proxy = Image->Proxy.Get();
+        const FColor* ProxyPixels = Proxy ? reinterpret_cast<const FColor*>(Proxy->BGRA.GetData()) : nullptr;
+        const float Opacity = Image->GetEffectiveOpacity();
+
+        for (int32 Y = Footprint.Min.Y; Y < Footprint.Max.Y; Y++)
+        {
+            const double CanvasY = Bounds.Min.Y + (Y + 0.5) * CanvasPerPixel.Y;
+            const double V = (CanvasY - ImageBounds.Min.Y) / Image->Size.Y;
+            if (V < 0.0 || V >= 1.0)
+                continue;
+
+            for (int32 X = Footprint.Min.X; X < Footprint.Max.X; X++)
+            {
+                const double CanvasX = Bounds.Min.X + (X + 0.5) * CanvasPerPixel.X;
+                const double U = (CanvasX - ImageBounds.Min.X) / Image->Size.X;
+                if (U < 0.0 || U >= 1.0)
+                    continue;
+
+                FColor Source = PlaceholderColor;
+                if (ProxyPixels)
+                {
+                    const int32 SrcX = FMath::Min((int32)(U * Proxy->Width), Proxy->Width - 1);
+                    const int32 SrcY = FMath::Min((int32)(V * Proxy->Height), Proxy->Height - 1);
+                    Source = ProxyPixels[SrcY * Proxy->Width + SrcX];
+                }
+
+                FColor& Dest = Pixels[Y * Width + X];
+                const float Alpha = Opacity * Source.A / 255.0f;
+                Dest.R = (uint8)FMath::Lerp((float)Dest.R, (float)Source.R, Alpha);
+                Dest.G = (uint8)FMath::Lerp((float)Dest.G, (float)Source.G, Alpha);
+                Dest.B = (uint8)FMath::Lerp((float)Dest.B, (float)Source.B, Alpha);
+            }
+        }
+    }
+}
+
+void FRefMinimap::UploadRegion(const FIntRect& PixelRect)
+{
+    if (!Texture)
+        return;
+
+    // The render thread reads the copy later and frees it
+    const int32 RegionWidth = PixelRect.Width();
+    const int32 RegionHeight = PixelRect.Height();
+    uint8* RegionData = new uint8[RegionWidth * RegionHeight * 4];
+    for (int32 Y = 0; Y < RegionHeight; Y++)
+    {
+        FMemory::Memcpy(RegionData + Y * RegionWidth * 4, &Pixels[(PixelRect.Min.Y + Y) * Width + PixelRect.Min.X], RegionWidth * 4);
+    }
+
+    FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(PixelRect.Min.X, PixelRect.Min.Y, 0, 0, RegionWidth, RegionHeight);
+    Texture->UpdateTextureRegions(0, 1, Region, RegionWidth * 4, 4, RegionData,
+        [](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+        {
+            delete[] SrcData;
+            delete Regions;
+        });
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+class UTexture2D;
+class FReferenceCollector;
+
+// Low-res composite of the whole board for the navigator inset. Only regions
+// marked dirty by edits are re-composited and re-uploaded, so drawing it costs
+// the same no matter how many images are on the board.
+class FRefMinimap
+{
+public:
+    // Longest side of the composite in pixels
+    static constexpr int32 Resolution = 256;
+
+    // Canvas units kept around the board extent
+    static constexpr float Margin = 100.0f;
+
+    FRefMinimap();
+
+    // Region of the board, in canvas space, whose pixels are stale
+    void MarkDirty(const FBox2D& CanvasRect);
+    void MarkAllDirty() { bFullRebuild = true; }
+
+    // Re-composites the dirty region. Game thread; returns true if the texture was recreated.
+    bool Update(const TArray<TSharedPtr<FRefImage>>& Images, const FVector2D& CanvasSize);
+
+    UTexture2D* GetTexture() const { return Texture; }
+
+    // Called by the owner's FGCObject to keep the composite texture alive
+    void AddReferencedObjects(FReferenceCollector& Collector);
+
+    // Canvas-space area the composite covers
+    const FBox2D& GetBounds() const { return Bounds; }
+
+private:
+    void Composite(const TArray<TSharedPtr<FRefImage>>& Images, const FIntRect& PixelRect);
+    void UploadRegion(const FIntRect& PixelRect);
+
+    FBox2D Bounds;
+    FVector2D BoardSize;
+    int32 Width;
+    int32 Height;
+    TArray<FColor> Pixels;
+    UTexture2D* Texture;
+
+    FBox2D DirtyRect;
+    bool bFullRebuild;
+};
\ No newline at end of file
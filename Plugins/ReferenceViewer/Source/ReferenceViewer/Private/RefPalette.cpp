@@ -0,0 +1,152 @@
+#include "RefPalette.h"
+#include "Async/Async.h"
+#include "Math/VectorRegister.h"
+
+namespace
+{
+    float DistanceSquared(const VectorRegister4Float& A, const VectorRegister4Float& B)
+    {
+        const VectorRegister4Float Diff = VectorSubtract(A, B);
+        return VectorGetComponent(VectorDot3(Diff, Diff), 0);
+    }
+
+    int32 FindNearest(const VectorRegister4Float& Sample, const TArray<VectorRegister4Float>& Centers, float& OutDistance)
+    {
+        int32 Nearest = 0;
+        OutDistance = MAX_flt;
+        for (int32 C = 0; C < Centers.Num(); C++)
+        {
+            const float Distance = DistanceSquared(Sample, Centers[C]);
+            if (Distance < OutDistance)
+            {
+                OutDistance = Distance;
+                Nearest = C;
+            }
+        }
+        return Nearest;
+    }
+}
+
+FRefPalettePtr FRefPaletteExtractor::Extract(const FRefImageProxy& Proxy)
+{
+    if (Proxy.Width <= 0 || Proxy.Height <= 0)
+        return nullptr;
+
+    // Point samples, not averages, so the palette only holds colours that are really in the image.
+    // Clustering happens in sRGB, which is closer to how different colours look.
+    const int32 Step = FMath::Max(1, FMath::DivideAndRoundUp(FMath::Max(Proxy.Width, Proxy.Height), SampleDimension));
+    TArray<VectorRegister4Float> Samples;
+    Samples.Reserve(FMath::Square(SampleDimension));
+    for (int32 Y = Step / 2; Y < Proxy.Height; Y += Step)
+    {
+        const uint8* Row = Proxy.BGRA.GetData() + (int64)Y * Proxy.Width * 4;
+        for (int32 X = Step / 2; X < Proxy.Width; X += Step)
+        {
+            const uint8* Src = Row + X * 4;
+            if (Src[3] < 128)
+                continue;
+
+            Samples.Add(MakeVectorRegisterFloat(Src[2] / 255.0f, Src[1] / 255.0f, Src[0] / 255.0f, 0.0f));
+        }
+    }
+
+    if (Samples.Num() == 0)
+        return nullptr;
+
+    // Farthest-point seeding: deterministic, and small accent colours still get a centre
+    const int32 K = FMath::Min(NumColors, Samples.Num());
+    TArray<VectorRegister4Float> Centers;
+    Centers.Add(Samples[Samples.Num() / 2]);
+
+    TArray<float> NearestDistance;
+    NearestDistance.Init(MAX_flt, Samples.Num());
+    while (Centers.Num() < K)
+    {
+        int32 Farthest = 0;
+        for (int32 S = 0; S < Samples.Num(); S++)
+        {
+            NearestDistance[S] = FMath::Min(NearestDistance[S], DistanceSquared(Samples[S], Centers.Last()));
+            if (NearestDistance[S] > NearestDistance[Farthest])
+            {
+                Farthest = S;
+            }
+        }
+        if (NearestDistance[Farthest] <= 0.0f)
+            break;
+
+        Centers.Add(Samples[Farthest]);
+    }
+
+    // Lloyd iterations
+    TArray<int32> Assignment;
+    Assignment.Init(INDEX_NONE, Samples.Num());
+    TArray<VectorRegister4Float> Sums;
+    TArray<int32> Counts;
+    for (int32 Iteration = 0; Iteration < MaxIterations; Iteration++)
+    {
+        Sums.Init(VectorZeroFloat(), Centers.Num());
+        Counts.Init(0, Centers.Num());
+
+        bool bChanged = false;
+        for (int32 S = 0; S < Samples.Num(); S++)
+        {
+            float Distance;
+            const int32 Nearest = FindNearest(Samples[S], Centers, Distance);
+            bChanged |= (Assignment[S] != Nearest);
+            Assignment[S] = Nearest;
+            Sums[Nearest] = VectorAdd(Sums[Nearest], Samples[S]);
+            Counts[Nearest]++;
+        }
+
+        for (int32 C = 0; C < Centers.Num(); C++)
+        {
+            if (Counts[C] > 0)
+            {
+                Centers[C] = VectorDivide(Sums[C], VectorSetFloat1((float)Counts[C]));
+            }
+        }
+
+        if (!bChanged)
+            break;
+    }
+
+    TArray<int32> Order;
+    for (int32 C = 0; C < Centers.Num(); C++)
+    {
+        if (Counts[C] > 0)
+        {
+            Order.Add(C);
+        }
+    }
+    Order.Sort([&Counts](int32 A, int32 B) { return Counts[A] > Counts[B]; });
+
+    TSharedPtr<FRefPalette, ESPMode::ThreadSafe> Palette = MakeShared<FRefPalette, ESPMode::ThreadSafe>();
+    for (int32 C : Order)
+    {
+        alignas(16) float Channels[4];
+        VectorStoreAligned(Centers[C], Channels);
+        const FColor SRGB(
+            (uint8)FMath::RoundToInt(FMath::Clamp(Channels[0], 0.0f, 1.0f) * 255.0f),
+            (uint8)FMath::RoundToInt(FMath::Clamp(Channels[1], 0.0f, 1.0f) * 255.0f),
+            (uint8)FMath::RoundToInt(FMath::Clamp(Channels[2], 0.0f, 1.0f) * 255.0f));
+        Palette->Colors.Add(FLinearColor::FromSRGBColor(SRGB));
+        Palette->Weights.Add(Counts[C] / (float)Samples.Num());
+    }
+    return Palette;
+}
+
+void FRefPaletteExtractor::ExtractAsync(FRefImageProxyPtr Proxy, TFunction<void(FRefPalettePtr)> OnComplete)
+{
+    if (!Proxy.IsValid())
+        return;
+
+    Async(EAsyncExecution::ThreadPool, [Proxy, OnComplete = MoveTemp(OnComplete)]() mutable
+    {
+        FRefPalettePtr Palette = Extract(*Proxy);
+
+        AsyncTask(ENamedThreads::GameThread, [Palette, OnComplete = MoveTemp(OnComplete)]()
+        {
+            OnComplete(Palette);
+        });
+    });
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+// Dominant colours of a reference, most common first
+struct FRefPalette
+{
+    // Linear colour of each cluster centre
+    TArray<FLinearColor> Colors;
+
+    // Fraction of sampled pixels in each cluster
+    TArray<float> Weights;
+};
+
+typedef TSharedPtr<const FRefPalette, ESPMode::ThreadSafe> FRefPalettePtr;
+
+// k-means palette extraction over a downsampled copy of the proxy
+class FRefPaletteExtractor
+{
+public:
+    static constexpr int32 NumColors = 6;
+
+    // Samples are taken on a grid no larger than this on either side
+    static constexpr int32 SampleDimension = 64;
+
+    static constexpr int32 MaxIterations = 12;
+
+    // Null if the proxy has no opaque pixels. Any thread.
+    static FRefPalettePtr Extract(const FRefImageProxy& Proxy);
+
+    // Extracts on the thread pool. OnComplete runs on the game thread.
+    static void ExtractAsync(FRefImageProxyPtr Proxy, TFunction<void(FRefPalettePtr)> OnComplete);
+};
\ No newline at end of file
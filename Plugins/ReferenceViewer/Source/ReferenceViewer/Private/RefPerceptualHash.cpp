@@ -0,0 +1,162 @@
+#include "RefPerceptualHash.h"
+#include "Math/VectorRegister.h"
+#include "Algo/Sort.h"
+
+namespace
+{
+    constexpr int32 DctSize = FRefPerceptualHash::DctSize;
+    constexpr int32 DctKeep = 8;
+
+    // First DctKeep rows of the orthonormal DCT-II matrix; only low frequencies are hashed
+    struct FDctBasis
+    {
+        alignas(16) float Rows[DctKeep][DctSize];
+
+        FDctBasis()
+        {
+            for (int32 U = 0; U < DctKeep; U++)
+            {
+                const float Scale = U == 0 ? FMath::Sqrt(1.0f / DctSize) : FMath::Sqrt(2.0f / DctSize);
+                for (int32 X = 0; X < DctSize; X++)
+                {
+                    Rows[U][X] = Scale * FMath::Cos(PI * (2 * X + 1) * U / (2.0f * DctSize));
+                }
+            }
+        }
+    };
+
+    const FDctBasis& GetDctBasis()
+    {
+        static const FDctBasis Basis;
+        return Basis;
+    }
+
+    // Dot product of two 16-byte aligned DctSize-long rows, four lanes at a time
+    float DotRow(const float* A, const float* B)
+    {
+        VectorRegister4Float Sum = VectorZeroFloat();
+        for (int32 I = 0; I < DctSize; I += 4)
+        {
+            Sum = VectorMultiplyAdd(VectorLoadAligned(A + I), VectorLoadAligned(B + I), Sum);
+        }
+        alignas(16) float Lanes[4];
+        VectorStoreAligned(Sum, Lanes);
+        return Lanes[0] + Lanes[1] + Lanes[2] + Lanes[3];
+    }
+}
+
+void FRefPerceptualHash::DownsampleLuma(const FRefImageProxy& Proxy, int32 OutWidth, int32 OutHeight, float* OutLuma)
+{
+    TArray<float, TInlineAllocator<DctSize * DctSize>> Sums;
+    TArray<int32, TInlineAllocator<DctSize * DctSize>> Counts;
+    Sums.SetNumZeroed(OutWidth * OutHeight);
+    Counts.SetNumZeroed(OutWidth * OutHeight);
+
+    // Every source pixel lands in exactly one cell; small proxies leave some cells empty
+    for (int32 Y = 0; Y < Proxy.Height; Y++)
+    {
+        const int32 CellY = (int32)((int64)Y * OutHeight / Proxy.Height);
+        const uint8* Src = Proxy.BGRA.GetData() + (int64)Y * Proxy.Width * 4;
+        for (int32 X = 0; X < Proxy.Width; X++, Src += 4)
+        {
+            const int32 Cell = CellY * OutWidth + (int32)((int64)X * OutWidth / Proxy.Width);
+            Sums[Cell] += 0.114f * Src[0] + 0.587f * Src[1] + 0.299f * Src[2];
+            Counts[Cell]++;
+        }
+    }
+
+    for (int32 Y = 0; Y < OutHeight; Y++)
+    {
+        for (int32 X = 0; X < OutWidth; X++)
+        {
+            const int32 Cell = Y * OutWidth + X;
+            if (Counts[Cell] > 0)
+            {
+                OutLuma[Cell] = Sums[Cell] / (Counts[Cell] * 255.0f);
+            }
+            else
+            {
+                // Proxy narrower than the grid: nearest source pixel
+                const uint8* Src = Proxy.BGRA.GetData() + ((int64)(Y * Proxy.Height / OutHeight) * Proxy.Width + X * Proxy.Width / OutWidth) * 4;
+                OutLuma[Cell] = (0.114f * Src[0] + 0.587f * Src[1] + 0.299f * Src[2]) / 255.0f;
+            }
+        }
+    }
+}
+
+FRefImageHash FRefPerceptualHash::Compute(const FRefImageProxy& Proxy)
+{
+    FRefImageHash Hash;
+    if (Proxy.Width <= 0 || Proxy.Height <= 0)
+        return Hash;
+
+    // dHash: each bit says whether luma rises to the right
+    {
+        float Luma[9 * 8];
+        DownsampleLuma(Proxy, 9, 8, Luma);
+        for (int32 Y = 0; Y < 8; Y++)
+        {
+            for (int32 X = 0; X < 8; X++)
+            {
+                if (Luma[Y * 9 + X] < Luma[Y * 9 + X + 1])
+                {
+                    Hash.DHash |= 1ull << (Y * 8 + X);
+                }
+            }
+        }
+    }
+
+    // pHash: 8x8 low-frequency block of the 2D DCT, as B * L * B^T with B the kept basis rows
+    {
+        alignas(16) float Luma[DctSize][DctSize];
+        DownsampleLuma(Proxy, DctSize, DctSize, &Luma[0][0]);
+
+        // Columns of L are needed as contiguous rows for the first pass
+        alignas(16) float LumaT[DctSize][DctSize];
+        for (int32 Y = 0; Y < DctSize; Y++)
+        {
+            for (int32 X = 0; X < DctSize; X++)
+            {
+                LumaT[X][Y] = Luma[Y][X];
+            }
+        }
+
+        const FDctBasis& Basis = GetDctBasis();
+
+        // Temp[U][X] = sum_Y B[U][Y] * L[Y][X]
+        alignas(16) float Temp[DctKeep][DctSize];
+        for (int32 U = 0; U < DctKeep; U++)
+        {
+            for (int32 X = 0; X < DctSize; X++)
+            {
+                Temp[U][X] = DotRow(Basis.Rows[U], LumaT[X]);
+            }
+        }
+
+        // Coeffs[U][V] = sum_X Temp[U][X] * B[V][X]
+        float Coeffs[DctKeep * DctKeep];
+        for (int32 U = 0; U < DctKeep; U++)
+        {
+            for (int32 V = 0; V < DctKeep; V++)
+            {
+                Coeffs[U * DctKeep + V] = DotRow(Temp[U], Basis.Rows[V]);
+            }
+        }
+
+        // The DC term only carries overall brightness, so it is left out of the median
+        float Sorted[DctKeep * DctKeep - 1];
+        FMemory::Memcpy(Sorted, Coeffs + 1, sizeof(Sorted));
+        Algo::Sort(Sorted);
+        const float Median = Sorted[(DctKeep * DctKeep - 1) / 2];
+
+        for (int32 I = 1; I < DctKeep * DctKeep; I++)
+        {
+            if (Coeffs[I] > Median)
+            {
+                Hash.PHash |= 1ull << I;
+            }
+        }
+    }
+
+    return Hash;
+}
\ No newline at end of file
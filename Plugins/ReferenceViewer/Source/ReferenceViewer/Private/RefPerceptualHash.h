@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+// Perceptual fingerprint of an image. Similar images differ in few bits.
+struct FRefImageHash
+{
+    // Signs of the low-frequency DCT of a 32x32 luma thumbnail, against their median
+    uint64 PHash = 0;
+
+    // Horizontal luma gradients of a 9x8 thumbnail
+    uint64 DHash = 0;
+
+    int32 PDistance(const FRefImageHash& Other) const { return FMath::CountBits(PHash ^ Other.PHash); }
+    int32 DDistance(const FRefImageHash& Other) const { return FMath::CountBits(DHash ^ Other.DHash); }
+};
+
+class FRefPerceptualHash
+{
+public:
+    // Side of the luma thumbnail the DCT runs on
+    static constexpr int32 DctSize = 32;
+
+    // Any thread. Cost is one pass over the proxy plus a 32x32 partial DCT.
+    static FRefImageHash Compute(const FRefImageProxy& Proxy);
+
+private:
+    // Area-averaged luma, 0..1, OutWidth x OutHeight
+    static void DownsampleLuma(const FRefImageProxy& Proxy, int32 OutWidth, int32 OutHeight, float* OutLuma);
+};
\ No newline at end of file
@@ -0,0 +1,453 @@
+#include "RefSilhouetteRasterizer.h"
+#include "RefImageLoader.h"
+#include "SReferenceCanvas.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Containers/Ticker.h"
+#include "Engine/StaticMesh.h"
+#include "StaticMeshResources.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRefSilhouette, Log, All);
+
+FColor FRefSilhouetteRasterizer::FillColor(255, 180, 0, 110);
+FColor FRefSilhouetteRasterizer::OutlineColor(255, 255, 255, 255);
+
+namespace
+{
+    // Image axes (right, up) as components of the mesh position
+    void GetViewAxes(ERefOrthoView View, int32& OutU, int32& OutV)
+    {
+        switch (View)
+        {
+            case ERefOrthoView::Front: OutU = 1; OutV = 2; break;
+            case ERefOrthoView::Side:  OutU = 0; OutV = 2; break;
+            case ERefOrthoView::Top:   OutU = 1; OutV = 0; break;
+        }
+    }
+
+    const TCHAR* GetViewName(ERefOrthoView View)
+    {
+        switch (View)
+        {
+            case ERefOrthoView::Front: return TEXT("Front");
+            case ERefOrthoView::Side:  return TEXT("Side");
+            case ERefOrthoView::Top:   return TEXT("Top");
+        }
+        return TEXT("");
+    }
+
+    FORCEINLINE float EdgeFunction(const FVector2f& A, const FVector2f& B, float PX, float PY)
+    {
+        return (B.X - A.X) * (PY - A.Y) - (B.Y - A.Y) * (PX - A.X);
+    }
+}
+
+FRefMeshSnapshotPtr FRefMeshSnapshot::Capture(const UStaticMesh* Mesh)
+{
+    check(IsInGameThread());
+
+    const FStaticMeshRenderData* RenderData = Mesh ? Mesh->GetRenderData() : nullptr;
+    if (!RenderData || RenderData->LODResources.Num() == 0)
+        return nullptr;
+
+    const FStaticMeshLODResources& LOD = RenderData->LODResources[0];
+    const FPositionVertexBuffer& PositionBuffer = LOD.VertexBuffers.PositionVertexBuffer;
+    if (PositionBuffer.GetNumVertices() == 0 || !PositionBuffer.GetVertexData())
+        return nullptr;
+
+    TSharedPtr<FRefMeshSnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FRefMeshSnapshot, ESPMode::ThreadSafe>();
+    Snapshot->Positions.SetNumUninitialized(PositionBuffer.GetNumVertices());
+    for (uint32 i = 0; i < PositionBuffer.GetNumVertices(); i++)
+    {
+        Snapshot->Positions[i] = PositionBuffer.VertexPosition(i);
+        Snapshot->Bounds += Snapshot->Positions[i];
+    }
+
+    LOD.IndexBuffer.GetCopy(Snapshot->Indices);
+    if (Snapshot->Indices.Num() < 3)
+        return nullptr;
+
+    return Snapshot;
+}
+
+FRefSilhouetteRasterizer::FRefSilhouetteRasterizer(ERefOrthoView InView, int32 InResolution)
+    : View(InView)
+    , Resolution(InResolution)
+    , Bounds(ForceInit)
+    , Scale(1.0f)
+    , Width(0)
+    , Height(0)
+    , NumBands(0)
+    , LastRenderMs(0.0)
+    , LastDirtyBands(0)
+{
+}
+
+FVector2f FRefSilhouetteRasterizer::Project(const FVector3f& Position) const
+{
+    int32 U, V;
+    GetViewAxes(View, U, V);
+    return FVector2f(
+        (Position[U] - Bounds.Min[U]) * Scale + Padding,
+        (Bounds.Max[V] - Position[V]) * Scale + Padding);
+}
+
+void FRefSilhouetteRasterizer::Render(const FRefMeshSnapshot& Mesh)
+{
+    const double StartTime = FPlatformTime::Seconds();
+
+    const int32 NumVertices = Mesh.Positions.Num();
+    const int32 NumTriangles = Mesh.Indices.Num() / 3;
+
+    // Same topology and framing means the previous image is still valid outside moved triangles
+    const bool bSameTopology = Projected.Num() == NumVertices && Indices.Num() == Mesh.Indices.Num()
+        && FMemory::Memcmp(Indices.GetData(), Mesh.Indices.GetData(), Indices.Num() * sizeof(uint32)) == 0;
+    const bool bIncremental = bSameTopology && Bounds.Min == Mesh.Bounds.Min && Bounds.Max == Mesh.Bounds.Max;
+
+    if (!bIncremental)
+    {
+        int32 U, V;
+        GetViewAxes(View, U, V);
+        Bounds = Mesh.Bounds;
+        const FVector3f Extent = Bounds.GetSize();
+        Scale = (Resolution - 2 * Padding) / FMath::Max3(Extent[U], Extent[V], KINDA_SMALL_NUMBER);
+        Width = FMath::CeilToInt(Extent[U] * Scale) + 2 * Padding;
+        Height = FMath::CeilToInt(Extent[V] * Scale) + 2 * Padding;
+        NumBands = FMath::DivideAndRoundUp(Height, BandHeight);
+        Coverage.SetNumZeroed(Width * Height);
+        Pixels.SetNumZeroed(Width * Height);
+    }
+
+    TArray<FVector2f> NewProjected;
+    NewProjected.SetNumUninitialized(NumVertices);
+    ParallelFor(NumVertices, [&](int32 i)
+    {
+        NewProjected[i] = Project(Mesh.Positions[i]);
+    }, EParallelForFlags::None);
+
+    TBitArray<> DirtyBands(!bIncremental, NumBands);
+    if (bIncremental)
+    {
+        // Both the old and the new footprint of a moved triangle need redrawing
+        auto MarkRows = [&](float MinY, float MaxY)
+        {
+            const int32 First = FMath::Clamp(FMath::FloorToInt(MinY) / BandHeight, 0, NumBands - 1);
+            const int32 Last = FMath::Clamp(FMath::CeilToInt(MaxY) / BandHeight, 0, NumBands - 1);
+            for (int32 Band = First; Band <= Last; Band++)
+            {
+                DirtyBands[Band] = true;
+            }
+        };
+
+        for (int32 Tri = 0; Tri < NumTriangles; Tri++)
+        {
+            const uint32 I0 = Indices[Tri * 3], I1 = Indices[Tri * 3 + 1], I2 = Indices[Tri * 3 + 2];
+            if (Projected[I0] == NewProjected[I0] && Projected[I1] == NewProjected[I1] && Projected[I2] == NewProjected[I2])
+                continue;
+
+            MarkRows(FMath::Min3(Projected[I0].Y, Projected[I1].Y, Projected[I2].Y),
+                     FMath::Max3(Projected[I0].Y, Projected[I1].Y, Projected[I2].Y));
+            MarkRows(FMath::Min3(NewProjected[I0].Y, NewProjected[I1].Y, NewProjected[I2].Y),
+                     FMath::Max3(NewProjected[I0].Y, NewProjected[I1].Y, NewProjected[I2].Y));
+        }
+    }
+    else
+    {
+        Indices = Mesh.Indices;
+    }
+    Projected = MoveTemp(NewProjected);
+
+    TArray<int32> RasterBands;
+    for (TConstSetBitIterator<> It(DirtyBands); It; ++It)
+    {
+        RasterBands.Add(It.GetIndex());
+    }
+
+    LastDirtyBands = RasterBands.Num();
+    if (RasterBands.Num() == 0)
+    {
+        LastRenderMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+        return;
+    }
+
+    // Bin triangles into the bands they overlap
+    BandStart.Reset();
+    BandStart.SetNumZeroed(NumBands + 1);
+    TArray<FIntPoint> TriangleBands;
+    TriangleBands.SetNumUninitialized(NumTriangles);
+    for (int32 Tri = 0; Tri < NumTriangles; Tri++)
+    {
+        const float MinY = FMath::Min3(Projected[Indices[Tri * 3]].Y, Projected[Indices[Tri * 3 + 1]].Y, Projected[Indices[Tri * 3 + 2]].Y);
+        const float MaxY = FMath::Max3(Projected[Indices[Tri * 3]].Y, Projected[Indices[Tri * 3 + 1]].Y, Projected[Indices[Tri * 3 + 2]].Y);
+        FIntPoint& Range = TriangleBands[Tri];
+        Range.X = FMath::Clamp(FMath::FloorToInt(MinY) / BandHeight, 0, NumBands - 1);
+        Range.Y = FMath::Clamp(FMath::CeilToInt(MaxY) / BandHeight, 0, NumBands - 1);
+        for (int32 Band = Range.X; Band <= Range.Y; Band++)
+        {
+            BandStart[Band + 1]++;
+        }
+    }
+    for (int32 Band = 0; Band < NumBands; Band++)
+    {
+        BandStart[Band + 1] += BandStart[Band];
+    }
+
+    BandTriangles.SetNumUninitialized(BandStart[NumBands]);
+    TArray<int32> Cursor(BandStart.GetData(), NumBands);
+    for (int32 Tri = 0; Tri < NumTriangles; Tri++)
+    {
+        for (int32 Band = TriangleBands[Tri].X; Band <= TriangleBands[Tri].Y; Band++)
+        {
+            BandTriangles[Cursor[Band]++] = Tri;
+        }
+    }
+
+    ParallelFor(RasterBands.Num(), [&](int32 i)
+    {
+        RasterizeBand(RasterBands[i]);
+    });
+
+    // Outlines look one row across band borders, so neighbours of dirty bands are recomposed too
+    TBitArray<> ComposeMask = DirtyBands;
+    for (int32 Band : RasterBands)
+    {
+        if (Band > 0) ComposeMask[Band - 1] = true;
+        if (Band < NumBands - 1) ComposeMask[Band + 1] = true;
+    }
+
+    TArray<int32> ComposeBands;
+    for (TConstSetBitIterator<> It(ComposeMask); It; ++It)
+    {
+        ComposeBands.Add(It.GetIndex());
+    }
+
+    ParallelFor(ComposeBands.Num(), [&](int32 i)
+    {
+        ComposeBand(ComposeBands[i]);
+    });
+
+    LastRenderMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+}
+
+void FRefSilhouetteRasterizer::RasterizeBand(int32 Band)
+{
+    const int32 BandMinY = Band * BandHeight;
+    const int32 BandMaxY = FMath::Min(BandMinY + BandHeight, Height) - 1;
+    FMemory::Memzero(Coverage.GetData() + BandMinY * Width, (BandMaxY - BandMinY + 1) * Width);
+
+    for (int32 i = BandStart[Band]; i < BandStart[Band + 1]; i++)
+    {
+        const int32 Tri = BandTriangles[i];
+        const FVector2f A = Projected[Indices[Tri * 3]];
+        FVector2f B = Projected[Indices[Tri * 3 + 1]];
+        FVector2f C = Projected[Indices[Tri * 3 + 2]];
+
+        // Silhouettes ignore facing, so flip clockwise triangles instead of culling them
+        const float Area = EdgeFunction(A, B, C.X, C.Y);
+        if (FMath::Abs(Area) < KINDA_SMALL_NUMBER)
+            continue;
+        if (Area < 0.0f)
+        {
+            Swap(B, C);
+        }
+
+        const int32 MinX = FMath::Max(FMath::FloorToInt(FMath::Min3(A.X, B.X, C.X)), 0);
+        const int32 MaxX = FMath::Min(FMath::CeilToInt(FMath::Max3(A.X, B.X, C.X)), Width - 1);
+        const int32 MinY = FMath::Max(FMath::FloorToInt(FMath::Min3(A.Y, B.Y, C.Y)), BandMinY);
+        const int32 MaxY = FMath::Min(FMath::CeilToInt(FMath::Max3(A.Y, B.Y, C.Y)), BandMaxY);
+        if (MinX > MaxX || MinY > MaxY)
+            continue;
+
+        // Edge functions stepped incrementally along each row
+        const float StepX0 = -(C.Y - B.Y), StepX1 = -(A.Y - C.Y), StepX2 = -(B.Y - A.Y);
+        for (int32 Y = MinY; Y <= MaxY; Y++)
+        {
+            const float PX = MinX + 0.5f;
+            const float PY = Y + 0.5f;
+            float W0 = EdgeFunction(B, C, PX, PY);
+            float W1 = EdgeFunction(C, A, PX, PY);
+            float W2 = EdgeFunction(A, B, PX, PY);
+
+            uint8* Row = Coverage.GetData() + Y * Width;
+            for (int32 X = MinX; X <= MaxX; X++)
+            {
+                if (W0 >= 0.0f && W1 >= 0.0f && W2 >= 0.0f)
+                {
+                    Row[X] = 1;
+                }
+                W0 += StepX0;
+                W1 += StepX1;
+                W2 += StepX2;
+            }
+        }
+    }
+}
+
+void FRefSilhouetteRasterizer::ComposeBand(int32 Band)
+{
+    const int32 BandMinY = Band * BandHeight;
+    const int32 BandMaxY = FMath::Min(BandMinY + BandHeight, Height) - 1;
+
+    for (int32 Y = BandMinY; Y <= BandMaxY; Y++)
+    {
+        const uint8* Row = Coverage.GetData() + Y * Width;
+        const uint8* Above = Y > 0 ? Row - Width : nullptr;
+        const uint8* Below = Y < Height - 1 ? Row + Width : nullptr;
+        FColor* Out = Pixels.GetData() + Y * Width;
+
+        for (int32 X = 0; X < Width; X++)
+        {
+            if (!Row[X])
+            {
+                Out[X] = FColor(0, 0, 0, 0);
+                continue;
+            }
+
+            const bool bBorder = X == 0 || X == Width - 1 || !Above || !Below
+                || !Row[X - 1] || !Row[X + 1] || !Above[X] || !Below[X];
+            Out[X] = bBorder ? OutlineColor : FillColor;
+        }
+    }
+}
+
+FRefMeshSilhouette::FRefMeshSilhouette(UStaticMesh* InMesh, TSharedPtr<SReferenceCanvas> InCanvas, const FVector2D& InPosition)
+    : Mesh(InMesh)
+    , Canvas(InCanvas)
+    , Position(InPosition)
+    , bRenderInFlight(false)
+    , bRenderPending(false)
+{
+    for (ERefOrthoView View : { ERefOrthoView::Front, ERefOrthoView::Side, ERefOrthoView::Top })
+    {
+        Rasterizers.Add(MakeShared<FRefSilhouetteRasterizer, ESPMode::ThreadSafe>(View, Resolution));
+    }
+    Images.SetNum(Rasterizers.Num());
+}
+
+FRefMeshSilhouette::~FRefMeshSilhouette()
+{
+    if (PendingTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(PendingTickerHandle);
+    }
+
+    if (UStaticMesh* StaticMesh = Mesh.Get())
+    {
+        StaticMesh->OnMeshChanged().RemoveAll(this);
+    }
+}
+
+void FRefMeshSilhouette::Start()
+{
+    if (UStaticMesh* StaticMesh = Mesh.Get())
+    {
+        StaticMesh->OnMeshChanged().AddSP(this, &FRefMeshSilhouette::HandleMeshChanged);
+        HandleMeshChanged();
+    }
+}
+
+void FRefMeshSilhouette::HandleMeshChanged()
+{
+    // Edits can arrive faster than renders finish; they collapse into one pending render
+    bRenderPending = true;
+    if (!PendingTickerHandle.IsValid())
+    {
+        PendingTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+            FTickerDelegate::CreateSP(this, &FRefMeshSilhouette::TickPendingRender));
+    }
+}
+
+bool FRefMeshSilhouette::TickPendingRender(float DeltaTime)
+{
+    if (!IsValid() || !bRenderPending)
+    {
+        PendingTickerHandle.Reset();
+        return false;
+    }
+
+    // Wait for the previous render and for async mesh builds to finish
+    if (bRenderInFlight || Mesh->IsCompiling())
+        return true;
+
+    bRenderPending = false;
+    PendingTickerHandle.Reset();
+    LaunchRender();
+    return false;
+}
+
+void FRefMeshSilhouette::LaunchRender()
+{
+    FRefMeshSnapshotPtr Snapshot = FRefMeshSnapshot::Capture(Mesh.Get());
+    if (!Snapshot.IsValid())
+    {
+        UE_LOG(LogRefSilhouette, Warning, TEXT("%s has no CPU-accessible render data to rasterize"), *Mesh->GetName());
+        return;
+    }
+
+    bRenderInFlight = true;
+    TWeakPtr<FRefMeshSilhouette> WeakThis = AsShared();
+    TArray<TSharedPtr<FRefSilhouetteRasterizer, ESPMode::ThreadSafe>> Work = Rasterizers;
+
+    Async(EAsyncExecution::ThreadPool, [Snapshot, Work, WeakThis]()
+    {
+        for (const auto& Rasterizer : Work)
+        {
+            Rasterizer->Render(*Snapshot);
+        }
+
+        AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+        {
+            if (TSharedPtr<FRefMeshSilhouette> This = WeakThis.Pin())
+            {
+                This->OnRenderComplete();
+            }
+        });
+    });
+}
+
+void FRefMeshSilhouette::OnRenderComplete()
+{
+    bRenderInFlight = false;
+
+    TSharedPtr<SReferenceCanvas> CanvasPtr = Canvas.Pin();
+    if (!CanvasPtr.IsValid() || !Mesh.IsValid())
+        return;
+
+    FVector2D NextPosition = Position;
+    for (int32 i = 0; i < Rasterizers.Num(); i++)
+    {
+        const FRefSilhouetteRasterizer& Rasterizer = *Rasterizers[i];
+        UE_LOG(LogRefSilhouette, Verbose, TEXT("%s %s: %.2f ms, %d bands redrawn"),
+            *Mesh->GetName(), GetViewName(Rasterizer.GetView()), Rasterizer.GetLastRenderMs(), Rasterizer.GetLastDirtyBands());
+
+        if (Rasterizer.GetWidth() == 0 || Rasterizer.GetLastDirtyBands() == 0)
+            continue;
+
+        UTexture2D* Texture = FRefImageLoader::CreateTexture(
+            reinterpret_cast<const uint8*>(Rasterizer.GetPixels().GetData()), Rasterizer.GetWidth(), Rasterizer.GetHeight());
+        if (!Texture)
+            continue;
+
+        const FVector2D NewSize(Rasterizer.GetWidth(), Rasterizer.GetHeight());
+        if (TSharedPtr<FRefImage> Image = Images[i].Pin())
+        {
+            // Keep whatever scale the user gave the image
+            const float UserScale = Image->Texture ? Image->Size.X / Image->Texture->GetSizeX() : 1.0f;
+            CanvasPtr->InvalidateMinimap(Image->GetBounds());
+            Image->Size = NewSize * UserScale;
+            CanvasPtr->SetImageTexture(Image, Texture);
+        }
+        else
+        {
+            TSharedPtr<FRefImage> NewImage = MakeShareable(new FRefImage());
+            NewImage->Name = FString::Printf(TEXT("%s_%s"), *Mesh->GetName(), GetViewName(Rasterizer.GetView()));
+            NewImage->Texture = Texture;
+            NewImage->Size = NewSize;
+            NewImage->Position = NextPosition;
+            CanvasPtr->AddImage(NewImage);
+            Images[i] = NewImage;
+        }
+
+        NextPosition.X += NewSize.X + 20.0f;
+    }
+}
\ No newline at end of file
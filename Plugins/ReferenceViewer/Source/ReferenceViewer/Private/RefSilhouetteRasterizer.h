@@ -0,0 +1,117 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "RefViewerData.h"
+
+class UStaticMesh;
+class SReferenceCanvas;
+
+enum class ERefOrthoView : uint8
+{
+    Front,
+    Side,
+    Top
+};
+
+// Triangle list copied from a static mesh's LOD0 render data
+struct FRefMeshSnapshot
+{
+    TArray<FVector3f> Positions;
+    TArray<uint32> Indices;
+    FBox3f Bounds = FBox3f(ForceInit);
+
+    // Game thread; null if the mesh has no CPU-side render data
+    static TSharedPtr<const FRefMeshSnapshot, ESPMode::ThreadSafe> Capture(const UStaticMesh* Mesh);
+};
+
+typedef TSharedPtr<const FRefMeshSnapshot, ESPMode::ThreadSafe> FRefMeshSnapshotPtr;
+
+// Multithreaded CPU rasterizer producing an orthographic silhouette with outline.
+// The image is split into horizontal bands that rasterize in parallel. When only
+// vertex positions change, just the bands touched by moved triangles are redrawn.
+class FRefSilhouetteRasterizer
+{
+public:
+    static constexpr int32 BandHeight = 32;
+    static constexpr int32 Padding = 8;
+
+    FRefSilhouetteRasterizer(ERefOrthoView InView, int32 InResolution);
+
+    // Not thread safe; callers keep one render in flight per rasterizer
+    void Render(const FRefMeshSnapshot& Mesh);
+
+    ERefOrthoView GetView() const { return View; }
+    int32 GetWidth() const { return Width; }
+    int32 GetHeight() const { return Height; }
+    const TArray<FColor>& GetPixels() const { return Pixels; }
+
+    // Stats for the last Render()
+    double GetLastRenderMs() const { return LastRenderMs; }
+    int32 GetLastDirtyBands() const { return LastDirtyBands; }
+
+    static FColor FillColor;
+    static FColor OutlineColor;
+
+private:
+    FVector2f Project(const FVector3f& Position) const;
+    void RasterizeBand(int32 Band);
+    void ComposeBand(int32 Band);
+
+    ERefOrthoView View;
+    int32 Resolution;
+
+    // Projection of the last render
+    FBox3f Bounds;
+    float Scale;
+    int32 Width;
+    int32 Height;
+    int32 NumBands;
+
+    // Previous geometry, for change detection
+    TArray<FVector2f> Projected;
+    TArray<uint32> Indices;
+
+    // Triangles per band (CSR)
+    TArray<int32> BandStart;
+    TArray<int32> BandTriangles;
+
+    TArray<uint8> Coverage;
+    TArray<FColor> Pixels;
+
+    double LastRenderMs;
+    int32 LastDirtyBands;
+};
+
+// Front/side/top silhouettes of one static mesh kept on the board and
+// re-rendered in the background whenever the mesh is edited
+class FRefMeshSilhouette : public TSharedFromThis<FRefMeshSilhouette>
+{
+public:
+    static constexpr int32 Resolution = 1024;
+
+    FRefMeshSilhouette(UStaticMesh* InMesh, TSharedPtr<SReferenceCanvas> InCanvas, const FVector2D& InPosition);
+    ~FRefMeshSilhouette();
+
+    // Subscribes to mesh edits and kicks off the first render
+    void Start();
+
+    bool IsValid() const { return Mesh.IsValid() && Canvas.IsValid(); }
+
+private:
+    void HandleMeshChanged();
+    bool TickPendingRender(float DeltaTime);
+    void LaunchRender();
+    void OnRenderComplete();
+
+    TWeakObjectPtr<UStaticMesh> Mesh;
+    TWeakPtr<SReferenceCanvas> Canvas;
+    FVector2D Position;
+
+    TArray<TSharedPtr<FRefSilhouetteRasterizer, ESPMode::ThreadSafe>> Rasterizers;
+    TArray<TWeakPtr<FRefImage>> Images;
+
+    bool bRenderInFlight;
+    bool bRenderPending;
+    FTSTicker::FDelegateHandle PendingTickerHandle;
+};
\ No newline at end of file
@@ -0,0 +1,359 @@
+#include "RefSimilarityIndex.h"
+#include "RefThumbnailCache.h"
+#include "RefImageLoader.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Serialization/Archive.h"
+
+namespace
+{
+    FString NormalizePath(const FString& Path)
+    {
+        FString Result = FPaths::ConvertRelativePathToFull(Path);
+        FPaths::NormalizeFilename(Result);
+        return Result;
+    }
+}
+
+FRefSimilarityIndex& FRefSimilarityIndex::Get()
+{
+    check(IsInGameThread());
+
+    static TSharedPtr<FRefSimilarityIndex> Instance;
+    if (!Instance.IsValid())
+    {
+        Instance = MakeShareable(new FRefSimilarityIndex());
+        Instance->Load();
+    }
+    return *Instance;
+}
+
+FRefSimilarityIndex::FRefSimilarityIndex()
+    : bTreeStale(false)
+    , NumInBatch(0)
+    , bDirty(false)
+    , bSaveInFlight(false)
+{
+}
+
+FString FRefSimilarityIndex::GetIndexPath()
+{
+    return FPaths::ProjectSavedDir() / TEXT("ReferenceViewer") / TEXT("Similarity.index");
+}
+
+bool FRefSimilarityIndex::IsCurrent(const FString& FilePath, const FDateTime& Timestamp, int64 FileSize) const
+{
+    const int32* Index = EntryByPath.Find(FilePath);
+    return Index && Entries[*Index].Timestamp == Timestamp && Entries[*Index].FileSize == FileSize;
+}
+
+void FRefSimilarityIndex::IndexFiles(const TArray<FRefIndexRequest>& Requests)
+{
+    for (const FRefIndexRequest& Request : Requests)
+    {
+        FRefIndexRequest Normalized = Request;
+        Normalized.FilePath = NormalizePath(Request.FilePath);
+        if (IsCurrent(Normalized.FilePath, Normalized.Timestamp, Normalized.FileSize) || PendingPaths.Contains(Normalized.FilePath))
+            continue;
+
+        PendingPaths.Add(Normalized.FilePath);
+        Pending.Add(MoveTemp(Normalized));
+    }
+
+    PumpBatch();
+}
+
+void FRefSimilarityIndex::Add(const FString& FilePath, const FDateTime& Timestamp, int64 FileSize, const FRefImageHash& Hash)
+{
+    SetEntry(NormalizePath(FilePath), Timestamp, FileSize, Hash);
+    SaveAsync();
+}
+
+void FRefSimilarityIndex::SetEntry(const FString& FilePath, const FDateTime& Timestamp, int64 FileSize, const FRefImageHash& Hash)
+{
+    bDirty = true;
+
+    if (const int32* Existing = EntryByPath.Find(FilePath))
+    {
+        FEntry& Entry = Entries[*Existing];
+        Entry.Timestamp = Timestamp;
+        Entry.FileSize = FileSize;
+        bTreeStale |= (Entry.Hash.PHash != Hash.PHash);
+        Entry.Hash = Hash;
+        return;
+    }
+
+    const int32 EntryIndex = Entries.Num();
+    FEntry& Entry = Entries.AddDefaulted_GetRef();
+    Entry.FilePath = FilePath;
+    Entry.Timestamp = Timestamp;
+    Entry.FileSize = FileSize;
+    Entry.Hash = Hash;
+    EntryByPath.Add(FilePath, EntryIndex);
+
+    if (!bTreeStale)
+    {
+        InsertNode(EntryIndex);
+    }
+}
+
+void FRefSimilarityIndex::InsertNode(int32 EntryIndex)
+{
+    FNode NewNode;
+    NewNode.Hash = Entries[EntryIndex].Hash.PHash;
+    NewNode.Entry = EntryIndex;
+
+    if (Nodes.Num() == 0)
+    {
+        Nodes.Add(NewNode);
+        return;
+    }
+
+    int32 Current = 0;
+    for (;;)
+    {
+        const int32 Distance = FMath::CountBits(Nodes[Current].Hash ^ NewNode.Hash);
+
+        int32 Child = Nodes[Current].FirstChild;
+        while (Child != INDEX_NONE && Nodes[Child].Distance != Distance)
+        {
+            Child = Nodes[Child].NextSibling;
+        }
+
+        if (Child == INDEX_NONE)
+        {
+            NewNode.Distance = Distance;
+            NewNode.NextSibling = Nodes[Current].FirstChild;
+            Nodes[Current].FirstChild = Nodes.Add(NewNode);
+            return;
+        }
+        Current = Child;
+    }
+}
+
+void FRefSimilarityIndex::RebuildTree()
+{
+    Nodes.Reset(Entries.Num());
+    for (int32 EntryIndex = 0; EntryIndex < Entries.Num(); EntryIndex++)
+    {
+        InsertNode(EntryIndex);
+    }
+    bTreeStale = false;
+}
+
+TArray<FRefSimilarMatch> FRefSimilarityIndex::FindSimilar(const FRefImageHash& Hash, int32 MaxDistance, int32 MaxResults)
+{
+    if (bTreeStale)
+    {
+        RebuildTree();
+    }
+
+    TArray<FRefSimilarMatch> Matches;
+    if (Nodes.Num() == 0)
+        return Matches;
+
+    // Triangle inequality: a child at distance D from its parent can only hold
+    // matches when |D - d(parent, query)| <= MaxDistance
+    TArray<int32, TInlineAllocator<256>> Stack;
+    Stack.Add(0);
+    while (Stack.Num() > 0)
+    {
+        const FNode& Node = Nodes[Stack.Pop(EAllowShrinking::No)];
+        const int32 Distance = FMath::CountBits(Node.Hash ^ Hash.PHash);
+        if (Distance <= MaxDistance)
+        {
+            const FEntry& Entry = Entries[Node.Entry];
+            FRefSimilarMatch& Match = Matches.AddDefaulted_GetRef();
+            Match.FilePath = Entry.FilePath;
+            Match.Timestamp = Entry.Timestamp;
+            Match.FileSize = Entry.FileSize;
+            Match.Distance = Distance;
+            Match.DDistance = Entry.Hash.DDistance(Hash);
+        }
+
+        for (int32 Child = Node.FirstChild; Child != INDEX_NONE; Child = Nodes[Child].NextSibling)
+        {
+            if (FMath::Abs(Nodes[Child].Distance - Distance) <= MaxDistance)
+            {
+                Stack.Add(Child);
+            }
+        }
+    }
+
+    Matches.Sort([](const FRefSimilarMatch& A, const FRefSimilarMatch& B)
+    {
+        return A.Distance != B.Distance ? A.Distance < B.Distance : A.DDistance < B.DDistance;
+    });
+
+    // Files deleted since they were indexed are skipped, only among the results kept
+    TArray<FRefSimilarMatch> Result;
+    for (FRefSimilarMatch& Match : Matches)
+    {
+        if (Result.Num() >= MaxResults)
+            break;
+
+        if (FPaths::FileExists(Match.FilePath))
+        {
+            Result.Add(MoveTemp(Match));
+        }
+    }
+    return Result;
+}
+
+void FRefSimilarityIndex::PumpBatch()
+{
+    if (NumInBatch > 0)
+        return;
+
+    if (Pending.Num() == 0)
+    {
+        if (bDirty)
+        {
+            SaveAsync();
+        }
+        return;
+    }
+
+    // Newest requests first: the folder browsed last is the one being looked at
+    const int32 Count = FMath::Min(BatchSize, Pending.Num());
+    TArray<FBatchResult> Batch;
+    Batch.SetNum(Count);
+    for (int32 Index = 0; Index < Count; Index++)
+    {
+        Batch[Index].Request = Pending.Pop(EAllowShrinking::No);
+        PendingPaths.Remove(Batch[Index].Request.FilePath);
+    }
+    NumInBatch = Count;
+
+    TWeakPtr<FRefSimilarityIndex> WeakIndex = AsShared();
+    Async(EAsyncExecution::ThreadPool, [WeakIndex, Batch = MoveTemp(Batch)]() mutable
+    {
+        ParallelFor(Batch.Num(), [&Batch](int32 Index)
+        {
+            FBatchResult& Item = Batch[Index];
+            const FRefIndexRequest& Request = Item.Request;
+
+            // A thumbnail the library already cached saves the full decode
+            FRefThumbnail Thumbnail;
+            if (!FRefThumbnailCache::Load(Request.FilePath, Request.Timestamp, Request.FileSize, Thumbnail))
+            {
+                TArray64<uint8> BGRA;
+                int32 Width = 0;
+                int32 Height = 0;
+                if (FRefImageLoader::DecodeFile(Request.FilePath, BGRA, Width, Height))
+                {
+                    Thumbnail.Proxy = FRefImageLoader::MakeProxy(BGRA.GetData(), Width, Height, FRefThumbnailCache::ThumbnailSize);
+                }
+            }
+
+            if (Thumbnail.Proxy.IsValid())
+            {
+                Item.Hash = FRefPerceptualHash::Compute(*Thumbnail.Proxy);
+                Item.bHashed = true;
+            }
+        });
+
+        AsyncTask(ENamedThreads::GameThread, [WeakIndex, Batch = MoveTemp(Batch)]() mutable
+        {
+            if (TSharedPtr<FRefSimilarityIndex> Index = WeakIndex.Pin())
+            {
+                Index->OnBatchComplete(MoveTemp(Batch));
+            }
+        });
+    });
+}
+
+void FRefSimilarityIndex::OnBatchComplete(TArray<FBatchResult> Results)
+{
+    NumInBatch = 0;
+    for (const FBatchResult& Result : Results)
+    {
+        if (Result.bHashed)
+        {
+            SetEntry(Result.Request.FilePath, Result.Request.Timestamp, Result.Request.FileSize, Result.Hash);
+        }
+    }
+    PumpBatch();
+}
+
+void FRefSimilarityIndex::Load()
+{
+    TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileReader(*GetIndexPath(), FILEREAD_Silent));
+    if (!Ar.IsValid())
+        return;
+
+    uint32 FileMagic = 0;
+    uint32 FileVersion = 0;
+    int32 Count = 0;
+    *Ar << FileMagic << FileVersion << Count;
+    if (FileMagic != Magic || FileVersion != Version || Count < 0)
+        return;
+
+    Entries.Reserve(Count);
+    EntryByPath.Reserve(Count);
+    for (int32 Index = 0; Index < Count && !Ar->IsError(); Index++)
+    {
+        FEntry Entry;
+        *Ar << Entry.FilePath << Entry.Timestamp << Entry.FileSize << Entry.Hash.PHash << Entry.Hash.DHash;
+        if (Ar->IsError())
+            break;
+
+        EntryByPath.Add(Entry.FilePath, Entries.Num());
+        Entries.Add(MoveTemp(Entry));
+    }
+
+    RebuildTree();
+}
+
+void FRefSimilarityIndex::SaveAsync()
+{
+    // One write at a time, so an older snapshot can never land after a newer one
+    if (bSaveInFlight)
+    {
+        bDirty = true;
+        return;
+    }
+    bDirty = false;
+    bSaveInFlight = true;
+
+    TSharedPtr<TArray<FEntry>, ESPMode::ThreadSafe> Snapshot = MakeShared<TArray<FEntry>, ESPMode::ThreadSafe>(Entries);
+    TWeakPtr<FRefSimilarityIndex> WeakIndex = AsShared();
+    Async(EAsyncExecution::ThreadPool, [WeakIndex, Snapshot]()
+    {
+        const FString Path = GetIndexPath();
+        const FString TempPath = Path + TEXT(".tmp");
+        TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*TempPath));
+        if (Ar.IsValid())
+        {
+            uint32 FileMagic = Magic;
+            uint32 FileVersion = Version;
+            int32 Count = Snapshot->Num();
+            *Ar << FileMagic << FileVersion << Count;
+            for (FEntry& Entry : *Snapshot)
+            {
+                *Ar << Entry.FilePath << Entry.Timestamp << Entry.FileSize << Entry.Hash.PHash << Entry.Hash.DHash;
+            }
+
+            const bool bSuccess = Ar->Close();
+            Ar.Reset();
+            if (bSuccess)
+            {
+                IFileManager::Get().Move(*Path, *TempPath, true, true);
+            }
+        }
+
+        AsyncTask(ENamedThreads::GameThread, [WeakIndex]()
+        {
+            if (TSharedPtr<FRefSimilarityIndex> Index = WeakIndex.Pin())
+            {
+                Index->bSaveInFlight = false;
+                if (Index->bDirty)
+                {
+                    Index->SaveAsync();
+                }
+            }
+        });
+    });
+}
\ No newline at end of file
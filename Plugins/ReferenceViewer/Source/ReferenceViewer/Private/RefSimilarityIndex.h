@@ -0,0 +1,112 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefPerceptualHash.h"
+
+// File to fingerprint in the background
+struct FRefIndexRequest
+{
+    FString FilePath;
+    FDateTime Timestamp;
+    int64 FileSize = 0;
+};
+
+struct FRefSimilarMatch
+{
+    FString FilePath;
+    FDateTime Timestamp;
+    int64 FileSize = 0;
+
+    // Differing pHash bits, 0..64; dHash bits break ties
+    int32 Distance = 0;
+    int32 DDistance = 0;
+};
+
+// Persistent perceptual-hash index over every library folder browsed and every
+// file imported. Hashing runs on workers in batches; lookups walk a BK-tree
+// keyed on pHash Hamming distance, so only branches that can hold a match
+// within the radius are visited.
+class FRefSimilarityIndex : public TSharedFromThis<FRefSimilarityIndex>
+{
+public:
+    static constexpr uint32 Magic = 0x31495352; // "RSI1"
+    static constexpr uint32 Version = 1;
+
+    // Files hashed per worker batch
+    static constexpr int32 BatchSize = 64;
+
+    // pHash distance at or below which two images count as the same picture
+    static constexpr int32 NearDuplicateDistance = 6;
+
+    // Loaded from disk on first use. Game thread only.
+    static FRefSimilarityIndex& Get();
+
+    // Queues files whose timestamp or size differ from what is indexed
+    void IndexFiles(const TArray<FRefIndexRequest>& Requests);
+
+    // Records a hash computed elsewhere, e.g. from an image just imported
+    void Add(const FString& FilePath, const FDateTime& Timestamp, int64 FileSize, const FRefImageHash& Hash);
+
+    // Closest indexed files within MaxDistance, nearest first
+    TArray<FRefSimilarMatch> FindSimilar(const FRefImageHash& Hash, int32 MaxDistance, int32 MaxResults);
+
+    int32 GetNumEntries() const { return Entries.Num(); }
+    int32 GetNumPending() const { return Pending.Num() + NumInBatch; }
+
+    static FString GetIndexPath();
+
+private:
+    struct FEntry
+    {
+        FString FilePath;
+        FDateTime Timestamp;
+        int64 FileSize = 0;
+        FRefImageHash Hash;
+    };
+
+    // BK-tree node; children are a sibling list tagged with their distance to the parent
+    struct FNode
+    {
+        uint64 Hash = 0;
+        int32 Entry = INDEX_NONE;
+        int32 FirstChild = INDEX_NONE;
+        int32 NextSibling = INDEX_NONE;
+        int32 Distance = 0;
+    };
+
+    struct FBatchResult
+    {
+        FRefIndexRequest Request;
+        FRefImageHash Hash;
+        bool bHashed = false;
+    };
+
+    FRefSimilarityIndex();
+
+    bool IsCurrent(const FString& FilePath, const FDateTime& Timestamp, int64 FileSize) const;
+    void SetEntry(const FString& FilePath, const FDateTime& Timestamp, int64 FileSize, const FRefImageHash& Hash);
+    void InsertNode(int32 EntryIndex);
+    void RebuildTree();
+
+    void PumpBatch();
+    void OnBatchComplete(TArray<FBatchResult> Results);
+
+    void Load();
+    void SaveAsync();
+
+    TArray<FEntry> Entries;
+    TMap<FString, int32> EntryByPath;
+
+    TArray<FNode> Nodes;
+
+    // Set when an indexed file is re-hashed; the tree is rebuilt before the next lookup
+    bool bTreeStale;
+
+    TArray<FRefIndexRequest> Pending;
+    TSet<FString> PendingPaths;
+    int32 NumInBatch;
+
+    // Entries changed since the last save was started
+    bool bDirty;
+    bool bSaveInFlight;
+};
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "RefSnapIndex.h"
+#include "Algo/BinarySearch.h"
+
+namespace
+{
+    // Lines closer than this, in canvas units, count as one
+    constexpr double CoincidentDistance = 0.01;
+
+    // Min, centre and max of Bounds along Axis
+    void GetAxisLines(const FBox2D& Bounds, int32 Axis, double (&OutPositions)[3])
+    {
+        OutPositions[0] = Bounds.Min[Axis];
+        OutPositions[1] = (Bounds.Min[Axis] + Bounds.Max[Axis]) * 0.5;
+        OutPositions[2] = Bounds.Max[Axis];
+    }
+}
+
+void FRefSnapIndex::BeginUpdate()
+{
+    CurrentStamp++;
+}
+
+void FRefSnapIndex::Update(const FGuid& Id, const FBox2D& Bounds)
+{
+    if (FEntry* Entry = Entries.Find(Id))
+    {
+        Entry->Stamp = CurrentStamp;
+        if (Entry->Bounds == Bounds)
+            return;
+
+        RemoveLines(Id, Entry->Bounds);
+        Entry->Bounds = Bounds;
+    }
+    else
+    {
+        Entries.Add(Id, FEntry{ Bounds, CurrentStamp });
+    }
+    AddLines(Id, Bounds);
+}
+
+void FRefSnapIndex::EndUpdate()
+{
+    for (auto It = Entries.CreateIterator(); It; ++It)
+    {
+        if (It->Value.Stamp != CurrentStamp)
+        {
+            RemoveLines(It->Key, It->Value.Bounds);
+            It.RemoveCurrent();
+        }
+    }
+}
+
+void FRefSnapIndex::Reset()
+{
+    Lines[0].Reset();
+    Lines[1].Reset();
+    Entries.Reset();
+    Guides.Reset();
+}
+
+void FRefSnapIndex::AddLines(const FGuid& Id, const FBox2D& Bounds)
+{
+    for (int32 Axis = 0; Axis < 2; Axis++)
+    {
+        double Positions[3];
+        GetAxisLines(Bounds, Axis, Positions);
+        const int32 Other = 1 - Axis;
+        for (double Position : Positions)
+        {
+            const int32 Index = Algo::UpperBoundBy(Lines[Axis], Position, &FLine::Position);
+            Lines[Axis].Insert(FLine{ Position, Bounds.Min[Other], Bounds.Max[Other], Id }, Index);
+        }
+    }
+}
+
+void FRefSnapIndex::RemoveLines(const FGuid& Id, const FBox2D& Bounds)
+{
+    for (int32 Axis = 0; Axis < 2; Axis++)
+    {
+        double Positions[3];
+        GetAxisLines(Bounds, Axis, Positions);
+        TArray<FLine>& AxisLines = Lines[Axis];
+        for (double Position : Positions)
+        {
+            // Lines at the same position sit together; find this image's among them
+            for (int32 Index = Algo::LowerBoundBy(AxisLines, Position, &FLine::Position);
+                Index < AxisLines.Num() && AxisLines[Index].Position == Position; Index++)
+            {
+                if (AxisLines[Index].Id == Id)
+                {
+                    AxisLines.RemoveAt(Index, 1, EAllowShrinking::No);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+int32 FRefSnapIndex::FindNearest(const TArray<FLine>& AxisLines, double Value, double Threshold)
+{
+    // The closest line is the first at or after Value, or the one before it
+    const int32 After = Algo::LowerBoundBy(AxisLines, Value, &FLine::Position);
+    int32 Nearest = INDEX_NONE;
+    double NearestDistance = Threshold;
+    for (int32 Index = After - 1; Index <= After; Index++)
+    {
+        if (AxisLines.IsValidIndex(Index))
+        {
+            const double Distance = FMath::Abs(AxisLines[Index].Position - Value);
+            if (Distance <= NearestDistance)
+            {
+                NearestDistance = Distance;
+                Nearest = Index;
+            }
+        }
+    }
+    return Nearest;
+}
+
+FVector2D FRefSnapIndex::Snap(const FBox2D& Box, double Threshold, bool bAllowX, bool bAllowY, bool& bOutSnappedX, bool& bOutSnappedY)
+{
+    Guides.Reset();
+    FVector2D Offset = FVector2D::ZeroVector;
+    bool bSnapped[2] = { false, false };
+    const bool bAllowed[2] = { bAllowX, bAllowY };
+
+    for (int32 Axis = 0; Axis < 2; Axis++)
+    {
+        if (!bAllowed[Axis])
+            continue;
+
+        double Positions[3];
+        GetAxisLines(Box, Axis, Positions);
+
+        // Whichever of the box's edges and centre is closest to a line wins the axis
+        double BestDistance = Threshold;
+        for (double Position : Positions)
+        {
+            const int32 Nearest = FindNearest(Lines[Axis], Position, BestDistance);
+            if (Nearest != INDEX_NONE)
+            {
+                BestDistance = FMath::Abs(Lines[Axis][Nearest].Position - Position);
+                Offset[Axis] = Lines[Axis][Nearest].Position - Position;
+                bSnapped[Axis] = true;
+            }
+        }
+    }
+
+    // Guides for every edge and centre of the snapped box that now lies on a line
+    const FBox2D Snapped = Box.ShiftBy(Offset);
+    for (int32 Axis = 0; Axis < 2; Axis++)
+    {
+        if (!bSnapped[Axis])
+            continue;
+
+        double Positions[3];
+        GetAxisLines(Snapped, Axis, Positions);
+        const int32 Other = 1 - Axis;
+        for (double Position : Positions)
+        {
+            AddGuide(Axis, Position, Snapped.Min[Other], Snapped.Max[Other]);
+        }
+    }
+
+    bOutSnappedX = bSnapped[0];
+    bOutSnappedY = bSnapped[1];
+    return Offset;
+}
+
+void FRefSnapIndex::AddGuide(int32 Axis, double Position, double SpanMin, double SpanMax)
+{
+    const TArray<FLine>& AxisLines = Lines[Axis];
+    int32 Index = Algo::LowerBoundBy(AxisLines, Position - CoincidentDistance, &FLine::Position);
+    if (Index >= AxisLines.Num() || AxisLines[Index].Position > Position + CoincidentDistance)
+        return;
+
+    FGuide& Guide = Guides.AddDefaulted_GetRef();
+    Guide.bVertical = Axis == 0;
+    Guide.Position = AxisLines[Index].Position;
+    Guide.SpanMin = SpanMin;
+    Guide.SpanMax = SpanMax;
+    for (; Index < AxisLines.Num() && AxisLines[Index].Position <= Position + CoincidentDistance; Index++)
+    {
+        Guide.SpanMin = FMath::Min(Guide.SpanMin, AxisLines[Index].SpanMin);
+        Guide.SpanMax = FMath::Max(Guide.SpanMax, AxisLines[Index].SpanMax);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Smart guide targets: the edges and centres of the images on the board, kept in one sorted
+// array per axis. A dragged box finds the nearest line to each of its own edges and centre
+// by binary search, so a drag step costs O(log n) however many images the board holds.
+// The index is brought up to date between drags: unchanged images cost a map lookup, and
+// only those that moved are taken out and reinserted.
+class FRefSnapIndex
+{
+public:
+    // A line the snapped box lies on. Vertical guides run along x = Position, horizontal
+    // ones along y = Position; the span covers the box and every image on the line.
+    struct FGuide
+    {
+        bool bVertical = false;
+        double Position = 0.0;
+        double SpanMin = 0.0;
+        double SpanMax = 0.0;
+    };
+
+    // Pass every target to Update between these; EndUpdate drops the images that weren't
+    void BeginUpdate();
+    void Update(const FGuid& Id, const FBox2D& Bounds);
+    void EndUpdate();
+
+    void Reset();
+    int32 Num() const { return Entries.Num(); }
+
+    // Offset that brings the closest edge or centre of Box onto a line within Threshold, on each
+    // allowed axis. Axes with nothing in reach keep a zero offset and report false in bOutSnapped.
+    // The lines the snapped box then lies on become the guides.
+    FVector2D Snap(const FBox2D& Box, double Threshold, bool bAllowX, bool bAllowY, bool& bOutSnappedX, bool& bOutSnappedY);
+
+    const TArray<FGuide>& GetGuides() const { return Guides; }
+    void ClearGuides() { Guides.Reset(); }
+
+private:
+    // Edge or centre of an image; SpanMin/Max is the image's extent along the line
+    struct FLine
+    {
+        double Position;
+        double SpanMin;
+        double SpanMax;
+        FGuid Id;
+    };
+
+    struct FEntry
+    {
+        FBox2D Bounds;
+        uint32 Stamp;
+    };
+
+    void AddLines(const FGuid& Id, const FBox2D& Bounds);
+    void RemoveLines(const FGuid& Id, const FBox2D& Bounds);
+
+    // Closest line to Value within Threshold, or INDEX_NONE
+    static int32 FindNearest(const TArray<FLine>& AxisLines, double Value, double Threshold);
+
+    // Adds a guide at Position if any line lies on it, spanning those lines and Span
+    void AddGuide(int32 Axis, double Position, double SpanMin, double SpanMax);
+
+    // Sorted by Position: vertical lines (x) first, horizontal lines (y) second
+    TArray<FLine> Lines[2];
+    TMap<FGuid, FEntry> Entries;
+    uint32 CurrentStamp = 0;
+
+    TArray<FGuide> Guides;
+};
\ No newline at end of file
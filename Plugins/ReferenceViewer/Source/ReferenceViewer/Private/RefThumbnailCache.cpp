@@ -0,0 +1,127 @@
+#include "RefThumbnailCache.h"
+#include "RefImageLoader.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Hash/CityHash.h"
+
+namespace
+{
+    const uint32 ThumbnailMagic = 0x48544652; // "RFTH"
+    const uint32 ThumbnailVersion = 1;
+
+    // Fixed header followed by the thumbnail as PNG
+    struct FThumbnailHeader
+    {
+        uint32 Magic;
+        uint32 Version;
+        int32 SourceWidth;
+        int32 SourceHeight;
+    };
+}
+
+FString FRefThumbnailCache::GetCacheDir()
+{
+    return FPaths::ProjectSavedDir() / TEXT("ReferenceViewer") / TEXT("Thumbnails");
+}
+
+FString FRefThumbnailCache::GetCachePath(const FString& FilePath, const FDateTime& Timestamp, int64 FileSize)
+{
+    FString Normalized = FPaths::ConvertRelativePathToFull(FilePath);
+    FPaths::NormalizeFilename(Normalized);
+
+    uint64 Key = CityHash64(reinterpret_cast<const char*>(*Normalized), Normalized.Len() * sizeof(TCHAR));
+    Key = CityHash128to64(Uint128_64(Key, (uint64)Timestamp.GetTicks()));
+    Key = CityHash128to64(Uint128_64(Key, (uint64)FileSize));
+    return GetCacheDir() / FString::Printf(TEXT("%016llx.thumb"), Key);
+}
+
+bool FRefThumbnailCache::LoadOrBuild(const FString& FilePath, const FDateTime& Timestamp, int64 FileSize, FRefThumbnail& OutThumbnail)
+{
+    const FString CachePath = GetCachePath(FilePath, Timestamp, FileSize);
+    if (Read(CachePath, OutThumbnail))
+        return true;
+
+    int32 Width = 0;
+    int32 Height = 0;
+    {
+        TArray64<uint8> BGRA;
+        if (!FRefImageLoader::DecodeFile(FilePath, BGRA, Width, Height))
+            return false;
+
+        OutThumbnail.Proxy = FRefImageLoader::MakeProxy(BGRA.GetData(), Width, Height, ThumbnailSize);
+    }
+    if (!OutThumbnail.Proxy.IsValid())
+        return false;
+
+    OutThumbnail.SourceSize = FIntPoint(Width, Height);
+    Write(CachePath, OutThumbnail);
+    return true;
+}
+
+bool FRefThumbnailCache::Load(const FString& FilePath, const FDateTime& Timestamp, int64 FileSize, FRefThumbnail& OutThumbnail)
+{
+    return Read(GetCachePath(FilePath, Timestamp, FileSize), OutThumbnail);
+}
+
+bool FRefThumbnailCache::Read(const FString& CachePath, FRefThumbnail& OutThumbnail)
+{
+    TArray64<uint8> Data;
+    if (!FFileHelper::LoadFileToArray(Data, *CachePath, FILEREAD_Silent) || Data.Num() <= (int64)sizeof(FThumbnailHeader))
+        return false;
+
+    FThumbnailHeader Header;
+    FMemory::Memcpy(&Header, Data.GetData(), sizeof(Header));
+    if (Header.Magic != ThumbnailMagic || Header.Version != ThumbnailVersion)
+        return false;
+
+    TArray64<uint8> BGRA;
+    int32 Width = 0;
+    int32 Height = 0;
+    if (!FRefImageLoader::DecodeMemory(Data.GetData() + sizeof(Header), Data.Num() - sizeof(Header), BGRA, Width, Height))
+        return false;
+
+    TSharedPtr<FRefImageProxy, ESPMode::ThreadSafe> Proxy = MakeShared<FRefImageProxy, ESPMode::ThreadSafe>();
+    Proxy->Width = Width;
+    Proxy->Height = Height;
+    Proxy->BGRA = TArray<uint8>(BGRA.GetData(), (int32)BGRA.Num());
+    FRefImageLoader::BuildCoverage(*Proxy);
+
+    OutThumbnail.Proxy = Proxy;
+    OutThumbnail.SourceSize = FIntPoint(Header.SourceWidth, Header.SourceHeight);
+    return true;
+}
+
+void FRefThumbnailCache::Write(const FString& CachePath, const FRefThumbnail& Thumbnail)
+{
+    const FRefImageProxy& Proxy = *Thumbnail.Proxy;
+
+    IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+    TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+    if (!ImageWrapper.IsValid() || !ImageWrapper->SetRaw(Proxy.BGRA.GetData(), Proxy.BGRA.Num(), Proxy.Width, Proxy.Height, ERGBFormat::BGRA, 8))
+        return;
+
+    const TArray64<uint8> Compressed = ImageWrapper->GetCompressed();
+    if (Compressed.Num() == 0)
+        return;
+
+    FThumbnailHeader Header;
+    Header.Magic = ThumbnailMagic;
+    Header.Version = ThumbnailVersion;
+    Header.SourceWidth = Thumbnail.SourceSize.X;
+    Header.SourceHeight = Thumbnail.SourceSize.Y;
+
+    TArray64<uint8> Data;
+    Data.SetNumUninitialized(sizeof(Header) + Compressed.Num());
+    FMemory::Memcpy(Data.GetData(), &Header, sizeof(Header));
+    FMemory::Memcpy(Data.GetData() + sizeof(Header), Compressed.GetData(), Compressed.Num());
+
+    // Written under a temporary name so a reader never sees half a file
+    const FString TempPath = CachePath + TEXT(".tmp");
+    if (FFileHelper::SaveArrayToFile(Data, *TempPath))
+    {
+        IFileManager::Get().Move(*CachePath, *TempPath, true, true, false, true);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RefViewerData.h"
+
+// Small preview of an image file, with the size of the file's full pixels
+struct FRefThumbnail
+{
+    FRefImageProxyPtr Proxy;
+    FIntPoint SourceSize = FIntPoint::ZeroValue;
+};
+
+// On-disk thumbnail cache for library browsing. Entries are keyed by path,
+// modification time and size, so an edited file simply misses and is rebuilt.
+class FRefThumbnailCache
+{
+public:
+    // Longest side of a cached thumbnail; also used as the placeholder when dropped on the board
+    static constexpr int32 ThumbnailSize = 256;
+
+    // Reads the cached thumbnail, or decodes the file and writes one. Any thread.
+    static bool LoadOrBuild(const FString& FilePath, const FDateTime& Timestamp, int64 FileSize, FRefThumbnail& OutThumbnail);
+
+    // Cached thumbnail only; false on a miss. Any thread.
+    static bool Load(const FString& FilePath, const FDateTime& Timestamp, int64 FileSize, FRefThumbnail& OutThumbnail);
+
+    static FString GetCacheDir();
+
+private:
+    static FString GetCachePath(const FString& FilePath, const FDateTime& Timestamp, int64 FileSize);
+    static bool Read(const FString& CachePath, FRefThumbnail& OutThumbnail);
+    static void Write(const FString& CachePath, const FRefThumbnail& Thumbnail);
+};
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "RefUploadScheduler.h"
+#include "Engine/Texture2D.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+    TAutoConsoleVariable<float> CVarUploadBudgetMs(
+        TEXT("ReferenceViewer.UploadBudgetMs"),
+        2.0f,
+        TEXT("Game thread time per frame the reference board may spend submitting texture uploads."),
+        ECVF_Default);
+
+    TAutoConsoleVariable<float> CVarUploadBudgetMB(
+        TEXT("ReferenceViewer.UploadBudgetMB"),
+        16.0f,
+        TEXT("Texture data per frame the reference board may upload, in megabytes."),
+        ECVF_Default);
+}
+
+void FRefUploadScheduler::Enqueue(TSharedPtr<FRefImage> Image, TArray64<uint8>&& BGRA, int32 Width, int32 Height)
+{
+    check(IsInGameThread());
+
+    if (!Image.IsValid() || Width <= 0 || Height <= 0 || BGRA.Num() < (int64)Width * Height * 4)
+        return;
+
+    Jobs.RemoveAll([&Image](const TUniquePtr<FJob>& Job) { return Job->Image == Image; });
+
+    TUniquePtr<FJob> Job = MakeUnique<FJob>();
+    Job->Image = Image;
+    Job->BGRA = MakeShared<TArray64<uint8>, ESPMode::ThreadSafe>(MoveTemp(BGRA));
+    Job->Width = Width;
+    Job->Height = Height;
+    Jobs.Add(MoveTemp(Job));
+}
+
+int64 FRefUploadScheduler::GetQueuedBytes() const
+{
+    int64 Bytes = 0;
+    for (const TUniquePtr<FJob>& Job : Jobs)
+    {
+        Bytes += (int64)(Job->Height - Job->NextRow) * Job->Width * 4;
+    }
+    return Bytes;
+}
+
+void FRefUploadScheduler::Tick(const FBox2D& ViewBounds, float DeltaTime, TFunctionRef<void(TSharedPtr<FRefImage>, UTexture2D*)> OnUploaded)
+{
+    LastTickBytes = 0;
+    LastTickMs = 0.0;
+
+    // Images removed from the board while queued
+    Jobs.RemoveAll([](const TUniquePtr<FJob>& Job) { return !Job->Image.IsValid(); });
+
+    if (Jobs.Num() > 0)
+    {
+        const FVector2D ViewCenter = ViewBounds.GetCenter();
+        for (const TUniquePtr<FJob>& Job : Jobs)
+        {
+            TSharedPtr<FRefImage> Image = Job->Image.Pin();
+            const FBox2D Bounds = Image->GetBounds();
+            Job->bOnScreen = Image->IsEffectivelyVisible() && ViewBounds.Intersect(Bounds);
+            Job->ViewDistance = FVector2D::DistSquared(Bounds.GetCenter(), ViewCenter);
+        }
+
+        // On screen first, then nearest to the view, so panning reveals finished images
+        Jobs.StableSort([](const TUniquePtr<FJob>& A, const TUniquePtr<FJob>& B)
+        {
+            if (A->bOnScreen != B->bOnScreen)
+                return A->bOnScreen;
+            return A->ViewDistance < B->ViewDistance;
+        });
+
+        const double BudgetSeconds = FMath::Max(0.0f, CVarUploadBudgetMs.GetValueOnGameThread()) / 1000.0;
+        const int64 BudgetBytes = FMath::Max<int64>(ChunkBytes, (int64)(CVarUploadBudgetMB.GetValueOnGameThread() * 1024.0f * 1024.0f));
+        const double StartTime = FPlatformTime::Seconds();
+        auto IsBudgetSpent = [&]()
+        {
+            return LastTickBytes + ChunkBytes > BudgetBytes || FPlatformTime::Seconds() - StartTime >= BudgetSeconds;
+        };
+
+        // A tiny budget still makes progress: one texture created and one band submitted per tick
+        int32 NumCreated = 0;
+        for (int32 JobIndex = 0; JobIndex < Jobs.Num(); JobIndex++)
+        {
+            if (LastTickBytes > 0 && IsBudgetSpent())
+                break;
+
+            FJob& Job = *Jobs[JobIndex];
+            if (!Job.Texture)
+            {
+                if (NumCreated > 0 && IsBudgetSpent())
+                    continue;
+
+                NumCreated++;
+                if (!CreateTexture(Job))
+                {
+                    Jobs.RemoveAt(JobIndex--);
+                    continue;
+                }
+            }
+
+            // Bands go out once the render thread has created the texture, a frame later at most
+            if (!Job.CreateFence.IsFenceComplete())
+                continue;
+
+            while (Job.NextRow < Job.Height && (LastTickBytes == 0 || !IsBudgetSpent()))
+            {
+                LastTickBytes += SubmitBand(Job);
+            }
+
+            if (Job.NextRow >= Job.Height)
+            {
+                OnUploaded(Job.Image.Pin(), Job.Texture);
+                Jobs.RemoveAt(JobIndex--);
+            }
+        }
+
+        LastTickMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+    }
+
+    // Smoothed over roughly half a second of frames
+    if (DeltaTime > 0.0f)
+    {
+        const double TickMBps = LastTickBytes / (1024.0 * 1024.0) / DeltaTime;
+        ThroughputMBps = FMath::Lerp(ThroughputMBps, TickMBps, FMath::Min(1.0, DeltaTime * 2.0));
+    }
+}
+
+void FRefUploadScheduler::AddReferencedObjects(FReferenceCollector& Collector)
+{
+    for (const TUniquePtr<FJob>& Job : Jobs)
+    {
+        Collector.AddReferencedObject(Job->Texture);
+    }
+}
+
+bool FRefUploadScheduler::CreateTexture(FJob& Job)
+{
+    Job.Texture = UTexture2D::CreateTransient(Job.Width, Job.Height, PF_B8G8R8A8);
+    if (!Job.Texture)
+        return false;
+
+    // Empty mip data makes UpdateResource allocate the GPU texture without copying anything;
+    // the pixels follow band by band, and the CPU copy bundles are written from is refilled alongside
+    FByteBulkData& BulkData = Job.Texture->GetPlatformData()->Mips[0].BulkData;
+    BulkData.Lock(LOCK_READ_WRITE);
+    BulkData.Realloc(0);
+    BulkData.Unlock();
+    Job.Texture->UpdateResource();
+
+    Job.CreateFence.BeginFence();
+    return true;
+}
+
+int64 FRefUploadScheduler::SubmitBand(FJob& Job)
+{
+    const int64 Pitch = (int64)Job.Width * 4;
+    const int32 RowsPerBand = FMath::Max(1, (int32)(ChunkBytes / Pitch));
+    const int32 Rows = FMath::Min(RowsPerBand, Job.Height - Job.NextRow);
+    const int64 BandOffset = Job.NextRow * Pitch;
+    const int64 BandBytes = Rows * Pitch;
+
+    // Safe to touch now that the render thread is done creating the resource from it
+    FByteBulkData& BulkData = Job.Texture->GetPlatformData()->Mips[0].BulkData;
+    uint8* CpuCopy = static_cast<uint8*>(BulkData.Lock(LOCK_READ_WRITE));
+    if (Job.NextRow == 0)
+    {
+        CpuCopy = static_cast<uint8*>(BulkData.Realloc(Job.Height * Pitch));
+    }
+    FMemory::Memcpy(CpuCopy + BandOffset, Job.BGRA->GetData() + BandOffset, BandBytes);
+    BulkData.Unlock();
+
+    // The render thread reads straight from the decoded buffer, which the cleanup keeps alive until then
+    FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(0, Job.NextRow, 0, Job.NextRow, Job.Width, Rows);
+    Job.Texture->UpdateTextureRegions(0, 1, Region, Pitch, 4, Job.BGRA->GetData(),
+        [Pixels = Job.BGRA](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+        {
+            delete Regions;
+        });
+
+    Job.NextRow += Rows;
+    return BandBytes;
+}
\ No newline at end of file
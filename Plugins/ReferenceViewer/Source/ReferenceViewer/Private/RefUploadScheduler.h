@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderCommandFence.h"
+#include "UObject/GCObject.h"
+#include "RefViewerData.h"
+
+class UTexture2D;
+
+// Spreads full-resolution texture uploads over several frames. Decoded pixels are
+// queued here instead of going through UpdateResource in one go; each frame a few
+// row bands are submitted, within a time and size budget, images on screen first.
+// The budget is set with ReferenceViewer.UploadBudgetMs and ReferenceViewer.UploadBudgetMB.
+// Textures being filled are reported to the garbage collector until they are handed over.
+class FRefUploadScheduler : public FGCObject
+{
+public:
+    // Rows per band are picked so one band is about this many bytes
+    static constexpr int64 ChunkBytes = 1 << 20;
+
+    // Replaces any upload still queued for the same image. Game thread.
+    void Enqueue(TSharedPtr<FRefImage> Image, TArray64<uint8>&& BGRA, int32 Width, int32 Height);
+
+    // Submits bands until this frame's budget is spent. ViewBounds is the visible board area in
+    // canvas space. OnUploaded receives each texture once its last band has been submitted.
+    void Tick(const FBox2D& ViewBounds, float DeltaTime, TFunctionRef<void(TSharedPtr<FRefImage>, UTexture2D*)> OnUploaded);
+
+    bool IsIdle() const { return Jobs.Num() == 0; }
+
+    // Stats
+    int32 GetQueueDepth() const { return Jobs.Num(); }
+    int64 GetQueuedBytes() const;
+    double GetThroughputMBps() const { return ThroughputMBps; }
+    double GetLastTickMB() const { return LastTickBytes / (1024.0 * 1024.0); }
+    double GetLastTickMs() const { return LastTickMs; }
+
+    // FGCObject
+    virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+    virtual FString GetReferencerName() const override { return TEXT("FRefUploadScheduler"); }
+
+private:
+    struct FJob
+    {
+        TWeakPtr<FRefImage> Image;
+        TSharedPtr<TArray64<uint8>, ESPMode::ThreadSafe> BGRA;
+        int32 Width = 0;
+        int32 Height = 0;
+
+        TObjectPtr<UTexture2D> Texture = nullptr;
+        int32 NextRow = 0;
+
+        // Bands wait until the render thread has created the texture
+        FRenderCommandFence CreateFence;
+
+        // Sort key for this tick
+        bool bOnScreen = false;
+        double ViewDistance = 0.0;
+    };
+
+    bool CreateTexture(FJob& Job);
+    int64 SubmitBand(FJob& Job);
+
+    TArray<TUniquePtr<FJob>> Jobs;
+
+    int64 LastTickBytes = 0;
+    double LastTickMs = 0.0;
+    double ThroughputMBps = 0.0;
+};
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "ReferenceBoardExportCommandlet.h"
+#include "RefBoardExporter.h"
+#include "RefBoardBundle.h"
+#include "RefBoardJournal.h"
+#include "RefLayoutFile.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRefBoardExportCommandlet, Log, All);
+
+UReferenceBoardExportCommandlet::UReferenceBoardExportCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = true;
+    LogToConsole = true;
+}
+
+int32 UReferenceBoardExportCommandlet::Main(const FString& Params)
+{
+    TArray<FString> Tokens;
+    TArray<FString> Switches;
+    TMap<FString, FString> Values;
+    ParseCommandLine(*Params, Tokens, Switches, Values);
+
+    const FString* Board = Values.Find(TEXT("Board"));
+    const FString* Output = Values.Find(TEXT("Output"));
+    if (!Board || !Output)
+    {
+        UE_LOG(LogRefBoardExportCommandlet, Error, TEXT("Usage: -run=ReferenceBoardExport -Board=<.refboard|.json|board name> -Output=<file.png|file.exr> [-Scale=N] [-Width=N] [-Margin=N] [-NoAnnotations]"));
+        return 1;
+    }
+
+    FReferenceLayout Layout;
+    TSharedPtr<FRefBoardBundle> Bundle;
+    const FString Extension = FPaths::GetExtension(*Board);
+    if (Extension.Equals(TEXT("refboard"), ESearchCase::IgnoreCase))
+    {
+        Bundle = FRefBoardBundle::Open(*Board);
+        if (Bundle.IsValid())
+        {
+            Layout = Bundle->GetLayout();
+        }
+    }
+    else if (Extension.Equals(TEXT("json"), ESearchCase::IgnoreCase))
+    {
+        FRefLayoutFile::Load(*Board, Layout);
+    }
+    else
+    {
+        FRefBoardJournal::Replay(*Board, Layout);
+    }
+
+    if (Layout.Images.Num() == 0 && Layout.Strokes.Num() == 0)
+    {
+        UE_LOG(LogRefBoardExportCommandlet, Error, TEXT("Could not load board %s, or it is empty"), **Board);
+        return 1;
+    }
+
+    FRefBoardExportSettings Settings;
+    Settings.bAnnotations = !Switches.Contains(TEXT("NoAnnotations"));
+    if (const FString* Scale = Values.Find(TEXT("Scale")))
+    {
+        Settings.Scale = FCString::Atod(**Scale);
+    }
+    if (const FString* Margin = Values.Find(TEXT("Margin")))
+    {
+        Settings.Margin = FCString::Atof(**Margin);
+    }
+    if (const FString* Width = Values.Find(TEXT("Width")))
+    {
+        Settings.Width = FCString::Atoi(**Width);
+    }
+
+    if (Settings.Scale <= 0.0 || Settings.Width < 0)
+    {
+        UE_LOG(LogRefBoardExportCommandlet, Error, TEXT("Scale and width must be positive"));
+        return 1;
+    }
+
+    return FRefBoardExporter::Export(Layout, Bundle, FPaths::ConvertRelativePathToFull(*Output), Settings) ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ReferenceBoardExportCommandlet.generated.h"
+
+// Renders a board to an image without opening the editor UI:
+//
+//   UnrealEditor-Cmd.exe Project.uproject -run=ReferenceBoardExport -Board=<board> -Output=<file.png|file.exr>
+//       [-Scale=<pixels per board unit>] [-Width=<output width>] [-Margin=<board units>] [-NoAnnotations]
+//
+// -Board takes a .refboard bundle, a layout .json, or the name of a saved board, which is
+// replayed from its autosave journal. -Width, the output width in pixels, overrides -Scale.
+UCLASS()
+class UReferenceBoardExportCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UReferenceBoardExportCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
\ No newline at end of file
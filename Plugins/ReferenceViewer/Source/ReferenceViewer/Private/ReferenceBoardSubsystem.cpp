@@ -0,0 +1,229 @@
+#include "ReferenceBoardSubsystem.h"
+#include "ReferenceViewer.h"
+#include "RefBoardHost.h"
+#include "RefBatchLoader.h"
+#include "SReferenceCanvas.h"
+#include "RefUploadScheduler.h"
+#include "RefBoardSession.h"
+#include "RefBoardExporter.h"
+#include "Misc/Paths.h"
+
+FString UReferenceBoardSubsystem::CreateBoard(const FString& Name)
+{
+    const FString BoardName = MakeUniqueBoardName(Name.IsEmpty() ? TEXT("Board") : Name);
+    FReferenceViewerModule::OpenBoardWindow(BoardName);
+    return FindBoard(BoardName).IsValid() ? BoardName : FString();
+}
+
+TArray<FString> UReferenceBoardSubsystem::GetBoardNames() const
+{
+    TArray<FString> Names;
+    for (const auto& Pair : Boards)
+    {
+        if (Pair.Value.IsValid())
+        {
+            Names.Add(Pair.Key);
+        }
+    }
+    return Names;
+}
+
+TArray<FGuid> UReferenceBoardSubsystem::AddImages(const FString& Board, const TArray<FRefBoardImageSpec>& Images)
+{
+    TArray<FGuid> Ids;
+    TSharedPtr<IRefBoardHost> Host = FindBoard(Board);
+    TSharedPtr<SReferenceCanvas> Canvas = Host.IsValid() ? Host->GetBoardCanvas() : nullptr;
+    if (!Canvas.IsValid())
+        return Ids;
+
+    Loaders.RemoveAll([](const TSharedPtr<FRefBatchLoader>& Loader) { return Loader->IsComplete(); });
+
+    TArray<TSharedPtr<FRefImage>> NewImages;
+    TArray<FRefBatchLoader::FRequest> Requests;
+    NewImages.Reserve(Images.Num());
+    Requests.Reserve(Images.Num());
+    Ids.Reserve(Images.Num());
+
+    for (const FRefBoardImageSpec& Spec : Images)
+    {
+        if (!FPaths::FileExists(Spec.FilePath))
+        {
+            Ids.Add(FGuid());
+            continue;
+        }
+
+        // Drawn as a placeholder until the loader swaps the pixels in
+        TSharedPtr<FRefImage> NewImage = MakeShareable(new FRefImage());
+        NewImage->FilePath = Spec.FilePath;
+        NewImage->Name = FPaths::GetBaseFilename(Spec.FilePath);
+        NewImage->Position = Spec.Position;
+        NewImage->Opacity = FMath::Clamp(Spec.Opacity, 0.0f, 1.0f);
+        const bool bNativeSize = Spec.Size.X <= 0.0 || Spec.Size.Y <= 0.0;
+        if (!bNativeSize)
+        {
+            NewImage->Size = Spec.Size;
+        }
+
+        FRefBatchLoader::FRequest& Request = Requests.AddDefaulted_GetRef();
+        Request.Image = NewImage;
+        Request.FilePath = Spec.FilePath;
+        Request.bNativeSize = bNativeSize;
+
+        Ids.Add(NewImage->Id);
+        NewImages.Add(NewImage);
+    }
+
+    Canvas->AddImages(NewImages);
+
+    if (Requests.Num() > 0)
+    {
+        TSharedPtr<FRefBatchLoader> Loader = MakeShared<FRefBatchLoader>(Canvas, MoveTemp(Requests));
+        Loaders.Add(Loader);
+        Loader->Start();
+    }
+    return Ids;
+}
+
+int32 UReferenceBoardSubsystem::SetImageTransforms(const FString& Board, const TArray<FRefBoardImageTransform>& Transforms)
+{
+    TSharedPtr<IRefBoardHost> Host = FindBoard(Board);
+    TSharedPtr<SReferenceCanvas> Canvas = Host.IsValid() ? Host->GetBoardCanvas() : nullptr;
+    if (!Canvas.IsValid())
+        return 0;
+
+    TArray<FRefImageRecord> Records;
+    Records.Reserve(Transforms.Num());
+    for (const FRefBoardImageTransform& Transform : Transforms)
+    {
+        FRefImageRecord& Record = Records.AddDefaulted_GetRef();
+        Record.Id = Transform.Id;
+        Record.Position = Transform.Position;
+        Record.Size = Transform.Size;
+        Record.Rotation = Transform.Rotation;
+        Record.Opacity = FMath::Clamp(Transform.Opacity, 0.0f, 1.0f);
+    }
+    return Canvas->SetImageTransforms(Records);
+}
+
+TArray<FRefBoardImageTransform> UReferenceBoardSubsystem::GetImageTransforms(const FString& Board) const
+{
+    TArray<FRefBoardImageTransform> Transforms;
+    TSharedPtr<IRefBoardHost> Host = FindBoard(Board);
+    TSharedPtr<SReferenceCanvas> Canvas = Host.IsValid() ? Host->GetBoardCanvas() : nullptr;
+    if (!Canvas.IsValid())
+        return Transforms;
+
+    Transforms.Reserve(Canvas->GetImages().Num());
+    for (const TSharedPtr<FRefImage>& Image : Canvas->GetImages())
+    {
+        FRefBoardImageTransform& Transform = Transforms.AddDefaulted_GetRef();
+        Transform.Id = Image->Id;
+        Transform.Position = Image->GetCanvasPosition();
+        Transform.Size = Image->Size;
+        Transform.Rotation = Image->Rotation;
+        Transform.Opacity = Image->Opacity;
+    }
+    return Transforms;
+}
+
+bool UReferenceBoardSubsystem::ClearBoard(const FString& Board)
+{
+    TSharedPtr<IRefBoardHost> Host = FindBoard(Board);
+    TSharedPtr<SReferenceCanvas> Canvas = Host.IsValid() ? Host->GetBoardCanvas() : nullptr;
+    if (!Canvas.IsValid())
+        return false;
+
+    Canvas->ClearImages();
+    return true;
+}
+
+bool UReferenceBoardSubsystem::SaveBoard(const FString& Board, const FString& Path)
+{
+    TSharedPtr<IRefBoardHost> Host = FindBoard(Board);
+    return Host.IsValid() && Host->SaveBoard(Path);
+}
+
+bool UReferenceBoardSubsystem::LoadBoard(const FString& Board, const FString& Path)
+{
+    TSharedPtr<IRefBoardHost> Host = FindBoard(Board);
+    return Host.IsValid() && Host->OpenBoard(Path);
+}
+
+bool UReferenceBoardSubsystem::ExportBoardImage(const FString& Board, const FString& Path, float Scale, bool bAnnotations)
+{
+    TSharedPtr<IRefBoardHost> Host = FindBoard(Board);
+    if (!Host.IsValid() || Scale <= 0.0f)
+        return false;
+
+    FRefBoardExportSettings Settings;
+    Settings.Scale = Scale;
+    Settings.bAnnotations = bAnnotations;
+    return Host->ExportImage(Path, Settings);
+}
+
+int32 UReferenceBoardSubsystem::GetNumPendingLoads(const FString& Board) const
+{
+    TSharedPtr<IRefBoardHost> Host = FindBoard(Board);
+    TSharedPtr<SReferenceCanvas> Canvas = Host.IsValid() ? Host->GetBoardCanvas() : nullptr;
+    if (!Canvas.IsValid())
+        return 0;
+
+    // Decoded but still queued for upload counts too
+    int32 NumPending = Canvas->GetUploadScheduler().GetQueueDepth();
+    for (const TSharedPtr<FRefBatchLoader>& Loader : Loaders)
+    {
+        if (Loader->GetCanvas() == Canvas)
+        {
+            NumPending += Loader->GetNumRemaining();
+        }
+    }
+    return NumPending;
+}
+
+FString UReferenceBoardSubsystem::RegisterBoard(TSharedRef<IRefBoardHost> Host, const FString& PreferredName)
+{
+    // Closed panels leave stale entries behind; drop them so their names can be reused
+    for (auto It = Boards.CreateIterator(); It; ++It)
+    {
+        if (!It->Value.IsValid())
+        {
+            It.RemoveCurrent();
+        }
+    }
+
+    const FString BoardName = MakeUniqueBoardName(PreferredName.IsEmpty() ? TEXT("Board") : PreferredName);
+    Boards.Add(BoardName, Host);
+    return BoardName;
+}
+
+void UReferenceBoardSubsystem::SaveSession() const
+{
+    TArray<FRefSessionBoard> SessionBoards;
+    for (const auto& Pair : Boards)
+    {
+        if (TSharedPtr<IRefBoardHost> Host = Pair.Value.Pin())
+        {
+            FRefSessionBoard& Board = SessionBoards.AddDefaulted_GetRef();
+            Board.Name = Pair.Key;
+            Board.BundlePath = Host->GetBundlePath();
+            Board.bAutosave = Host->OwnsAutosave();
+        }
+    }
+    FRefBoardSession::Save(SessionBoards);
+}
+
+TSharedPtr<IRefBoardHost> UReferenceBoardSubsystem::FindBoard(const FString& Board) const
+{
+    const TWeakPtr<IRefBoardHost>* Found = Boards.Find(Board);
+    return Found ? Found->Pin() : nullptr;
+}
+
+FString UReferenceBoardSubsystem::MakeUniqueBoardName(const FString& PreferredName) const
+{
+    FString BoardName = PreferredName;
+    for (int32 Suffix = 2; FindBoard(BoardName).IsValid(); Suffix++)
+    {
+        BoardName = FString::Printf(TEXT("%s %d"), *PreferredName, Suffix);
+    }
+    return BoardName;
+}
\ No newline at end of file
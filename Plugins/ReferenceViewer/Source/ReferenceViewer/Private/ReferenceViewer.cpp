@@ -2,6 +2,7 @@
 #include "ReferenceViewerStyle.h"
 #include "ReferenceViewerCommands.h"
 #include "SReferenceCanvas.h"
+#include "SRefLibraryPanel.h"
 #include "LevelEditor.h"
 #include "Widgets/Docking/SDockTab.h"
 #include "Widgets/Layout/SBox.h"
@@ -17,29 +18,66 @@
 #include "Widgets/Layout/SSplitter.h"
 #include "ToolMenus.h"
 #include "HAL/PlatformFilemanager.h"
+#include "HAL/FileManager.h"
 #include "Misc/Paths.h"
 #include "DesktopPlatformModule.h"
 #include "IDesktopPlatform.h"
 #include "Framework/Application/SlateApplication.h"
 #include "Types/SlateConstants.h"
 #include "RefViewerData.h"
+#include "RefBoardJournal.h"
+#include "RefBoardBundle.h"
+#include "RefBoardExporter.h"
+#include "RefImageLoader.h"
+#include "RefSilhouetteRasterizer.h"
+#include "RefAnimation.h"
+#include "RefGifDecoder.h"
+#include "RefFolderWatch.h"
+#include "RefSimilarityIndex.h"
+#include "RefUploadScheduler.h"
+#include "RefBoardHost.h"
+#include "ReferenceBoardSubsystem.h"
+#include "RefBoardSession.h"
+#include "Misc/CoreDelegates.h"
+#include "HAL/PlatformTime.h"
+#include "Editor.h"
+#include "Framework/Notifications/NotificationManager.h"
+#include "Widgets/Notifications/SNotificationList.h"
+#include "Engine/StaticMesh.h"
 #include "IImageWrapper.h"
 #include "IImageWrapperModule.h"
 #include "Engine/Texture2D.h"
 #include "Misc/FileHelper.h"
+#include "ContentBrowserModule.h"
+#include "IContentBrowserSingleton.h"
 #include "Dom/JsonObject.h"
 #include "Serialization/JsonSerializer.h"
 #include "Serialization/JsonWriter.h"
 
 static const FName ReferenceViewerTabName("ReferenceViewer");
+static const FString AutosaveBoardName(TEXT("Autosave"));
+
+// Find Similar: pHash bits allowed to differ, and how many matches are listed
+static const int32 SimilarSearchDistance = 12;
+static const int32 SimilarSearchMaxResults = 200;
+
+// Only one panel at a time owns the autosave board
+static TWeakPtr<FRefBoardJournal> ActiveAutosaveJournal;
+
+// StartupModule runs on every editor launch, whether or not a board is ever opened
+static const double StartupBudgetMs = 1.0;
+
+DEFINE_LOG_CATEGORY_STATIC(LogReferenceViewer, Log, All);
 
 #define LOCTEXT_NAMESPACE "FReferenceViewerModule"
 
 // Main overlay window - DCC-style floating reference panel
-class SReferenceOverlay : public SCompoundWidget
+class SReferenceOverlay : public SCompoundWidget, public IRefBoardHost
 {
 public:
     SLATE_BEGIN_ARGS(SReferenceOverlay) {}
+        // Name scripts address the board by; made unique on registration
+        SLATE_ARGUMENT(FString, BoardName)
     SLATE_END_ARGS()
 
     void Construct(const FArguments& InArgs)
@@ -84,6 +122,105 @@ public:
                             .IsEnabled(this, &SReferenceOverlay::IsMeasureToolEnabled)
                         ]
                         
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0)
+                        [
+                            SNew(SButton)
+                            .Text(FText::FromString("Crop"))
+                            .ToolTipText(FText::FromString("Drag over an image to place a crop of it; the crop shares the original's texture (Shift: crop in place)"))
+                            .ButtonStyle(FCoreStyle::Get(), "ToggleButton")
+                            .OnClicked(this, &SReferenceOverlay::OnCropTool)
+                            .IsEnabled(this, &SReferenceOverlay::IsCropToolEnabled)
+                        ]
+                        
+                        // Annotations
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0)
+                        [
+                            SNew(SButton)
+                            .Text(FText::FromString("Draw"))
+                            .ToolTipText(FText::FromString("Sketch over the board (Shift: straight line, Ctrl: arrow). Clicking a palette swatch picks it up as ink."))
+                            .ButtonStyle(FCoreStyle::Get(), "ToggleButton")
+                            .OnClicked(this, &SReferenceOverlay::OnAnnotateTool)
+                            .IsEnabled(this, &SReferenceOverlay::IsAnnotateToolEnabled)
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0)
+                        [
+                            SNew(SButton)
+                            .Text(FText::FromString("Erase"))
+                            .ToolTipText(FText::FromString("Drag over strokes to erase them (Ctrl+Click: erase all)"))
+                            .ButtonStyle(FCoreStyle::Get(), "ToggleButton")
+                            .OnClicked(this, &SReferenceOverlay::OnEraseTool)
+                            .IsEnabled(this, &SReferenceOverlay::IsEraseToolEnabled)
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0)
+                        [
+                            SNew(SBox)
+                            .WidthOverride(40)
+                            [
+                                SNew(SSpinBox<float>)
+                                .ToolTipText(FText::FromString("Stroke width, in board units"))
+                                .Value(this, &SReferenceOverlay::GetStrokeWidth)
+                                .OnValueChanged(this, &SReferenceOverlay::SetStrokeWidth)
+                                .MinValue(1.0f)
+                                .MaxValue(40.0f)
+                                .Delta(1.0f)
+                                .Font(FCoreStyle::GetDefaultFontStyle("Regular", 9))
+                            ]
+                        ]
+                        
+                        // Split a sheet into a grid of crops
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0)
+                        [
+                            SNew(SButton)
+                            .Text(FText::FromString("Split"))
+                            .ToolTipText(FText::FromString("Replace each selected image with a grid of crops, one per cell"))
+                            .OnClicked(this, &SReferenceOverlay::OnSplitClicked)
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        [
+                            SNew(SBox)
+                            .WidthOverride(40)
+                            [
+                                SNew(SSpinBox<int32>)
+                                .ToolTipText(FText::FromString("Columns"))
+                                .Value(this, &SReferenceOverlay::GetSplitColumns)
+                                .OnValueChanged(this, &SReferenceOverlay::SetSplitColumns)
+                                .MinValue(1)
+                                .MaxValue(16)
+                                .Font(FCoreStyle::GetDefaultFontStyle("Regular", 9))
+                            ]
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0)
+                        [
+                            SNew(SBox)
+                            .WidthOverride(40)
+                            [
+                                SNew(SSpinBox<int32>)
+                                .ToolTipText(FText::FromString("Rows"))
+                                .Value(this, &SReferenceOverlay::GetSplitRows)
+                                .OnValueChanged(this, &SReferenceOverlay::SetSplitRows)
+                                .MinValue(1)
+                                .MaxValue(16)
+                                .Font(FCoreStyle::GetDefaultFontStyle("Regular", 9))
+                            ]
+                        ]
+                                                
                         + SHorizontalBox::Slot()
                         .AutoWidth()
                         .Padding(10, 0)
@@ -101,6 +238,101 @@ public:
                             .OnClicked(this, &SReferenceOverlay::OnImportClicked)
                         ]
                         
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0, 0, 0)
+                        [
+                            SNew(SButton)
+                            .Text(FText::FromString("Import Sequence"))
+                            .ToolTipText(FText::FromString("Pick one frame of a numbered image sequence (walk_0001.png, ...) to play the whole sequence"))
+                            .OnClicked(this, &SReferenceOverlay::OnImportSequenceClicked)
+                        ]
+                        
+                        // Content Browser selection
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0, 0, 0)
+                        [
+                            SNew(SButton)
+                            .Text(FText::FromString("Add Selected Textures"))
+                            .ToolTipText(FText::FromString("Place the textures selected in the Content Browser without re-importing them"))
+                            .OnClicked(this, &SReferenceOverlay::OnAddSelectedTexturesClicked)
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0, 0, 0)
+                        [
+                            SNew(SButton)
+                            .Text(FText::FromString("Mesh Silhouettes"))
+                            .ToolTipText(FText::FromString("Front, side and top silhouettes of the static meshes selected in the Content Browser, updated as the mesh is edited"))
+                            .OnClicked(this, &SReferenceOverlay::OnAddMeshSilhouettesClicked)
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0, 0, 0)
+                        [
+                            SNew(SButton)
+                            .Text(FText::FromString("Arrange"))
+                            .ToolTipText(FText::FromString("Pack the selected images, or the whole board, without overlap. Locked images stay in place."))
+                            .OnClicked(this, &SReferenceOverlay::OnArrangeClicked)
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0, 0, 0)
+                        [
+                            SNew(SButton)
+                            .Text(this, &SReferenceOverlay::GetWatchFolderText)
+                            .ToolTipText(FText::FromString("Bind the board to a folder: images added, changed or removed there are updated on the board"))
+                            .OnClicked(this, &SReferenceOverlay::OnWatchFolderClicked)
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0, 0, 0)
+                        [
+                            SNew(SButton)
+                            .Text(FText::FromString("Find Similar"))
+                            .ToolTipText(FText::FromString("List the indexed library images that look like the selected image"))
+                            .OnClicked(this, &SReferenceOverlay::OnFindSimilarClicked)
+                            .IsEnabled_Lambda([this]() { return Canvas.IsValid() && Canvas->GetSelectedImages().Num() > 0; })
+                        ]
+                        
+                        // Library panel toggle
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .VAlign(VAlign_Center)
+                        .Padding(5, 0, 0, 0)
+                        [
+                            SNew(SCheckBox)
+                            .IsChecked(this, &SReferenceOverlay::GetLibraryVisibleState)
+                            .OnCheckStateChanged(this, &SReferenceOverlay::OnLibraryVisibleChanged)
+                            .ToolTipText(FText::FromString("Browse a folder of reference images beside the board and drag them in"))
+                            [
+                                SNew(STextBlock)
+                                .Text(FText::FromString("Library"))
+                                .Font(FCoreStyle::GetDefaultFontStyle("Regular", 9))
+                            ]
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .VAlign(VAlign_Center)
+                        .Padding(5, 0, 0, 0)
+                        [
+                            SNew(SCheckBox)
+                            .IsChecked(this, &SReferenceOverlay::GetDuplicateWarningState)
+                            .OnCheckStateChanged(this, &SReferenceOverlay::OnDuplicateWarningChanged)
+                            .ToolTipText(FText::FromString("Warn when an imported image is a near-duplicate of one already indexed"))
+                            [
+                                SNew(STextBlock)
+                                .Text(FText::FromString("Dupe Check"))
+                                .Font(FCoreStyle::GetDefaultFontStyle("Regular", 9))
+                            ]
+                        ]
+                        
                         // Clear button
                         + SHorizontalBox::Slot()
                         .AutoWidth()
@@ -111,6 +343,34 @@ public:
                             .OnClicked(this, &SReferenceOverlay::OnClearClicked)
                         ]
                         
+                        // Board bundle
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0)
+                        [
+                            SNew(SButton)
+                            .Text(FText::FromString("Open Board"))
+                            .OnClicked(this, &SReferenceOverlay::OnOpenBundleClicked)
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        [
+                            SNew(SButton)
+                            .Text(FText::FromString("Save Board"))
+                            .OnClicked(this, &SReferenceOverlay::OnSaveBundleClicked)
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .Padding(2, 0)
+                        [
+                            SNew(SButton)
+                            .Text(FText::FromString("Export Image"))
+                            .ToolTipText(FText::FromString("Render the whole board to a PNG or EXR at full resolution"))
+                            .OnClicked(this, &SReferenceOverlay::OnExportImageClicked)
+                        ]
+                        
                         + SHorizontalBox::Slot()
                         .FillWidth(1.0f)
                         [
@@ -150,6 +410,80 @@ public:
                             ]
                         ]
                         
+                        // Smart guides toggle
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .VAlign(VAlign_Center)
+                        [
+                            SNew(SCheckBox)
+                            .IsChecked(this, &SReferenceOverlay::GetSmartGuidesState)
+                            .OnCheckStateChanged(this, &SReferenceOverlay::OnSmartGuidesChanged)
+                            [
+                                SNew(STextBlock)
+                                .Text(FText::FromString("Guides"))
+                                .Font(FCoreStyle::GetDefaultFontStyle("Regular", 9))
+                            ]
+                        ]
+                        
+                        // Edge overlay toggle
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .VAlign(VAlign_Center)
+                        [
+                            SNew(SCheckBox)
+                            .IsChecked(this, &SReferenceOverlay::GetEdgeOverlayState)
+                            .OnCheckStateChanged(this, &SReferenceOverlay::OnEdgeOverlayChanged)
+                            [
+                                SNew(STextBlock)
+                                .Text(FText::FromString("Edges"))
+                                .Font(FCoreStyle::GetDefaultFontStyle("Regular", 9))
+                            ]
+                        ]
+                        
+                        // High bit-depth display
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .VAlign(VAlign_Center)
+                        .Padding(10, 0, 2, 0)
+                        [
+                            SNew(STextBlock)
+                            .Text(FText::FromString("EV:"))
+                            .Font(FCoreStyle::GetDefaultFontStyle("Regular", 9))
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        [
+                            SNew(SBox)
+                            .WidthOverride(50)
+                            [
+                                SNew(SSpinBox<float>)
+                                .ToolTipText(FText::FromString("Exposure of EXR, HDR and 16-bit images, in stops"))
+                                .Value(this, &SReferenceOverlay::GetExposure)
+                                .OnValueChanged(this, &SReferenceOverlay::SetExposure)
+                                .MinValue(-10.0f)
+                                .MaxValue(10.0f)
+                                .Delta(0.25f)
+                                .Font(FCoreStyle::GetDefaultFontStyle("Regular", 9))
+                            ]
+                        ]
+                        
+                        + SHorizontalBox::Slot()
+                        .AutoWidth()
+                        .VAlign(VAlign_Center)
+                        .Padding(5, 0)
+                        [
+                            SNew(SCheckBox)
+                            .ToolTipText(FText::FromString("Show high bit-depth images from half-float textures, without exposure or tonemapping"))
+                            .IsChecked(this, &SReferenceOverlay::GetFloatTexturesState)
+                            .OnCheckStateChanged(this, &SReferenceOverlay::OnFloatTexturesChanged)
+                            [
+                                SNew(STextBlock)
+                                .Text(FText::FromString("Float"))
+                                .Font(FCoreStyle::GetDefaultFontStyle("Regular", 9))
+                            ]
+                        ]
+                        
                         // Window opacity
                         + SHorizontalBox::Slot()
                         .AutoWidth()
@@ -185,11 +519,25 @@ public:
                     ]
                 ]
                 
-                // Main canvas area
+                // Library beside the main canvas area
                 + SVerticalBox::Slot()
                 .FillHeight(1.0f)
                 [
-                    SAssignNew(Canvas, SReferenceCanvas)
+                    SNew(SSplitter)
+                    .Orientation(Orient_Horizontal)
+                    
+                    + SSplitter::Slot()
+                    .Value(0.22f)
+                    [
+                        SAssignNew(LibraryPanel, SRefLibraryPanel)
+                        .Visibility(this, &SReferenceOverlay::GetLibraryVisibility)
+                    ]
+                    
+                    + SSplitter::Slot()
+                    .Value(0.78f)
+                    [
+                        SAssignNew(Canvas, SReferenceCanvas)
+                    ]
                 ]
                 
                 // Minimal status bar
@@ -215,7 +563,7 @@ public:
                         .AutoWidth()
                         [
                             SNew(STextBlock)
-                            .Text(FText::FromString("Middle Mouse: Pan | Ctrl+Scroll: Zoom | G: Grid | 1-9: Opacity"))
+                            .Text(FText::FromString("Middle Mouse: Pan | Ctrl+Scroll: Zoom | G: Grid | Alt+Drag: No Guides | Space: Play/Pause | A: Arrange | N: Navigator | E: Edges | C: Compare | X: Crop (Shift: in place) | D: Draw | Shift+D: Erase | L: Lock | 1-9: Opacity | Ctrl+G: Group | Ctrl+Shift+G: Ungroup | Alt+Click: Pick in Group | F: Collapse | H: Hide | Shift+H: Show All"))
                             .Font(FCoreStyle::GetDefaultFontStyle("Regular", 8))
                             .ColorAndOpacity(FSlateColor(FLinearColor(0.6f, 0.6f, 0.6f)))
                         ]
@@ -225,11 +573,35 @@ public:
         ];
         
         CurrentToolMode = EReferenceToolMode::Select;
+        SplitColumns = 4;
+        SplitRows = 4;
         WindowOpacity = 1.0f;
         GridSize = 20.0f;
         bGridEnabled = true;
+        bLibraryVisible = false;
+        bWarnOnDuplicates = true;
+        
+        if (GEditor)
+        {
+            if (UReferenceBoardSubsystem* Boards = GEditor->GetEditorSubsystem<UReferenceBoardSubsystem>())
+            {
+                BoardName = Boards->RegisterBoard(SharedThis(this), InArgs._BoardName);
+            }
+        }
+        
+        RestoreAutosave();
+        SaveSession();
     }
-
+    
+    virtual ~SReferenceOverlay()
+    {
+        // Closing a panel drops it from the session; shutting the editor down keeps every board
+        if (!IsEngineExitRequested())
+        {
+            SaveSession();
+        }
+    }
+    
     void AddImage(TSharedPtr<FRefImage> Image)
     {
         if (Canvas.IsValid())
@@ -248,13 +620,54 @@ public:
         }
         return FReply::Unhandled();
     }
-
+    
+    // IRefBoardHost
+    virtual TSharedPtr<SReferenceCanvas> GetBoardCanvas() const override
+    {
+        return Canvas;
+    }
+    
+    virtual bool SaveBoard(const FString& Path) override
+    {
+        return Canvas.IsValid() && WriteBundle(Path);
+    }
+    
+    virtual bool OpenBoard(const FString& Path) override
+    {
+        return Canvas.IsValid() && LoadBundle(Path);
+    }
+    
+    virtual bool ExportImage(const FString& Path, const FRefBoardExportSettings& Settings) override
+    {
+        return Canvas.IsValid() && WriteImage(Path, Settings);
+    }
+    
+    virtual FString GetBundlePath() const override
+    {
+        return CurrentBundlePath;
+    }
+    
+    virtual bool OwnsAutosave() const override
+    {
+        return Journal.IsValid() && ActiveAutosaveJournal.Pin() == Journal;
+    }
+    
 private:
     TSharedPtr<SReferenceCanvas> Canvas;
+    TSharedPtr<SRefLibraryPanel> LibraryPanel;
+    TSharedPtr<FRefBoardJournal> Journal;
+    TArray<TSharedPtr<FRefMeshSilhouette>> MeshSilhouettes;
+    TSharedPtr<FRefFolderWatch> FolderWatch;
     EReferenceToolMode CurrentToolMode;
+    int32 SplitColumns;
+    int32 SplitRows;
     float WindowOpacity;
     float GridSize;
     bool bGridEnabled;
+    bool bLibraryVisible;
+    bool bWarnOnDuplicates;
+    FString BoardName;
+    FString CurrentBundlePath;
     
     // Tool selection
     FReply OnSelectTool()
@@ -273,6 +686,33 @@ private:
         return FReply::Handled();
     }
     
+    FReply OnCropTool()
+    {
+        CurrentToolMode = EReferenceToolMode::Crop;
+        if (Canvas.IsValid())
+            Canvas->SetToolMode(CurrentToolMode);
+        return FReply::Handled();
+    }
+    
+    FReply OnSplitClicked()
+    {
+        if (!Canvas.IsValid())
+            return FReply::Handled();
+            
+        // Splitting changes the selection, so work from a copy
+        const TArray<TSharedPtr<FRefImage>> Sheets = Canvas->GetSelectedImages();
+        for (const TSharedPtr<FRefImage>& Sheet : Sheets)
+        {
+            Canvas->SplitImage(Sheet, SplitColumns, SplitRows);
+        }
+        return FReply::Handled();
+    }
+    
+    int32 GetSplitColumns() const { return SplitColumns; }
+    void SetSplitColumns(int32 Columns) { SplitColumns = Columns; }
+    int32 GetSplitRows() const { return SplitRows; }
+    void SetSplitRows(int32 Rows) { SplitRows = Rows; }
+    
     bool IsSelectToolEnabled() const
     {
         return CurrentToolMode != EReferenceToolMode::Select;
@@ -283,20 +723,110 @@ private:
         return CurrentToolMode != EReferenceToolMode::Measure;
     }
     
-    // Grid controls
-    ECheckBoxState GetGridEnabledState() const
+    bool IsCropToolEnabled() const
     {
-        return bGridEnabled ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+        return CurrentToolMode != EReferenceToolMode::Crop;
     }
     
-    void OnGridEnabledChanged(ECheckBoxState NewState)
+    FReply OnAnnotateTool()
     {
-        bGridEnabled = (NewState == ECheckBoxState::Checked);
+        CurrentToolMode = EReferenceToolMode::Annotate;
         if (Canvas.IsValid())
-        {
-            Canvas->SetGridEnabled(bGridEnabled);
-        }
-    }
+            Canvas->SetToolMode(CurrentToolMode);
+        return FReply::Handled();
+    }
+    
+    FReply OnEraseTool()
+    {
+        CurrentToolMode = EReferenceToolMode::Erase;
+        if (Canvas.IsValid())
+            Canvas->SetToolMode(CurrentToolMode);
+        return FReply::Handled();
+    }
+    
+    bool IsAnnotateToolEnabled() const
+    {
+        return CurrentToolMode != EReferenceToolMode::Annotate;
+    }
+    
+    bool IsEraseToolEnabled() const
+    {
+        return CurrentToolMode != EReferenceToolMode::Erase;
+    }
+    
+    float GetStrokeWidth() const { return Canvas.IsValid() ? Canvas->GetAnnotationThickness() : 3.0f; }
+    void SetStrokeWidth(float Width)
+    {
+        if (Canvas.IsValid())
+        {
+            Canvas->SetAnnotationThickness(Width);
+        }
+    }
+    
+    // Grid controls
+    ECheckBoxState GetGridEnabledState() const
+    {
+        return bGridEnabled ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+    }
+    
+    void OnGridEnabledChanged(ECheckBoxState NewState)
+    {
+        bGridEnabled = (NewState == ECheckBoxState::Checked);
+        if (Canvas.IsValid())
+        {
+            Canvas->SetGridEnabled(bGridEnabled);
+        }
+    }
+    
+    ECheckBoxState GetSmartGuidesState() const
+    {
+        return Canvas.IsValid() && Canvas->IsSmartGuidesEnabled() ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+    }
+    
+    void OnSmartGuidesChanged(ECheckBoxState NewState)
+    {
+        if (Canvas.IsValid())
+        {
+            Canvas->SetSmartGuidesEnabled(NewState == ECheckBoxState::Checked);
+        }
+    }
+    
+    // High bit-depth display
+    float GetExposure() const { return Canvas.IsValid() ? Canvas->GetExposure() : 0.0f; }
+    void SetExposure(float Stops)
+    {
+        if (Canvas.IsValid())
+        {
+            Canvas->SetExposure(Stops);
+        }
+    }
+    
+    ECheckBoxState GetFloatTexturesState() const
+    {
+        return Canvas.IsValid() && Canvas->IsFloatTexturesEnabled() ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+    }
+    
+    void OnFloatTexturesChanged(ECheckBoxState NewState)
+    {
+        if (Canvas.IsValid())
+        {
+            Canvas->SetFloatTexturesEnabled(NewState == ECheckBoxState::Checked);
+        }
+    }
+    
+    // Edge overlay
+    ECheckBoxState GetEdgeOverlayState() const
+    {
+        return Canvas.IsValid() && Canvas->IsEdgeOverlayEnabled() ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+    }
+    
+    void OnEdgeOverlayChanged(ECheckBoxState NewState)
+    {
+        if (Canvas.IsValid())
+        {
+            Canvas->SetEdgeOverlayEnabled(NewState == ECheckBoxState::Checked);
+        }
+    }
     
     float GetGridSize() const { return GridSize; }
     void SetGridSize(float NewSize)
@@ -324,12 +854,25 @@ private:
     {
         if (Canvas.IsValid())
         {
+            const FRefUploadScheduler& Uploads = Canvas->GetUploadScheduler();
+            if (!Uploads.IsIdle())
+            {
+                return FText::FromString(FString::Printf(TEXT("Uploading %d images - %.0f MB left at %.0f MB/s"),
+                    Uploads.GetQueueDepth(), Uploads.GetQueuedBytes() / (1024.0 * 1024.0), Uploads.GetThroughputMBps()));
+            }
+            
             switch (CurrentToolMode)
             {
                 case EReferenceToolMode::Select:
                     return FText::FromString("Select Mode - Click to select, drag to move");
                 case EReferenceToolMode::Measure:
-                    return FText::FromString("Measure Mode - Click to place measurement points");
+                    return FText::FromString("Measure Mode - Click to place measurement points (snaps to edges, Alt: free placement)");
+                case EReferenceToolMode::Crop:
+                    return FText::FromString("Crop Mode - Drag over an image to place a crop of it (Shift: crop in place)");
+                case EReferenceToolMode::Annotate:
+                    return FText::FromString(FString::Printf(TEXT("Draw Mode - Drag to sketch (Shift: straight line, Ctrl: arrow) - %d strokes"), Canvas->GetNumStrokes()));
+                case EReferenceToolMode::Erase:
+                    return FText::FromString("Erase Mode - Drag over strokes to erase them (Ctrl+Click: erase all)");
                 default:
                     return FText::GetEmpty();
             }
@@ -351,80 +894,609 @@ private:
                 TEXT("Select Reference Images"),
                 DefaultPath,
                 TEXT(""),
-                TEXT("Image Files (*.png;*.jpg;*.jpeg;*.bmp)|*.png;*.jpg;*.jpeg;*.bmp"),
+                TEXT("Image Files (*.png;*.jpg;*.jpeg;*.bmp;*.tga;*.exr;*.hdr;*.gif)|*.png;*.jpg;*.jpeg;*.bmp;*.tga;*.exr;*.hdr;*.gif"),
                 EFileDialogFlags::Multiple,
                 OpenFilenames
             );
 
             if (bOpened)
             {
+                TArray<TSharedPtr<FRefImage>> NewImages;
                 for (const FString& Filename : OpenFilenames)
                 {
-                    LoadImageFile(Filename);
+                    if (TSharedPtr<FRefImage> NewImage = LoadImageFile(Filename))
+                    {
+                        CheckImportedImage(*NewImage);
+                        NewImages.Add(NewImage);
+                    }
+                }
+                
+                // Batch imports are packed instead of stacked on the same spot
+                if (NewImages.Num() > 1 && Canvas.IsValid())
+                {
+                    Canvas->PackNewImages(NewImages);
                 }
             }
         }
         return FReply::Handled();
     }
     
+    FReply OnImportSequenceClicked()
+    {
+        IDesktopPlatform* DesktopPlatform = FDesktopPlatformModule::Get();
+        if (DesktopPlatform)
+        {
+            TArray<FString> OpenFilenames;
+            bool bOpened = DesktopPlatform->OpenFileDialog(
+                FSlateApplication::Get().FindBestParentWindowHandleForDialogs(nullptr),
+                TEXT("Select Any Frame of the Sequence"),
+                FPaths::ProjectDir(),
+                TEXT(""),
+                TEXT("Image Files (*.png;*.jpg;*.jpeg;*.bmp;*.tga;*.exr)|*.png;*.jpg;*.jpeg;*.bmp;*.tga;*.exr"),
+                EFileDialogFlags::None,
+                OpenFilenames
+            );
+            
+            if (bOpened && OpenFilenames.Num() > 0)
+            {
+                const FString Pattern = FRefImageSequenceSource::MakePattern(OpenFilenames[0]);
+                LoadImageFile(Pattern.IsEmpty() ? OpenFilenames[0] : Pattern);
+            }
+        }
+        return FReply::Handled();
+    }
+    
+    FReply OnAddSelectedTexturesClicked()
+    {
+        if (!Canvas.IsValid())
+            return FReply::Handled();
+            
+        TArray<FAssetData> SelectedAssets;
+        FContentBrowserModule& ContentBrowserModule = FModuleManager::LoadModuleChecked<FContentBrowserModule>("ContentBrowser");
+        ContentBrowserModule.Get().GetSelectedAssets(SelectedAssets);
+        
+        TArray<TSharedPtr<FRefImage>> NewImages;
+        for (const FAssetData& Asset : SelectedAssets)
+        {
+            if (Asset.IsInstanceOf(UTexture2D::StaticClass()))
+            {
+                if (TSharedPtr<FRefImage> NewImage = Canvas->AddTextureAsset(Cast<UTexture2D>(Asset.GetAsset()), FVector2D(400, 300)))
+                {
+                    NewImages.Add(NewImage);
+                }
+            }
+        }
+        
+        if (NewImages.Num() > 1)
+        {
+            Canvas->PackNewImages(NewImages);
+        }
+        return FReply::Handled();
+    }
+    
+    FReply OnArrangeClicked()
+    {
+        if (Canvas.IsValid())
+        {
+            Canvas->ArrangeImages();
+        }
+        return FReply::Handled();
+    }
+    
+    FReply OnAddMeshSilhouettesClicked()
+    {
+        if (!Canvas.IsValid())
+            return FReply::Handled();
+            
+        // Drop sessions whose mesh was deleted
+        MeshSilhouettes.RemoveAll([](const TSharedPtr<FRefMeshSilhouette>& Silhouette) { return !Silhouette->IsValid(); });
+        
+        TArray<FAssetData> SelectedAssets;
+        FContentBrowserModule& ContentBrowserModule = FModuleManager::LoadModuleChecked<FContentBrowserModule>("ContentBrowser");
+        ContentBrowserModule.Get().GetSelectedAssets(SelectedAssets);
+        
+        FVector2D Position(0, 0);
+        for (const FAssetData& Asset : SelectedAssets)
+        {
+            if (UStaticMesh* StaticMesh = Cast<UStaticMesh>(Asset.GetAsset()))
+            {
+                TSharedPtr<FRefMeshSilhouette> Silhouette = MakeShared<FRefMeshSilhouette>(StaticMesh, Canvas, Position);
+                Silhouette->Start();
+                MeshSilhouettes.Add(Silhouette);
+                Position.Y += FRefMeshSilhouette::Resolution + 20.0f;
+            }
+        }
+        return FReply::Handled();
+    }
+    
     FReply OnClearClicked()
     {
         if (Canvas.IsValid())
         {
+            FolderWatch.Reset();
             Canvas->ClearImages();
         }
         return FReply::Handled();
     }
     
-    void LoadImageFile(const FString& FilePath)
+    // Library panel
+    ECheckBoxState GetLibraryVisibleState() const
+    {
+        return bLibraryVisible ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+    }
+    
+    void OnLibraryVisibleChanged(ECheckBoxState NewState)
+    {
+        bLibraryVisible = (NewState == ECheckBoxState::Checked);
+    }
+    
+    EVisibility GetLibraryVisibility() const
+    {
+        return bLibraryVisible ? EVisibility::Visible : EVisibility::Collapsed;
+    }
+    
+    // Similarity search
+    ECheckBoxState GetDuplicateWarningState() const
+    {
+        return bWarnOnDuplicates ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+    }
+    
+    void OnDuplicateWarningChanged(ECheckBoxState NewState)
+    {
+        bWarnOnDuplicates = (NewState == ECheckBoxState::Checked);
+    }
+    
+    FReply OnFindSimilarClicked()
+    {
+        if (!Canvas.IsValid() || Canvas->GetSelectedImages().Num() == 0)
+            return FReply::Handled();
+            
+        TSharedPtr<FRefImage> Image = Canvas->GetSelectedImages()[0];
+        if (!Image->Proxy.IsValid())
+            return FReply::Handled();
+            
+        const FRefImageHash Hash = FRefPerceptualHash::Compute(*Image->Proxy);
+        TArray<FRefSimilarMatch> Matches = FRefSimilarityIndex::Get().FindSimilar(Hash, SimilarSearchDistance, SimilarSearchMaxResults);
+        
+        bLibraryVisible = true;
+        LibraryPanel->ShowMatches(FString::Printf(TEXT("Like %s"), *Image->Name), Matches);
+        return FReply::Handled();
+    }
+    
+    // Indexes a freshly imported file and, if enabled, points out when it is already in the library
+    void CheckImportedImage(const FRefImage& Image)
+    {
+        if (!Image.Proxy.IsValid() || Image.FilePath.IsEmpty())
+            return;
+            
+        const FRefImageHash Hash = FRefPerceptualHash::Compute(*Image.Proxy);
+        FRefSimilarityIndex& Index = FRefSimilarityIndex::Get();
+        const FString FullPath = FPaths::ConvertRelativePathToFull(Image.FilePath);
+        
+        if (bWarnOnDuplicates)
+        {
+            for (const FRefSimilarMatch& Match : Index.FindSimilar(Hash, FRefSimilarityIndex::NearDuplicateDistance, 2))
+            {
+                if (FPaths::IsSamePath(Match.FilePath, FullPath))
+                    continue;
+                    
+                FNotificationInfo Info(FText::FromString(FString::Printf(TEXT("%s looks like a near-duplicate of %s"),
+                    *FPaths::GetCleanFilename(Image.FilePath), *Match.FilePath)));
+                Info.ExpireDuration = 6.0f;
+                FSlateNotificationManager::Get().AddNotification(Info);
+                break;
+            }
+        }
+        
+        const FFileStatData Stat = IFileManager::Get().GetStatData(*FullPath);
+        if (Stat.bIsValid)
+        {
+            Index.Add(FullPath, Stat.ModificationTime, Stat.FileSize, Hash);
+        }
+    }
+    
+    // Folder binding
+    FText GetWatchFolderText() const
+    {
+        return FolderWatch.IsValid()
+            ? FText::FromString(FString::Printf(TEXT("Unwatch %s"), *FPaths::GetCleanFilename(FolderWatch->GetFolder())))
+            : FText::FromString("Watch Folder");
+    }
+    
+    FReply OnWatchFolderClicked()
+    {
+        if (FolderWatch.IsValid())
+        {
+            // Unbinding keeps the images on the board
+            FolderWatch.Reset();
+            return FReply::Handled();
+        }
+        
+        IDesktopPlatform* DesktopPlatform = FDesktopPlatformModule::Get();
+        FString FolderPath;
+        if (DesktopPlatform && DesktopPlatform->OpenDirectoryDialog(
+                FSlateApplication::Get().FindBestParentWindowHandleForDialogs(nullptr),
+                TEXT("Select Folder to Watch"),
+                FPaths::ProjectDir(),
+                FolderPath))
+        {
+            WatchFolder(FolderPath);
+        }
+        return FReply::Handled();
+    }
+    
+    void WatchFolder(const FString& FolderPath)
+    {
+        if (!Canvas.IsValid() || !FPaths::DirectoryExists(FolderPath))
+            return;
+            
+        FolderWatch = MakeShared<FRefFolderWatch>(FolderPath, Canvas);
+        FolderWatch->Start();
+    }
+    
+    // Replays the autosave journal into the canvas, then starts journaling this panel
+    void RestoreAutosave()
+    {
+        if (ActiveAutosaveJournal.IsValid() || !Canvas.IsValid())
+            return;
+            
+        FReferenceLayout Restored;
+        if (FRefBoardJournal::Replay(AutosaveBoardName, Restored))
+        {
+            for (const FRefImageRecord& Record : Restored.Images)
+            {
+                LoadRecord(Record);
+            }
+            Canvas->RestoreGroups(Restored.Groups);
+            Canvas->RestoreStrokes(Restored.Strokes);
+        }
+        
+        Journal = MakeShared<FRefBoardJournal>(AutosaveBoardName, Restored);
+        ActiveAutosaveJournal = Journal;
+        Canvas->SetJournal(Journal);
+    }
+    
+    // Board bundles
+    FReferenceLayout MakeLayout() const
+    {
+        FReferenceLayout Layout;
+        Layout.Name = BoardName.IsEmpty() ? TEXT("Board") : BoardName;
+        Layout.GridSize = GridSize;
+        Layout.bGridEnabled = bGridEnabled;
+        Layout.WatchedFolder = FolderWatch.IsValid() ? FolderWatch->GetFolder() : FString();
+        for (const TSharedPtr<FRefImage>& Image : Canvas->GetImages())
+        {
+            Layout.Images.Add(Image->ToRecord());
+        }
+        Layout.Groups = Canvas->GetGroupRecords();
+        Layout.Strokes = Canvas->GetStrokes();
+        return Layout;
+    }
+    
+    FReply OnSaveBundleClicked()
+    {
+        IDesktopPlatform* DesktopPlatform = FDesktopPlatformModule::Get();
+        if (DesktopPlatform && Canvas.IsValid())
+        {
+            TArray<FString> SaveFilenames;
+            bool bSaved = DesktopPlatform->SaveFileDialog(
+                FSlateApplication::Get().FindBestParentWindowHandleForDialogs(nullptr),
+                TEXT("Save Reference Board"),
+                FReferenceViewerModule::GetSavedLayoutsPath(),
+                TEXT("Board.refboard"),
+                TEXT("Reference Board (*.refboard)|*.refboard"),
+                EFileDialogFlags::None,
+                SaveFilenames
+            );
+            
+            if (bSaved && SaveFilenames.Num() > 0)
+            {
+                WriteBundle(SaveFilenames[0]);
+            }
+        }
+        return FReply::Handled();
+    }
+    
+    FReply OnOpenBundleClicked()
+    {
+        IDesktopPlatform* DesktopPlatform = FDesktopPlatformModule::Get();
+        if (DesktopPlatform && Canvas.IsValid())
+        {
+            TArray<FString> OpenFilenames;
+            bool bOpened = DesktopPlatform->OpenFileDialog(
+                FSlateApplication::Get().FindBestParentWindowHandleForDialogs(nullptr),
+                TEXT("Open Reference Board"),
+                FReferenceViewerModule::GetSavedLayoutsPath(),
+                TEXT(""),
+                TEXT("Reference Board (*.refboard)|*.refboard"),
+                EFileDialogFlags::None,
+                OpenFilenames
+            );
+            
+            if (bOpened && OpenFilenames.Num() > 0)
+            {
+                LoadBundle(OpenFilenames[0]);
+            }
+        }
+        return FReply::Handled();
+    }
+    
+    FReply OnExportImageClicked()
+    {
+        IDesktopPlatform* DesktopPlatform = FDesktopPlatformModule::Get();
+        if (DesktopPlatform && Canvas.IsValid())
+        {
+            TArray<FString> SaveFilenames;
+            bool bSaved = DesktopPlatform->SaveFileDialog(
+                FSlateApplication::Get().FindBestParentWindowHandleForDialogs(nullptr),
+                TEXT("Export Board Image"),
+                FReferenceViewerModule::GetSavedLayoutsPath(),
+                TEXT("Board.png"),
+                TEXT("PNG Image (*.png)|*.png|OpenEXR Image (*.exr)|*.exr"),
+                EFileDialogFlags::None,
+                SaveFilenames
+            );
+            
+            if (bSaved && SaveFilenames.Num() > 0)
+            {
+                WriteImage(SaveFilenames[0], FRefBoardExportSettings());
+            }
+        }
+        return FReply::Handled();
+    }
+    
+    bool WriteImage(const FString& ImagePath, const FRefBoardExportSettings& Settings)
     {
-        IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+        // Images opened from a bundle are read back from its mapping rather than their files
+        TSharedPtr<FRefBoardBundle> Bundle;
+        for (const TSharedPtr<FRefImage>& Image : Canvas->GetImages())
+        {
+            if (Image->Bundle.IsValid())
+            {
+                Bundle = Image->Bundle;
+                break;
+            }
+        }
+        
+        // Images with nothing else to read from, like mesh silhouettes, are taken from their textures
+        TMap<FGuid, UTexture2D*> LiveTextures;
+        for (const TSharedPtr<FRefImage>& Image : Canvas->GetImages())
+        {
+            if (Image->Texture)
+            {
+                LiveTextures.Add(Image->Id, Image->Texture);
+            }
+        }
+        return FRefBoardExporter::Export(MakeLayout(), Bundle, ImagePath, Settings, &LiveTextures);
+    }
+    
+    bool WriteBundle(const FString& BundlePath)
+    {
+        if (!FRefBoardBundle::Write(BundlePath, MakeLayout(), Canvas->GetImages()))
+            return false;
+            
+        CurrentBundlePath = BundlePath;
+        SaveSession();
+        return true;
+    }
+    
+    bool LoadBundle(const FString& BundlePath)
+    {
+        TSharedPtr<FRefBoardBundle> Bundle = FRefBoardBundle::Open(BundlePath);
+        if (!Bundle.IsValid())
+            return false;
+            
+        FolderWatch.Reset();
+        Canvas->ClearImages();
+        
+        const FReferenceLayout& Layout = Bundle->GetLayout();
+        bGridEnabled = Layout.bGridEnabled;
+        SetGridSize(Layout.GridSize);
+        Canvas->SetGridEnabled(bGridEnabled);
         
-        TArray<uint8> RawFileData;
-        if (FFileHelper::LoadFileToArray(RawFileData, *FilePath))
+        // Crops of one sheet reuse the texture and proxy made for the first of them
+        TArray<TSharedPtr<FRefImage>> Sheets;
+        TArray<TPair<int32, FRefImageProxyPtr>> SheetProxies;
+        
+        for (const FRefImageRecord& Record : Layout.Images)
         {
-            EImageFormat Format = ImageWrapperModule.DetectImageFormat(RawFileData.GetData(), RawFileData.Num());
-            if (Format != EImageFormat::Invalid)
+            const int32 Index = Bundle->FindImage(Record.Id);
+            if (Index == INDEX_NONE)
             {
-                TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(Format);
-                if (ImageWrapper.IsValid() && ImageWrapper->SetCompressed(RawFileData.GetData(), RawFileData.Num()))
+                // Not embedded; fall back to the project asset or the original file if this machine has it
+                if (Record.TextureAsset.IsValid() || FPaths::FileExists(Record.FilePath))
                 {
-                    TArray<uint8> UncompressedBGRA;
-                    if (ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, UncompressedBGRA))
-                    {
-                        TSharedPtr<FRefImage> NewImage = MakeShareable(new FRefImage());
-                        NewImage->FilePath = FilePath;
-                        NewImage->Name = FPaths::GetBaseFilename(FilePath);
-                        
-                        // Create texture
-                        UTexture2D* NewTexture = UTexture2D::CreateTransient(
-                            ImageWrapper->GetWidth(),
-                            ImageWrapper->GetHeight(),
-                            PF_B8G8R8A8
-                        );
-                        
-                        if (NewTexture)
-                        {
-                            void* TextureData = NewTexture->GetPlatformData()->Mips[0].BulkData.Lock(LOCK_READ_WRITE);
-                            FMemory::Memcpy(TextureData, UncompressedBGRA.GetData(), UncompressedBGRA.Num());
-                            NewTexture->GetPlatformData()->Mips[0].BulkData.Unlock();
-                            NewTexture->UpdateResource();
-                            
-                            NewImage->Texture = NewTexture;
-                            NewImage->Size = FVector2D(ImageWrapper->GetWidth(), ImageWrapper->GetHeight());
-                            
-                            // Position in center of canvas
-                            NewImage->Position = FVector2D(
-                                400 - NewImage->Size.X / 2,
-                                300 - NewImage->Size.Y / 2
-                            );
-                            
-                            AddImage(NewImage);
-                        }
-                    }
+                    LoadRecord(Record);
                 }
+                continue;
+            }
+            
+            // Start every image from its thumbnail mip; the canvas sharpens the ones that come on screen
+            const FVector2D ThumbnailSize = FVector2D(FRefBoardBundle::ThumbnailSize) / FVector2D(Record.UVRegion.GetSize());
+            const int32 Mip = Bundle->SelectMip(Index, ThumbnailSize);
+            
+            const TSharedPtr<FRefImage>* Sheet = Sheets.FindByPredicate([&](const TSharedPtr<FRefImage>& Other)
+            {
+                return Other->ResidentMip == Mip && Bundle->SharesPixels(Other->BundleIndex, Index);
+            });
+            UTexture2D* Texture = Sheet ? (*Sheet)->Texture : Bundle->CreateTexture(Index, Mip);
+            if (!Texture)
+                continue;
+                
+            TSharedPtr<FRefImage> NewImage = MakeShareable(new FRefImage());
+            NewImage->ApplyRecord(Record);
+            NewImage->Texture = Texture;
+            NewImage->Bundle = Bundle;
+            NewImage->BundleIndex = Index;
+            NewImage->ResidentMip = Mip;
+            
+            // The mips are already mapped, so the proxy behind hit testing, palettes and the minimap costs no decode
+            const TPair<int32, FRefImageProxyPtr>* SheetProxy = SheetProxies.FindByPredicate([&](const TPair<int32, FRefImageProxyPtr>& Other)
+            {
+                return Bundle->SharesPixels(Other.Key, Index);
+            });
+            if (!SheetProxy)
+            {
+                SheetProxy = &SheetProxies.Emplace_GetRef(Index, Bundle->MakeProxy(Index));
+            }
+            NewImage->Proxy = FRefImageLoader::CropProxy(SheetProxy->Value, NewImage->UVRegion);
+            AddImage(NewImage);
+            Canvas->BuildEdgeMap(NewImage);
+            
+            if (!Sheet)
+            {
+                Sheets.Add(NewImage);
             }
         }
+        Canvas->RestoreGroups(Layout.Groups);
+        Canvas->RestoreStrokes(Layout.Strokes);
+        
+        // Rebind last, so images already on the board are adopted rather than loaded twice
+        if (!Layout.WatchedFolder.IsEmpty())
+        {
+            WatchFolder(Layout.WatchedFolder);
+        }
+        
+        CurrentBundlePath = BundlePath;
+        SaveSession();
+        return true;
+    }
+    
+    void SaveSession() const
+    {
+        if (GEditor)
+        {
+            if (UReferenceBoardSubsystem* Boards = GEditor->GetEditorSubsystem<UReferenceBoardSubsystem>())
+            {
+                Boards->SaveSession();
+            }
+        }
+    }
+    
+    // Recreates a saved image from its project asset or its source file
+    void LoadRecord(const FRefImageRecord& Record)
+    {
+        if (Record.TextureAsset.IsValid())
+        {
+            if (UTexture2D* Texture = Cast<UTexture2D>(Record.TextureAsset.TryLoad()))
+            {
+                TSharedPtr<FRefImage> NewImage = MakeShareable(new FRefImage());
+                NewImage->Texture = Texture;
+                NewImage->ApplyRecord(Record);
+                NewImage->Proxy = FRefImageLoader::CropProxy(FRefImageLoader::MakeTextureProxy(Texture), NewImage->UVRegion);
+                AddImage(NewImage);
+                if (Canvas.IsValid())
+                {
+                    Canvas->BuildEdgeMap(NewImage);
+                }
+            }
+            return;
+        }
+        
+        // A name that only looks like a pattern is restored as a still
+        if (IsAnimationPath(Record.FilePath) && LoadAnimation(Record.FilePath, &Record).IsValid())
+            return;
+            
+        // Stills are placed from the record alone and decoded once they come on screen
+        if (Canvas.IsValid())
+        {
+            Canvas->AddDeferredImage(Record);
+        }
+    }
+    
+    // GIFs and sequence patterns (walk_####.png) play back; a '#' elsewhere in a name is just a name
+    static bool IsAnimationPath(const FString& FilePath)
+    {
+        return FPaths::GetExtension(FilePath).Equals(TEXT("gif"), ESearchCase::IgnoreCase) || FRefImageSequenceSource::IsPattern(FilePath);
+    }
+    
+    TSharedPtr<FRefImage> LoadImageFile(const FString& FilePath, const FRefImageRecord* Record = nullptr)
+    {
+        // Falls back to a still decode if the file doesn't open as an animation
+        if (IsAnimationPath(FilePath))
+        {
+            if (TSharedPtr<FRefImage> Animated = LoadAnimation(FilePath, Record))
+                return Animated;
+        }
+        
+        int32 Width = 0;
+        int32 Height = 0;
+        TArray64<uint8> DecodedBGRA;
+        FRefHdrImagePtr Hdr;
+        if (!FRefImageLoader::DecodeFile(FilePath, DecodedBGRA, Width, Height, &Hdr))
+            return nullptr;
+            
+        TSharedPtr<FRefImage> NewImage = MakeShareable(new FRefImage());
+        NewImage->FilePath = FilePath;
+        NewImage->Name = FPaths::GetBaseFilename(FilePath);
+        NewImage->Proxy = FRefImageLoader::MakeProxy(DecodedBGRA.GetData(), Width, Height);
+        NewImage->HdrSource = Hdr;
+        NewImage->Size = FVector2D(Width, Height);
+        PlaceNewImage(NewImage, Record);
+        
+        // Drawn as a placeholder while the pixels go up in budgeted slices, so a big import doesn't stall the editor
+        if (Canvas.IsValid())
+        {
+            Canvas->QueueImageUpload(NewImage, MoveTemp(DecodedBGRA), Width, Height);
+        }
+        return NewImage;
+    }
+    
+    TSharedPtr<FRefImage> LoadAnimation(const FString& FilePath, const FRefImageRecord* Record)
+    {
+        FRefFrameSourcePtr Source;
+        if (FPaths::GetExtension(FilePath).Equals(TEXT("gif"), ESearchCase::IgnoreCase))
+        {
+            TSharedPtr<FRefGifDecoder, ESPMode::ThreadSafe> Gif = MakeShared<FRefGifDecoder, ESPMode::ThreadSafe>();
+            if (Gif->Open(FilePath))
+            {
+                Source = Gif;
+            }
+        }
+        else
+        {
+            Source = FRefImageSequenceSource::Open(FilePath);
+        }
+        
+        if (!Source.IsValid())
+            return nullptr;
+            
+        TSharedPtr<FRefAnimPlayer> Player = MakeShared<FRefAnimPlayer>(Source);
+        if (!Player->Initialize())
+            return nullptr;
+            
+        TSharedPtr<FRefImage> NewImage = MakeShareable(new FRefImage());
+        NewImage->FilePath = FilePath;
+        NewImage->Name = FPaths::GetBaseFilename(FilePath).Replace(TEXT("#"), TEXT(""));
+        NewImage->Texture = Player->GetTexture();
+        NewImage->Proxy = Player->GetProxy();
+        NewImage->Animation = Player;
+        NewImage->Size = FVector2D(Source->GetWidth(), Source->GetHeight());
+        return PlaceNewImage(NewImage, Record);
+    }
+    
+    TSharedPtr<FRefImage> PlaceNewImage(TSharedPtr<FRefImage> NewImage, const FRefImageRecord* Record)
+    {
+        if (Record)
+        {
+            NewImage->ApplyRecord(*Record);
+        }
+        else
+        {
+            // Position in center of canvas
+            NewImage->Position = FVector2D(
+                400 - NewImage->Size.X / 2,
+                300 - NewImage->Size.Y / 2
+            );
+        }
+        
+        AddImage(NewImage);
+        
+        if (Canvas.IsValid())
+        {
+            Canvas->BuildEdgeMap(NewImage);
+        }
+        return NewImage;
     }
 };
 
@@ -526,26 +1598,7 @@ public:
 private:
     FReply OnOpenOverlayClicked()
     {
-        // Create floating window with specific DCC-style properties
-        TSharedRef<SWindow> OverlayWindow = SNew(SWindow)
-            .Title(FText::FromString("Reference Panel"))
-            .ClientSize(FVector2D(1000, 700))
-            .SupportsMaximize(false)
-            .SupportsMinimize(true)
-            .SizingRule(ESizingRule::UserSized)
-            .IsTopmostWindow(true)
-            .FocusWhenFirstShown(true)
-            .HasCloseButton(true)
-            .SupportsTransparency(EWindowTransparency::PerWindow)
-            .InitialOpacity(1.0f)
-            .CreateTitleBar(true)
-            .AutoCenter(EAutoCenter::PreferredWorkArea)
-            [
-                SNew(SReferenceOverlay)
-            ];
-            
-        FSlateApplication::Get().AddWindow(OverlayWindow);
-        
+        FReferenceViewerModule::OpenBoardWindow(FString());
         return FReply::Handled();
     }
     
@@ -572,8 +1625,11 @@ private:
 
 void FReferenceViewerModule::StartupModule()
 {
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+    
+    // No ReloadTextures here: it reloads every Slate texture in the editor, and the style's
+    // brushes load on first use anyway
     FReferenceViewerStyle::Initialize();
-    FReferenceViewerStyle::ReloadTextures();
     
     FReferenceViewerCommands::Register();
     
@@ -589,10 +1645,65 @@ void FReferenceViewerModule::StartupModule()
     FGlobalTabmanager::Get()->RegisterNomadTabSpawner(ReferenceViewerTabName, FOnSpawnTab::CreateRaw(this, &FReferenceViewerModule::OnSpawnPluginTab))
         .SetDisplayName(LOCTEXT("FReferenceViewerTabTitle", "Reference Viewer"))
         .SetMenuType(ETabSpawnerMenuType::Hidden);
+        
+    // Last session's boards come back once the editor is up, not while modules are loading
+    EngineInitHandle = FCoreDelegates::OnFEngineLoopInitComplete.AddRaw(this, &FReferenceViewerModule::RestoreSession);
+    
+    const double StartupMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+    if (StartupMs > StartupBudgetMs)
+    {
+        UE_LOG(LogReferenceViewer, Warning, TEXT("Module startup took %.3f ms (budget %.1f ms)"), StartupMs, StartupBudgetMs);
+    }
+    else
+    {
+        UE_LOG(LogReferenceViewer, Verbose, TEXT("Module startup took %.3f ms"), StartupMs);
+    }
+}
+
+void FReferenceViewerModule::RestoreSession()
+{
+    FCoreDelegates::OnFEngineLoopInitComplete.Remove(EngineInitHandle);
+    EngineInitHandle.Reset();
+    
+    if (IsRunningCommandlet() || !GEditor || !FSlateApplication::IsInitialized())
+        return;
+        
+    UReferenceBoardSubsystem* Boards = GEditor->GetEditorSubsystem<UReferenceBoardSubsystem>();
+    TArray<FRefSessionBoard> SessionBoards;
+    if (!Boards || !FRefBoardSession::Load(SessionBoards))
+        return;
+        
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+    
+    // The autosave board opens first so its panel is the one that claims the journal
+    SessionBoards.StableSort([](const FRefSessionBoard& A, const FRefSessionBoard& B)
+    {
+        return A.bAutosave && !B.bAutosave;
+    });
+    
+    int32 NumRestored = 0;
+    for (const FRefSessionBoard& Board : SessionBoards)
+    {
+        // A board that was never saved has nothing to come back from
+        const bool bHasBundle = !Board.bAutosave && FPaths::FileExists(Board.BundlePath);
+        if (!Board.bAutosave && !bHasBundle)
+            continue;
+            
+        OpenBoardWindow(Board.Name);
+        if (bHasBundle)
+        {
+            Boards->LoadBoard(Board.Name, Board.BundlePath);
+        }
+        NumRestored++;
+    }
+    
+    UE_LOG(LogReferenceViewer, Log, TEXT("Restored %d board(s) from the last session in %.2f ms"),
+        NumRestored, FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
 }
 
 void FReferenceViewerModule::ShutdownModule()
 {
+    FCoreDelegates::OnFEngineLoopInitComplete.Remove(EngineInitHandle);
     UToolMenus::UnRegisterStartupCallback(this);
     UToolMenus::UnregisterOwner(this);
     FReferenceViewerStyle::Shutdown();
@@ -619,6 +1730,30 @@ void FReferenceViewerModule::PluginButtonClicked()
     FGlobalTabmanager::Get()->TryInvokeTab(ReferenceViewerTabName);
 }
 
+void FReferenceViewerModule::OpenBoardWindow(const FString& BoardName)
+{
+    // Create floating window with specific DCC-style properties
+    TSharedRef<SWindow> OverlayWindow = SNew(SWindow)
+        .Title(FText::FromString(BoardName.IsEmpty() ? TEXT("Reference Panel") : BoardName))
+        .ClientSize(FVector2D(1000, 700))
+        .SupportsMaximize(false)
+        .SupportsMinimize(true)
+        .SizingRule(ESizingRule::UserSized)
+        .IsTopmostWindow(true)
+        .FocusWhenFirstShown(true)
+        .HasCloseButton(true)
+        .SupportsTransparency(EWindowTransparency::PerWindow)
+        .InitialOpacity(1.0f)
+        .CreateTitleBar(true)
+        .AutoCenter(EAutoCenter::PreferredWorkArea)
+        [
+            SNew(SReferenceOverlay)
+            .BoardName(BoardName)
+        ];
+        
+    FSlateApplication::Get().AddWindow(OverlayWindow);
+}
+
 void FReferenceViewerModule::RegisterMenus()
 {
     FToolMenuOwnerScoped OwnerScoped(this);
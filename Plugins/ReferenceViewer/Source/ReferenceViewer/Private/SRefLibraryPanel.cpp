@@ -0,0 +1,443 @@
+#include "SRefLibraryPanel.h"
+#include "RefThumbnailCache.h"
+#include "RefImageLoader.h"
+#include "RefFolderWatch.h"
+#include "RefLibraryDragDropOp.h"
+#include "Engine/Texture2D.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "DesktopPlatformModule.h"
+#include "IDesktopPlatform.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Widgets/Layout/SBox.h"
+#include "Widgets/Layout/SBorder.h"
+#include "Widgets/Layout/SScaleBox.h"
+#include "Widgets/Images/SImage.h"
+#include "Widgets/Input/SButton.h"
+#include "Widgets/Text/STextBlock.h"
+
+// Tile that remembers its item, so released widgets can be mapped back to the item
+class SRefLibraryTile : public STableRow<FRefLibraryItemPtr>
+{
+public:
+    SLATE_BEGIN_ARGS(SRefLibraryTile) {}
+        SLATE_EVENT(FOnDragDetected, OnDragDetected)
+    SLATE_END_ARGS()
+
+    void Construct(const FArguments& InArgs, const TSharedRef<STableViewBase>& OwnerTable, FRefLibraryItemPtr InItem)
+    {
+        Item = InItem;
+        TWeakPtr<FRefLibraryItem> WeakItem = InItem;
+
+        STableRow<FRefLibraryItemPtr>::Construct(
+            STableRow<FRefLibraryItemPtr>::FArguments()
+            .Padding(3)
+            .OnDragDetected(InArgs._OnDragDetected)
+            .Content()
+            [
+                SNew(SVerticalBox)
+
+                + SVerticalBox::Slot()
+                .FillHeight(1.0f)
+                [
+                    SNew(SBorder)
+                    .BorderImage(FCoreStyle::Get().GetBrush("ToolPanel.DarkGroupBorder"))
+                    .Padding(2)
+                    [
+                        SNew(SScaleBox)
+                        .Stretch(EStretch::ScaleToFit)
+                        [
+                            SNew(SImage)
+                            .Image_Lambda([WeakItem]() -> const FSlateBrush*
+                            {
+                                TSharedPtr<FRefLibraryItem> Pinned = WeakItem.Pin();
+                                return Pinned.IsValid() ? Pinned->Brush.Get() : nullptr;
+                            })
+                        ]
+                    ]
+                ]
+
+                + SVerticalBox::Slot()
+                .AutoHeight()
+                .Padding(0, 2, 0, 0)
+                [
+                    SNew(STextBlock)
+                    .Text(FText::FromString(InItem->Name))
+                    .ToolTipText(FText::FromString(InItem->FilePath))
+                    .OverflowPolicy(ETextOverflowPolicy::Ellipsis)
+                    .Font(FCoreStyle::GetDefaultFontStyle("Regular", 8))
+                ]
+            ],
+            OwnerTable);
+    }
+
+    FRefLibraryItemPtr GetItem() const { return Item; }
+
+private:
+    FRefLibraryItemPtr Item;
+};
+
+void SRefLibraryPanel::Construct(const FArguments& InArgs)
+{
+    Generation = 0;
+    bScanning = false;
+    NumInFlight = 0;
+
+    ChildSlot
+    [
+        SNew(SVerticalBox)
+
+        + SVerticalBox::Slot()
+        .AutoHeight()
+        [
+            SNew(SBorder)
+            .BorderImage(FCoreStyle::Get().GetBrush("ToolPanel.GroupBorder"))
+            .Padding(5)
+            [
+                SNew(SHorizontalBox)
+
+                + SHorizontalBox::Slot()
+                .AutoWidth()
+                [
+                    SNew(SButton)
+                    .Text(FText::FromString("Browse..."))
+                    .ToolTipText(FText::FromString("Pick a folder of reference images to browse. Drag thumbnails onto the board."))
+                    .OnClicked(this, &SRefLibraryPanel::OnBrowseClicked)
+                ]
+
+                + SHorizontalBox::Slot()
+                .AutoWidth()
+                .Padding(2, 0, 0, 0)
+                [
+                    SNew(SButton)
+                    .Text(FText::FromString("Show Folder"))
+                    .Visibility_Lambda([this]() { return MatchesTitle.IsEmpty() ? EVisibility::Collapsed : EVisibility::Visible; })
+                    .OnClicked(this, &SRefLibraryPanel::OnShowFolderClicked)
+                ]
+
+                + SHorizontalBox::Slot()
+                .FillWidth(1.0f)
+                .VAlign(VAlign_Center)
+                .Padding(5, 0)
+                [
+                    SNew(STextBlock)
+                    .Text(this, &SRefLibraryPanel::GetStatusText)
+                    .Font(FCoreStyle::GetDefaultFontStyle("Regular", 9))
+                    .ColorAndOpacity(FSlateColor(FLinearColor(0.8f, 0.8f, 0.8f)))
+                ]
+            ]
+        ]
+
+        + SVerticalBox::Slot()
+        .FillHeight(1.0f)
+        [
+            SAssignNew(TileView, STileView<FRefLibraryItemPtr>)
+            .ListItemsSource(&Items)
+            .OnGenerateTile(this, &SRefLibraryPanel::OnGenerateTile)
+            .OnTileReleased(this, &SRefLibraryPanel::OnTileReleased)
+            .ItemWidth(TileSize)
+            .ItemHeight(TileSize + 18.0f)
+            .SelectionMode(ESelectionMode::Multi)
+        ]
+    ];
+}
+
+void SRefLibraryPanel::SetFolder(const FString& InFolder)
+{
+    Folder = FPaths::ConvertRelativePathToFull(InFolder);
+    FPaths::NormalizeDirectoryName(Folder);
+
+    ResetItems();
+    bScanning = true;
+    TWeakPtr<SRefLibraryPanel> WeakPanel = SharedThis(this);
+    const uint32 ScanGeneration = Generation;
+    const FString ScanFolder = Folder;
+
+    Async(EAsyncExecution::ThreadPool, [WeakPanel, ScanGeneration, ScanFolder]()
+    {
+        TArray<FRefLibraryItem> Found;
+        IFileManager::Get().IterateDirectoryStatRecursively(*ScanFolder, [&Found](const TCHAR* Name, const FFileStatData& Stat)
+        {
+            if (!Stat.bIsDirectory && FRefFolderWatch::IsSupportedFile(Name))
+            {
+                FRefLibraryItem& Item = Found.AddDefaulted_GetRef();
+                Item.FilePath = Name;
+                Item.Name = FPaths::GetBaseFilename(Item.FilePath);
+                Item.Timestamp = Stat.ModificationTime;
+                Item.FileSize = Stat.FileSize;
+            }
+            return true;
+        });
+
+        Found.Sort([](const FRefLibraryItem& A, const FRefLibraryItem& B) { return A.FilePath < B.FilePath; });
+
+        AsyncTask(ENamedThreads::GameThread, [WeakPanel, ScanGeneration, Found = MoveTemp(Found)]() mutable
+        {
+            if (TSharedPtr<SRefLibraryPanel> Panel = WeakPanel.Pin())
+            {
+                Panel->OnScanComplete(ScanGeneration, MoveTemp(Found));
+            }
+        });
+    });
+}
+
+void SRefLibraryPanel::ShowMatches(const FString& Title, const TArray<FRefSimilarMatch>& Matches)
+{
+    ResetItems();
+    MatchesTitle = Title;
+
+    for (const FRefSimilarMatch& Match : Matches)
+    {
+        FRefLibraryItemPtr Item = MakeShared<FRefLibraryItem>();
+        Item->FilePath = Match.FilePath;
+        Item->Name = FPaths::GetBaseFilename(Match.FilePath);
+        Item->Timestamp = Match.Timestamp;
+        Item->FileSize = Match.FileSize;
+        Items.Add(Item);
+    }
+    TileView->RequestListRefresh();
+}
+
+void SRefLibraryPanel::AddReferencedObjects(FReferenceCollector& Collector)
+{
+    for (const FRefLibraryItemPtr& Item : Resident)
+    {
+        Collector.AddReferencedObject(Item->Texture);
+    }
+}
+
+void SRefLibraryPanel::ResetItems()
+{
+    // Loads still in flight finish against their orphaned items and are dropped
+    Generation++;
+    bScanning = false;
+    MatchesTitle.Reset();
+    Items.Reset();
+    Queue.Reset();
+    Resident.Reset();
+    TileView->ClearSelection();
+    TileView->RequestListRefresh();
+}
+
+void SRefLibraryPanel::OnScanComplete(uint32 ScanGeneration, TArray<FRefLibraryItem> Found)
+{
+    if (ScanGeneration != Generation)
+        return;
+
+    bScanning = false;
+    Items.Reserve(Found.Num());
+
+    TArray<FRefIndexRequest> IndexRequests;
+    IndexRequests.Reserve(Found.Num());
+    for (FRefLibraryItem& Item : Found)
+    {
+        FRefIndexRequest& Request = IndexRequests.AddDefaulted_GetRef();
+        Request.FilePath = Item.FilePath;
+        Request.Timestamp = Item.Timestamp;
+        Request.FileSize = Item.FileSize;
+
+        Items.Add(MakeShared<FRefLibraryItem>(MoveTemp(Item)));
+    }
+    TileView->RequestListRefresh();
+
+    FRefSimilarityIndex::Get().IndexFiles(IndexRequests);
+}
+
+TSharedRef<ITableRow> SRefLibraryPanel::OnGenerateTile(FRefLibraryItemPtr Item, const TSharedRef<STableViewBase>& OwnerTable)
+{
+    // Tiles are only generated for what is on screen, so this doubles as the visibility signal
+    Item->bVisible = true;
+    if (Resident.Remove(Item) > 0)
+    {
+        Resident.Add(Item);
+    }
+    RequestThumbnail(Item);
+
+    return SNew(SRefLibraryTile, OwnerTable, Item)
+        .OnDragDetected(FOnDragDetected::CreateSP(this, &SRefLibraryPanel::OnTileDragDetected, Item));
+}
+
+void SRefLibraryPanel::OnTileReleased(const TSharedRef<ITableRow>& Row)
+{
+    FRefLibraryItemPtr Item = StaticCastSharedRef<SRefLibraryTile>(Row)->GetItem();
+    if (!Item.IsValid())
+        return;
+
+    // Scrolled past before its turn came
+    Item->bVisible = false;
+    if (Item->bQueued)
+    {
+        Item->bQueued = false;
+        Queue.Remove(Item);
+    }
+}
+
+FReply SRefLibraryPanel::OnTileDragDetected(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent, FRefLibraryItemPtr Item)
+{
+    TArray<FRefLibraryItemPtr> Dragged = TileView->GetSelectedItems();
+    if (!Dragged.Contains(Item))
+    {
+        Dragged.Reset();
+        Dragged.Add(Item);
+    }
+
+    // Only tiles showing a thumbnail can be placed without waiting
+    TArray<FRefLibraryDragDropOp::FEntry> Entries;
+    for (const FRefLibraryItemPtr& DraggedItem : Dragged)
+    {
+        if (!DraggedItem->Thumbnail.IsValid())
+            continue;
+
+        FRefLibraryDragDropOp::FEntry& Entry = Entries.AddDefaulted_GetRef();
+        Entry.FilePath = DraggedItem->FilePath;
+        Entry.Thumbnail = DraggedItem->Thumbnail;
+        Entry.SourceSize = DraggedItem->SourceSize;
+    }
+
+    if (Entries.Num() == 0)
+        return FReply::Unhandled();
+
+    return FReply::Handled().BeginDragDrop(FRefLibraryDragDropOp::New(MoveTemp(Entries)));
+}
+
+FReply SRefLibraryPanel::OnBrowseClicked()
+{
+    IDesktopPlatform* DesktopPlatform = FDesktopPlatformModule::Get();
+    FString FolderPath;
+    if (DesktopPlatform && DesktopPlatform->OpenDirectoryDialog(
+            FSlateApplication::Get().FindBestParentWindowHandleForDialogs(nullptr),
+            TEXT("Select Library Folder"),
+            Folder.IsEmpty() ? FPaths::ProjectDir() : Folder,
+            FolderPath))
+    {
+        SetFolder(FolderPath);
+    }
+    return FReply::Handled();
+}
+
+FReply SRefLibraryPanel::OnShowFolderClicked()
+{
+    if (Folder.IsEmpty())
+    {
+        ResetItems();
+    }
+    else
+    {
+        SetFolder(Folder);
+    }
+    return FReply::Handled();
+}
+
+FText SRefLibraryPanel::GetStatusText() const
+{
+    const int32 NumIndexing = FRefSimilarityIndex::Get().GetNumPending();
+    const FString Indexing = NumIndexing > 0 ? FString::Printf(TEXT(" (indexing %d)"), NumIndexing) : FString();
+
+    if (!MatchesTitle.IsEmpty())
+        return FText::FromString(FString::Printf(TEXT("%s: %d matches%s"), *MatchesTitle, Items.Num(), *Indexing));
+
+    if (Folder.IsEmpty())
+        return FText::FromString("No library folder");
+
+    if (bScanning)
+        return FText::FromString(FString::Printf(TEXT("Scanning %s..."), *FPaths::GetCleanFilename(Folder)));
+
+    return FText::FromString(FString::Printf(TEXT("%s: %d images%s"), *FPaths::GetCleanFilename(Folder), Items.Num(), *Indexing));
+}
+
+void SRefLibraryPanel::RequestThumbnail(const FRefLibraryItemPtr& Item)
+{
+    if (Item->Thumbnail.IsValid() || Item->bQueued || Item->bLoading || Item->bFailed)
+        return;
+
+    Item->bQueued = true;
+    Queue.Add(Item);
+    PumpQueue();
+}
+
+void SRefLibraryPanel::PumpQueue()
+{
+    while (NumInFlight < MaxConcurrentLoads && Queue.Num() > 0)
+    {
+        FRefLibraryItemPtr Item = Queue.Pop(EAllowShrinking::No);
+        Item->bQueued = false;
+        if (!Item->bVisible)
+            continue;
+
+        Item->bLoading = true;
+        NumInFlight++;
+
+        TWeakPtr<SRefLibraryPanel> WeakPanel = SharedThis(this);
+        TWeakPtr<FRefLibraryItem> WeakItem = Item;
+        const FString FilePath = Item->FilePath;
+        const FDateTime Timestamp = Item->Timestamp;
+        const int64 FileSize = Item->FileSize;
+
+        Async(EAsyncExecution::ThreadPool, [WeakPanel, WeakItem, FilePath, Timestamp, FileSize]()
+        {
+            // Proxy stays null if the file could not be decoded
+            TSharedPtr<FRefThumbnail, ESPMode::ThreadSafe> Result = MakeShared<FRefThumbnail, ESPMode::ThreadSafe>();
+            FRefThumbnailCache::LoadOrBuild(FilePath, Timestamp, FileSize, *Result);
+
+            AsyncTask(ENamedThreads::GameThread, [WeakPanel, WeakItem, Result]()
+            {
+                if (TSharedPtr<SRefLibraryPanel> Panel = WeakPanel.Pin())
+                {
+                    Panel->OnThumbnailLoaded(WeakItem, Result);
+                }
+            });
+        });
+    }
+}
+
+void SRefLibraryPanel::OnThumbnailLoaded(TWeakPtr<FRefLibraryItem> WeakItem, TSharedPtr<FRefThumbnail, ESPMode::ThreadSafe> Result)
+{
+    NumInFlight--;
+
+    // Null when the folder changed while loading
+    FRefLibraryItemPtr Item = WeakItem.Pin();
+    if (Item.IsValid())
+    {
+        Item->bLoading = false;
+        if (!Result->Proxy.IsValid())
+        {
+            Item->bFailed = true;
+        }
+        else if (UTexture2D* Texture = FRefImageLoader::CreateTexture(Result->Proxy->BGRA.GetData(), Result->Proxy->Width, Result->Proxy->Height))
+        {
+            Item->Thumbnail = Result->Proxy;
+            Item->SourceSize = Result->SourceSize;
+            Item->Texture = Texture;
+            Item->Brush = MakeShareable(new FSlateBrush());
+            Item->Brush->SetResourceObject(Texture);
+            Item->Brush->ImageSize = FVector2D(Result->Proxy->Width, Result->Proxy->Height);
+            Item->Brush->DrawAs = ESlateBrushDrawType::Image;
+
+            Resident.Add(Item);
+            TrimResident();
+        }
+    }
+
+    PumpQueue();
+}
+
+void SRefLibraryPanel::TrimResident()
+{
+    // Evict the oldest thumbnails that are off screen
+    int32 Index = 0;
+    while (Resident.Num() > MaxResidentThumbnails && Index < Resident.Num())
+    {
+        FRefLibraryItem& Item = *Resident[Index];
+        if (Item.bVisible)
+        {
+            Index++;
+            continue;
+        }
+
+        Item.Thumbnail.Reset();
+        Item.Texture = nullptr;
+        Item.Brush.Reset();
+        Resident.RemoveAt(Index, 1, EAllowShrinking::No);
+    }
+}
\ No newline at end of file
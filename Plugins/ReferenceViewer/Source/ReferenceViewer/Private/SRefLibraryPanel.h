@@ -0,0 +1,99 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SCompoundWidget.h"
+#include "UObject/GCObject.h"
+#include "Widgets/Views/STileView.h"
+#include "RefViewerData.h"
+#include "RefSimilarityIndex.h"
+
+struct FRefThumbnail;
+
+// One file in the library folder
+struct FRefLibraryItem
+{
+    FString FilePath;
+    FString Name;
+    FDateTime Timestamp;
+    int64 FileSize = 0;
+
+    // Loaded thumbnail; dropped again when the item scrolls out of the resident set
+    FRefImageProxyPtr Thumbnail;
+    FIntPoint SourceSize = FIntPoint::ZeroValue;
+    UTexture2D* Texture = nullptr;
+    TSharedPtr<FSlateBrush> Brush;
+
+    // A tile widget currently exists for the item
+    bool bVisible = false;
+    bool bQueued = false;
+    bool bLoading = false;
+    bool bFailed = false;
+};
+
+typedef TSharedPtr<FRefLibraryItem> FRefLibraryItemPtr;
+
+// Browsable folder of reference images next to the board. The tile view only
+// builds widgets for the tiles on screen; thumbnails are requested as tiles
+// appear, loaded on workers newest-first from the on-disk cache, and released
+// once too many are resident. Tiles drag onto the canvas.
+class SRefLibraryPanel : public SCompoundWidget, public FGCObject
+{
+public:
+    SLATE_BEGIN_ARGS(SRefLibraryPanel) {}
+    SLATE_END_ARGS()
+
+    // Thumbnail loads in flight at once
+    static constexpr int32 MaxConcurrentLoads = 4;
+
+    // Thumbnails kept in memory; the rest reload from the disk cache when scrolled back
+    static constexpr int32 MaxResidentThumbnails = 256;
+
+    static constexpr float TileSize = 112.0f;
+
+    void Construct(const FArguments& InArgs);
+
+    // Lists the images in the folder and its subfolders, scanning on a worker.
+    // Found files are also queued for the similarity index.
+    void SetFolder(const FString& InFolder);
+    const FString& GetFolder() const { return Folder; }
+
+    // Lists search results instead of the folder until the folder is shown again
+    void ShowMatches(const FString& Title, const TArray<FRefSimilarMatch>& Matches);
+
+    // FGCObject: keeps the resident thumbnail textures alive
+    virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+    virtual FString GetReferencerName() const override { return TEXT("SRefLibraryPanel"); }
+
+private:
+    TSharedRef<ITableRow> OnGenerateTile(FRefLibraryItemPtr Item, const TSharedRef<STableViewBase>& OwnerTable);
+    void OnTileReleased(const TSharedRef<ITableRow>& Row);
+    FReply OnTileDragDetected(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent, FRefLibraryItemPtr Item);
+    FReply OnBrowseClicked();
+    FReply OnShowFolderClicked();
+    void ResetItems();
+    FText GetStatusText() const;
+
+    void OnScanComplete(uint32 ScanGeneration, TArray<FRefLibraryItem> Found);
+    void RequestThumbnail(const FRefLibraryItemPtr& Item);
+    void PumpQueue();
+    void OnThumbnailLoaded(TWeakPtr<FRefLibraryItem> WeakItem, TSharedPtr<FRefThumbnail, ESPMode::ThreadSafe> Result);
+    void TrimResident();
+
+    FString Folder;
+    TArray<FRefLibraryItemPtr> Items;
+
+    // Set while search results are listed
+    FString MatchesTitle;
+    TSharedPtr<STileView<FRefLibraryItemPtr>> TileView;
+
+    // Bumped on every folder change so a late scan of the old folder is ignored
+    uint32 Generation;
+    bool bScanning;
+
+    // Requests in arrival order; served from the back so the tiles just scrolled to load first
+    TArray<FRefLibraryItemPtr> Queue;
+    int32 NumInFlight;
+
+    // Items holding a thumbnail, least recently shown first
+    TArray<FRefLibraryItemPtr> Resident;
+};
\ No newline at end of file
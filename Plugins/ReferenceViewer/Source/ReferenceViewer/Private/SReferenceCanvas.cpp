@@ -1,6 +1,105 @@
 #include "SReferenceCanvas.h"
+#include "RefEdgeDetector.h"
+#include "RefBoardJournal.h"
+#include "RefBoardBundle.h"
+#include "RefImageCompare.h"
+#include "RefImageLoader.h"
+#include "RefBoardPacker.h"
+#include "RefMinimap.h"
+#include "RefAnimation.h"
+#include "RefPalette.h"
+#include "RefUploadScheduler.h"
+#include "RefGroupProxy.h"
+#include "RefThumbnailCache.h"
+#include "RefAnnotationLayer.h"
+#include "RefSnapIndex.h"
+#include "Engine/Texture2D.h"
+#include "Async/Async.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
 #include "Rendering/DrawElements.h"
+#include "DragAndDrop/AssetDragDropOp.h"
+#include "RefLibraryDragDropOp.h"
 #include "Framework/Application/SlateApplication.h"
+#include "Framework/Notifications/NotificationManager.h"
+#include "Widgets/Notifications/SNotificationList.h"
+#include "HAL/PlatformApplicationMisc.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("ReferenceViewer"), STATGROUP_ReferenceViewer, STATCAT_Advanced);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Input To Paint (ms)"), STAT_RefViewer_InputLatency, STATGROUP_ReferenceViewer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Upload Queue (images)"), STAT_RefViewer_UploadQueue, STATGROUP_ReferenceViewer);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Upload Queue (MB)"), STAT_RefViewer_UploadQueueMB, STATGROUP_ReferenceViewer);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Upload Submitted (MB)"), STAT_RefViewer_UploadFrameMB, STATGROUP_ReferenceViewer);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Upload Submit Time (ms)"), STAT_RefViewer_UploadFrameMs, STATGROUP_ReferenceViewer);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Upload Throughput (MB/s)"), STAT_RefViewer_UploadThroughput, STATGROUP_ReferenceViewer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Deferred Images"), STAT_RefViewer_DeferredImages, STATGROUP_ReferenceViewer);
+
+namespace
+{
+    // Screen pixels a simplified stroke may stray from the drawn one
+    constexpr float AnnotationTolerance = 1.5f;
+    
+    // Eraser radius in screen pixels
+    constexpr float EraserRadius = 6.0f;
+    
+    // Screen pixels within which a dragged selection snaps to a smart guide
+    constexpr float GuideSnapDistance = 6.0f;
+    
+    // Parents before children
+    void ForEachGroup(const TArray<TSharedPtr<FRefGroup>>& Groups, TFunctionRef<void(const TSharedPtr<FRefGroup>&)> Visit)
+    {
+        for (const TSharedPtr<FRefGroup>& Group : Groups)
+        {
+            Visit(Group);
+            ForEachGroup(Group->Children, Visit);
+        }
+    }
+    
+    // Whether Group or any group around it is selected, i.e. it already moves with the selection
+    bool IsInSelectedGroup(const FRefGroup* Group)
+    {
+        for (; Group; Group = Group->Parent.Pin().Get())
+        {
+            if (Group->bSelected)
+                return true;
+        }
+        return false;
+    }
+    
+    // Drops members that left the board, then groups with nothing left in them
+    void PruneGroups(TArray<TSharedPtr<FRefGroup>>& Groups, const TSet<const FRefImage*>& OnBoard)
+    {
+        for (const TSharedPtr<FRefGroup>& Group : Groups)
+        {
+            const int32 NumRemoved = Group->Images.RemoveAll([&OnBoard, &Group](const TWeakPtr<FRefImage>& Member)
+            {
+                TSharedPtr<FRefImage> Image = Member.Pin();
+                if (Image.IsValid() && OnBoard.Contains(Image.Get()))
+                    return false;
+                    
+                if (Image.IsValid() && Image->Group == Group)
+                {
+                    Image->Group.Reset();
+                }
+                return true;
+            });
+            
+            PruneGroups(Group->Children, OnBoard);
+            if (NumRemoved > 0)
+            {
+                Group->MarkBoundsDirty();
+            }
+            Group->FirstIndex = MAX_int32;
+            Group->EndIndex = 0;
+        }
+        
+        Groups.RemoveAll([](const TSharedPtr<FRefGroup>& Group)
+        {
+            return Group->Images.Num() == 0 && Group->Children.Num() == 0;
+        });
+    }
+}
 
 void SReferenceCanvas::Construct(const FArguments& InArgs)
 {
@@ -10,9 +109,40 @@ void SReferenceCanvas::Construct(const FArguments& InArgs)
     CurrentToolMode = EReferenceToolMode::Select;
     bIsDragging = false;
     bIsPanning = false;
+    PendingDragPos = FVector2D::ZeroVector;
+    bDragPending = false;
+    bDragAxisConstrained = false;
+    SnapIndex = MakeShared<FRefSnapIndex>();
+    DragStartBounds = FBox2D(ForceInit);
+    bSmartGuides = true;
+    bDragGuidesSuppressed = false;
     bShowGrid = true;
     GridSize = 20.0f;
+    MeasureHoverPos = FVector2D::ZeroVector;
+    bMeasureHoverSnapped = false;
+    MeasureSnapRadius = 12.0f;
+    bShowEdgeOverlay = false;
+    Annotations = MakeShared<FRefAnnotationLayer>();
+    AnnotationColor = FLinearColor(1.0f, 0.25f, 0.1f);
+    AnnotationThickness = 3.0f;
+    bIsErasing = false;
+    Minimap = MakeShared<FRefMinimap>();
+    bShowMinimap = true;
+    bIsMinimapDragging = false;
+    LastResidencyUpdateTime = 0.0;
+    Uploads = MakeShared<FRefUploadScheduler>();
+    CropStart = FVector2D::ZeroVector;
+    CropEnd = FVector2D::ZeroVector;
+    bCropInPlace = false;
+    Exposure = 0.0f;
+    bFloatTextures = false;
+    CompareMode = ERefCompareMode::Off;
+    CompareWipeX = 0.0f;
+    CompareTexture = nullptr;
+    bCompareInFlight = false;
     bNeedsRedraw = true;
+    PendingInputTime = 0.0;
+    InputLatencyMs = 0.0f;
 }
 
 int32 SReferenceCanvas::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, 
@@ -39,12 +169,57 @@ int32 SReferenceCanvas::OnPaint(const FPaintArgs& Args, const FGeometry& Allotte
     DrawImages(AllottedGeometry, OutDrawElements, LayerId);
     LayerId += Images.Num() + 1;
     
+    // Compared pair is drawn on top by the comparison view
+    if (CompareMode != ERefCompareMode::Off)
+    {
+        DrawComparison(AllottedGeometry, OutDrawElements, LayerId);
+        LayerId += 4;
+    }
+    
+    // Annotations sit over the references they mark up
+    if (Annotations->Num() > 0 || Annotations->IsDrawing())
+    {
+        const FBox2D CanvasViewBounds(-ViewOffset, AllottedGeometry.GetLocalSize() / ViewZoom - ViewOffset);
+        Annotations->Draw(AllottedGeometry, OutDrawElements, LayerId++, CanvasViewBounds, ViewZoom, ViewOffset);
+    }
+    
+    if (bIsDragging && SnapIndex->GetGuides().Num() > 0)
+    {
+        DrawSnapGuides(AllottedGeometry, OutDrawElements, LayerId++);
+    }
+    
     // Draw measurements if in measure mode
-    if (CurrentToolMode == EReferenceToolMode::Measure && MeasurePoints.Num() > 0)
+    if (CurrentToolMode == EReferenceToolMode::Measure && (MeasurePoints.Num() > 0 || bMeasureHoverSnapped))
     {
         DrawMeasurements(AllottedGeometry, OutDrawElements, LayerId++);
     }
     
+    if (CropTarget.IsValid())
+    {
+        DrawCropRect(AllottedGeometry, OutDrawElements, LayerId++);
+    }
+        
+    DrawAnimationControls(AllottedGeometry, OutDrawElements, LayerId);
+    LayerId += 2;
+    
+    DrawPalettes(AllottedGeometry, OutDrawElements, LayerId);
+    LayerId += 2;
+    
+    if (bShowMinimap)
+    {
+        DrawMinimap(AllottedGeometry, OutDrawElements, LayerId);
+        LayerId += 3;
+    }
+    
+    // This paint is the first to show the input gathered since the last one
+    if (PendingInputTime > 0.0)
+    {
+        const float LatencyMs = (FPlatformTime::Seconds() - PendingInputTime) * 1000.0;
+        InputLatencyMs = InputLatencyMs > 0.0f ? FMath::Lerp(InputLatencyMs, LatencyMs, 0.1f) : LatencyMs;
+        SET_FLOAT_STAT(STAT_RefViewer_InputLatency, LatencyMs);
+        PendingInputTime = 0.0;
+    }
+    
     bNeedsRedraw = false;
     return LayerId;
 }
@@ -84,13 +259,37 @@ void SReferenceCanvas::DrawGrid(const FGeometry& AllottedGeometry, FSlateWindowE
 
 void SReferenceCanvas::DrawImages(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const
 {
-    for (const auto& Image : Images)
+    const FRefImage* ComparedA = CompareMode != ERefCompareMode::Off ? CompareA.Pin().Get() : nullptr;
+    const FRefImage* ComparedB = CompareMode != ERefCompareMode::Off ? CompareB.Pin().Get() : nullptr;
+    const FBox2D CanvasViewBounds(-ViewOffset, AllottedGeometry.GetLocalSize() / ViewZoom - ViewOffset);
+    
+    for (int32 Index = 0; Index < Images.Num(); Index++)
     {
-        if (!Image->bVisible || !Image->Texture)
+        const TSharedPtr<FRefImage>& Image = Images[Index];
+        
+        // Hidden, off-screen and collapsed groups are dealt with whole at their first member
+        const FRefGroup* Culled = FindOutermostGroup(*Image, [&CanvasViewBounds](const FRefGroup& Group)
+        {
+            return !Group.bVisible || Group.bCollapsed || !CanvasViewBounds.Intersect(Group.GetBounds());
+        });
+        if (Culled)
+        {
+            if (Culled->bCollapsed && Culled->bVisible && CanvasViewBounds.Intersect(Culled->GetBounds()))
+            {
+                DrawGroupProxy(*Culled, AllottedGeometry, OutDrawElements, LayerId);
+            }
+            Index = FMath::Max(Index, Culled->EndIndex - 1);
+            continue;
+        }
+        
+        if (!Image->bVisible)
+            continue;
+            
+        if (Image.Get() == ComparedA || Image.Get() == ComparedB)
             continue;
             
         // Transform to screen space
-        FVector2D ScreenPos = (Image->Position + ViewOffset) * ViewZoom;
+        FVector2D ScreenPos = (Image->GetCanvasPosition() + ViewOffset) * ViewZoom;
         FVector2D ScreenSize = Image->Size * ViewZoom;
         
         // Culling check
@@ -99,8 +298,22 @@ void SReferenceCanvas::DrawImages(const FGeometry& AllottedGeometry, FSlateWindo
         if (!ViewBounds.Intersect(ScreenBounds))
             continue;
             
+        // Placed but still loading
+        if (!Image->Texture)
+        {
+            FSlateDrawElement::MakeBox(
+                OutDrawElements,
+                LayerId,
+                AllottedGeometry.ToPaintGeometry(ScreenSize, FSlateLayoutTransform(ScreenPos)),
+                FCoreStyle::Get().GetBrush("WhiteBrush"),
+                ESlateDrawEffect::None,
+                FLinearColor(0.2f, 0.2f, 0.2f, 0.5f * Image->GetEffectiveOpacity())
+            );
+            continue;
+        }
+        
         // Get or create brush
-        TSharedPtr<FSlateBrush> Brush = GetOrCreateBrush(Image->Texture);
+        TSharedPtr<FSlateBrush> Brush = GetImageBrush(*Image);
         if (!Brush.IsValid())
             continue;
             
@@ -116,9 +329,26 @@ void SReferenceCanvas::DrawImages(const FGeometry& AllottedGeometry, FSlateWindo
             ImageGeometry,
             Brush.Get(),
             ESlateDrawEffect::None,
-            FLinearColor(1, 1, 1, Image->Opacity)
+            FLinearColor(1, 1, 1, Image->GetEffectiveOpacity())
         );
         
+        // Draw detected outlines on top
+        if (bShowEdgeOverlay && Image->EdgeTexture)
+        {
+            TSharedPtr<FSlateBrush> EdgeBrush = GetOrCreateBrush(Image->EdgeTexture);
+            if (EdgeBrush.IsValid())
+            {
+                FSlateDrawElement::MakeBox(
+                    OutDrawElements,
+                    LayerId + 1,
+                    ImageGeometry,
+                    EdgeBrush.Get(),
+                    ESlateDrawEffect::None,
+                    FLinearColor::White
+                );
+            }
+        }
+        
         // Draw selection outline
         if (Image->bSelected)
         {
@@ -142,10 +372,365 @@ void SReferenceCanvas::DrawImages(const FGeometry& AllottedGeometry, FSlateWindo
             );
         }
     }
+    
+    // Selected groups are outlined around everything they hold
+    for (const auto& Group : SelectedGroups)
+    {
+        const FBox2D Bounds = Group->GetBounds();
+        if (!Group->IsEffectivelyVisible() || !Bounds.bIsValid || !CanvasViewBounds.Intersect(Bounds))
+            continue;
+            
+        const FVector2D ScreenMin = (Bounds.Min + ViewOffset) * ViewZoom;
+        const FVector2D ScreenMax = (Bounds.Max + ViewOffset) * ViewZoom;
+        TArray<FVector2D> BorderPoints = {
+            ScreenMin,
+            FVector2D(ScreenMax.X, ScreenMin.Y),
+            ScreenMax,
+            FVector2D(ScreenMin.X, ScreenMax.Y),
+            ScreenMin
+        };
+        
+        FSlateDrawElement::MakeLines(
+            OutDrawElements,
+            LayerId + 1,
+            AllottedGeometry.ToPaintGeometry(),
+            BorderPoints,
+            ESlateDrawEffect::None,
+            FLinearColor(0, 1, 1, 1),
+            false,
+            2.0f
+        );
+    }
+}
+
+void SReferenceCanvas::DrawGroupProxy(const FRefGroup& Group, const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const
+{
+    const FBox2D Bounds = Group.GetBounds();
+    const FVector2D ScreenPos = (Bounds.Min + ViewOffset) * ViewZoom;
+    const FVector2D ScreenSize = Bounds.GetSize() * ViewZoom;
+    const float Opacity = Group.GetEffectiveOpacity();
+    
+    // Flat placeholder until the first composite arrives
+    TSharedPtr<FSlateBrush> Brush = GetOrCreateBrush(Group.ProxyTexture);
+    FSlateDrawElement::MakeBox(
+        OutDrawElements,
+        LayerId,
+        AllottedGeometry.ToPaintGeometry(ScreenSize, FSlateLayoutTransform(ScreenPos)),
+        Brush.IsValid() ? Brush.Get() : FCoreStyle::Get().GetBrush("WhiteBrush"),
+        ESlateDrawEffect::None,
+        Brush.IsValid() ? FLinearColor(1, 1, 1, Opacity) : FLinearColor(0.2f, 0.2f, 0.2f, 0.5f * Opacity)
+    );
+    
+    // Frame marks it as a collapsed group rather than a single image
+    TArray<FVector2D> FramePoints = {
+        ScreenPos,
+        ScreenPos + FVector2D(ScreenSize.X, 0),
+        ScreenPos + ScreenSize,
+        ScreenPos + FVector2D(0, ScreenSize.Y),
+        ScreenPos
+    };
+    
+    FSlateDrawElement::MakeLines(
+        OutDrawElements,
+        LayerId + 1,
+        AllottedGeometry.ToPaintGeometry(),
+        FramePoints,
+        ESlateDrawEffect::None,
+        FLinearColor(1.0f, 0.7f, 0.2f, 0.8f),
+        false,
+        1.0f
+    );
+}
+
+void SReferenceCanvas::DrawImageBox(const FRefImage& Image, const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FLinearColor& Tint) const
+{
+    TSharedPtr<FSlateBrush> Brush = GetImageBrush(Image);
+    if (!Brush.IsValid())
+        return;
+        
+    FSlateDrawElement::MakeBox(
+        OutDrawElements,
+        LayerId,
+        AllottedGeometry.ToPaintGeometry(Image.Size * ViewZoom, FSlateLayoutTransform((Image.GetCanvasPosition() + ViewOffset) * ViewZoom)),
+        Brush.Get(),
+        ESlateDrawEffect::None,
+        Tint
+    );
+}
+
+void SReferenceCanvas::DrawComparison(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const
+{
+    TSharedPtr<FRefImage> A = CompareA.Pin();
+    TSharedPtr<FRefImage> B = CompareB.Pin();
+    if (!A.IsValid() || !B.IsValid())
+        return;
+        
+    switch (CompareMode)
+    {
+        case ERefCompareMode::Wipe:
+        {
+            // B shows left of the wipe line, A right of it
+            const FVector2D LocalSize = AllottedGeometry.GetLocalSize();
+            const float WipeScreenX = FMath::Clamp((CompareWipeX + ViewOffset.X) * ViewZoom, 0.0, LocalSize.X);
+            
+            DrawImageBox(*A, AllottedGeometry, OutDrawElements, LayerId, FLinearColor(1, 1, 1, A->GetEffectiveOpacity()));
+            
+            OutDrawElements.PushClip(FSlateClippingZone(AllottedGeometry.MakeChild(FVector2D(WipeScreenX, LocalSize.Y), FSlateLayoutTransform())));
+            DrawImageBox(*B, AllottedGeometry, OutDrawElements, LayerId + 1, FLinearColor(1, 1, 1, B->GetEffectiveOpacity()));
+            OutDrawElements.PopClip();
+            
+            TArray<FVector2D> WipeLine = { FVector2D(WipeScreenX, 0), FVector2D(WipeScreenX, LocalSize.Y) };
+            FSlateDrawElement::MakeLines(
+                OutDrawElements,
+                LayerId + 2,
+                AllottedGeometry.ToPaintGeometry(),
+                WipeLine,
+                ESlateDrawEffect::None,
+                FLinearColor(1, 1, 0, 1),
+                false,
+                1.5f
+            );
+            break;
+        }
+        
+        case ERefCompareMode::OnionSkin:
+        {
+            // Complementary tints make it obvious which image a contour belongs to
+            DrawImageBox(*A, AllottedGeometry, OutDrawElements, LayerId, FLinearColor(1.0f, 0.45f, 0.45f, 1.0f));
+            DrawImageBox(*B, AllottedGeometry, OutDrawElements, LayerId + 1, FLinearColor(0.45f, 1.0f, 1.0f, 0.5f));
+            break;
+        }
+        
+        case ERefCompareMode::Difference:
+        case ERefCompareMode::Heatmap:
+        {
+            DrawImageBox(*A, AllottedGeometry, OutDrawElements, LayerId, FLinearColor(1, 1, 1, A->GetEffectiveOpacity()));
+            DrawImageBox(*B, AllottedGeometry, OutDrawElements, LayerId, FLinearColor(1, 1, 1, B->GetEffectiveOpacity()));
+            
+            TSharedPtr<FSlateBrush> DiffBrush = GetOrCreateBrush(CompareTexture);
+            if (CompareResult.IsValid() && DiffBrush.IsValid())
+            {
+                const FVector2D ScreenPos = (CompareResult->CanvasRect.Min + ViewOffset) * ViewZoom;
+                const FVector2D ScreenSize = CompareResult->CanvasRect.GetSize() * ViewZoom;
+                
+                FSlateDrawElement::MakeBox(
+                    OutDrawElements,
+                    LayerId + 1,
+                    AllottedGeometry.ToPaintGeometry(ScreenSize, FSlateLayoutTransform(ScreenPos)),
+                    DiffBrush.Get(),
+                    ESlateDrawEffect::None,
+                    FLinearColor::White
+                );
+                
+                FSlateDrawElement::MakeText(
+                    OutDrawElements,
+                    LayerId + 2,
+                    AllottedGeometry.ToPaintGeometry(FVector2D(200, 20), FSlateLayoutTransform(ScreenPos + FVector2D(4, 4))),
+                    FString::Printf(TEXT("Mean difference %.1f%%"), CompareResult->MeanError * 100.0f),
+                    FCoreStyle::GetDefaultFontStyle("Bold", 10),
+                    ESlateDrawEffect::None,
+                    FLinearColor::White
+                );
+            }
+            break;
+        }
+        
+        default:
+            break;
+    }
+}
+
+void SReferenceCanvas::DrawAnimationControls(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const
+{
+    // Scrub bar under each selected animated image
+    for (const auto& Image : SelectedImages)
+    {
+        if (!Image->Animation.IsValid() || Image->Animation->GetNumFrames() <= 1)
+            continue;
+            
+        const FBox2D BarRect = GetScrubBarRect(*Image);
+        const float Progress = (Image->Animation->GetCurrentFrame() + 1) / (float)Image->Animation->GetNumFrames();
+        
+        FSlateDrawElement::MakeBox(
+            OutDrawElements,
+            LayerId,
+            AllottedGeometry.ToPaintGeometry(BarRect.GetSize(), FSlateLayoutTransform(BarRect.Min)),
+            FCoreStyle::Get().GetBrush("WhiteBrush"),
+            ESlateDrawEffect::None,
+            FLinearColor(0.15f, 0.15f, 0.15f, 0.9f)
+        );
+        
+        FSlateDrawElement::MakeBox(
+            OutDrawElements,
+            LayerId + 1,
+            AllottedGeometry.ToPaintGeometry(FVector2D(BarRect.GetSize().X * Progress, BarRect.GetSize().Y), FSlateLayoutTransform(BarRect.Min)),
+            FCoreStyle::Get().GetBrush("WhiteBrush"),
+            ESlateDrawEffect::None,
+            Image->Animation->IsPlaying() ? FLinearColor(0.2f, 0.6f, 1.0f, 1.0f) : FLinearColor(1.0f, 0.6f, 0.2f, 1.0f)
+        );
+    }
+}
+
+void SReferenceCanvas::DrawPalettes(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const
+{
+    // Swatch strip under each selected image, below its scrub bar if it has one
+    for (const auto& Image : SelectedImages)
+    {
+        if (!Image->Palette.IsValid())
+            continue;
+            
+        for (int32 Index = 0; Index < Image->Palette->Colors.Num(); Index++)
+        {
+            const FBox2D SwatchRect = GetSwatchRect(*Image, Index);
+            
+            FSlateDrawElement::MakeBox(
+                OutDrawElements,
+                LayerId,
+                AllottedGeometry.ToPaintGeometry(SwatchRect.GetSize() + FVector2D(2, 2), FSlateLayoutTransform(SwatchRect.Min - FVector2D(1, 1))),
+                FCoreStyle::Get().GetBrush("WhiteBrush"),
+                ESlateDrawEffect::None,
+                FLinearColor(0.05f, 0.05f, 0.05f, 0.9f)
+            );
+            
+            FSlateDrawElement::MakeBox(
+                OutDrawElements,
+                LayerId + 1,
+                AllottedGeometry.ToPaintGeometry(SwatchRect.GetSize(), FSlateLayoutTransform(SwatchRect.Min)),
+                FCoreStyle::Get().GetBrush("WhiteBrush"),
+                ESlateDrawEffect::None,
+                Image->Palette->Colors[Index]
+            );
+        }
+    }
+}
+
+void SReferenceCanvas::DrawMinimap(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const
+{
+    TSharedPtr<FSlateBrush> Brush = GetOrCreateBrush(Minimap->GetTexture());
+    if (!Brush.IsValid())
+        return;
+        
+    const FVector2D LocalSize = AllottedGeometry.GetLocalSize();
+    const FBox2D MinimapRect = GetMinimapRect(LocalSize);
+    
+    FSlateDrawElement::MakeBox(
+        OutDrawElements,
+        LayerId,
+        AllottedGeometry.ToPaintGeometry(MinimapRect.GetSize() + FVector2D(2, 2), FSlateLayoutTransform(MinimapRect.Min - FVector2D(1, 1))),
+        FCoreStyle::Get().GetBrush("WhiteBrush"),
+        ESlateDrawEffect::None,
+        FLinearColor(0.4f, 0.4f, 0.4f, 1.0f)
+    );
+    
+    FSlateDrawElement::MakeBox(
+        OutDrawElements,
+        LayerId + 1,
+        AllottedGeometry.ToPaintGeometry(MinimapRect.GetSize(), FSlateLayoutTransform(MinimapRect.Min)),
+        Brush.Get(),
+        ESlateDrawEffect::None,
+        FLinearColor::White
+    );
+    
+    // Current viewport, clamped to the inset
+    const FBox2D& Bounds = Minimap->GetBounds();
+    const FVector2D Scale = MinimapRect.GetSize() / Bounds.GetSize();
+    const FVector2D ViewMin = MinimapRect.Min + (-ViewOffset - Bounds.Min) * Scale;
+    const FVector2D ViewMax = MinimapRect.Min + (LocalSize / ViewZoom - ViewOffset - Bounds.Min) * Scale;
+    const FVector2D Min = FVector2D::Max(ViewMin, MinimapRect.Min);
+    const FVector2D Max = FVector2D::Min(ViewMax, MinimapRect.Max);
+    if (Min.X >= Max.X || Min.Y >= Max.Y)
+        return;
+        
+    TArray<FVector2D> ViewLines = {
+        Min, FVector2D(Max.X, Min.Y), Max, FVector2D(Min.X, Max.Y), Min
+    };
+    FSlateDrawElement::MakeLines(
+        OutDrawElements,
+        LayerId + 2,
+        AllottedGeometry.ToPaintGeometry(),
+        ViewLines,
+        ESlateDrawEffect::None,
+        FLinearColor(1, 1, 1, 0.9f),
+        false,
+        1.0f
+    );
+}
+
+void SReferenceCanvas::DrawCropRect(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const
+{
+    const FVector2D Min = (CropStart.ComponentMin(CropEnd) + ViewOffset) * ViewZoom;
+    const FVector2D Max = (CropStart.ComponentMax(CropEnd) + ViewOffset) * ViewZoom;
+    TArray<FVector2D> BorderPoints = {
+        Min,
+        FVector2D(Max.X, Min.Y),
+        Max,
+        FVector2D(Min.X, Max.Y),
+        Min
+    };
+    
+    FSlateDrawElement::MakeLines(
+        OutDrawElements,
+        LayerId,
+        AllottedGeometry.ToPaintGeometry(),
+        BorderPoints,
+        ESlateDrawEffect::None,
+        bCropInPlace ? FLinearColor(1, 0.5f, 0, 1) : FLinearColor(1, 1, 0, 1),
+        false,
+        1.5f
+    );
+}
+
+void SReferenceCanvas::DrawSnapGuides(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const
+{
+    for (const FRefSnapIndex::FGuide& Guide : SnapIndex->GetGuides())
+    {
+        const FVector2D Start = Guide.bVertical ? FVector2D(Guide.Position, Guide.SpanMin) : FVector2D(Guide.SpanMin, Guide.Position);
+        const FVector2D End = Guide.bVertical ? FVector2D(Guide.Position, Guide.SpanMax) : FVector2D(Guide.SpanMax, Guide.Position);
+        TArray<FVector2D> LinePoints = {
+            (Start + ViewOffset) * ViewZoom,
+            (End + ViewOffset) * ViewZoom
+        };
+        
+        FSlateDrawElement::MakeLines(
+            OutDrawElements,
+            LayerId,
+            AllottedGeometry.ToPaintGeometry(),
+            LinePoints,
+            ESlateDrawEffect::None,
+            FLinearColor(1.0f, 0.2f, 0.6f, 1.0f),
+            true,
+            1.0f
+        );
+    }
 }
 
 void SReferenceCanvas::DrawMeasurements(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const
 {
+    // Snap target under the cursor
+    if (bMeasureHoverSnapped)
+    {
+        const FVector2D Center = (MeasureHoverPos + ViewOffset) * ViewZoom;
+        const float R = 5.0f;
+        TArray<FVector2D> MarkerPoints = {
+            Center + FVector2D(0, -R),
+            Center + FVector2D(R, 0),
+            Center + FVector2D(0, R),
+            Center + FVector2D(-R, 0),
+            Center + FVector2D(0, -R)
+        };
+        
+        FSlateDrawElement::MakeLines(
+            OutDrawElements,
+            LayerId,
+            AllottedGeometry.ToPaintGeometry(),
+            MarkerPoints,
+            ESlateDrawEffect::None,
+            FLinearColor(1, 1, 0, 1),
+            false,
+            1.5f
+        );
+    }
+    
     if (MeasurePoints.Num() >= 2)
     {
         TArray<FVector2D> LinePoints;
@@ -198,32 +783,112 @@ FReply SReferenceCanvas::OnMouseButtonDown(const FGeometry& MyGeometry, const FP
     FVector2D LocalMousePos = MyGeometry.AbsoluteToLocal(MouseEvent.GetScreenSpacePosition());
     FVector2D CanvasPos = LocalMousePos / ViewZoom - ViewOffset;
     
+    // Navigator: click jumps, drag pans
+    if (MouseEvent.GetEffectingButton() == EKeys::LeftMouseButton && bShowMinimap && Minimap->GetTexture()
+        && GetMinimapRect(MyGeometry.GetLocalSize()).IsInside(LocalMousePos))
+    {
+        CenterViewOnMinimap(LocalMousePos, MyGeometry.GetLocalSize());
+        bIsMinimapDragging = true;
+        return FReply::Handled().CaptureMouse(SharedThis(this));
+    }
+    
+    // Scrub bars of selected animations
     if (MouseEvent.GetEffectingButton() == EKeys::LeftMouseButton)
     {
-        switch (CurrentToolMode)
+        for (const auto& Image : SelectedImages)
         {
-            case EReferenceToolMode::Select:
-            case EReferenceToolMode::Move:
+            if (Image->Animation.IsValid() && GetScrubBarRect(*Image).ExpandBy(FVector2D(0, 3)).IsInside(LocalMousePos))
             {
-                TSharedPtr<FRefImage> HitImage = GetImageAtPosition(CanvasPos);
-                if (HitImage.IsValid())
-                {
-                    SelectImage(HitImage, MouseEvent.IsControlDown());
-                    bIsDragging = true;
-                    DragStartPos = CanvasPos;
-                    return FReply::Handled().CaptureMouse(SharedThis(this));
-                }
-                break;
+                ScrubImage = Image;
+                ScrubTo(*Image, LocalMousePos.X);
+                return FReply::Handled().CaptureMouse(SharedThis(this));
             }
-            
-            case EReferenceToolMode::Measure:
-            {
-                if (MouseEvent.IsControlDown())
-                {
+        }
+    }
+    
+    // Palette swatches of selected images copy their colour
+    if (MouseEvent.GetEffectingButton() == EKeys::LeftMouseButton)
+    {
+        for (const auto& Image : SelectedImages)
+        {
+            if (!Image->Palette.IsValid())
+                continue;
+                
+            for (int32 Index = 0; Index < Image->Palette->Colors.Num(); Index++)
+            {
+                if (GetSwatchRect(*Image, Index).IsInside(LocalMousePos))
+                {
+                    // Drawing picks the swatch up as ink instead
+                    if (CurrentToolMode == EReferenceToolMode::Annotate)
+                    {
+                        AnnotationColor = Image->Palette->Colors[Index];
+                    }
+                    else
+                    {
+                        CopySwatchColor(Image->Palette->Colors[Index]);
+                    }
+                    return FReply::Handled();
+                }
+            }
+        }
+    }
+    
+    if (MouseEvent.GetEffectingButton() == EKeys::LeftMouseButton)
+    {
+        switch (CurrentToolMode)
+        {
+            case EReferenceToolMode::Select:
+            case EReferenceToolMode::Move:
+            {
+                TSharedPtr<FRefImage> HitImage = GetImageAtPosition(CanvasPos);
+                if (HitImage.IsValid())
+                {
+                    // Clicks take the whole group; Alt reaches into an expanded one for a single image
+                    const bool bPickImage = MouseEvent.IsAltDown()
+                        && !FindOutermostGroup(*HitImage, [](const FRefGroup& Group) { return Group.bCollapsed; });
+                    if (HitImage->Group.IsValid() && !bPickImage)
+                    {
+                        SelectGroup(HitImage->Group->GetRoot(), MouseEvent.IsControlDown());
+                    }
+                    else
+                    {
+                        SelectImage(HitImage, MouseEvent.IsControlDown());
+                    }
+                    bIsDragging = true;
+                    DragStartPos = CanvasPos;
+                    LastMousePos = CanvasPos;
+                    
+                    DragStartPositions.Reset(SelectedImages.Num());
+                    for (const auto& Image : SelectedImages)
+                    {
+                        DragStartPositions.Add(Image->Position);
+                    }
+                    DragStartOffsets.Reset(SelectedGroups.Num());
+                    for (const auto& Group : SelectedGroups)
+                    {
+                        DragStartOffsets.Add(Group->Offset);
+                    }
+                    UpdateSnapIndex();
+                    return FReply::Handled().CaptureMouse(SharedThis(this));
+                }
+                break;
+            }
+            
+            case EReferenceToolMode::Measure:
+            {
+                if (MouseEvent.IsControlDown())
+                {
                     MeasurePoints.Empty();
                 }
                 else
                 {
+                    // Snap to the nearest detected edge unless Alt is held
+                    FVector2D SnappedPos;
+                    if (!MouseEvent.IsAltDown() && SnapToEdge(CanvasPos, SnappedPos))
+                    {
+                        CanvasPos = SnappedPos;
+                    }
+                    
                     MeasurePoints.Add(CanvasPos);
                     if (MeasurePoints.Num() > 2)
                     {
@@ -233,6 +898,44 @@ FReply SReferenceCanvas::OnMouseButtonDown(const FGeometry& MyGeometry, const FP
                 InvalidateCanvas();
                 return FReply::Handled();
             }
+            
+            case EReferenceToolMode::Crop:
+            {
+                // Animations update their texture in place, so they can't be shared as a sheet
+                TSharedPtr<FRefImage> HitImage = GetImageAtPosition(CanvasPos);
+                if (HitImage.IsValid() && !HitImage->Animation.IsValid())
+                {
+                    CropTarget = HitImage;
+                    CropStart = CanvasPos;
+                    CropEnd = CanvasPos;
+                    bCropInPlace = MouseEvent.IsShiftDown();
+                    return FReply::Handled().CaptureMouse(SharedThis(this));
+                }
+                break;
+            }
+            
+            case EReferenceToolMode::Annotate:
+            {
+                // Shift draws a straight line, Ctrl an arrow
+                const bool bArrow = MouseEvent.IsControlDown();
+                Annotations->BeginStroke(CanvasPos, AnnotationColor, AnnotationThickness, AnnotationTolerance / ViewZoom,
+                    MouseEvent.IsShiftDown() || bArrow, bArrow);
+                InvalidateCanvas();
+                return FReply::Handled().CaptureMouse(SharedThis(this));
+            }
+            
+            case EReferenceToolMode::Erase:
+            {
+                // Ctrl clears every stroke, as it clears the measure points
+                if (MouseEvent.IsControlDown())
+                {
+                    ClearAnnotations();
+                    return FReply::Handled();
+                }
+                bIsErasing = true;
+                EraseStrokesAt(CanvasPos);
+                return FReply::Handled().CaptureMouse(SharedThis(this));
+            }
             // REMOVED ColorPicker case completely
         }
     }
@@ -248,8 +951,60 @@ FReply SReferenceCanvas::OnMouseButtonDown(const FGeometry& MyGeometry, const FP
 
 FReply SReferenceCanvas::OnMouseButtonUp(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent)
 {
+    if (bIsMinimapDragging || ScrubImage.IsValid())
+    {
+        bIsMinimapDragging = false;
+        ScrubImage.Reset();
+        return FReply::Handled().ReleaseMouseCapture();
+    }
+    
+    if (Annotations->IsDrawing())
+    {
+        const FRefStroke* Stroke = Annotations->EndStroke();
+        if (Stroke && Journal.IsValid())
+        {
+            Journal->RecordAddStroke(*Stroke);
+        }
+        InvalidateCanvas();
+        return FReply::Handled().ReleaseMouseCapture();
+    }
+    
+    if (bIsErasing)
+    {
+        bIsErasing = false;
+        return FReply::Handled().ReleaseMouseCapture();
+    }
+    
+    if (TSharedPtr<FRefImage> Cropped = CropTarget.Pin())
+    {
+        CropTarget.Reset();
+        CropImage(Cropped, FBox2D(CropStart.ComponentMin(CropEnd), CropStart.ComponentMax(CropEnd)), bCropInPlace);
+        InvalidateCanvas();
+        return FReply::Handled().ReleaseMouseCapture();
+    }
+    
     if (bIsDragging || bIsPanning)
     {
+        // Land on the release point even if no tick ran since the last move
+        ApplyPendingDrag();
+        SnapIndex->ClearGuides();
+        
+        // Journal the final positions once per drag rather than per mouse event
+        if (bIsDragging && !bIsPanning && Journal.IsValid())
+        {
+            for (const auto& Image : SelectedImages)
+            {
+                if (!Image->IsEffectivelyLocked())
+                {
+                    Journal->RecordMove(*Image);
+                }
+            }
+            if (SelectedGroups.Num() > 0)
+            {
+                RecordGroups();
+            }
+        }
+        
         bIsDragging = false;
         bIsPanning = false;
         return FReply::Handled().ReleaseMouseCapture();
@@ -262,31 +1017,87 @@ FReply SReferenceCanvas::OnMouseMove(const FGeometry& MyGeometry, const FPointer
     FVector2D LocalMousePos = MyGeometry.AbsoluteToLocal(MouseEvent.GetScreenSpacePosition());
     FVector2D CanvasPos = LocalMousePos / ViewZoom - ViewOffset;
     
+    if (bIsMinimapDragging)
+    {
+        CenterViewOnMinimap(LocalMousePos, MyGeometry.GetLocalSize());
+        return FReply::Handled();
+    }
+    
+    if (TSharedPtr<FRefImage> Scrubbed = ScrubImage.Pin())
+    {
+        ScrubTo(*Scrubbed, LocalMousePos.X);
+        return FReply::Handled();
+    }
+    
+    if (Annotations->IsDrawing())
+    {
+        Annotations->ExtendStroke(CanvasPos);
+        NoteInput();
+        InvalidateCanvas();
+        return FReply::Handled();
+    }
+    
+    if (bIsErasing)
+    {
+        EraseStrokesAt(CanvasPos);
+        NoteInput();
+        return FReply::Handled();
+    }
+    
+    if (TSharedPtr<FRefImage> Cropped = CropTarget.Pin())
+    {
+        const FBox2D Bounds = Cropped->GetBounds();
+        CropEnd = CanvasPos.ComponentMax(Bounds.Min).ComponentMin(Bounds.Max);
+        NoteInput();
+        InvalidateCanvas();
+        return FReply::Handled();
+    }
+    
+    if (bIsPanning)
+    {
+        // Pan view
+        FVector2D Delta = LocalMousePos - DragStartPos;
+        ViewOffset += Delta / ViewZoom;
+        DragStartPos = LocalMousePos;
+        LastMousePos = LocalMousePos / ViewZoom - ViewOffset;
+        NoteInput();
+        InvalidateCanvas();
+        return FReply::Handled();
+    }
+    
     if (bIsDragging)
     {
-        if (bIsPanning)
+        if (CurrentToolMode == EReferenceToolMode::Move || CurrentToolMode == EReferenceToolMode::Select)
         {
-            // Pan view
-            FVector2D Delta = LocalMousePos - DragStartPos;
-            ViewOffset += Delta / ViewZoom;
-            DragStartPos = LocalMousePos;
-            InvalidateCanvas();
+            // Only the latest cursor position matters; Tick applies it
+            PendingDragPos = CanvasPos;
+            bDragAxisConstrained = MouseEvent.IsShiftDown();
+            bDragGuidesSuppressed = MouseEvent.IsAltDown();
+            bDragPending = true;
+            NoteInput();
         }
-        else if (CurrentToolMode == EReferenceToolMode::Move || CurrentToolMode == EReferenceToolMode::Select)
+        LastMousePos = CanvasPos;
+        return FReply::Handled();
+    }
+    
+    // Wipe line follows the cursor
+    if (CompareMode == ERefCompareMode::Wipe && CanvasPos.X != CompareWipeX)
+    {
+        CompareWipeX = CanvasPos.X;
+        InvalidateCanvas();
+    }
+    
+    // Live snap feedback for the measure tool
+    if (CurrentToolMode == EReferenceToolMode::Measure)
+    {
+        FVector2D SnappedPos;
+        const bool bSnapped = !MouseEvent.IsAltDown() && SnapToEdge(CanvasPos, SnappedPos);
+        if (bSnapped != bMeasureHoverSnapped || (bSnapped && SnappedPos != MeasureHoverPos))
         {
-            // Move selected images
-            FVector2D Delta = CanvasPos - LastMousePos;
-            if (MouseEvent.IsShiftDown())
-            {
-                // Constrain to axis
-                if (FMath::Abs(Delta.X) > FMath::Abs(Delta.Y))
-                    Delta.Y = 0;
-                else
-                    Delta.X = 0;
-            }
-            MoveSelectedImages(Delta);
+            bMeasureHoverSnapped = bSnapped;
+            MeasureHoverPos = bSnapped ? SnappedPos : CanvasPos;
+            InvalidateCanvas();
         }
-        return FReply::Handled();
     }
     
     LastMousePos = CanvasPos;
@@ -308,6 +1119,7 @@ FReply SReferenceCanvas::OnMouseWheel(const FGeometry& MyGeometry, const FPointe
         FVector2D PostZoomCanvasPos = LocalMousePos / ViewZoom - ViewOffset;
         ViewOffset += PostZoomCanvasPos - PreZoomCanvasPos;
         
+        NoteInput();
         InvalidateCanvas();
         return FReply::Handled();
     }
@@ -316,7 +1128,15 @@ FReply SReferenceCanvas::OnMouseWheel(const FGeometry& MyGeometry, const FPointe
 
 FReply SReferenceCanvas::OnKeyDown(const FGeometry& MyGeometry, const FKeyEvent& InKeyEvent)
 {
-    if (InKeyEvent.GetKey() == EKeys::G)
+    if (InKeyEvent.GetKey() == EKeys::G && InKeyEvent.IsControlDown())
+    {
+        if (InKeyEvent.IsShiftDown())
+            UngroupSelection();
+        else
+            GroupSelection();
+        return FReply::Handled();
+    }
+    else if (InKeyEvent.GetKey() == EKeys::G)
     {
         bShowGrid = !bShowGrid;
         InvalidateCanvas();
@@ -327,12 +1147,188 @@ FReply SReferenceCanvas::OnKeyDown(const FGeometry& MyGeometry, const FKeyEvent&
         SetToolMode(EReferenceToolMode::Measure);
         return FReply::Handled();
     }
+    else if (InKeyEvent.GetKey() == EKeys::D)
+    {
+        // D draws, Shift+D erases
+        const EReferenceToolMode Mode = InKeyEvent.IsShiftDown() ? EReferenceToolMode::Erase : EReferenceToolMode::Annotate;
+        SetToolMode(CurrentToolMode == Mode ? EReferenceToolMode::Select : Mode);
+        return FReply::Handled();
+    }
+    else if (InKeyEvent.GetKey() == EKeys::X)
+    {
+        SetToolMode(CurrentToolMode == EReferenceToolMode::Crop ? EReferenceToolMode::Select : EReferenceToolMode::Crop);
+        return FReply::Handled();
+    }
+    else if (InKeyEvent.GetKey() == EKeys::C)
+    {
+        // Off -> Wipe -> Onion skin -> Difference -> Heatmap -> Off
+        const ERefCompareMode NextMode = CompareMode == ERefCompareMode::Heatmap
+            ? ERefCompareMode::Off
+            : (ERefCompareMode)((uint8)CompareMode + 1);
+        SetCompareMode(NextMode);
+        return FReply::Handled();
+    }
+    else if (InKeyEvent.GetKey() == EKeys::A)
+    {
+        ArrangeImages();
+        return FReply::Handled();
+    }
+    else if (InKeyEvent.GetKey() == EKeys::SpaceBar || InKeyEvent.GetKey() == EKeys::Left || InKeyEvent.GetKey() == EKeys::Right)
+    {
+        // Playback controls for selected animations
+        bool bHandled = false;
+        for (const auto& Image : SelectedImages)
+        {
+            if (!Image->Animation.IsValid())
+                continue;
+                
+            if (InKeyEvent.GetKey() == EKeys::SpaceBar)
+                Image->Animation->TogglePlay();
+            else
+                Image->Animation->Step(InKeyEvent.GetKey() == EKeys::Left ? -1 : 1);
+            bHandled = true;
+        }
+        InvalidateCanvas();
+        return bHandled ? FReply::Handled() : FReply::Unhandled();
+    }
+    else if (InKeyEvent.GetKey() == EKeys::N)
+    {
+        SetMinimapEnabled(!bShowMinimap);
+        return FReply::Handled();
+    }
+    else if (InKeyEvent.GetKey() == EKeys::E)
+    {
+        SetEdgeOverlayEnabled(!bShowEdgeOverlay);
+        return FReply::Handled();
+    }
+    else if (InKeyEvent.GetKey() == EKeys::F)
+    {
+        // Collapse selected groups to a single composite, or expand them again
+        for (const auto& Group : SelectedGroups)
+        {
+            Group->bCollapsed = !Group->bCollapsed;
+        }
+        if (SelectedGroups.Num() > 0)
+        {
+            RecordGroups();
+        }
+        InvalidateCanvas();
+        return FReply::Handled();
+    }
+    else if (InKeyEvent.GetKey() == EKeys::H)
+    {
+        if (InKeyEvent.IsShiftDown())
+        {
+            // Show everything again
+            for (const auto& Image : Images)
+            {
+                if (Image->bVisible)
+                    continue;
+                    
+                Image->bVisible = true;
+                Image->MarkGroupDirty();
+                if (Journal.IsValid())
+                {
+                    Journal->RecordVisibility(*Image);
+                }
+            }
+            ForEachGroup(Groups, [](const TSharedPtr<FRefGroup>& Group)
+            {
+                if (!Group->bVisible)
+                {
+                    Group->bVisible = true;
+                    Group->MarkBoundsDirty();
+                }
+            });
+            Minimap->MarkAllDirty();
+        }
+        else
+        {
+            // Hide the selection
+            for (const auto& Image : SelectedImages)
+            {
+                Minimap->MarkDirty(Image->GetBounds());
+                Image->bVisible = false;
+                Image->MarkGroupDirty();
+                if (Journal.IsValid())
+                {
+                    Journal->RecordVisibility(*Image);
+                }
+            }
+            for (const auto& Group : SelectedGroups)
+            {
+                Minimap->MarkDirty(Group->GetBounds());
+                Group->bVisible = false;
+                Group->MarkBoundsDirty();
+            }
+            ClearSelection();
+        }
+        if (Groups.Num() > 0)
+        {
+            RecordGroups();
+        }
+        InvalidateCanvas();
+        return FReply::Handled();
+    }
     // REMOVED C key handler for ColorPicker
+    else if (InKeyEvent.GetKey() == EKeys::L)
+    {
+        // Toggle lock on selected images and groups
+        for (auto& Image : SelectedImages)
+        {
+            Image->bLocked = !Image->bLocked;
+            if (Journal.IsValid())
+            {
+                Journal->RecordLock(*Image);
+            }
+        }
+        for (auto& Group : SelectedGroups)
+        {
+            Group->bLocked = !Group->bLocked;
+        }
+        if (SelectedGroups.Num() > 0)
+        {
+            RecordGroups();
+        }
+        InvalidateCanvas();
+        return FReply::Handled();
+    }
     else if (InKeyEvent.GetKey() == EKeys::Delete)
     {
-        // Remove selected images
+        // Remove selected images, and everything in selected groups
+        TArray<TSharedPtr<FRefImage>> Removed = SelectedImages;
+        for (const auto& Group : SelectedGroups)
+        {
+            for (int32 Index = Group->FirstIndex; Index < Group->EndIndex && Images.IsValidIndex(Index); Index++)
+            {
+                if (!Images[Index]->bSelected)
+                {
+                    Images[Index]->bSelected = true;
+                    Removed.Add(Images[Index]);
+                }
+            }
+        }
+        
+        bool bAnyGrouped = false;
+        for (const auto& Image : Removed)
+        {
+            Minimap->MarkDirty(Image->GetBounds());
+            bAnyGrouped |= Image->Group.IsValid();
+            if (Journal.IsValid())
+            {
+                Journal->RecordRemove(*Image);
+            }
+        }
         Images.RemoveAll([](const TSharedPtr<FRefImage>& Image) { return Image->bSelected; });
         SelectedImages.Empty();
+        SelectedGroups.Empty();
+        
+        // Groups left empty go with them
+        RefreshGroupRanges();
+        if (bAnyGrouped)
+        {
+            RecordGroups();
+        }
         InvalidateCanvas();
         return FReply::Handled();
     }
@@ -363,6 +1359,21 @@ FReply SReferenceCanvas::OnKeyDown(const FGeometry& MyGeometry, const FKeyEvent&
         for (auto& Image : SelectedImages)
         {
             Image->Opacity = NewOpacity;
+            Image->MarkGroupDirty();
+            Minimap->MarkDirty(Image->GetBounds());
+            if (Journal.IsValid())
+            {
+                Journal->RecordOpacity(*Image);
+            }
+        }
+        for (auto& Group : SelectedGroups)
+        {
+            Group->Opacity = NewOpacity;
+            Minimap->MarkDirty(Group->GetBounds());
+        }
+        if (SelectedGroups.Num() > 0)
+        {
+            RecordGroups();
         }
         InvalidateCanvas();
         return FReply::Handled();
@@ -371,52 +1382,383 @@ FReply SReferenceCanvas::OnKeyDown(const FGeometry& MyGeometry, const FKeyEvent&
     return FReply::Unhandled();
 }
 
-void SReferenceCanvas::MoveSelectedImages(const FVector2D& Delta)
+FReply SReferenceCanvas::OnDragOver(const FGeometry& MyGeometry, const FDragDropEvent& DragDropEvent)
 {
-    for (auto& Image : SelectedImages)
+    if (DragDropEvent.GetOperationAs<FRefLibraryDragDropOp>().IsValid())
+        return FReply::Handled();
+        
+    TSharedPtr<FAssetDragDropOp> AssetOp = DragDropEvent.GetOperationAs<FAssetDragDropOp>();
+    if (AssetOp.IsValid())
     {
-        if (!Image->bLocked)
+        for (const FAssetData& Asset : AssetOp->GetAssets())
         {
-            Image->Position += Delta;
-            if (bShowGrid)
+            if (Asset.IsInstanceOf(UTexture2D::StaticClass()))
             {
-                Image->Position = SnapToGrid(Image->Position);
+                return FReply::Handled();
             }
         }
     }
-    InvalidateCanvas();
-}
-
-FVector2D SReferenceCanvas::SnapToGrid(const FVector2D& Position) const
-{
-    return FVector2D(
-        FMath::RoundToFloat(Position.X / GridSize) * GridSize,
-        FMath::RoundToFloat(Position.Y / GridSize) * GridSize
-    );
+    return FReply::Unhandled();
 }
 
-TSharedPtr<FRefImage> SReferenceCanvas::GetImageAtPosition(const FVector2D& Position) const
+FReply SReferenceCanvas::OnDrop(const FGeometry& MyGeometry, const FDragDropEvent& DragDropEvent)
 {
-    // Search from top to bottom
-    for (int32 i = Images.Num() - 1; i >= 0; i--)
+    TSharedPtr<FAssetDragDropOp> AssetOp = DragDropEvent.GetOperationAs<FAssetDragDropOp>();
+    TSharedPtr<FRefLibraryDragDropOp> LibraryOp = DragDropEvent.GetOperationAs<FRefLibraryDragDropOp>();
+    if (!AssetOp.IsValid() && !LibraryOp.IsValid())
+        return FReply::Unhandled();
+        
+    FVector2D LocalMousePos = MyGeometry.AbsoluteToLocal(DragDropEvent.GetScreenSpacePosition());
+    FVector2D CanvasPos = LocalMousePos / ViewZoom - ViewOffset;
+    
+    TArray<TSharedPtr<FRefImage>> Dropped;
+    if (AssetOp.IsValid())
     {
-        if (Images[i]->HitTest(Position))
+        for (const FAssetData& Asset : AssetOp->GetAssets())
         {
-            return Images[i];
+            if (!Asset.IsInstanceOf(UTexture2D::StaticClass()))
+                continue;
+                
+            if (UTexture2D* Texture = Cast<UTexture2D>(Asset.GetAsset()))
+            {
+                Dropped.Add(AddTextureAsset(Texture, CanvasPos));
+            }
         }
     }
-    return nullptr;
-}
-
-void SReferenceCanvas::SelectImage(TSharedPtr<FRefImage> Image, bool bMultiSelect)
-{
-    if (!bMultiSelect)
+    else
     {
-        for (auto& Img : Images)
+        for (const FRefLibraryDragDropOp::FEntry& Entry : LibraryOp->Entries)
         {
-            Img->bSelected = false;
+            if (TSharedPtr<FRefImage> NewImage = AddFileImage(Entry.FilePath, Entry.Thumbnail, Entry.SourceSize, CanvasPos))
+            {
+                Dropped.Add(NewImage);
+            }
+        }
+    }
+    
+    // Several textures are packed from the drop point instead of stacking
+    if (Dropped.Num() > 1)
+    {
+        PackImages(Dropped, CanvasPos);
+    }
+    
+    return Dropped.Num() > 0 ? FReply::Handled() : FReply::Unhandled();
+}
+
+void SReferenceCanvas::UpdateSnapIndex()
+{
+    // Only images moved since the last drag touch the index. Those this drag moves are left
+    // out, so the selection never snaps to itself.
+    DragStartBounds = FBox2D(ForceInit);
+    SnapIndex->BeginUpdate();
+    for (const auto& Image : Images)
+    {
+        const bool bMoving = (Image->bSelected || IsInSelectedGroup(Image->Group.Get())) && !Image->IsEffectivelyLocked();
+        if (bMoving)
+        {
+            DragStartBounds += Image->GetBounds();
+        }
+        else if (Image->IsEffectivelyVisible())
+        {
+            SnapIndex->Update(Image->Id, Image->GetBounds());
+        }
+    }
+    SnapIndex->EndUpdate();
+    SnapIndex->ClearGuides();
+}
+
+void SReferenceCanvas::MoveSelectedImages(FVector2D Delta)
+{
+    // Smart guides take the axes they snap on, and the grid the rest. An axis-constrained
+    // drag only snaps along its axis.
+    bool bGuideX = false;
+    bool bGuideY = false;
+    SnapIndex->ClearGuides();
+    if (bSmartGuides && !bDragGuidesSuppressed && DragStartBounds.bIsValid)
+    {
+        const bool bAllowX = !bDragAxisConstrained || (Delta.Y == 0 && Delta.X != 0);
+        const bool bAllowY = !bDragAxisConstrained || (Delta.X == 0 && Delta.Y != 0);
+        Delta += SnapIndex->Snap(DragStartBounds.ShiftBy(Delta), GuideSnapDistance / ViewZoom, bAllowX, bAllowY, bGuideX, bGuideY);
+    }
+    
+    auto SnapPosition = [this, bGuideX, bGuideY](const FVector2D& Position)
+    {
+        if (!bShowGrid)
+            return Position;
+            
+        const FVector2D OnGrid = SnapToGrid(Position);
+        return FVector2D(bGuideX ? Position.X : OnGrid.X, bGuideY ? Position.Y : OnGrid.Y);
+    };
+    
+    // Delta is from the drag start, so snapping never eats small movements
+    for (int32 i = 0; i < SelectedImages.Num(); i++)
+    {
+        FRefImage& Image = *SelectedImages[i];
+        if (Image.IsEffectivelyLocked() || !DragStartPositions.IsValidIndex(i) || IsInSelectedGroup(Image.Group.Get()))
+            continue;
+            
+        Minimap->MarkDirty(Image.GetBounds());
+        Image.Position = SnapPosition(DragStartPositions[i] + Delta);
+        Image.MarkGroupDirty();
+        Minimap->MarkDirty(Image.GetBounds());
+    }
+    
+    // A group moves by its offset alone, however many images it holds
+    for (int32 i = 0; i < SelectedGroups.Num(); i++)
+    {
+        FRefGroup& Group = *SelectedGroups[i];
+        if (Group.IsEffectivelyLocked() || !DragStartOffsets.IsValidIndex(i) || IsInSelectedGroup(Group.Parent.Pin().Get()))
+            continue;
+            
+        Minimap->MarkDirty(Group.GetBounds());
+        Group.SetOffset(SnapPosition(DragStartOffsets[i] + Delta));
+        Minimap->MarkDirty(Group.GetBounds());
+    }
+    InvalidateCanvas();
+}
+
+void SReferenceCanvas::ApplyPendingDrag()
+{
+    if (!bDragPending)
+        return;
+        
+    bDragPending = false;
+    
+    FVector2D Delta = PendingDragPos - DragStartPos;
+    if (bDragAxisConstrained)
+    {
+        // Constrain to axis
+        if (FMath::Abs(Delta.X) > FMath::Abs(Delta.Y))
+            Delta.Y = 0;
+        else
+            Delta.X = 0;
+    }
+    MoveSelectedImages(Delta);
+}
+
+void SReferenceCanvas::NoteInput()
+{
+    if (PendingInputTime <= 0.0)
+    {
+        PendingInputTime = FPlatformTime::Seconds();
+    }
+}
+
+void SReferenceCanvas::ArrangeImages()
+{
+    const bool bSelectionOnly = SelectedImages.Num() > 0 || SelectedGroups.Num() > 0;
+    
+    // Ungrouped images and top-level groups pack as units; grouped images only when picked out on their own
+    TArray<TSharedPtr<FRefImage>> ToPack;
+    FBox2D TargetBounds(ForceInit);
+    for (const auto& Image : bSelectionOnly ? SelectedImages : Images)
+    {
+        if (Image->IsEffectivelyLocked() || (!bSelectionOnly && Image->Group.IsValid()) || IsInSelectedGroup(Image->Group.Get()))
+            continue;
+            
+        ToPack.Add(Image);
+        TargetBounds += Image->GetBounds();
+    }
+    
+    TArray<TSharedPtr<FRefGroup>> GroupsToPack;
+    for (const auto& Group : bSelectionOnly ? SelectedGroups : Groups)
+    {
+        if (Group->IsEffectivelyLocked() || !Group->GetBounds().bIsValid || IsInSelectedGroup(Group->Parent.Pin().Get()))
+            continue;
+            
+        GroupsToPack.Add(Group);
+        TargetBounds += Group->GetBounds();
+    }
+    
+    if (ToPack.Num() > 0 || GroupsToPack.Num() > 0)
+    {
+        PackImages(ToPack, TargetBounds.Min, GroupsToPack);
+    }
+}
+
+void SReferenceCanvas::PackNewImages(const TArray<TSharedPtr<FRefImage>>& NewImages)
+{
+    TSet<const FRefImage*> NewSet;
+    for (const auto& Image : NewImages)
+    {
+        NewSet.Add(Image.Get());
+    }
+    
+    FBox2D ExistingBounds(ForceInit);
+    for (const auto& Image : Images)
+    {
+        if (!NewSet.Contains(Image.Get()))
+        {
+            ExistingBounds += Image->GetBounds();
+        }
+    }
+    
+    const FVector2D Origin = ExistingBounds.bIsValid
+        ? FVector2D(ExistingBounds.Max.X + FRefBoardPacker::Spacing, ExistingBounds.Min.Y)
+        : FVector2D::ZeroVector;
+    PackImages(NewImages, Origin);
+}
+
+void SReferenceCanvas::PackImages(const TArray<TSharedPtr<FRefImage>>& ToPack, const FVector2D& Origin, const TArray<TSharedPtr<FRefGroup>>& GroupsToPack)
+{
+    TSet<const FRefImage*> PackSet;
+    TArray<FVector2D> Sizes;
+    for (const auto& Image : ToPack)
+    {
+        PackSet.Add(Image.Get());
+        Sizes.Add(Image->Size);
+    }
+    
+    // Groups pack as one box after the images
+    TSet<const FRefGroup*> GroupSet;
+    for (const auto& Group : GroupsToPack)
+    {
+        GroupSet.Add(Group.Get());
+        Sizes.Add(Group->GetBounds().GetSize());
+    }
+    
+    // Everything else on the board is packed around
+    TArray<FBox2D> Obstacles;
+    for (const auto& Image : Images)
+    {
+        const bool bInPackedGroup = GroupSet.Num() > 0
+            && FindOutermostGroup(*Image, [&GroupSet](const FRefGroup& Group) { return GroupSet.Contains(&Group); });
+        if (!PackSet.Contains(Image.Get()) && !bInPackedGroup)
+        {
+            Obstacles.Add(Image->GetBounds());
+        }
+    }
+    
+    // Pack in grid cells so every image lands on the grid
+    const float CellSize = bShowGrid ? GridSize : 1.0f;
+    const FVector2D Start = bShowGrid ? SnapToGrid(Origin) : Origin;
+    
+    TArray<FVector2D> Positions;
+    FRefBoardPacker::Pack(Sizes, Start, CellSize, Obstacles, Positions);
+    
+    for (int32 i = 0; i < ToPack.Num(); i++)
+    {
+        Minimap->MarkDirty(ToPack[i]->GetBounds());
+        ToPack[i]->SetCanvasPosition(Positions[i]);
+        Minimap->MarkDirty(ToPack[i]->GetBounds());
+        if (Journal.IsValid())
+        {
+            Journal->RecordMove(*ToPack[i]);
+        }
+    }
+    
+    for (int32 i = 0; i < GroupsToPack.Num(); i++)
+    {
+        FRefGroup& Group = *GroupsToPack[i];
+        const FBox2D Bounds = Group.GetBounds();
+        Minimap->MarkDirty(Bounds);
+        Group.SetOffset(Group.Offset + Positions[ToPack.Num() + i] - Bounds.Min);
+        Minimap->MarkDirty(Group.GetBounds());
+    }
+    if (GroupsToPack.Num() > 0)
+    {
+        RecordGroups();
+    }
+    InvalidateCanvas();
+}
+
+FVector2D SReferenceCanvas::SnapToGrid(const FVector2D& Position) const
+{
+    return FVector2D(
+        FMath::RoundToFloat(Position.X / GridSize) * GridSize,
+        FMath::RoundToFloat(Position.Y / GridSize) * GridSize
+    );
+}
+
+bool SReferenceCanvas::SnapToEdge(const FVector2D& CanvasPos, FVector2D& OutCanvasPos) const
+{
+    // Snap radius is constant on screen, so convert it to canvas units
+    const float CanvasRadius = MeasureSnapRadius / ViewZoom;
+    float BestDistSq = CanvasRadius * CanvasRadius;
+    bool bFound = false;
+    
+    for (const auto& Image : Images)
+    {
+        if (!Image->IsEffectivelyVisible() || !Image->EdgeMap.IsValid())
+            continue;
+            
+        const FBox2D Bounds = Image->GetBounds().ExpandBy(CanvasRadius);
+        if (!Bounds.IsInside(CanvasPos))
+            continue;
+            
+        // Canvas units to edge map pixels
+        const FRefEdgeMap& EdgeMap = *Image->EdgeMap;
+        const FVector2D Scale(EdgeMap.Width / Image->Size.X, EdgeMap.Height / Image->Size.Y);
+        const FVector2D ImagePos = Image->GetCanvasPosition();
+        const FVector2D EdgePos = (CanvasPos - ImagePos) * Scale;
+        
+        FVector2D EdgeHit;
+        if (EdgeMap.FindNearestEdge(EdgePos, CanvasRadius * FMath::Max(Scale.X, Scale.Y), EdgeHit))
+        {
+            const FVector2D Candidate = ImagePos + EdgeHit / Scale;
+            const float DistSq = FVector2D::DistSquared(Candidate, CanvasPos);
+            if (DistSq <= BestDistSq)
+            {
+                BestDistSq = DistSq;
+                OutCanvasPos = Candidate;
+                bFound = true;
+            }
         }
-        SelectedImages.Empty();
+    }
+    
+    return bFound;
+}
+
+TSharedPtr<FRefImage> SReferenceCanvas::GetImageAtPosition(const FVector2D& Position) const
+{
+    // Search from top to bottom
+    for (int32 i = Images.Num() - 1; i >= 0; i--)
+    {
+        const FRefImage& Image = *Images[i];
+        
+        // Groups that are hidden or don't contain the point are skipped in one step
+        const FRefGroup* Skipped = FindOutermostGroup(Image, [&Position](const FRefGroup& Group)
+        {
+            return !Group.bVisible || !Group.GetBounds().IsInside(Position);
+        });
+        if (Skipped)
+        {
+            i = FMath::Min(i, Skipped->FirstIndex);
+            continue;
+        }
+        
+        // A collapsed group is hit anywhere inside its bounds
+        if (FindOutermostGroup(Image, [](const FRefGroup& Group) { return Group.bCollapsed; }))
+        {
+            return Images[i];
+        }
+        
+        if (Image.bVisible && Image.HitTest(Position))
+        {
+            return Images[i];
+        }
+    }
+    return nullptr;
+}
+
+const FRefGroup* SReferenceCanvas::FindOutermostGroup(const FRefImage& Image, TFunctionRef<bool(const FRefGroup&)> Predicate) const
+{
+    const FRefGroup* Found = nullptr;
+    for (const FRefGroup* Group = Image.Group.Get(); Group; Group = Group->Parent.Pin().Get())
+    {
+        if (Predicate(*Group))
+        {
+            Found = Group;
+        }
+    }
+    return Found;
+}
+
+void SReferenceCanvas::SelectImage(TSharedPtr<FRefImage> Image, bool bMultiSelect)
+{
+    if (!bMultiSelect)
+    {
+        ClearSelection();
     }
     
     Image->bSelected = !Image->bSelected;
@@ -432,6 +1774,40 @@ void SReferenceCanvas::SelectImage(TSharedPtr<FRefImage> Image, bool bMultiSelec
     InvalidateCanvas();
 }
 
+void SReferenceCanvas::SelectGroup(TSharedPtr<FRefGroup> Group, bool bMultiSelect)
+{
+    if (!bMultiSelect)
+    {
+        ClearSelection();
+    }
+    
+    Group->bSelected = !Group->bSelected;
+    if (Group->bSelected)
+    {
+        SelectedGroups.AddUnique(Group);
+    }
+    else
+    {
+        SelectedGroups.Remove(Group);
+    }
+    
+    InvalidateCanvas();
+}
+
+void SReferenceCanvas::ClearSelection()
+{
+    for (auto& Img : Images)
+    {
+        Img->bSelected = false;
+    }
+    for (auto& Group : SelectedGroups)
+    {
+        Group->bSelected = false;
+    }
+    SelectedImages.Empty();
+    SelectedGroups.Empty();
+}
+
 TSharedPtr<FSlateBrush> SReferenceCanvas::GetOrCreateBrush(UTexture2D* Texture) const
 {
     if (!Texture)
@@ -451,31 +1827,1482 @@ TSharedPtr<FSlateBrush> SReferenceCanvas::GetOrCreateBrush(UTexture2D* Texture)
     return NewBrush;
 }
 
-FVector2D SReferenceCanvas::ComputeDesiredSize(float) const
+TSharedPtr<FSlateBrush> SReferenceCanvas::GetImageBrush(const FRefImage& Image) const
 {
-    return FVector2D(800, 600);
+    if (!Image.IsCropped())
+        return GetOrCreateBrush(Image.Texture);
+        
+    if (!Image.Texture)
+        return nullptr;
+        
+    // A brush is a few bytes; the texture behind it stays shared with the rest of the sheet
+    if (!Image.CachedBrush.IsValid() || Image.CachedBrush->GetResourceObject() != Image.Texture || Image.CachedBrush->GetUVRegion() != Image.UVRegion)
+    {
+        Image.CachedBrush = MakeShareable(new FSlateBrush());
+        Image.CachedBrush->SetResourceObject(Image.Texture);
+        Image.CachedBrush->ImageSize = FVector2D(Image.Texture->GetSizeX(), Image.Texture->GetSizeY());
+        Image.CachedBrush->DrawAs = ESlateBrushDrawType::Image;
+        Image.CachedBrush->SetUVRegion(Image.UVRegion);
+    }
+    return Image.CachedBrush;
 }
 
-void SReferenceCanvas::AddImage(TSharedPtr<FRefImage> Image)
+void SReferenceCanvas::Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime)
 {
-    if (Image.IsValid())
+    ApplyPendingDrag();
+    
+    SLeafWidget::Tick(AllottedGeometry, InCurrentTime, InDeltaTime);
+    
+    UpdateBundleMips(AllottedGeometry);
+    UpdateHdrImages(AllottedGeometry);
+    UpdateDeferredLoads(AllottedGeometry);
+    UpdateUploads(AllottedGeometry, InDeltaTime);
+    UpdateAssetResidency(AllottedGeometry, InCurrentTime);
+    UpdateComparison();
+    UpdateMinimap();
+    UpdateAnimations(AllottedGeometry, InDeltaTime);
+    UpdateGroupProxies(AllottedGeometry);
+}
+
+void SReferenceCanvas::UpdateAnimations(const FGeometry& AllottedGeometry, float DeltaTime)
+{
+    // Off-screen animations don't decode
+    const FBox2D ViewBounds(-ViewOffset, AllottedGeometry.GetLocalSize() / ViewZoom - ViewOffset);
+    
+    for (const auto& Image : Images)
     {
-        Images.Add(Image);
-        InvalidateCanvas();
+        if (!Image->Animation.IsValid() || !Image->IsEffectivelyVisible() || !ViewBounds.Intersect(Image->GetBounds()))
+            continue;
+            
+        if (Image->Animation->Tick(DeltaTime))
+        {
+            InvalidateCanvas();
+        }
     }
 }
 
-void SReferenceCanvas::RemoveImage(TSharedPtr<FRefImage> Image)
+FBox2D SReferenceCanvas::GetScrubBarRect(const FRefImage& Image) const
 {
-    Images.Remove(Image);
-    SelectedImages.Remove(Image);
+    const FVector2D ScreenPos = (Image.GetCanvasPosition() + ViewOffset) * ViewZoom;
+    const FVector2D ScreenSize = Image.Size * ViewZoom;
+    const FVector2D BarMin(ScreenPos.X, ScreenPos.Y + ScreenSize.Y + 4.0f);
+    return FBox2D(BarMin, BarMin + FVector2D(ScreenSize.X, 6.0f));
+}
+
+FBox2D SReferenceCanvas::GetSwatchRect(const FRefImage& Image, int32 Index) const
+{
+    const float SwatchSize = 16.0f;
+    const float SwatchGap = 3.0f;
+    
+    const FVector2D ScreenPos = (Image.GetCanvasPosition() + ViewOffset) * ViewZoom;
+    float Top = ScreenPos.Y + Image.Size.Y * ViewZoom + 4.0f;
+    if (Image.Animation.IsValid() && Image.Animation->GetNumFrames() > 1)
+    {
+        Top = GetScrubBarRect(Image).Max.Y + 4.0f;
+    }
+    
+    const FVector2D SwatchMin(ScreenPos.X + Index * (SwatchSize + SwatchGap), Top);
+    return FBox2D(SwatchMin, SwatchMin + FVector2D(SwatchSize, SwatchSize));
+}
+
+void SReferenceCanvas::CopySwatchColor(const FLinearColor& Color) const
+{
+    // Same text form as copying a colour property, so it pastes into material and Details fields
+    const FString ColorText = Color.ToString();
+    FPlatformApplicationMisc::ClipboardCopy(*ColorText);
+    
+    FNotificationInfo Info(FText::FromString(FString::Printf(TEXT("Copied linear colour %s"), *ColorText)));
+    Info.ExpireDuration = 2.0f;
+    FSlateNotificationManager::Get().AddNotification(Info);
+}
+
+void SReferenceCanvas::ScrubTo(FRefImage& Image, float LocalX)
+{
+    const FBox2D BarRect = GetScrubBarRect(Image);
+    const float Alpha = FMath::Clamp((LocalX - BarRect.Min.X) / FMath::Max(1.0, BarRect.GetSize().X), 0.0f, 1.0f);
+    const int32 NumFrames = Image.Animation->GetNumFrames();
+    
+    Image.Animation->Pause();
+    Image.Animation->Seek(FMath::Min(FMath::FloorToInt(Alpha * NumFrames), NumFrames - 1));
+    NoteInput();
     InvalidateCanvas();
 }
 
-void SReferenceCanvas::ClearImages()
+void SReferenceCanvas::UpdateMinimap()
 {
-    Images.Empty();
-    SelectedImages.Empty();
-    BrushCache.Empty();
+    if (!bShowMinimap)
+        return;
+        
+    UTexture2D* OldTexture = Minimap->GetTexture();
+    if (Minimap->Update(Images, CanvasSize) && OldTexture)
+    {
+        BrushCache.Remove(OldTexture);
+    }
+}
+
+void SReferenceCanvas::InvalidateMinimap(const FBox2D& CanvasRect)
+{
+    Minimap->MarkDirty(CanvasRect);
+}
+
+FBox2D SReferenceCanvas::GetMinimapRect(const FVector2D& LocalSize) const
+{
+    // Bottom-right inset, longest side 200px, aspect of the board
+    const float MaxSide = 200.0f;
+    const float Inset = 10.0f;
+    const FVector2D Extent = Minimap->GetBounds().bIsValid ? Minimap->GetBounds().GetSize() : CanvasSize;
+    const FVector2D Size = Extent * (MaxSide / FMath::Max(Extent.X, Extent.Y));
+    const FVector2D Max = LocalSize - FVector2D(Inset, Inset);
+    return FBox2D(Max - Size, Max);
+}
+
+void SReferenceCanvas::CenterViewOnMinimap(const FVector2D& LocalPos, const FVector2D& LocalSize)
+{
+    const FBox2D MinimapRect = GetMinimapRect(LocalSize);
+    const FBox2D& Bounds = Minimap->GetBounds();
+    const FVector2D Alpha = (LocalPos - MinimapRect.Min) / MinimapRect.GetSize();
+    const FVector2D Target = Bounds.Min + Alpha.ClampAxes(0.0, 1.0) * Bounds.GetSize();
+    
+    ViewOffset = LocalSize / (2.0f * ViewZoom) - Target;
+    NoteInput();
+    InvalidateCanvas();
+}
+
+void SReferenceCanvas::SetCompareMode(ERefCompareMode Mode)
+{
+    if (Mode != ERefCompareMode::Off && CompareMode == ERefCompareMode::Off)
+    {
+        if (SelectedImages.Num() < 2)
+            return;
+            
+        CompareA = SelectedImages[0];
+        CompareB = SelectedImages[1];
+        CompareWipeX = (SelectedImages[0]->GetBounds().GetCenter().X + SelectedImages[1]->GetBounds().GetCenter().X) * 0.5f;
+    }
+    
+    CompareMode = Mode;
+    if (Mode == ERefCompareMode::Off)
+    {
+        CompareA.Reset();
+        CompareB.Reset();
+        CompareResult.Reset();
+        CompareKey = FCompareKey();
+        if (CompareTexture)
+        {
+            BrushCache.Remove(CompareTexture);
+            CompareTexture = nullptr;
+        }
+    }
     InvalidateCanvas();
+}
+
+void SReferenceCanvas::UpdateComparison()
+{
+    if (CompareMode != ERefCompareMode::Difference && CompareMode != ERefCompareMode::Heatmap)
+        return;
+        
+    TSharedPtr<FRefImage> A = CompareA.Pin();
+    TSharedPtr<FRefImage> B = CompareB.Pin();
+    if (!A.IsValid() || !B.IsValid() || !Images.Contains(A) || !Images.Contains(B))
+    {
+        SetCompareMode(ERefCompareMode::Off);
+        return;
+    }
+    
+    // Difference needs CPU pixels on both sides
+    if (!A->Proxy.IsValid() || !B->Proxy.IsValid())
+        return;
+        
+    // Cached result stays valid until a transform or the pixels change
+    FCompareKey Key;
+    Key.ProxyA = A->Proxy.Get();
+    Key.ProxyB = B->Proxy.Get();
+    Key.RectA = A->GetBounds();
+    Key.RectB = B->GetBounds();
+    Key.bHeatmap = CompareMode == ERefCompareMode::Heatmap;
+    
+    // One job at a time; a stale result is replaced on a later tick
+    if (Key == CompareKey || bCompareInFlight)
+        return;
+        
+    CompareKey = Key;
+    bCompareInFlight = true;
+    
+    TWeakPtr<SReferenceCanvas> WeakCanvas = SharedThis(this);
+    FRefImageProxyPtr ProxyA = A->Proxy;
+    FRefImageProxyPtr ProxyB = B->Proxy;
+    
+    Async(EAsyncExecution::ThreadPool, [WeakCanvas, ProxyA, ProxyB, Key]()
+    {
+        FRefDiffResultPtr Result = FRefImageCompare::ComputeDifference(*ProxyA, Key.RectA, *ProxyB, Key.RectB, Key.bHeatmap);
+        
+        AsyncTask(ENamedThreads::GameThread, [WeakCanvas, Result]()
+        {
+            TSharedPtr<SReferenceCanvas> Canvas = WeakCanvas.Pin();
+            if (!Canvas.IsValid())
+                return;
+                
+            Canvas->bCompareInFlight = false;
+            if (Canvas->CompareMode == ERefCompareMode::Off)
+                return;
+                
+            if (Canvas->CompareTexture)
+            {
+                Canvas->BrushCache.Remove(Canvas->CompareTexture);
+            }
+            Canvas->CompareResult = Result;
+            Canvas->CompareTexture = Result.IsValid()
+                ? FRefImageLoader::CreateTexture(reinterpret_cast<const uint8*>(Result->Pixels.GetData()), Result->Width, Result->Height)
+                : nullptr;
+            Canvas->InvalidateCanvas();
+        });
+    });
+}
+
+void SReferenceCanvas::UpdateAssetResidency(const FGeometry& AllottedGeometry, double CurrentTime)
+{
+    // Slate gives the streamer no screen size, so ask for full mips while an asset image is on screen
+    const double UpdateInterval = 1.0;
+    const float ResidencySeconds = 3.0f;
+    
+    if (CurrentTime - LastResidencyUpdateTime < UpdateInterval)
+        return;
+    LastResidencyUpdateTime = CurrentTime;
+    
+    const FBox2D ViewBounds(FVector2D::ZeroVector, AllottedGeometry.GetLocalSize());
+    for (const auto& Image : Images)
+    {
+        if (!Image->TextureAsset.IsValid() || !Image->Texture || !Image->IsEffectivelyVisible())
+            continue;
+            
+        const FVector2D ScreenPos = (Image->GetCanvasPosition() + ViewOffset) * ViewZoom;
+        const FVector2D ScreenSize = Image->Size * ViewZoom;
+        if (ViewBounds.Intersect(FBox2D(ScreenPos, ScreenPos + ScreenSize)))
+        {
+            Image->Texture->SetForceMipLevelsToBeResident(ResidencySeconds);
+        }
+    }
+}
+
+void SReferenceCanvas::UpdateBundleMips(const FGeometry& AllottedGeometry)
+{
+    // Cap uploads per frame so zooming into a large board doesn't hitch
+    const int32 MaxUpgradesPerTick = 4;
+    int32 NumUpgrades = 0;
+    
+    const FBox2D ViewBounds(FVector2D::ZeroVector, AllottedGeometry.GetLocalSize());
+    
+    for (const auto& Image : Images)
+    {
+        if (NumUpgrades >= MaxUpgradesPerTick)
+            break;
+            
+        if (!Image->Bundle.IsValid() || Image->BundleIndex == INDEX_NONE || Image->ResidentMip == 0 || !Image->IsEffectivelyVisible())
+            continue;
+            
+        const FVector2D ScreenPos = (Image->GetCanvasPosition() + ViewOffset) * ViewZoom;
+        const FVector2D ScreenSize = Image->Size * ViewZoom;
+        if (!ViewBounds.Intersect(FBox2D(ScreenPos, ScreenPos + ScreenSize)))
+            continue;
+            
+        // Only ever sharpen; lower mips stay resident once uploaded. A crop shows part of its
+        // texture, so the whole texture is drawn larger than the crop.
+        const FVector2D UVSize(Image->UVRegion.GetSize());
+        const int32 WantedMip = Image->Bundle->SelectMip(Image->BundleIndex, ScreenSize / UVSize.ComponentMax(FVector2D(UE_SMALL_NUMBER)));
+        if (WantedMip >= Image->ResidentMip)
+            continue;
+            
+        if (UTexture2D* NewTexture = Image->Bundle->CreateTexture(Image->BundleIndex, WantedMip))
+        {
+            SetImageTexture(Image, NewTexture);
+            Image->ResidentMip = WantedMip;
+            NumUpgrades++;
+            
+            // Other crops of the same sheet move up with it
+            for (const auto& Other : Images)
+            {
+                if (Other != Image && Other->Bundle == Image->Bundle && Other->BundleIndex != INDEX_NONE
+                    && Other->ResidentMip > WantedMip && Image->Bundle->SharesPixels(Other->BundleIndex, Image->BundleIndex))
+                {
+                    SetImageTexture(Other, NewTexture);
+                    Other->ResidentMip = WantedMip;
+                }
+            }
+        }
+    }
+}
+
+void SReferenceCanvas::UpdateHdrImages(const FGeometry& AllottedGeometry)
+{
+    // Tonemapping runs on workers; a few sheets at a time keeps an exposure drag responsive
+    const int32 MaxHdrUpdatesPerTick = 2;
+    int32 NumUpdates = HdrJobs.Num();
+    
+    const FBox2D ViewBounds(-ViewOffset, AllottedGeometry.GetLocalSize() / ViewZoom - ViewOffset);
+    
+    for (const auto& Image : Images)
+    {
+        if (NumUpdates >= MaxHdrUpdatesPerTick)
+            break;
+            
+        // Images still waiting for their first upload are redone once it lands
+        if (!Image->HdrSource.IsValid() || !Image->Texture || HdrJobs.Contains(Image->HdrSource.Get())
+            || !Image->IsEffectivelyVisible() || !ViewBounds.Intersect(Image->GetBounds()))
+            continue;
+            
+        // A new exposure is applied at the size now on screen, whatever was resident before;
+        // otherwise the texture only ever sharpens
+        const FRefHdrImagePtr Hdr = Image->HdrSource;
+        const FVector2D UVSize(Image->UVRegion.GetSize());
+        const int32 WantedMip = Hdr->SelectMip(Image->Size * ViewZoom / UVSize.ComponentMax(FVector2D(UE_SMALL_NUMBER)));
+        const bool bExposureChanged = !bFloatTextures && Image->HdrExposure != Exposure;
+        if (Image->bHdrFloat == bFloatTextures && !bExposureChanged && WantedMip >= Image->HdrMip)
+            continue;
+            
+        NumUpdates++;
+        
+        // Crops of the same sheet move with it
+        TArray<TSharedPtr<FRefImage>> Sharers;
+        for (const auto& Other : Images)
+        {
+            if (Other->HdrSource == Hdr)
+            {
+                Other->HdrMip = WantedMip;
+                Other->HdrExposure = Exposure;
+                Other->bHdrFloat = bFloatTextures;
+                Sharers.Add(Other);
+            }
+        }
+        
+        if (bFloatTextures)
+        {
+            if (UTexture2D* NewTexture = FRefImageLoader::CreateFloatTexture(*Hdr, WantedMip))
+            {
+                for (const TSharedPtr<FRefImage>& Sharer : Sharers)
+                {
+                    SetImageTexture(Sharer, NewTexture);
+                }
+            }
+            continue;
+        }
+        
+        HdrJobs.Add(Hdr.Get());
+        TWeakPtr<SReferenceCanvas> WeakCanvas = SharedThis(this);
+        TWeakPtr<FRefImage> WeakImage = Image;
+        const float JobExposure = Exposure;
+        
+        Async(EAsyncExecution::ThreadPool, [WeakCanvas, WeakImage, Hdr, WantedMip, JobExposure]()
+        {
+            TSharedPtr<TArray64<uint8>, ESPMode::ThreadSafe> BGRA = MakeShared<TArray64<uint8>, ESPMode::ThreadSafe>();
+            FRefImageLoader::Tonemap(*Hdr, WantedMip, JobExposure, *BGRA);
+            
+            AsyncTask(ENamedThreads::GameThread, [WeakCanvas, WeakImage, Hdr, BGRA]()
+            {
+                if (TSharedPtr<SReferenceCanvas> Canvas = WeakCanvas.Pin())
+                {
+                    Canvas->OnHdrTonemapped(Hdr, WeakImage, MoveTemp(*BGRA));
+                }
+            });
+        });
+    }
+}
+
+void SReferenceCanvas::OnHdrTonemapped(FRefHdrImagePtr Hdr, TWeakPtr<FRefImage> WeakImage, TArray64<uint8>&& BGRA)
+{
+    HdrJobs.Remove(Hdr.Get());
+    
+    TSharedPtr<FRefImage> Image = WeakImage.Pin();
+    if (!Image.IsValid() || Image->HdrSource != Hdr || Image->bHdrFloat || !Images.Contains(Image))
+        return;
+        
+    // Through the upload budget like any decoded file; crops pick the texture up when it lands
+    const FRefHdrImage::FMip& Mip = Hdr->Mips[Image->HdrMip];
+    if (BGRA.Num() == (int64)Mip.Width * Mip.Height * 4)
+    {
+        QueueImageUpload(Image, MoveTemp(BGRA), Mip.Width, Mip.Height);
+    }
+}
+
+void SReferenceCanvas::UpdateDeferredLoads(const FGeometry& AllottedGeometry)
+{
+    LoadThumbnails();
+    
+    // The image carrying a shared upload was removed before it landed; the rest wait for the screen again
+    for (auto It = FileLoads.CreateIterator(); It; ++It)
+    {
+        if (!It->Value.bDecoded || It->Value.Uploading.IsValid())
+            continue;
+            
+        for (const TWeakPtr<FRefImage>& WeakImage : It->Value.Waiting)
+        {
+            TSharedPtr<FRefImage> Image = WeakImage.Pin();
+            if (Image.IsValid() && Images.Contains(Image))
+            {
+                Image->bDeferredLoad = true;
+                DeferredImages.Add(Image);
+            }
+        }
+        It.RemoveCurrent();
+    }
+    
+    if (DeferredImages.Num() == 0)
+        return;
+        
+    // Restored boards can be large; only what is on screen is worth decoding, a few files at a time
+    const int32 MaxFileLoadsInFlight = 4;
+    const FBox2D ViewBounds(-ViewOffset, AllottedGeometry.GetLocalSize() / ViewZoom - ViewOffset);
+    
+    for (int32 Index = DeferredImages.Num() - 1; Index >= 0; Index--)
+    {
+        TSharedPtr<FRefImage> Image = DeferredImages[Index].Pin();
+        if (!Image.IsValid() || !Image->bDeferredLoad)
+        {
+            DeferredImages.RemoveAtSwap(Index);
+            continue;
+        }
+        
+        if (FileLoads.Num() >= MaxFileLoadsInFlight)
+            break;
+            
+        // Collapsed groups draw from the members' thumbnails
+        if (!Image->IsEffectivelyVisible() || !ViewBounds.Intersect(Image->GetBounds())
+            || FindOutermostGroup(*Image, [](const FRefGroup& Group) { return Group.bCollapsed; }))
+            continue;
+            
+        // The thumbnail stands in until the full pixels are up. A crop's proxy is already cropped,
+        // so it can't stand in for the sheet texture the crop's UV region expects.
+        if (!Image->Texture && Image->Proxy.IsValid() && !Image->IsCropped())
+        {
+            SetImageTexture(Image, FRefImageLoader::CreateTexture(Image->Proxy->BGRA.GetData(), Image->Proxy->Width, Image->Proxy->Height));
+            Image->bPreviewTexture = Image->Texture != nullptr;
+        }
+        
+        Image->bDeferredLoad = false;
+        DeferredImages.RemoveAtSwap(Index);
+        LoadFullImage(Image);
+    }
+    
+    SET_DWORD_STAT(STAT_RefViewer_DeferredImages, DeferredImages.Num());
+}
+
+void SReferenceCanvas::LoadThumbnails()
+{
+    if (PendingThumbnails.Num() == 0)
+        return;
+        
+    // Everything restored since the last tick is looked up in one background pass. Only the
+    // proxy is kept; a texture is made from it once the image is actually on screen.
+    TArray<TWeakPtr<FRefImage>> Requested = MoveTemp(PendingThumbnails);
+    TArray<FString> FilePaths;
+    FilePaths.Reserve(Requested.Num());
+    for (const TWeakPtr<FRefImage>& WeakImage : Requested)
+    {
+        TSharedPtr<FRefImage> Image = WeakImage.Pin();
+        FilePaths.Add(Image.IsValid() ? Image->FilePath : FString());
+    }
+    
+    TWeakPtr<SReferenceCanvas> WeakCanvas = SharedThis(this);
+    
+    Async(EAsyncExecution::ThreadPool, [WeakCanvas, Requested = MoveTemp(Requested), FilePaths = MoveTemp(FilePaths)]()
+    {
+        TArray<FRefImageProxyPtr> Thumbnails;
+        Thumbnails.SetNum(FilePaths.Num());
+        for (int32 Index = 0; Index < FilePaths.Num(); Index++)
+        {
+            const FFileStatData Stat = FilePaths[Index].IsEmpty() ? FFileStatData() : IFileManager::Get().GetStatData(*FilePaths[Index]);
+            FRefThumbnail Thumbnail;
+            if (Stat.bIsValid && FRefThumbnailCache::Load(FilePaths[Index], Stat.ModificationTime, Stat.FileSize, Thumbnail))
+            {
+                Thumbnails[Index] = Thumbnail.Proxy;
+            }
+        }
+        
+        AsyncTask(ENamedThreads::GameThread, [WeakCanvas, Requested, Thumbnails = MoveTemp(Thumbnails)]()
+        {
+            TSharedPtr<SReferenceCanvas> Canvas = WeakCanvas.Pin();
+            if (!Canvas.IsValid())
+                return;
+                
+            for (int32 Index = 0; Index < Requested.Num(); Index++)
+            {
+                // A full decode that finished first has a better proxy already
+                TSharedPtr<FRefImage> Image = Requested[Index].Pin();
+                if (Image.IsValid() && Thumbnails[Index].IsValid() && !Image->Proxy.IsValid())
+                {
+                    Image->Proxy = FRefImageLoader::CropProxy(Thumbnails[Index], Image->UVRegion);
+                    Image->MarkGroupDirty();
+                    Canvas->Minimap->MarkDirty(Image->GetBounds());
+                }
+            }
+            Canvas->InvalidateCanvas();
+        });
+    });
+}
+
+void SReferenceCanvas::UpdateUploads(const FGeometry& AllottedGeometry, float DeltaTime)
+{
+    const FBox2D ViewBounds(-ViewOffset, AllottedGeometry.GetLocalSize() / ViewZoom - ViewOffset);
+    Uploads->Tick(ViewBounds, DeltaTime, [this](TSharedPtr<FRefImage> Image, UTexture2D* Texture)
+    {
+        OnImageUploaded(Image, Texture);
+    });
+    
+    SET_DWORD_STAT(STAT_RefViewer_UploadQueue, Uploads->GetQueueDepth());
+    SET_FLOAT_STAT(STAT_RefViewer_UploadQueueMB, Uploads->GetQueuedBytes() / (1024.0 * 1024.0));
+    SET_FLOAT_STAT(STAT_RefViewer_UploadFrameMB, Uploads->GetLastTickMB());
+    SET_FLOAT_STAT(STAT_RefViewer_UploadFrameMs, Uploads->GetLastTickMs());
+    SET_FLOAT_STAT(STAT_RefViewer_UploadThroughput, Uploads->GetThroughputMBps());
+}
+
+void SReferenceCanvas::QueueImageUpload(TSharedPtr<FRefImage> Image, TArray64<uint8>&& BGRA, int32 Width, int32 Height)
+{
+    Uploads->Enqueue(Image, MoveTemp(BGRA), Width, Height);
+}
+
+FVector2D SReferenceCanvas::ComputeDesiredSize(float) const
+{
+    return FVector2D(800, 600);
+}
+
+void SReferenceCanvas::AddReferencedObjects(FReferenceCollector& Collector)
+{
+    // Animated images draw their player's texture, which this reaches through Texture
+    for (const TSharedPtr<FRefImage>& Image : Images)
+    {
+        Collector.AddReferencedObject(Image->Texture);
+        Collector.AddReferencedObject(Image->EdgeTexture);
+    }
+    ForEachGroup(Groups, [&Collector](const TSharedPtr<FRefGroup>& Group)
+    {
+        Collector.AddReferencedObject(Group->ProxyTexture);
+    });
+    Collector.AddReferencedObject(CompareTexture);
+    Minimap->AddReferencedObjects(Collector);
+}
+
+void SReferenceCanvas::AddImage(TSharedPtr<FRefImage> Image)
+{
+    if (Image.IsValid())
+    {
+        Images.Add(Image);
+        Minimap->MarkDirty(Image->GetBounds());
+        if (Journal.IsValid())
+        {
+            Journal->RecordAdd(*Image);
+        }
+        InvalidateCanvas();
+    }
+}
+
+void SReferenceCanvas::AddImages(const TArray<TSharedPtr<FRefImage>>& NewImages)
+{
+    FBox2D DirtyBounds(ForceInit);
+    Images.Reserve(Images.Num() + NewImages.Num());
+    for (const auto& Image : NewImages)
+    {
+        if (!Image.IsValid())
+            continue;
+            
+        Images.Add(Image);
+        DirtyBounds += Image->GetBounds();
+        if (Journal.IsValid())
+        {
+            Journal->RecordAdd(*Image);
+        }
+    }
+    
+    if (DirtyBounds.bIsValid)
+    {
+        Minimap->MarkDirty(DirtyBounds);
+    }
+    InvalidateCanvas();
+}
+
+int32 SReferenceCanvas::SetImageTransforms(const TArray<FRefImageRecord>& Transforms)
+{
+    TMap<FGuid, FRefImage*> ImagesById;
+    ImagesById.Reserve(Images.Num());
+    for (const auto& Image : Images)
+    {
+        ImagesById.Add(Image->Id, Image.Get());
+    }
+    
+    FBox2D DirtyBounds(ForceInit);
+    int32 NumApplied = 0;
+    for (const FRefImageRecord& Transform : Transforms)
+    {
+        FRefImage** Found = ImagesById.Find(Transform.Id);
+        if (!Found)
+            continue;
+            
+        FRefImage& Image = **Found;
+        DirtyBounds += Image.GetBounds();
+        Image.Size = Transform.Size;
+        Image.Rotation = Transform.Rotation;
+        Image.Opacity = Transform.Opacity;
+        Image.SetCanvasPosition(Transform.Position);
+        DirtyBounds += Image.GetBounds();
+        NumApplied++;
+        
+        if (Journal.IsValid())
+        {
+            Journal->RecordTransform(Image);
+        }
+    }
+    
+    if (DirtyBounds.bIsValid)
+    {
+        Minimap->MarkDirty(DirtyBounds);
+    }
+    InvalidateCanvas();
+    return NumApplied;
+}
+
+void SReferenceCanvas::RemoveImage(TSharedPtr<FRefImage> Image)
+{
+    if (Image.IsValid() && Images.Remove(Image) > 0)
+    {
+        Minimap->MarkDirty(Image->GetBounds());
+        if (Journal.IsValid())
+        {
+            Journal->RecordRemove(*Image);
+        }
+        
+        if (Image->Group.IsValid())
+        {
+            RefreshGroupRanges();
+            RecordGroups();
+        }
+    }
+    SelectedImages.Remove(Image);
+    InvalidateCanvas();
+}
+
+TSharedPtr<FRefImage> SReferenceCanvas::MakeCrop(const FRefImage& Source, const FBox2f& LocalUV) const
+{
+    TSharedPtr<FRefImage> Crop = MakeShareable(new FRefImage());
+    Crop->Name = Source.Name;
+    Crop->FilePath = Source.FilePath;
+    Crop->TextureAsset = Source.TextureAsset;
+    Crop->Texture = Source.Texture;
+    Crop->Bundle = Source.Bundle;
+    Crop->BundleIndex = Source.BundleIndex;
+    Crop->ResidentMip = Source.ResidentMip;
+    Crop->HdrSource = Source.HdrSource;
+    Crop->HdrMip = Source.HdrMip;
+    Crop->HdrExposure = Source.HdrExposure;
+    Crop->bHdrFloat = Source.bHdrFloat;
+    Crop->bDeferredLoad = Source.bDeferredLoad;
+    Crop->bPreviewTexture = Source.bPreviewTexture;
+    Crop->Opacity = Source.Opacity;
+    
+    // LocalUV is relative to what Source shows, which may itself be a crop
+    const FVector2f SourceUVSize = Source.UVRegion.GetSize();
+    Crop->UVRegion = FBox2f(Source.UVRegion.Min + LocalUV.Min * SourceUVSize, Source.UVRegion.Min + LocalUV.Max * SourceUVSize);
+    Crop->Proxy = FRefImageLoader::CropProxy(Source.Proxy, LocalUV);
+    
+    Crop->Position = Source.GetCanvasPosition() + FVector2D(LocalUV.Min) * Source.Size;
+    Crop->Size = FVector2D(LocalUV.GetSize()) * Source.Size;
+    return Crop;
+}
+
+TSharedPtr<FRefImage> SReferenceCanvas::CropImage(TSharedPtr<FRefImage> Image, const FBox2D& CanvasRect, bool bInPlace)
+{
+    if (!Image.IsValid() || Image->Animation.IsValid() || !Images.Contains(Image))
+        return nullptr;
+        
+    const FBox2D Bounds = Image->GetBounds();
+    const FBox2D Rect = Bounds.Overlap(CanvasRect);
+    const FVector2D RectSize = Rect.GetSize();
+    if (!Rect.bIsValid || RectSize.X < 2.0 || RectSize.Y < 2.0)
+        return nullptr;
+        
+    const FBox2f LocalUV(FVector2f((Rect.Min - Bounds.Min) / Bounds.GetSize()), FVector2f((Rect.Max - Bounds.Min) / Bounds.GetSize()));
+    
+    if (!bInPlace)
+    {
+        TSharedPtr<FRefImage> Crop = MakeCrop(*Image, LocalUV);
+        AddImage(Crop);
+        if (Journal.IsValid())
+        {
+            Journal->RecordCrop(*Crop);
+        }
+        if (Crop->bDeferredLoad)
+        {
+            DeferredImages.Add(Crop);
+        }
+        BuildEdgeMap(Crop);
+        SelectImage(Crop, false);
+        return Crop;
+    }
+    
+    if (Image->IsEffectivelyLocked())
+        return nullptr;
+        
+    TSharedPtr<FRefImage> Trimmed = MakeCrop(*Image, LocalUV);
+    Minimap->MarkDirty(Bounds);
+    Image->UVRegion = Trimmed->UVRegion;
+    Image->Proxy = Trimmed->Proxy;
+    Image->Size = Trimmed->Size;
+    Image->SetCanvasPosition(Trimmed->Position);
+    
+    // Edges and palette described the uncropped pixels
+    Image->EdgeMap.Reset();
+    Image->EdgeTexture = nullptr;
+    Image->Palette.Reset();
+    BuildEdgeMap(Image);
+    
+    if (Journal.IsValid())
+    {
+        Journal->RecordCrop(*Image);
+    }
+    InvalidateCanvas();
+    return Image;
+}
+
+TArray<TSharedPtr<FRefImage>> SReferenceCanvas::SplitImage(TSharedPtr<FRefImage> Image, int32 Columns, int32 Rows)
+{
+    TArray<TSharedPtr<FRefImage>> Cells;
+    const int32 Index = Images.Find(Image);
+    if (Index == INDEX_NONE || Image->Animation.IsValid() || Image->IsEffectivelyLocked() || Columns < 1 || Rows < 1 || Columns * Rows < 2)
+        return Cells;
+        
+    TSharedPtr<FRefGroup> Group = Image->Group;
+    Cells.Reserve(Columns * Rows);
+    for (int32 Row = 0; Row < Rows; Row++)
+    {
+        for (int32 Column = 0; Column < Columns; Column++)
+        {
+            const FBox2f CellUV(
+                FVector2f((float)Column / Columns, (float)Row / Rows),
+                FVector2f((float)(Column + 1) / Columns, (float)(Row + 1) / Rows));
+                
+            TSharedPtr<FRefImage> Cell = MakeCrop(*Image, CellUV);
+            Cell->Name = FString::Printf(TEXT("%s_%d_%d"), *Image->Name, Row, Column);
+            
+            // MakeCrop places it in canvas space; re-place it inside the sheet's group
+            const FVector2D CanvasPosition = Cell->Position;
+            Cell->Group = Group;
+            Cell->SetCanvasPosition(CanvasPosition);
+            if (Group.IsValid())
+            {
+                Group->Images.Add(Cell);
+            }
+            Cells.Add(Cell);
+        }
+    }
+    
+    // The cells take the sheet's place in the stacking order, and in its group
+    Minimap->MarkDirty(Image->GetBounds());
+    if (Journal.IsValid())
+    {
+        Journal->RecordRemove(*Image);
+    }
+    ClearSelection();
+    Images.RemoveAt(Index);
+    Images.Insert(Cells, Index);
+    
+    for (const auto& Cell : Cells)
+    {
+        if (Journal.IsValid())
+        {
+            Journal->RecordAdd(*Cell);
+            Journal->RecordCrop(*Cell);
+        }
+        if (Cell->bDeferredLoad)
+        {
+            DeferredImages.Add(Cell);
+        }
+        BuildEdgeMap(Cell);
+        SelectImage(Cell, true);
+    }
+    
+    if (Group.IsValid())
+    {
+        RefreshGroupRanges();
+        RecordGroups();
+    }
+    InvalidateCanvas();
+    return Cells;
+}
+
+void SReferenceCanvas::SetImageTexture(TSharedPtr<FRefImage> Image, UTexture2D* Texture)
+{
+    if (!Image.IsValid())
+        return;
+        
+    if (Image->Texture)
+    {
+        BrushCache.Remove(Image->Texture);
+    }
+    Image->Texture = Texture;
+    Image->bPreviewTexture = false;
+    Image->MarkGroupDirty();
+    Minimap->MarkDirty(Image->GetBounds());
+    InvalidateCanvas();
+}
+
+TSharedPtr<FRefImage> SReferenceCanvas::AddTextureAsset(UTexture2D* Texture, const FVector2D& CenterPos)
+{
+    if (!Texture)
+        return nullptr;
+        
+    TSharedPtr<FRefImage> NewImage = MakeShareable(new FRefImage());
+    NewImage->Name = Texture->GetName();
+    NewImage->Texture = Texture;
+    NewImage->TextureAsset = FSoftObjectPath(Texture);
+    NewImage->Proxy = FRefImageLoader::MakeTextureProxy(Texture);
+    NewImage->Size = FVector2D(Texture->GetSizeX(), Texture->GetSizeY());
+    NewImage->Position = CenterPos - NewImage->Size * 0.5f;
+    
+    AddImage(NewImage);
+    BuildEdgeMap(NewImage);
+    return NewImage;
+}
+
+TSharedPtr<FRefImage> SReferenceCanvas::AddFileImage(const FString& FilePath, FRefImageProxyPtr Preview, const FIntPoint& SourceSize, const FVector2D& CenterPos)
+{
+    if (!Preview.IsValid())
+        return nullptr;
+        
+    UTexture2D* PreviewTexture = FRefImageLoader::CreateTexture(Preview->BGRA.GetData(), Preview->Width, Preview->Height);
+    if (!PreviewTexture)
+        return nullptr;
+        
+    // Laid out at the full size from the start so nothing moves when the real pixels arrive
+    TSharedPtr<FRefImage> NewImage = MakeShareable(new FRefImage());
+    NewImage->FilePath = FilePath;
+    NewImage->Name = FPaths::GetBaseFilename(FilePath);
+    NewImage->Texture = PreviewTexture;
+    NewImage->bPreviewTexture = true;
+    NewImage->Proxy = Preview;
+    NewImage->Size = SourceSize.X > 0 && SourceSize.Y > 0
+        ? FVector2D(SourceSize.X, SourceSize.Y)
+        : FVector2D(Preview->Width, Preview->Height);
+    NewImage->Position = CenterPos - NewImage->Size * 0.5f;
+    AddImage(NewImage);
+    
+    LoadFullImage(NewImage);
+    return NewImage;
+}
+
+TSharedPtr<FRefImage> SReferenceCanvas::AddDeferredImage(const FRefImageRecord& Record)
+{
+    TSharedPtr<FRefImage> NewImage = MakeShareable(new FRefImage());
+    NewImage->ApplyRecord(Record);
+    NewImage->bDeferredLoad = true;
+    AddImage(NewImage);
+    
+    DeferredImages.Add(NewImage);
+    PendingThumbnails.Add(NewImage);
+    return NewImage;
+}
+
+void SReferenceCanvas::LoadFullImage(TSharedPtr<FRefImage> Image)
+{
+    // Another crop of the same sheet is already loading; wait for its texture instead of decoding again
+    if (FFileLoad* Pending = FileLoads.Find(Image->FilePath))
+    {
+        Pending->Waiting.Add(Image);
+        return;
+    }
+    FileLoads.Add(Image->FilePath).Waiting.Add(Image);
+    
+    TWeakPtr<SReferenceCanvas> WeakCanvas = SharedThis(this);
+    const FString FilePath = Image->FilePath;
+    
+    Async(EAsyncExecution::ThreadPool, [WeakCanvas, FilePath]()
+    {
+        TSharedPtr<TArray64<uint8>, ESPMode::ThreadSafe> BGRA = MakeShared<TArray64<uint8>, ESPMode::ThreadSafe>();
+        int32 Width = 0;
+        int32 Height = 0;
+        FRefImageProxyPtr Proxy;
+        FRefHdrImagePtr Hdr;
+        if (FRefImageLoader::DecodeFile(FilePath, *BGRA, Width, Height, &Hdr))
+        {
+            Proxy = FRefImageLoader::MakeProxy(BGRA->GetData(), Width, Height);
+        }
+        
+        AsyncTask(ENamedThreads::GameThread, [WeakCanvas, FilePath, BGRA, Width, Height, Proxy, Hdr]()
+        {
+            if (TSharedPtr<SReferenceCanvas> Canvas = WeakCanvas.Pin())
+            {
+                Canvas->OnFileDecoded(FilePath, MoveTemp(*BGRA), Width, Height, Proxy, Hdr);
+            }
+        });
+    });
+}
+
+void SReferenceCanvas::OnFileDecoded(const FString& FilePath, TArray64<uint8>&& BGRA, int32 Width, int32 Height, FRefImageProxyPtr Proxy, FRefHdrImagePtr Hdr)
+{
+    FFileLoad* Load = FileLoads.Find(FilePath);
+    if (!Load)
+        return;
+        
+    TSharedPtr<FRefImage> Uploading;
+    for (const TWeakPtr<FRefImage>& WeakImage : Load->Waiting)
+    {
+        TSharedPtr<FRefImage> Image = WeakImage.Pin();
+        if (!Image.IsValid() || !Proxy.IsValid() || !Images.Contains(Image))
+            continue;
+            
+        // Previews stay up until the full pixels are on the GPU
+        Image->Proxy = FRefImageLoader::CropProxy(Proxy, Image->UVRegion);
+        Image->HdrSource = Hdr;
+        Image->HdrMip = 0;
+        Image->HdrExposure = 0.0f;
+        Image->bHdrFloat = false;
+        Image->MarkGroupDirty();
+        BuildEdgeMap(Image);
+        if (!Uploading.IsValid())
+        {
+            Uploading = Image;
+        }
+    }
+    
+    if (!Uploading.IsValid())
+    {
+        FileLoads.Remove(FilePath);
+        return;
+    }
+    
+    // One upload for all of them; the others pick the texture up when it lands
+    Load->Uploading = Uploading;
+    Load->bDecoded = true;
+    QueueImageUpload(Uploading, MoveTemp(BGRA), Width, Height);
+}
+
+void SReferenceCanvas::OnImageUploaded(TSharedPtr<FRefImage> Image, UTexture2D* Texture)
+{
+    // A tonemapped upload that landed after the switch to float textures
+    if (Image.IsValid() && Image->bHdrFloat)
+        return;
+        
+    SetImageTexture(Image, Texture);
+    
+    if (Image.IsValid() && Image->HdrSource.IsValid())
+    {
+        for (const auto& Other : Images)
+        {
+            if (Other != Image && Other->HdrSource == Image->HdrSource && !Other->bHdrFloat
+                && Other->HdrMip == Image->HdrMip && Other->HdrExposure == Image->HdrExposure)
+            {
+                SetImageTexture(Other, Texture);
+            }
+        }
+    }
+    
+    FFileLoad* Load = Image.IsValid() ? FileLoads.Find(Image->FilePath) : nullptr;
+    if (!Load || Load->Uploading.Pin() != Image)
+        return;
+        
+    for (const TWeakPtr<FRefImage>& WeakImage : Load->Waiting)
+    {
+        TSharedPtr<FRefImage> Sharer = WeakImage.Pin();
+        if (Sharer.IsValid() && Sharer != Image && Images.Contains(Sharer))
+        {
+            SetImageTexture(Sharer, Texture);
+        }
+    }
+    FileLoads.Remove(Image->FilePath);
+}
+
+void SReferenceCanvas::BuildEdgeMap(TSharedPtr<FRefImage> Image)
+{
+    if (!Image.IsValid() || !Image->Proxy.IsValid())
+        return;
+        
+    TWeakPtr<SReferenceCanvas> WeakCanvas = SharedThis(this);
+    TWeakPtr<FRefImage> WeakImage = Image;
+    
+    FRefEdgeDetector::BuildAsync(Image->Proxy, [WeakCanvas, WeakImage](FRefEdgeMapPtr EdgeMap)
+    {
+        TSharedPtr<SReferenceCanvas> Canvas = WeakCanvas.Pin();
+        TSharedPtr<FRefImage> Image = WeakImage.Pin();
+        if (!Canvas.IsValid() || !Image.IsValid() || !EdgeMap.IsValid())
+            return;
+            
+        Image->EdgeMap = EdgeMap;
+        Image->EdgeTexture = FRefEdgeDetector::CreateOverlayTexture(*EdgeMap, FColor(255, 140, 0));
+        Canvas->InvalidateCanvas();
+    });
+    
+    FRefPaletteExtractor::ExtractAsync(Image->Proxy, [WeakCanvas, WeakImage](FRefPalettePtr Palette)
+    {
+        TSharedPtr<SReferenceCanvas> Canvas = WeakCanvas.Pin();
+        TSharedPtr<FRefImage> Image = WeakImage.Pin();
+        if (!Canvas.IsValid() || !Image.IsValid())
+            return;
+            
+        Image->Palette = Palette;
+        Canvas->InvalidateCanvas();
+    });
+}
+
+void SReferenceCanvas::ClearImages()
+{
+    Images.Empty();
+    SelectedImages.Empty();
+    Groups.Empty();
+    SelectedGroups.Empty();
+    DeferredImages.Empty();
+    PendingThumbnails.Empty();
+    FileLoads.Empty();
+    CropTarget.Reset();
+    Annotations->Reset();
+    bIsErasing = false;
+    SnapIndex->Reset();
+    BrushCache.Empty();
+    Minimap->MarkAllDirty();
+    if (Journal.IsValid())
+    {
+        Journal->RecordClear();
+    }
+    InvalidateCanvas();
+}
+
+TArray<FRefStroke> SReferenceCanvas::GetStrokes() const
+{
+    return Annotations->GetStrokes();
+}
+
+int32 SReferenceCanvas::GetNumStrokes() const
+{
+    return Annotations->Num();
+}
+
+void SReferenceCanvas::RestoreStrokes(const TArray<FRefStroke>& Strokes)
+{
+    for (const FRefStroke& Stroke : Strokes)
+    {
+        Annotations->AddStroke(Stroke);
+        if (Journal.IsValid())
+        {
+            Journal->RecordAddStroke(Stroke);
+        }
+    }
+    InvalidateCanvas();
+}
+
+void SReferenceCanvas::ClearAnnotations()
+{
+    if (Journal.IsValid())
+    {
+        for (const FRefStroke& Stroke : Annotations->GetStrokes())
+        {
+            Journal->RecordRemoveStroke(Stroke.Id);
+        }
+    }
+    Annotations->Reset();
+    InvalidateCanvas();
+}
+
+void SReferenceCanvas::EraseStrokesAt(const FVector2D& CanvasPos)
+{
+    const float Radius = EraserRadius / ViewZoom;
+    while (const FRefStroke* Hit = Annotations->FindStrokeAt(CanvasPos, Radius))
+    {
+        const FGuid StrokeId = Hit->Id;
+        Annotations->RemoveStroke(StrokeId);
+        if (Journal.IsValid())
+        {
+            Journal->RecordRemoveStroke(StrokeId);
+        }
+        InvalidateCanvas();
+    }
+}
+
+void SReferenceCanvas::GroupSelection()
+{
+    // Anything already moving with a selected group stays where it is in the tree
+    TArray<TSharedPtr<FRefImage>> MemberImages;
+    for (const auto& Image : SelectedImages)
+    {
+        if (!IsInSelectedGroup(Image->Group.Get()))
+        {
+            MemberImages.Add(Image);
+        }
+    }
+    TArray<TSharedPtr<FRefGroup>> MemberGroups;
+    for (const auto& Group : SelectedGroups)
+    {
+        if (!IsInSelectedGroup(Group->Parent.Pin().Get()))
+        {
+            MemberGroups.Add(Group);
+        }
+    }
+    if (MemberImages.Num() + MemberGroups.Num() < 2)
+        return;
+        
+    // Nests inside the members' group if they all share one, otherwise goes top-level
+    TSharedPtr<FRefGroup> Parent = MemberImages.Num() > 0 ? MemberImages[0]->Group : MemberGroups[0]->Parent.Pin();
+    for (const auto& Image : MemberImages)
+    {
+        if (Image->Group != Parent)
+        {
+            Parent.Reset();
+        }
+    }
+    for (const auto& Group : MemberGroups)
+    {
+        if (Group->Parent.Pin() != Parent)
+        {
+            Parent.Reset();
+        }
+    }
+    
+    int32 NumGroups = 0;
+    ForEachGroup(Groups, [&NumGroups](const TSharedPtr<FRefGroup>&) { NumGroups++; });
+    
+    TSharedPtr<FRefGroup> NewGroup = MakeShared<FRefGroup>();
+    NewGroup->Name = FString::Printf(TEXT("Group %d"), NumGroups + 1);
+    NewGroup->Parent = Parent;
+    (Parent.IsValid() ? Parent->Children : Groups).Add(NewGroup);
+    
+    // Members stay put on the board; their positions become relative to the new group
+    for (const auto& Image : MemberImages)
+    {
+        const FVector2D CanvasPosition = Image->GetCanvasPosition();
+        if (Image->Group.IsValid())
+        {
+            Image->Group->Images.RemoveAll([&Image](const TWeakPtr<FRefImage>& Member) { return Member.HasSameObject(Image.Get()); });
+            Image->Group->MarkBoundsDirty();
+        }
+        Image->Group = NewGroup;
+        NewGroup->Images.Add(Image);
+        Image->SetCanvasPosition(CanvasPosition);
+        if (Journal.IsValid())
+        {
+            Journal->RecordMove(*Image);
+        }
+    }
+    for (const auto& Group : MemberGroups)
+    {
+        const FVector2D CanvasOffset = Group->GetCanvasOffset();
+        if (TSharedPtr<FRefGroup> OldParent = Group->Parent.Pin())
+        {
+            OldParent->Children.Remove(Group);
+            OldParent->MarkBoundsDirty();
+        }
+        else
+        {
+            Groups.Remove(Group);
+        }
+        Group->Parent = NewGroup;
+        NewGroup->Children.Add(Group);
+        Group->Offset = CanvasOffset - NewGroup->GetCanvasOffset();
+    }
+    NewGroup->MarkBoundsDirty();
+    
+    GatherGroupMembers();
+    RefreshGroupRanges();
+    SelectGroup(NewGroup, false);
+    RecordGroups();
+}
+
+void SReferenceCanvas::UngroupSelection()
+{
+    if (SelectedGroups.Num() == 0)
+        return;
+        
+    const TArray<TSharedPtr<FRefGroup>> ToDissolve = SelectedGroups;
+    ClearSelection();
+    
+    // Members move up to the dissolved group's parent and come out selected
+    for (const auto& Group : ToDissolve)
+    {
+        TSharedPtr<FRefGroup> Parent = Group->Parent.Pin();
+        TArray<TSharedPtr<FRefGroup>>& Siblings = Parent.IsValid() ? Parent->Children : Groups;
+        
+        // The group's offset is folded into its members, so nothing moves on the board
+        for (const TWeakPtr<FRefImage>& Member : Group->Images)
+        {
+            TSharedPtr<FRefImage> Image = Member.Pin();
+            if (!Image.IsValid())
+                continue;
+                
+            Image->Position += Group->Offset;
+            Image->Group = Parent;
+            if (Parent.IsValid())
+            {
+                Parent->Images.Add(Image);
+            }
+            Image->bSelected = true;
+            SelectedImages.Add(Image);
+            if (Journal.IsValid())
+            {
+                Journal->RecordMove(*Image);
+            }
+        }
+        for (const auto& Child : Group->Children)
+        {
+            Child->Offset += Group->Offset;
+            Child->Parent = Parent;
+            Child->bSelected = true;
+            Siblings.Add(Child);
+            SelectedGroups.Add(Child);
+        }
+        
+        Siblings.Remove(Group);
+        if (Parent.IsValid())
+        {
+            Parent->MarkBoundsDirty();
+        }
+        Group->Images.Empty();
+        Group->Children.Empty();
+        if (Group->ProxyTexture)
+        {
+            BrushCache.Remove(Group->ProxyTexture);
+            Group->ProxyTexture = nullptr;
+        }
+    }
+    
+    RefreshGroupRanges();
+    RecordGroups();
+    InvalidateCanvas();
+}
+
+TArray<FRefGroupRecord> SReferenceCanvas::GetGroupRecords() const
+{
+    TArray<FRefGroupRecord> Records;
+    ForEachGroup(Groups, [&Records](const TSharedPtr<FRefGroup>& Group)
+    {
+        Records.Add(Group->ToRecord());
+    });
+    return Records;
+}
+
+void SReferenceCanvas::RestoreGroups(const TArray<FRefGroupRecord>& Records)
+{
+    Groups.Empty();
+    SelectedGroups.Empty();
+    for (const auto& Image : Images)
+    {
+        Image->Group.Reset();
+    }
+    
+    TMap<FGuid, TSharedPtr<FRefGroup>> GroupsById;
+    TArray<TSharedPtr<FRefGroup>> Restored;
+    for (const FRefGroupRecord& Record : Records)
+    {
+        TSharedPtr<FRefGroup>& Group = Restored.AddDefaulted_GetRef();
+        if (GroupsById.Contains(Record.Id))
+            continue;
+            
+        Group = MakeShared<FRefGroup>();
+        Group->Id = Record.Id;
+        Group->Name = Record.Name;
+        Group->Offset = Record.Offset;
+        Group->Opacity = Record.Opacity;
+        Group->bLocked = Record.bLocked;
+        Group->bVisible = Record.bVisible;
+        Group->bCollapsed = Record.bCollapsed;
+        GroupsById.Add(Record.Id, Group);
+    }
+    
+    // Linked once all exist, so records may come in any order; a parent cycle leaves the group top-level
+    for (int32 i = 0; i < Records.Num(); i++)
+    {
+        const TSharedPtr<FRefGroup>& Group = Restored[i];
+        if (!Group.IsValid())
+            continue;
+            
+        TSharedPtr<FRefGroup> Parent = GroupsById.FindRef(Records[i].ParentId);
+        for (const FRefGroup* Ancestor = Parent.Get(); Ancestor; Ancestor = Ancestor->Parent.Pin().Get())
+        {
+            if (Ancestor == Group.Get())
+            {
+                Parent.Reset();
+                break;
+            }
+        }
+        
+        Group->Parent = Parent;
+        (Parent.IsValid() ? Parent->Children : Groups).Add(Group);
+    }
+    
+    TMap<FGuid, TSharedPtr<FRefImage>> ImagesById;
+    ImagesById.Reserve(Images.Num());
+    for (const auto& Image : Images)
+    {
+        ImagesById.Add(Image->Id, Image);
+    }
+    for (int32 i = 0; i < Records.Num(); i++)
+    {
+        const TSharedPtr<FRefGroup>& Group = Restored[i];
+        if (!Group.IsValid())
+            continue;
+            
+        for (const FGuid& ImageId : Records[i].Images)
+        {
+            TSharedPtr<FRefImage> Image = ImagesById.FindRef(ImageId);
+            if (Image.IsValid() && !Image->Group.IsValid())
+            {
+                Image->Group = Group;
+                Group->Images.Add(Image);
+            }
+        }
+    }
+    
+    GatherGroupMembers();
+    RefreshGroupRanges();
+    RecordGroups();
+    Minimap->MarkAllDirty();
+    InvalidateCanvas();
+}
+
+void SReferenceCanvas::RefreshGroupRanges()
+{
+    TSet<const FRefImage*> OnBoard;
+    OnBoard.Reserve(Images.Num());
+    for (const auto& Image : Images)
+    {
+        OnBoard.Add(Image.Get());
+    }
+    PruneGroups(Groups, OnBoard);
+    
+    for (int32 Index = 0; Index < Images.Num(); Index++)
+    {
+        for (FRefGroup* Group = Images[Index]->Group.Get(); Group; Group = Group->Parent.Pin().Get())
+        {
+            Group->FirstIndex = FMath::Min(Group->FirstIndex, Index);
+            Group->EndIndex = Index + 1;
+        }
+    }
+    
+    SelectedGroups.RemoveAll([](const TSharedPtr<FRefGroup>& Group)
+    {
+        return Group->Images.Num() == 0 && Group->Children.Num() == 0;
+    });
+}
+
+void SReferenceCanvas::GatherGroupMembers()
+{
+    // Each group is anchored at its topmost member
+    TMap<const FRefGroup*, int32> Anchors;
+    for (int32 Index = 0; Index < Images.Num(); Index++)
+    {
+        for (const FRefGroup* Group = Images[Index]->Group.Get(); Group; Group = Group->Parent.Pin().Get())
+        {
+            Anchors.Add(Group, Index);
+        }
+    }
+    
+    // Sorting on the anchors along each image's group chain, outermost first, brings the members
+    // of every group together without disturbing the order inside it or between ungrouped images
+    struct FOrderKey
+    {
+        TArray<int32, TInlineAllocator<4>> Path;
+        TSharedPtr<FRefImage> Image;
+    };
+    
+    TArray<FOrderKey> Keys;
+    Keys.Reserve(Images.Num());
+    for (int32 Index = 0; Index < Images.Num(); Index++)
+    {
+        FOrderKey& Key = Keys.AddDefaulted_GetRef();
+        Key.Image = Images[Index];
+        Key.Path.Add(Index);
+        for (const FRefGroup* Group = Images[Index]->Group.Get(); Group; Group = Group->Parent.Pin().Get())
+        {
+            Key.Path.Insert(Anchors[Group], 0);
+        }
+    }
+    
+    Keys.Sort([](const FOrderKey& A, const FOrderKey& B)
+    {
+        const int32 NumShared = FMath::Min(A.Path.Num(), B.Path.Num());
+        for (int32 i = 0; i < NumShared; i++)
+        {
+            if (A.Path[i] != B.Path[i])
+                return A.Path[i] < B.Path[i];
+        }
+        return A.Path.Num() < B.Path.Num();
+    });
+    
+    for (int32 Index = 0; Index < Images.Num(); Index++)
+    {
+        Images[Index] = MoveTemp(Keys[Index].Image);
+    }
+}
+
+void SReferenceCanvas::RecordGroups()
+{
+    if (Journal.IsValid())
+    {
+        Journal->RecordGroups(GetGroupRecords());
+    }
+}
+
+void SReferenceCanvas::UpdateGroupProxies(const FGeometry& AllottedGeometry)
+{
+    // Only collapsed groups on screen need a composite; expanded ones may hold collapsed children
+    const FBox2D ViewBounds(-ViewOffset, AllottedGeometry.GetLocalSize() / ViewZoom - ViewOffset);
+    
+    TArray<TSharedPtr<FRefGroup>> Pending = Groups;
+    while (Pending.Num() > 0)
+    {
+        TSharedPtr<FRefGroup> Group = Pending.Pop();
+        if (!Group->bVisible || !ViewBounds.Intersect(Group->GetBounds()))
+            continue;
+            
+        if (!Group->bCollapsed)
+        {
+            Pending.Append(Group->Children);
+        }
+        else if (Group->bProxyDirty && !Group->bProxyInFlight)
+        {
+            BuildGroupProxy(Group);
+        }
+    }
+}
+
+void SReferenceCanvas::BuildGroupProxy(TSharedPtr<FRefGroup> Group)
+{
+    // Members as seen from inside the group; its own opacity is applied when the composite is drawn
+    TArray<FRefGroupProxyLayer> Layers;
+    for (int32 Index = Group->FirstIndex; Index < Group->EndIndex && Images.IsValidIndex(Index); Index++)
+    {
+        const FRefImage& Image = *Images[Index];
+        float Opacity = Image.Opacity;
+        bool bVisible = Image.bVisible;
+        for (const FRefGroup* Inner = Image.Group.Get(); Inner && Inner != Group.Get(); Inner = Inner->Parent.Pin().Get())
+        {
+            Opacity *= Inner->Opacity;
+            bVisible &= Inner->bVisible;
+        }
+        if (!bVisible)
+            continue;
+            
+        FRefGroupProxyLayer& Layer = Layers.AddDefaulted_GetRef();
+        Layer.Proxy = Image.Proxy;
+        Layer.Rect = Image.GetBounds();
+        Layer.Opacity = Opacity;
+    }
+    
+    // Edits made while this runs dirty it again and queue the next build
+    Group->bProxyDirty = false;
+    Group->bProxyInFlight = true;
+    
+    TWeakPtr<SReferenceCanvas> WeakCanvas = SharedThis(this);
+    TWeakPtr<FRefGroup> WeakGroup = Group;
+    
+    FRefGroupProxyBuilder::CompositeAsync(MoveTemp(Layers), Group->GetBounds(), [WeakCanvas, WeakGroup](FRefImageProxyPtr Composite)
+    {
+        TSharedPtr<SReferenceCanvas> Canvas = WeakCanvas.Pin();
+        TSharedPtr<FRefGroup> Group = WeakGroup.Pin();
+        if (!Canvas.IsValid() || !Group.IsValid())
+            return;
+            
+        Group->bProxyInFlight = false;
+        if (!Composite.IsValid())
+            return;
+            
+        if (Group->ProxyTexture)
+        {
+            Canvas->BrushCache.Remove(Group->ProxyTexture);
+        }
+        Group->ProxyTexture = FRefImageLoader::CreateTexture(Composite->BGRA.GetData(), Composite->Width, Composite->Height);
+        Canvas->InvalidateCanvas();
+    });
 }
\ No newline at end of file
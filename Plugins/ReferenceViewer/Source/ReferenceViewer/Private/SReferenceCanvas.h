@@ -2,10 +2,18 @@
 
 #include "CoreMinimal.h"
 #include "Widgets/SLeafWidget.h"
+#include "UObject/GCObject.h"
 #include "RefViewerData.h"
 
+class FRefAnnotationLayer;
+class FRefBoardJournal;
+class FRefMinimap;
+class FRefSnapIndex;
+class FRefUploadScheduler;
+struct FRefDiffResult;
+
 // High-performance custom canvas widget
-class SReferenceCanvas : public SLeafWidget
+class SReferenceCanvas : public SLeafWidget, public FGCObject
 {
 public:
     SLATE_BEGIN_ARGS(SReferenceCanvas) {}
@@ -19,21 +27,104 @@ public:
         int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
     
     virtual FVector2D ComputeDesiredSize(float) const override;
+    virtual void Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime) override;
     
     // Make widget interactive
     virtual bool SupportsKeyboardFocus() const override { return true; }
     
+    // FGCObject: the transient textures the board creates are referenced from nowhere else
+    virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+    virtual FString GetReferencerName() const override { return TEXT("SReferenceCanvas"); }
+    
     // Input handling
     virtual FReply OnMouseButtonDown(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
     virtual FReply OnMouseButtonUp(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
     virtual FReply OnMouseMove(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
     virtual FReply OnMouseWheel(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
     virtual FReply OnKeyDown(const FGeometry& MyGeometry, const FKeyEvent& InKeyEvent) override;
+    virtual FReply OnDragOver(const FGeometry& MyGeometry, const FDragDropEvent& DragDropEvent) override;
+    virtual FReply OnDrop(const FGeometry& MyGeometry, const FDragDropEvent& DragDropEvent) override;
     
     // Image management
     void AddImage(TSharedPtr<FRefImage> Image);
+    
+    // Batch forms for scripted boards: the whole batch costs one navigator update and one redraw
+    void AddImages(const TArray<TSharedPtr<FRefImage>>& NewImages);
+    int32 SetImageTransforms(const TArray<FRefImageRecord>& Transforms);
+    
     void RemoveImage(TSharedPtr<FRefImage> Image);
     void ClearImages();
+    const TArray<TSharedPtr<FRefImage>>& GetImages() const { return Images; }
+    const TArray<TSharedPtr<FRefImage>>& GetSelectedImages() const { return SelectedImages; }
+    
+    // Swaps an image's texture in place, keeping its transform
+    void SetImageTexture(TSharedPtr<FRefImage> Image, UTexture2D* Texture);
+    
+    // Uploads decoded full-size pixels over the next frames within the upload budget, then swaps them
+    // in as the image's texture. Until then the image keeps its current texture, or draws as a placeholder.
+    void QueueImageUpload(TSharedPtr<FRefImage> Image, TArray64<uint8>&& BGRA, int32 Width, int32 Height);
+    const FRefUploadScheduler& GetUploadScheduler() const { return *Uploads; }
+    
+    // Places a project texture asset on the board as-is: no decode, its streamed mips are drawn directly
+    TSharedPtr<FRefImage> AddTextureAsset(UTexture2D* Texture, const FVector2D& CenterPos);
+    
+    // Places an image file at once from a small preview, then swaps in the full pixels decoded in the background
+    TSharedPtr<FRefImage> AddFileImage(const FString& FilePath, FRefImageProxyPtr Preview, const FIntPoint& SourceSize, const FVector2D& CenterPos);
+    
+    // Places a saved image without reading its file. It shows its cached thumbnail, if the library
+    // has one, and the file is decoded only once the image comes on screen.
+    TSharedPtr<FRefImage> AddDeferredImage(const FRefImageRecord& Record);
+    
+    // Crops CanvasRect out of an image without copying pixels: the crop draws a UV region of the
+    // same texture. Lifts the region out as a new image on top, or with bInPlace trims the image itself.
+    TSharedPtr<FRefImage> CropImage(TSharedPtr<FRefImage> Image, const FBox2D& CanvasRect, bool bInPlace);
+    
+    // Replaces a contact sheet with a Columns x Rows grid of crops, all drawn from its one texture
+    TArray<TSharedPtr<FRefImage>> SplitImage(TSharedPtr<FRefImage> Image, int32 Columns, int32 Rows);
+    
+    // Packs the selection, or the whole board, without overlap. Locked images stay put.
+    void ArrangeImages();
+    
+    // Packs freshly added images to the right of the existing content
+    void PackNewImages(const TArray<TSharedPtr<FRefImage>>& NewImages);
+    
+    // Groups the selected images and groups under a new group, or dissolves the selected groups
+    void GroupSelection();
+    void UngroupSelection();
+    
+    // Top-level groups; nested ones hang off their parents
+    const TArray<TSharedPtr<FRefGroup>>& GetGroups() const { return Groups; }
+    
+    // Parents before children, for layouts
+    TArray<FRefGroupRecord> GetGroupRecords() const;
+    
+    // Rebuilds the group tree from saved records; call once the member images are on the board
+    void RestoreGroups(const TArray<FRefGroupRecord>& Records);
+    
+    // Analyses the image proxy in the background: edges for measure snapping and outlines,
+    // and the colour palette shown under the selection
+    void BuildEdgeMap(TSharedPtr<FRefImage> Image);
+    
+    // Annotations drawn over the board with the Annotate tool, in canvas space
+    TArray<FRefStroke> GetStrokes() const;
+    void RestoreStrokes(const TArray<FRefStroke>& Strokes);
+    void ClearAnnotations();
+    int32 GetNumStrokes() const;
+    
+    // Ink for new strokes; Thickness is in canvas units
+    void SetAnnotationColor(const FLinearColor& Color) { AnnotationColor = Color; }
+    void SetAnnotationThickness(float Thickness) { AnnotationThickness = Thickness; }
+    const FLinearColor& GetAnnotationColor() const { return AnnotationColor; }
+    float GetAnnotationThickness() const { return AnnotationThickness; }
+    
+    // Exposure in stops for high bit-depth images. Only those on screen are tonemapped again,
+    // at the mip their current size needs; the rest catch up as they come into view.
+    void SetExposure(float Stops) { Exposure = Stops; }
+    float GetExposure() const { return Exposure; }
+    
+    // Draws high bit-depth images from half-float textures, without exposure or tonemapping
+    void SetFloatTexturesEnabled(bool bEnabled) { bFloatTextures = bEnabled; }
+    bool IsFloatTexturesEnabled() const { return bFloatTextures; }
     
     // Tool modes
     void SetToolMode(EReferenceToolMode Mode) { CurrentToolMode = Mode; }
@@ -42,15 +133,50 @@ public:
     // Grid
     void SetGridEnabled(bool bEnabled) { bShowGrid = bEnabled; }
     void SetGridSize(float Size) { GridSize = Size; }
+    bool IsGridEnabled() const { return bShowGrid; }
+    float GetGridSize() const { return GridSize; }
+    
+    // Smart guides: dragged images snap to the edges and centres of the others, ahead of the grid
+    void SetSmartGuidesEnabled(bool bEnabled) { bSmartGuides = bEnabled; }
+    bool IsSmartGuidesEnabled() const { return bSmartGuides; }
+    
+    // View
+    float GetViewZoom() const { return ViewZoom; }
+    
+    // Navigator inset
+    void SetMinimapEnabled(bool bEnabled) { bShowMinimap = bEnabled; InvalidateCanvas(); }
+    bool IsMinimapEnabled() const { return bShowMinimap; }
+    
+    // Marks a canvas region for re-composite in the navigator, for edits made outside the canvas
+    void InvalidateMinimap(const FBox2D& CanvasRect);
+    
+    // Edge overlay
+    void SetEdgeOverlayEnabled(bool bEnabled) { bShowEdgeOverlay = bEnabled; InvalidateCanvas(); }
+    bool IsEdgeOverlayEnabled() const { return bShowEdgeOverlay; }
+    
+    // Compare the first two selected images; Off ends the comparison
+    void SetCompareMode(ERefCompareMode Mode);
+    ERefCompareMode GetCompareMode() const { return CompareMode; }
+    
+    // Crash journal receiving every board mutation
+    void SetJournal(TSharedPtr<FRefBoardJournal> InJournal) { Journal = InJournal; }
     
     // Performance
     void InvalidateCanvas() { bNeedsRedraw = true; }
     
+    // Time from the first input event of a frame to the paint that shows it, smoothed
+    float GetInputLatencyMs() const { return InputLatencyMs; }
+    
 private:
     // Images
     TArray<TSharedPtr<FRefImage>> Images;
     TArray<TSharedPtr<FRefImage>> SelectedImages;
     
+    // Group tree. Each group's members are contiguous in Images, so a group
+    // is skipped in one step when drawing or picking.
+    TArray<TSharedPtr<FRefGroup>> Groups;
+    TArray<TSharedPtr<FRefGroup>> SelectedGroups;
+    
     // Canvas state
     FVector2D CanvasSize;
     FVector2D ViewOffset;
@@ -63,26 +189,184 @@ private:
     FVector2D DragStartPos;
     FVector2D LastMousePos;
     
+    // Drags are coalesced: mouse events only record the cursor, Tick moves the selection once per frame
+    TArray<FVector2D> DragStartPositions;
+    TArray<FVector2D> DragStartOffsets;
+    FVector2D PendingDragPos;
+    bool bDragPending;
+    bool bDragAxisConstrained;
+    
+    // Smart guides. The targets are the images left standing by the drag, and DragStartBounds
+    // encloses the ones it moves. Alt while dragging turns them off.
+    TSharedPtr<FRefSnapIndex> SnapIndex;
+    FBox2D DragStartBounds;
+    bool bSmartGuides;
+    bool bDragGuidesSuppressed;
+    
     // Grid
     bool bShowGrid;
     float GridSize;
     
     // Measurement
     TArray<FVector2D> MeasurePoints;
+    FVector2D MeasureHoverPos;
+    bool bMeasureHoverSnapped;
+    float MeasureSnapRadius;
+    
+    // Annotations
+    TSharedPtr<FRefAnnotationLayer> Annotations;
+    FLinearColor AnnotationColor;
+    float AnnotationThickness;
+    bool bIsErasing;
+    
+    // Edge overlay
+    bool bShowEdgeOverlay;
+    
+    // Animation scrubbing
+    TWeakPtr<FRefImage> ScrubImage;
+    
+    // Navigator inset
+    TSharedPtr<FRefMinimap> Minimap;
+    bool bShowMinimap;
+    bool bIsMinimapDragging;
+    
+    // Comparison
+    struct FCompareKey
+    {
+        const FRefImageProxy* ProxyA = nullptr;
+        const FRefImageProxy* ProxyB = nullptr;
+        FBox2D RectA = FBox2D(ForceInit);
+        FBox2D RectB = FBox2D(ForceInit);
+        bool bHeatmap = false;
+        
+        bool operator==(const FCompareKey& Other) const
+        {
+            return ProxyA == Other.ProxyA && ProxyB == Other.ProxyB && RectA == Other.RectA && RectB == Other.RectB && bHeatmap == Other.bHeatmap;
+        }
+    };
+    
+    ERefCompareMode CompareMode;
+    TWeakPtr<FRefImage> CompareA;
+    TWeakPtr<FRefImage> CompareB;
+    float CompareWipeX;
+    FCompareKey CompareKey;
+    TSharedPtr<const FRefDiffResult, ESPMode::ThreadSafe> CompareResult;
+    UTexture2D* CompareTexture;
+    bool bCompareInFlight;
+    
+    // Autosave
+    TSharedPtr<FRefBoardJournal> Journal;
+    
+    // Texture streaming requests for visible asset images
+    double LastResidencyUpdateTime;
+    
+    // Time-sliced uploads of decoded files
+    TSharedPtr<FRefUploadScheduler> Uploads;
+    
+    // Restored images still waiting for their files, and those still waiting for a cached thumbnail
+    TArray<TWeakPtr<FRefImage>> DeferredImages;
+    TArray<TWeakPtr<FRefImage>> PendingThumbnails;
+    
+    // Files being decoded and uploaded. Every image waiting on a file, such as the crops of one
+    // sheet, shares the single texture uploaded for it.
+    struct FFileLoad
+    {
+        TArray<TWeakPtr<FRefImage>> Waiting;
+        TWeakPtr<FRefImage> Uploading;
+        bool bDecoded = false;
+    };
+    TMap<FString, FFileLoad> FileLoads;
+    
+    // High bit-depth display; sheets being tonemapped, shared by their crops
+    float Exposure;
+    bool bFloatTextures;
+    TSet<const FRefHdrImage*> HdrJobs;
+    
+    // Crop tool drag
+    TWeakPtr<FRefImage> CropTarget;
+    FVector2D CropStart;
+    FVector2D CropEnd;
+    bool bCropInPlace;
     
     // Performance
     mutable bool bNeedsRedraw;
+    mutable double PendingInputTime;
+    mutable float InputLatencyMs;
     mutable TMap<UTexture2D*, TSharedPtr<FSlateBrush>> BrushCache;
     
     // Helper functions
     void DrawGrid(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const;
     void DrawImages(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const;
     void DrawMeasurements(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const;
+    void DrawSnapGuides(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const;
+    void DrawComparison(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const;
+    void DrawAnimationControls(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const;
+    void DrawPalettes(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const;
+    void DrawMinimap(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const;
+    void DrawGroupProxy(const FRefGroup& Group, const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const;
+    void DrawImageBox(const FRefImage& Image, const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FLinearColor& Tint) const;
+    
+    void UpdateBundleMips(const FGeometry& AllottedGeometry);
+    void UpdateHdrImages(const FGeometry& AllottedGeometry);
+    void OnHdrTonemapped(FRefHdrImagePtr Hdr, TWeakPtr<FRefImage> WeakImage, TArray64<uint8>&& BGRA);
+    void UpdateDeferredLoads(const FGeometry& AllottedGeometry);
+    void LoadThumbnails();
+    void LoadFullImage(TSharedPtr<FRefImage> Image);
+    void OnFileDecoded(const FString& FilePath, TArray64<uint8>&& BGRA, int32 Width, int32 Height, FRefImageProxyPtr Proxy, FRefHdrImagePtr Hdr);
+    void OnImageUploaded(TSharedPtr<FRefImage> Image, UTexture2D* Texture);
+    
+    // New image showing LocalUV of Source, in Source's place on the board, sharing its pixels
+    TSharedPtr<FRefImage> MakeCrop(const FRefImage& Source, const FBox2f& LocalUV) const;
+    void DrawCropRect(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId) const;
+    
+    // Erases every stroke passing under the eraser at CanvasPos
+    void EraseStrokesAt(const FVector2D& CanvasPos);
+    
+    void UpdateUploads(const FGeometry& AllottedGeometry, float DeltaTime);
+    void UpdateAssetResidency(const FGeometry& AllottedGeometry, double CurrentTime);
+    void UpdateComparison();
+    void UpdateMinimap();
+    void UpdateAnimations(const FGeometry& AllottedGeometry, float DeltaTime);
+    void UpdateGroupProxies(const FGeometry& AllottedGeometry);
+    void BuildGroupProxy(TSharedPtr<FRefGroup> Group);
+    
+    FBox2D GetScrubBarRect(const FRefImage& Image) const;
+    void ScrubTo(FRefImage& Image, float LocalX);
+    
+    // Palette swatch Index of a selected image, in local space
+    FBox2D GetSwatchRect(const FRefImage& Image, int32 Index) const;
+    void CopySwatchColor(const FLinearColor& Color) const;
+    
+    FBox2D GetMinimapRect(const FVector2D& LocalSize) const;
+    void CenterViewOnMinimap(const FVector2D& LocalPos, const FVector2D& LocalSize);
     
     FVector2D SnapToGrid(const FVector2D& Position) const;
+    bool SnapToEdge(const FVector2D& CanvasPos, FVector2D& OutCanvasPos) const;
     TSharedPtr<FRefImage> GetImageAtPosition(const FVector2D& Position) const;
     void SelectImage(TSharedPtr<FRefImage> Image, bool bMultiSelect);
-    void MoveSelectedImages(const FVector2D& Delta);
+    void SelectGroup(TSharedPtr<FRefGroup> Group, bool bMultiSelect);
+    void ClearSelection();
+    
+    // Outermost group around the image matching Predicate, if any
+    const FRefGroup* FindOutermostGroup(const FRefImage& Image, TFunctionRef<bool(const FRefGroup&)> Predicate) const;
+    
+    // Call after the image list changes: drops removed members and empty groups, and updates member ranges
+    void RefreshGroupRanges();
+    
+    // Reorders Images so each group's members are contiguous, each group at the place of its topmost member
+    void GatherGroupMembers();
+    
+    void RecordGroups();
+    
+    // Call when a drag starts: brings the snap targets up to date and measures what is moving
+    void UpdateSnapIndex();
+    void MoveSelectedImages(FVector2D Delta);
+    void ApplyPendingDrag();
+    void NoteInput();
+    void PackImages(const TArray<TSharedPtr<FRefImage>>& ToPack, const FVector2D& Origin, const TArray<TSharedPtr<FRefGroup>>& GroupsToPack = {});
     
     TSharedPtr<FSlateBrush> GetOrCreateBrush(UTexture2D* Texture) const;
+    
+    // The texture's shared brush, or for crops a brush of their own carrying the UV region
+    TSharedPtr<FSlateBrush> GetImageBrush(const FRefImage& Image) const;
 };
\ No newline at end of file
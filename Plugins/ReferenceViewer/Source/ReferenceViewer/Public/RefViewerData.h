@@ -2,16 +2,151 @@
 
 #include "CoreMinimal.h"
 #include "Engine/Texture2D.h"
+#include "UObject/SoftObjectPath.h"
+
+struct FRefEdgeMap;
+struct FRefPalette;
+class FRefBoardBundle;
+class FRefAnimPlayer;
+struct FRefGroup;
+
+// Low-resolution CPU copy of an image (BGRA8), kept after the full pixels are uploaded.
+// Immutable once built so worker threads can read it without copying.
+struct FRefImageProxy
+{
+    // Alpha above which a pixel takes clicks
+    static constexpr uint8 CoverageThreshold = 32;
+    
+    int32 Width = 0;
+    int32 Height = 0;
+    TArray<uint8> BGRA;
+    
+    // One bit per pixel, set where alpha is above CoverageThreshold, rows padded to whole words.
+    // Empty when every pixel is covered, as for most photos.
+    TArray<uint64> Coverage;
+    int32 CoverageStride = 0;
+    
+    // Whether the pixel at UV (0-1 over the proxy) takes clicks; one word read at most
+    bool IsCovered(const FVector2D& UV) const
+    {
+        if (Coverage.Num() == 0)
+            return true;
+            
+        const int32 X = FMath::Clamp((int32)(UV.X * Width), 0, Width - 1);
+        const int32 Y = FMath::Clamp((int32)(UV.Y * Height), 0, Height - 1);
+        return (Coverage[Y * CoverageStride + (X >> 6)] >> (X & 63)) & 1;
+    }
+};
+
+typedef TSharedPtr<const FRefImageProxy, ESPMode::ThreadSafe> FRefImageProxyPtr;
+
+// Linear half-float pixels of a source with more than 8 bits per channel (EXR, Radiance HDR,
+// 16-bit PNG), as a mip chain so a new exposure is only applied at the size an image is drawn.
+// Immutable once built.
+struct FRefHdrImage
+{
+    struct FMip
+    {
+        int32 Width = 0;
+        int32 Height = 0;
+        TArray64<FFloat16Color> Pixels;
+    };
+    
+    // Halved down to about the proxy size
+    TArray<FMip> Mips;
+    
+    // Values may exceed one and are tonemapped; otherwise they are only clamped
+    bool bHighDynamicRange = false;
+    
+    // Smallest mip that still covers DisplaySize pixels
+    int32 SelectMip(const FVector2D& DisplaySize) const
+    {
+        for (int32 Mip = Mips.Num() - 1; Mip > 0; Mip--)
+        {
+            if (Mips[Mip].Width >= DisplaySize.X && Mips[Mip].Height >= DisplaySize.Y)
+            {
+                return Mip;
+            }
+        }
+        return 0;
+    }
+};
+
+typedef TSharedPtr<const FRefHdrImage, ESPMode::ThreadSafe> FRefHdrImagePtr;
+
+// Persistent part of an image, used by layouts and the autosave journal
+struct FRefImageRecord
+{
+    FGuid Id;
+    FString Name;
+    FString FilePath;
+    FSoftObjectPath TextureAsset;
+    FVector2D Position = FVector2D::ZeroVector;
+    FVector2D Size = FVector2D(200, 200);
+    float Rotation = 0.0f;
+    float Opacity = 1.0f;
+    bool bLocked = false;
+    bool bVisible = true;
+    
+    // Part of the source image shown, in UVs
+    FBox2f UVRegion = FBox2f(FVector2f::ZeroVector, FVector2f::UnitVector);
+};
+
+// Persistent part of a group
+struct FRefGroupRecord
+{
+    FGuid Id;
+    FString Name;
+    FGuid ParentId;
+    FVector2D Offset = FVector2D::ZeroVector;
+    float Opacity = 1.0f;
+    bool bLocked = false;
+    bool bVisible = true;
+    bool bCollapsed = false;
+    
+    // Direct members; their stacking order comes from the image list
+    TArray<FGuid> Images;
+};
+
+// Annotation over the board: a freehand mark, a straight line or an arrow, in canvas space
+struct FRefStroke
+{
+    FGuid Id;
+    TArray<FVector2D> Points;
+    FLinearColor Color = FLinearColor(1.0f, 0.25f, 0.1f);
+    
+    // Canvas units, so strokes scale with the view like the images under them
+    float Thickness = 3.0f;
+    
+    // Arrowhead at the last point
+    bool bArrow = false;
+    
+    float GetArrowHeadLength() const { return 4.0f * Thickness + 6.0f; }
+    
+    FBox2D GetBounds() const
+    {
+        const FBox2D Bounds(Points);
+        return Bounds.bIsValid ? Bounds.ExpandBy(bArrow ? GetArrowHeadLength() : Thickness * 0.5f) : Bounds;
+    }
+};
 
 // Optimized image data structure
 struct FRefImage
 {
     // Basic data
+    FGuid Id;
     FString Name;
     FString FilePath;
     UTexture2D* Texture;
     
-    // Transform
+    // Set when Texture is a project asset used in place, rather than decoded from FilePath
+    FSoftObjectPath TextureAsset;
+    
+    // Part of the source shown, in UVs. Crops of one sheet share its Texture and differ only here;
+    // Proxy, edges and palette cover the cropped part alone.
+    FBox2f UVRegion;
+    
+    // Transform; Position is relative to the group, if any
     FVector2D Position;
     FVector2D Size;
     float Rotation;
@@ -22,12 +157,48 @@ struct FRefImage
     bool bLocked;
     bool bVisible;
     
-    // Cached render data
-    TSharedPtr<FSlateBrush> CachedBrush;
+    // Cached render data; the brush is only needed by crops, whose UV region the shared brush can't carry
+    mutable TSharedPtr<FSlateBrush> CachedBrush;
     FBox2D CachedBounds;
     
+    // CPU proxy for background analysis
+    FRefImageProxyPtr Proxy;
+    
+    // Edge analysis (built in the background after import)
+    TSharedPtr<const FRefEdgeMap, ESPMode::ThreadSafe> EdgeMap;
+    UTexture2D* EdgeTexture;
+    
+    // Dominant colours (built in the background alongside the edge map)
+    TSharedPtr<const FRefPalette, ESPMode::ThreadSafe> Palette;
+    
+    // Bundle backing the texture, if opened from a .refboard; higher mips are mapped in on demand
+    TSharedPtr<FRefBoardBundle> Bundle;
+    int32 BundleIndex;
+    int32 ResidentMip;
+    
+    // Linear source of a high bit-depth file. Texture is HdrMip tonemapped at HdrExposure, or
+    // with bHdrFloat that mip as a half-float texture.
+    FRefHdrImagePtr HdrSource;
+    int32 HdrMip;
+    float HdrExposure;
+    bool bHdrFloat;
+    
+    // Playback for GIFs and image sequences; Texture is the player's and is updated in place
+    TSharedPtr<FRefAnimPlayer> Animation;
+    
+    // Innermost group holding the image
+    TSharedPtr<FRefGroup> Group;
+    
+    // Placed from a saved record only; FilePath is decoded once the image comes on screen
+    bool bDeferredLoad;
+    
+    // Texture is made from the proxy and stands in until the decode of FilePath is up
+    bool bPreviewTexture;
+    
     FRefImage() 
-        : Texture(nullptr)
+        : Id(FGuid::NewGuid())
+        , Texture(nullptr)
+        , UVRegion(FVector2f::ZeroVector, FVector2f::UnitVector)
         , Position(FVector2D::ZeroVector)
         , Size(FVector2D(200, 200))
         , Rotation(0.0f)
@@ -35,27 +206,288 @@ struct FRefImage
         , bSelected(false)
         , bLocked(false)
         , bVisible(true)
+        , EdgeTexture(nullptr)
+        , BundleIndex(INDEX_NONE)
+        , ResidentMip(0)
+        , HdrMip(0)
+        , HdrExposure(0.0f)
+        , bHdrFloat(false)
+        , bDeferredLoad(false)
+        , bPreviewTexture(false)
     {}
     
+    bool IsCropped() const
+    {
+        return UVRegion.Min != FVector2f::ZeroVector || UVRegion.Max != FVector2f::UnitVector;
+    }
+    
+    // Canvas space, through any groups
+    FVector2D GetCanvasPosition() const;
+    float GetEffectiveOpacity() const;
+    bool IsEffectivelyVisible() const;
+    bool IsEffectivelyLocked() const;
+    
+    // Call after changing Position or Size so the cached group bounds follow
+    void MarkGroupDirty() const;
+    
+    // Places the image in canvas space, keeping the group bounds current
+    void SetCanvasPosition(const FVector2D& CanvasPosition);
+    
     FBox2D GetBounds() const
     {
-        return FBox2D(Position, Position + Size);
+        const FVector2D CanvasPosition = GetCanvasPosition();
+        return FBox2D(CanvasPosition, CanvasPosition + Size);
     }
     
+    // Transparent parts of cut-outs let clicks through to whatever is beneath
     bool HitTest(const FVector2D& Point) const
     {
-        return GetBounds().IsInside(Point);
+        const FBox2D Bounds = GetBounds();
+        if (!Bounds.IsInside(Point))
+            return false;
+            
+        return !Proxy.IsValid() || Proxy->IsCovered((Point - Bounds.Min) / Size);
+    }
+    
+    FRefImageRecord ToRecord() const
+    {
+        FRefImageRecord Record;
+        Record.Id = Id;
+        Record.Name = Name;
+        Record.FilePath = FilePath;
+        Record.TextureAsset = TextureAsset;
+        Record.Position = Position;
+        Record.Size = Size;
+        Record.Rotation = Rotation;
+        Record.Opacity = Opacity;
+        Record.bLocked = bLocked;
+        Record.bVisible = bVisible;
+        Record.UVRegion = UVRegion;
+        return Record;
+    }
+    
+    void ApplyRecord(const FRefImageRecord& Record)
+    {
+        Id = Record.Id;
+        Name = Record.Name;
+        FilePath = Record.FilePath;
+        TextureAsset = Record.TextureAsset;
+        Position = Record.Position;
+        Size = Record.Size;
+        Rotation = Record.Rotation;
+        Opacity = Record.Opacity;
+        bLocked = Record.bLocked;
+        bVisible = Record.bVisible;
+        UVRegion = Record.UVRegion;
     }
 };
 
+// Nestable set of images that moves, locks, hides and fades as one. Member positions are
+// relative to the group, so moving it changes a single Offset however many images it holds.
+// The board keeps the members of every group contiguous in its image list.
+struct FRefGroup : public TSharedFromThis<FRefGroup>
+{
+    FGuid Id;
+    FString Name;
+    
+    TWeakPtr<FRefGroup> Parent;
+    TArray<TSharedPtr<FRefGroup>> Children;
+    TArray<TWeakPtr<FRefImage>> Images;
+    
+    // Relative to the parent group, or the board for top-level groups
+    FVector2D Offset;
+    float Opacity;
+    bool bLocked;
+    bool bVisible;
+    bool bSelected;
+    
+    // Drawn as one composite of its members instead of the members themselves
+    bool bCollapsed;
+    UTexture2D* ProxyTexture;
+    bool bProxyDirty;
+    bool bProxyInFlight;
+    
+    // Members' range in the board's image list
+    int32 FirstIndex;
+    int32 EndIndex;
+    
+    FRefGroup()
+        : Id(FGuid::NewGuid())
+        , Offset(FVector2D::ZeroVector)
+        , Opacity(1.0f)
+        , bLocked(false)
+        , bVisible(true)
+        , bSelected(false)
+        , bCollapsed(false)
+        , ProxyTexture(nullptr)
+        , bProxyDirty(true)
+        , bProxyInFlight(false)
+        , FirstIndex(0)
+        , EndIndex(0)
+        , ContentBounds(ForceInit)
+        , bBoundsDirty(true)
+    {}
+    
+    FVector2D GetCanvasOffset() const
+    {
+        TSharedPtr<FRefGroup> ParentGroup = Parent.Pin();
+        return ParentGroup.IsValid() ? Offset + ParentGroup->GetCanvasOffset() : Offset;
+    }
+    
+    float GetEffectiveOpacity() const
+    {
+        TSharedPtr<FRefGroup> ParentGroup = Parent.Pin();
+        return ParentGroup.IsValid() ? Opacity * ParentGroup->GetEffectiveOpacity() : Opacity;
+    }
+    
+    bool IsEffectivelyVisible() const
+    {
+        TSharedPtr<FRefGroup> ParentGroup = Parent.Pin();
+        return bVisible && (!ParentGroup.IsValid() || ParentGroup->IsEffectivelyVisible());
+    }
+    
+    bool IsEffectivelyLocked() const
+    {
+        TSharedPtr<FRefGroup> ParentGroup = Parent.Pin();
+        return bLocked || (ParentGroup.IsValid() && ParentGroup->IsEffectivelyLocked());
+    }
+    
+    TSharedRef<FRefGroup> GetRoot()
+    {
+        TSharedPtr<FRefGroup> ParentGroup = Parent.Pin();
+        return ParentGroup.IsValid() ? ParentGroup->GetRoot() : AsShared();
+    }
+    
+    // Canvas-space union of all members, nested ones included. Cached; only
+    // recomputed after MarkBoundsDirty, and moving the group itself keeps it valid.
+    FBox2D GetBounds() const;
+    
+    // A member or child moved, resized, joined or left
+    void MarkBoundsDirty()
+    {
+        bBoundsDirty = true;
+        bProxyDirty = true;
+        if (TSharedPtr<FRefGroup> ParentGroup = Parent.Pin())
+        {
+            ParentGroup->MarkBoundsDirty();
+        }
+    }
+    
+    // Moves the group as a unit
+    void SetOffset(const FVector2D& NewOffset)
+    {
+        Offset = NewOffset;
+        if (TSharedPtr<FRefGroup> ParentGroup = Parent.Pin())
+        {
+            ParentGroup->MarkBoundsDirty();
+        }
+    }
+    
+    FRefGroupRecord ToRecord() const
+    {
+        FRefGroupRecord Record;
+        Record.Id = Id;
+        Record.Name = Name;
+        if (TSharedPtr<FRefGroup> ParentGroup = Parent.Pin())
+        {
+            Record.ParentId = ParentGroup->Id;
+        }
+        Record.Offset = Offset;
+        Record.Opacity = Opacity;
+        Record.bLocked = bLocked;
+        Record.bVisible = bVisible;
+        Record.bCollapsed = bCollapsed;
+        for (const TWeakPtr<FRefImage>& Member : Images)
+        {
+            if (TSharedPtr<FRefImage> Image = Member.Pin())
+            {
+                Record.Images.Add(Image->Id);
+            }
+        }
+        return Record;
+    }
+    
+private:
+    // In the group's own space, i.e. relative to GetCanvasOffset()
+    mutable FBox2D ContentBounds;
+    mutable bool bBoundsDirty;
+};
+
+inline FVector2D FRefImage::GetCanvasPosition() const
+{
+    return Group.IsValid() ? Position + Group->GetCanvasOffset() : Position;
+}
+
+inline float FRefImage::GetEffectiveOpacity() const
+{
+    return Group.IsValid() ? Opacity * Group->GetEffectiveOpacity() : Opacity;
+}
+
+inline bool FRefImage::IsEffectivelyVisible() const
+{
+    return bVisible && (!Group.IsValid() || Group->IsEffectivelyVisible());
+}
+
+inline bool FRefImage::IsEffectivelyLocked() const
+{
+    return bLocked || (Group.IsValid() && Group->IsEffectivelyLocked());
+}
+
+inline void FRefImage::MarkGroupDirty() const
+{
+    if (Group.IsValid())
+    {
+        Group->MarkBoundsDirty();
+    }
+}
+
+inline void FRefImage::SetCanvasPosition(const FVector2D& CanvasPosition)
+{
+    Position = Group.IsValid() ? CanvasPosition - Group->GetCanvasOffset() : CanvasPosition;
+    MarkGroupDirty();
+}
+
+inline FBox2D FRefGroup::GetBounds() const
+{
+    if (bBoundsDirty)
+    {
+        ContentBounds = FBox2D(ForceInit);
+        for (const TWeakPtr<FRefImage>& Member : Images)
+        {
+            if (TSharedPtr<FRefImage> Image = Member.Pin())
+            {
+                ContentBounds += FBox2D(Image->Position, Image->Position + Image->Size);
+            }
+        }
+        for (const TSharedPtr<FRefGroup>& Child : Children)
+        {
+            const FBox2D ChildBounds = Child->GetBounds();
+            if (ChildBounds.bIsValid)
+            {
+                ContentBounds += ChildBounds.ShiftBy(-GetCanvasOffset());
+            }
+        }
+        bBoundsDirty = false;
+    }
+    return ContentBounds.bIsValid ? ContentBounds.ShiftBy(GetCanvasOffset()) : ContentBounds;
+}
+
 // Layout save data
 struct FReferenceLayout
 {
     FString Name;
-    TArray<FRefImage> Images;
-    FVector2D CanvasSize;
-    float GridSize;
-    bool bGridEnabled;
+    TArray<FRefImageRecord> Images;
+    TArray<FRefGroupRecord> Groups;
+    TArray<FRefStroke> Strokes;
+    FVector2D CanvasSize = FVector2D(2000, 2000);
+    float GridSize = 20.0f;
+    bool bGridEnabled = true;
+    
+    // Folder the board mirrors, if bound to one
+    FString WatchedFolder;
+    
+    // Last autosave journal entry folded into this layout
+    uint64 JournalSequence = 0;
 };
 
 // Tool modes
@@ -63,5 +495,18 @@ enum class EReferenceToolMode : uint8
 {
     Select,
     Move,
-    Measure
+    Measure,
+    Crop,
+    Annotate,
+    Erase
+};
+
+// Two-image comparison views
+enum class ERefCompareMode : uint8
+{
+    Off,
+    Wipe,
+    OnionSkin,
+    Difference,
+    Heatmap
 };
\ No newline at end of file
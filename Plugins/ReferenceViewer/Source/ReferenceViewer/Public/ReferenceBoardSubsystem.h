@@ -0,0 +1,115 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EditorSubsystem.h"
+#include "ReferenceBoardSubsystem.generated.h"
+
+class IRefBoardHost;
+class FRefBatchLoader;
+
+// Image to place on a board from a script
+USTRUCT(BlueprintType)
+struct FRefBoardImageSpec
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reference Viewer")
+    FString FilePath;
+
+    // Top-left corner in board units
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reference Viewer")
+    FVector2D Position = FVector2D::ZeroVector;
+
+    // Zero keeps the file's pixel size
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reference Viewer")
+    FVector2D Size = FVector2D::ZeroVector;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reference Viewer")
+    float Opacity = 1.0f;
+};
+
+// Placement of one image already on a board
+USTRUCT(BlueprintType)
+struct FRefBoardImageTransform
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reference Viewer")
+    FGuid Id;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reference Viewer")
+    FVector2D Position = FVector2D::ZeroVector;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reference Viewer")
+    FVector2D Size = FVector2D(200, 200);
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reference Viewer")
+    float Rotation = 0.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reference Viewer")
+    float Opacity = 1.0f;
+};
+
+// Scripting entry point for reference boards (Blueprint and Python).
+// Every call is a batch: it is applied to the board in one pass with a single
+// redraw, and the pixels of added images stream in afterwards as one load wave.
+UCLASS()
+class REFERENCEVIEWER_API UReferenceBoardSubsystem : public UEditorSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    // Opens a floating panel with an empty board. Returns the board's name, made unique if taken.
+    UFUNCTION(BlueprintCallable, Category = "Reference Viewer")
+    FString CreateBoard(const FString& Name);
+
+    // Boards of all open panels
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Reference Viewer")
+    TArray<FString> GetBoardNames() const;
+
+    // Places every image at once as a placeholder and queues the files for loading.
+    // Returns the new image ids, in input order; invalid ids for files that do not exist.
+    UFUNCTION(BlueprintCallable, Category = "Reference Viewer")
+    TArray<FGuid> AddImages(const FString& Board, const TArray<FRefBoardImageSpec>& Images);
+
+    // Returns how many of the ids were found on the board
+    UFUNCTION(BlueprintCallable, Category = "Reference Viewer")
+    int32 SetImageTransforms(const FString& Board, const TArray<FRefBoardImageTransform>& Transforms);
+
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Reference Viewer")
+    TArray<FRefBoardImageTransform> GetImageTransforms(const FString& Board) const;
+
+    UFUNCTION(BlueprintCallable, Category = "Reference Viewer")
+    bool ClearBoard(const FString& Board);
+
+    // Writes a .refboard bundle
+    UFUNCTION(BlueprintCallable, Category = "Reference Viewer")
+    bool SaveBoard(const FString& Board, const FString& Path);
+
+    // Replaces the board's contents with a .refboard bundle
+    UFUNCTION(BlueprintCallable, Category = "Reference Viewer")
+    bool LoadBoard(const FString& Board, const FString& Path);
+
+    // Renders the whole board to a .png or .exr at Scale output pixels per board unit.
+    // Pixels are read from the source files, so pending loads need not finish first.
+    UFUNCTION(BlueprintCallable, Category = "Reference Viewer")
+    bool ExportBoardImage(const FString& Board, const FString& Path, float Scale = 1.0f, bool bAnnotations = true);
+
+    // Images whose pixels have not reached the board yet; poll until zero before capturing
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Reference Viewer")
+    int32 GetNumPendingLoads(const FString& Board) const;
+
+    // Called by panels as they open. Returns the name the board was registered under.
+    FString RegisterBoard(TSharedRef<IRefBoardHost> Host, const FString& PreferredName);
+
+    // Remembers the open boards for the next editor session. Panels call it as they open,
+    // close, or switch bundles; closed panels are left out.
+    void SaveSession() const;
+
+private:
+    TSharedPtr<IRefBoardHost> FindBoard(const FString& Board) const;
+    FString MakeUniqueBoardName(const FString& PreferredName) const;
+
+    TMap<FString, TWeakPtr<IRefBoardHost>> Boards;
+    TArray<TSharedPtr<FRefBatchLoader>> Loaders;
+};
\ No newline at end of file
@@ -14,10 +14,18 @@ public:
     
     static FString GetSavedLayoutsPath();
     
+    // Opens a floating reference panel; an empty name takes the default
+    static void OpenBoardWindow(const FString& BoardName);
+    
 private:
     void RegisterMenus();
+    
+    // Reopens the boards that were open when the editor last shut down
+    void RestoreSession();
+    
     TSharedRef<class SDockTab> OnSpawnPluginTab(const class FSpawnTabArgs& SpawnTabArgs);
     
     TSharedPtr<class FUICommandList> PluginCommands;
     TSharedPtr<class SWindow> OverlayWindow;
+    FDelegateHandle EngineInitHandle;
 };
\ No newline at end of file
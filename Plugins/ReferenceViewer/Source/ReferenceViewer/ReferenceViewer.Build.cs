@@ -10,24 +10,27 @@ public class ReferenceViewer : ModuleRules
             new string[]
             {
                 "Core",
+                "CoreUObject",
+                "Engine",
+                "EditorSubsystem",
             }
         );
         
         PrivateDependencyModuleNames.AddRange(
             new string[]
             {
-                "CoreUObject",
-                "Engine",
                 "Slate",
                 "SlateCore",
-                "EditorSubsystem",
                 "UnrealEd",
                 "ToolMenus",
                 "EditorWidgets",
                 "InputCore",
                 "Projects",
                 "DesktopPlatform",
+                "ContentBrowser",
+                "DirectoryWatcher",
                 "ImageWrapper",
+                "ImageCore",
                 "RenderCore",
                 "RHI",
                 "ApplicationCore",
@@ -35,5 +38,8 @@ public class ReferenceViewer : ModuleRules
                 "JsonUtilities"
             }
         );
+        
+        // Streaming deflate for board exports
+        AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
     }
 }
\ No newline at end of file